@@ -0,0 +1,1335 @@
+/* benchkernels - times the per block and per member kernels of the
+ * extraction engine by themselves, reporting ns/op and GB/s, so each
+ * change to one of them can be measured in isolation.
+ *
+ * Host tool, built against the platform C library (see miniclib.h and
+ * BUILD.TXT), it is not part of the plugin.
+ *
+ * usage: benchkernels [-t seconds] [-gz file.gz] [-bz2 file.bz2]
+ *                     [-lzma file.lzma] [-xz file.xz] [-zst file.zst]
+ *                     [-lz4 file.lz4] [kernel ...]
+ *        benchkernels -fuzz count
+ *   -t      approximate time to spend on each kernel, default 0.5
+ *   -gz     gzip corpus for inflate, default examples/example.tgz
+ *   -bz2    bzip2 corpus, default examples/example.tbz
+ *   -lzma   lzma (alone format) corpus, default examples/example.tlz,
+ *           decoded by every lzmadec configuration (LZMADEC_BRANCHY,
+ *           _LZMA_PROB32, see lzma/lzmadec.h), the one built marked
+ *           with an asterisk
+ *   -xz     xz corpus, default examples/example.txz, decoded on one
+ *           thread and on one per processor (use one of several blocks,
+ *           xz --block-size, to see the difference)
+ *   -zst    zstd corpus, default examples/example.tzst, decoded on one
+ *           thread and on one per processor (use one of several frames,
+ *           zstd --seekable or pzstd, to see the difference)
+ *   -lz4    lz4 corpus, default examples/example.tlz4
+ *   kernel  only run kernels whose name contains one of the given strings
+ *   -fuzz   instead checks tar_decode against the scalar valid_checksum,
+ *           getoct and zeroblock on count random and mangled headers,
+ *           and the gzip and bzip2 crc kernels against a bit at a time
+ *           crc on count/100 random buffers, and that a pool starts
+ *           tasks submitted from outside in order (so extractMany -a
+ *           skips every tarball after a failing one) on count/10000
+ *           lists, exiting with 1 if any result differs
+ *
+ * Header kernels work on a set of generated ustar headers (mixed
+ * short and prefixed names, assorted sizes and times), codec kernels
+ * decode the whole corpus once per op; pass real payloads for numbers
+ * that mean something, the examples are only a few KB.
+ *
+ * public domain
+ */
+
+#include "untar.h"
+#include "bz2/bz2.h"
+#include "bz2/bzlib_private.h"
+#include "lzma/LzmaDecode.h"
+#include "lzma/lzmadec.h"
+#include "lzma/lzma.h"
+#include "lzma/xz.h"
+#include "zstd/zstd.h"
+#include "lz4/lz4.h"
+#include "threads.h"
+#include "pool.h"
+
+
+/* !!!USER SUPPLIED!!! (see untar.h) */
+void PrintMessage(const TCHAR *msg, ...) { }
+void bz_internal_error(int errcode) { }
+
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* result of every op is folded into this so nothing is optimized away */
+static volatile unsigned long sink;
+
+static double benchTime = 0.5;
+static int filterCnt = 0;
+static char **filterList = NULL;
+
+
+/* a kernel, runs iters ops, bytes is data processed per op (0 if n/a) */
+typedef unsigned long (*kernel_fn)(void *arg, long iters);
+
+static void run(const char *name, kernel_fn fn, void *arg, double bytes)
+{
+  long iters = 1;
+  double elapsed, nsop;
+  int i;
+
+  if (filterCnt)
+  {
+    for (i = 0; i < filterCnt; i++)
+      if (strstr(name, filterList[i]) != NULL) break;
+    if (i == filterCnt) return;
+  }
+
+  /* grow until long enough to time, then scale up to requested time */
+  for (;;)
+  {
+    double start = now();
+    sink += fn(arg, iters);
+    elapsed = now() - start;
+    if (elapsed >= benchTime / 10) break;
+    iters *= (elapsed < benchTime / 1000) ? 16 : 2;
+  }
+  iters = (long)(iters * (benchTime / elapsed)) + 1;
+  {
+    double start = now();
+    sink += fn(arg, iters);
+    elapsed = now() - start;
+  }
+
+  nsop = elapsed * 1e9 / iters;
+  if (bytes > 0)
+    printf("%-32s %12.1f ns/op %9.3f GB/s\n", name, nsop, bytes / nsop);
+  else
+    printf("%-32s %12.1f ns/op\n", name, nsop);
+}
+
+
+/* loads whole file, returns NULL if unable to */
+static unsigned char *loadFile(const char *fname, long *size)
+{
+  FILE *f = fopen(fname, "rb");
+  unsigned char *data;
+  if (f == NULL) return NULL;
+  fseek(f, 0, SEEK_END);
+  *size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  data = (unsigned char *)malloc(*size + 1);
+  if ((data != NULL) && (fread(data, 1, *size, f) != (size_t)*size))
+  {
+    free(data);
+    data = NULL;
+  }
+  fclose(f);
+  return data;
+}
+
+
+/*** tar header kernels ***/
+
+#define HDRCNT 64
+static union tar_buffer headers[HDRCNT];
+static char *includeList[] = { "*.dll", "bin/*.exe", "doc/*.txt", "share/locale/*", "*.nsi", "readme" };
+
+/* xorshift, so fuzzed headers are the same on every host */
+static unsigned long fuzzState = 88172645UL;
+
+static unsigned fuzzRand(void)
+{
+  fuzzState ^= (fuzzState << 13) & 0xFFFFFFFFUL;
+  fuzzState ^= fuzzState >> 17;
+  fuzzState ^= (fuzzState << 5) & 0xFFFFFFFFUL;
+  return (unsigned)(fuzzState & 0xFFFFFFFFUL);
+}
+
+/* fills width bytes at p with what numeric fields hold, or nearly do */
+static void fuzzField(char *p, int width)
+{
+  static const char alphabet[] = "01234567012345670123456701234567    \0\0\08x";
+  int i, kind = fuzzRand() % 8;
+
+  if (kind == 0)       /* any bytes */
+  {
+    for (i = 0; i < width; i++) p[i] = (char)fuzzRand();
+  }
+  else if (kind == 1)  /* base-256 */
+  {
+    for (i = 0; i < width; i++) p[i] = (char)fuzzRand();
+    p[0] |= 0x80;
+  }
+  else if (kind < 5)   /* digits, padded with spaces and/or a terminator */
+  {
+    int lead = fuzzRand() % 3, n = fuzzRand() % (width + 1);
+    memset(p, (fuzzRand() & 1) ? ' ' : '\0', width);
+    for (i = 0; (i < n) && (lead + i < width); i++) p[lead + i] = (char)('0' + fuzzRand() % 8);
+    for (i = 0; i < lead; i++) p[i] = ' ';
+  }
+  else                 /* digits, spaces and terminators anywhere */
+  {
+    for (i = 0; i < width; i++) p[i] = alphabet[fuzzRand() % (sizeof(alphabet) - 1)];
+  }
+}
+
+/* random header: a generated one mangled, random bytes or (nearly) zero */
+static void fuzzHeader(union tar_buffer *b)
+{
+  struct tar_header *h = &b->header;
+  unsigned sum = 0;
+  int sum8 = 0, i, kind = fuzzRand() % 10;
+
+  if (kind == 0)
+  {
+    memset(b, 0, BLOCKSIZE);
+    if (fuzzRand() & 1) b->buffer[fuzzRand() % BLOCKSIZE] = (char)(1 + fuzzRand() % 255);
+    return;
+  }
+  if (kind == 1)
+  {
+    for (i = 0; i < BLOCKSIZE; i++) b->buffer[i] = (char)fuzzRand();
+    return;
+  }
+
+  *b = headers[fuzzRand() % HDRCNT];
+  for (i = fuzzRand() % 4; i > 0; i--)   /* high bytes, signed sums differ */
+    h->name[fuzzRand() % sizeof(h->name)] = (char)(0x80 | fuzzRand());
+  if (fuzzRand() & 1) fuzzField(h->size, sizeof(h->size));
+  if (fuzzRand() & 1) fuzzField(h->mtime, sizeof(h->mtime));
+
+  /* stored checksum: unsigned, signed, or mangled */
+  memset(h->chksum, ' ', sizeof(h->chksum));
+  for (i = 0; i < BLOCKSIZE; i++)
+  {
+    sum += ((unsigned char *)b->buffer)[i];
+    sum8 += ((signed char *)b->buffer)[i];
+  }
+  switch (fuzzRand() % 4)
+  {
+    case 0: sprintf(h->chksum, "%06o", sum); break;
+    case 1: sprintf(h->chksum, "%06o", (unsigned)sum8 & 0777777); break;
+    case 2: sprintf(h->chksum, "%07o", sum); break;
+    default: fuzzField(h->chksum, sizeof(h->chksum)); break;
+  }
+}
+
+/* returns number of headers where tar_decode differs from the scalar code */
+static long fuzzDecode(long count)
+{
+  union tar_buffer b;
+  struct tar_fields f;
+  long i, bad = 0;
+
+  for (i = 0; i < count; i++)
+  {
+    int r;
+
+    fuzzHeader(&b);
+    r = tar_decode(&b, &f);
+    if ((r != valid_checksum(&b.header)) ||
+        (f.chksum != (unsigned)getoct(b.header.chksum, 8)) ||
+        (f.size != getoct(b.header.size, 12)) ||
+        (f.mtime != getoct(b.header.mtime, 12)) ||
+        (!f.zero != !zeroblock(b.buffer, BLOCKSIZE)))
+    {
+      if (bad++ < 10)
+      {
+        int j;
+        printf("header %ld differs: result %d/%d size %llo/%llo mtime %llo/%llo chksum %o/%o zero %d\n  size/mtime/chksum:",
+               i, r, valid_checksum(&b.header),
+               (unsigned long long)f.size, (unsigned long long)getoct(b.header.size, 12),
+               (unsigned long long)f.mtime, (unsigned long long)getoct(b.header.mtime, 12),
+               f.chksum, (unsigned)getoct(b.header.chksum, 8), f.zero);
+        for (j = 124; j < 156; j++) printf(" %02x", (unsigned char)b.buffer[j]);
+        printf("\n");
+      }
+    }
+  }
+  printf("tar_decode: %ld of %ld headers differ from scalar code\n", bad, count);
+  return bad;
+}
+
+/* crc a bit at a time, reflected (gzip) or not (bzip2 register) */
+static unsigned long crcBits(unsigned long crc, const unsigned char *buf, long len, int reflected)
+{
+  int k;
+  while (len-- > 0)
+  {
+    if (reflected)
+    {
+      crc ^= *buf++;
+      for (k = 0; k < 8; k++) crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320UL : crc >> 1;
+    }
+    else
+    {
+      crc ^= (unsigned long)*buf++ << 24;
+      for (k = 0; k < 8; k++) crc = (crc & 0x80000000UL) ? ((crc << 1) ^ 0x04c11db7UL) & 0xFFFFFFFFUL : (crc << 1) & 0xFFFFFFFFUL;
+    }
+  }
+  return crc;
+}
+
+/* returns number of random buffers where the crc kernels differ from crcBits */
+static long fuzzCrc(long count)
+{
+  unsigned char *buf = (unsigned char *)malloc(65536 + 64);
+  long i, bad = 0;
+
+  if (buf == NULL) return 1;
+  for (i = 0; i < 65536 + 64; i++) buf[i] = (unsigned char)fuzzRand();
+  for (i = 0; i < count; i++)
+  {
+    unsigned off = fuzzRand() % 64, len = (i & 1) ? fuzzRand() % 65536 : fuzzRand() % 300;
+    unsigned long c = fuzzRand(), gz, bz;
+
+    gz = crcBits(c ^ 0xFFFFFFFFUL, buf + off, len, 1) ^ 0xFFFFFFFFUL;
+    bz = crcBits(c, buf + off, len, 0);
+    if ((crc32(c, buf + off, len) != gz) || (BZ2_crcBlock((UInt32)c, buf + off, (Int32)len) != bz))
+    {
+      if (bad++ < 10) printf("crc of %u bytes at offset %u differs\n", len, off);
+    }
+  }
+  free(buf);
+  printf("crc: %ld of %ld buffers differ from bit at a time crc\n", bad, count);
+  return bad;
+}
+
+/* pool task standing in for one of extractMany's (multi.c many_task),
+   the first to fail stops those not yet started */
+struct ordertask {
+  LOCK *lock;
+  int  *next;           /* tasks started so far */
+  int  *stop;
+  int   fail;
+  int   order;          /* when started, from 0 */
+  int   skipped;
+};
+
+static void orderTask(struct pool *p, int worker, void *arg)
+{
+  struct ordertask *t = (struct ordertask *)arg;
+
+  lock_acquire(t->lock);
+  t->order = (*t->next)++;
+  t->skipped = *t->stop;
+  if (!t->skipped && t->fail) *t->stop = 1;
+  lock_release(t->lock);
+}
+
+/* returns number of lists of tasks, submitted from outside a one worker
+   pool, not started in order or not skipped after the failing one */
+static long fuzzPool(long count)
+{
+  struct ordertask t[256];
+  LOCK lock;
+  long i, bad = 0;
+
+  lock_init(&lock);
+  for (i = 0; i < count; i++)
+  {
+    struct pool *p = pool_new(1);
+    int n = 2 + fuzzRand() % 255, fail = fuzzRand() % n, next = 0, stop = 0, j, ok = 1;
+
+    if (p == NULL)
+    {
+      bad++;
+      break;
+    }
+    for (j = 0; j < n; j++)
+    {
+      t[j].lock = &lock;
+      t[j].next = &next;
+      t[j].stop = &stop;
+      t[j].fail = (j == fail);
+      if (!pool_submit(p, -1, orderTask, &t[j])) orderTask(NULL, 0, &t[j]);
+    }
+    pool_free(p);
+    for (j = 0; j < n; j++)
+      if ((t[j].order != j) || (t[j].skipped != (j > fail))) ok = 0;
+    if (!ok && (bad++ < 10)) printf("pool list of %d tasks, failing at %d, not run in order\n", n, fail);
+  }
+  lock_free(&lock);
+  printf("pool: %ld of %ld lists not started in order\n", bad, count);
+  return bad;
+}
+
+/* fills in headers with realistic looking members */
+static void makeHeaders(void)
+{
+  static const char *dirs[] = { "", "bin/", "lib/plugins/", "share/doc/package-1.2.3/", "share/locale/de/LC_MESSAGES/" };
+  static const char *exts[] = { ".dll", ".exe", ".txt", ".mo", ".png", "" };
+  int i, j;
+
+  srand(12345);
+  for (i = 0; i < HDRCNT; i++)
+  {
+    struct tar_header *h = &headers[i].header;
+    unsigned sum = 0;
+
+    memset(h, 0, sizeof(*h));
+    if ((i % 4) == 3) /* long path, split into prefix + name */
+    {
+      sprintf(h->prefix, "package-1.2.3/%s%s", dirs[i % 5], "very/deeply/nested/source/tree/directory");
+      sprintf(h->name, "component_%03d%s", i, exts[i % 6]);
+    }
+    else
+      sprintf(h->name, "package-1.2.3/%sfile_%03d%s", dirs[i % 5], i, exts[i % 6]);
+    strcpy(h->mode, "0000644");
+    strcpy(h->uid, "0001750");
+    strcpy(h->gid, "0001750");
+    sprintf(h->size, "%011lo", (unsigned long)(rand() % (i < 32 ? 4096 : 4 << 20)));
+    sprintf(h->mtime, "%011lo", 1100000000UL + (unsigned long)rand());
+    h->typeflag = '0';
+    memcpy(h->magic, "ustar", 6);
+    memcpy(h->version, "00", 2);
+    strcpy(h->uname, "builder");
+    strcpy(h->gname, "builder");
+    memset(h->chksum, ' ', sizeof(h->chksum));
+    for (j = 0; j < BLOCKSIZE; j++) sum += ((unsigned char *)h)[j];
+    sprintf(h->chksum, "%06o", sum);
+  }
+}
+
+static unsigned long k_valid_checksum(void *arg, long iters)
+{
+  unsigned long r = 0;
+  long i;
+  for (i = 0; i < iters; i++)
+    r += valid_checksum(&headers[i % HDRCNT].header);
+  return r;
+}
+
+static unsigned long k_tar_decode(void *arg, long iters)
+{
+  struct tar_fields f;
+  unsigned long r = 0;
+  long i;
+  for (i = 0; i < iters; i++)
+  {
+    r += tar_decode(&headers[i % HDRCNT], &f);
+    r += (unsigned long)f.size + (unsigned long)f.mtime;
+  }
+  return r;
+}
+
+static unsigned long k_getoct(void *arg, long iters)
+{
+  unsigned long r = 0;
+  long i;
+  for (i = 0; i < iters; i++)
+  {
+    struct tar_header *h = &headers[i % HDRCNT].header;
+    r += getoct(h->size, 12) + getoct(h->mtime, 12);
+  }
+  return r;
+}
+
+static unsigned long k_getFullName(void *arg, long iters)
+{
+  char fname[BLOCKSIZE];
+  unsigned long r = 0;
+  long i;
+  for (i = 0; i < iters; i++)
+  {
+    getFullName(&headers[i % HDRCNT], fname);
+    r += fname[0];
+  }
+  return r;
+}
+
+/* zero run detection (-S), on zero blocks and on blocks nonzero at the end */
+static unsigned long k_zeroblock(void *arg, long iters)
+{
+  const char *blk = (const char *)arg;
+  unsigned long r = 0;
+  long i;
+  for (i = 0; i < iters; i++)
+    r += zeroblock(blk, 8 * BLOCKSIZE);
+  return r;
+}
+
+static char names[HDRCNT][BLOCKSIZE];
+
+static unsigned long k_stripPath(void *arg, long iters)
+{
+  unsigned long r = 0;
+  long i;
+  for (i = 0; i < iters; i++)
+    r += *stripPath((int)(i & 3), names[i % HDRCNT]);
+  return r;
+}
+
+static unsigned long k_ExprMatch(void *arg, long iters)
+{
+  unsigned long r = 0;
+  long i;
+  for (i = 0; i < iters; i++)
+    r += ExprMatch(stripPath(0, names[i % HDRCNT]), includeList[i % 6]);
+  return r;
+}
+
+static unsigned long k_matchname(void *arg, long iters)
+{
+  unsigned long r = 0;
+  long i;
+  for (i = 0; i < iters; i++)
+    r += matchname(names[i % HDRCNT], 6, includeList, 0);
+  return r;
+}
+
+
+/*** codec kernels ***/
+
+typedef struct corpus
+{
+  unsigned char *in;   /* compressed data */
+  long inSize;
+  unsigned char *out;  /* room for all of decompressed data */
+  long outSize;        /* decompressed size, determined by first decode */
+  void *state;         /* codec specific */
+} corpus;
+
+/* returns number of bytes in gzip header, 0 if not a gzip member */
+static long gzHeaderSize(const unsigned char *p, long len)
+{
+  long pos = 10;
+  if ((len < 18) || (p[0] != 0x1F) || (p[1] != 0x8B) || (p[2] != Z_DEFLATED)) return 0;
+  if (p[3] & 0x04) pos += 2 + p[10] + (p[11] << 8);   /* extra field */
+  if (p[3] & 0x08) while ((pos < len) && p[pos++]) ;  /* original name */
+  if (p[3] & 0x10) while ((pos < len) && p[pos++]) ;  /* comment */
+  if (p[3] & 0x02) pos += 2;                          /* header crc */
+  return (pos < len) ? pos : 0;
+}
+
+/* raw inflate of the first gzip member, crc as gzread would; piece is
+   the output given to each inflate call (0 for all of it) */
+static long inflateCorpus(corpus *c, unsigned long *crc, long piece)
+{
+  z_stream s;
+  long hdr = gzHeaderSize(c->in, c->inSize);
+  long outSize;
+  int err;
+
+  memset(&s, 0, sizeof(s));
+  if ((hdr == 0) || (inflateInit2(&s, -MAX_WBITS) != Z_OK)) return -1;
+  s.next_in = c->in + hdr;
+  s.avail_in = (uInt)(c->inSize - hdr);
+  s.next_out = c->out;
+  if (piece == 0)
+  {
+    s.avail_out = (uInt)c->outSize;
+    err = inflate(&s, Z_FINISH);
+  }
+  else do
+  {
+    s.avail_out = (uInt)((c->outSize - (long)s.total_out < piece) ? c->outSize - (long)s.total_out : piece);
+    err = inflate(&s, Z_NO_FLUSH);
+  } while ((err == Z_OK) && (s.avail_out == 0));
+  outSize = (long)s.total_out;
+  inflateEnd(&s);
+  if (err != Z_STREAM_END) return -1;
+  *crc = crc32(*crc, c->out, (uInt)outSize);
+  return outSize;
+}
+
+static unsigned long k_inflate(void *arg, long iters)
+{
+  corpus *c = (corpus *)arg;
+  unsigned long r = 0;
+  long i;
+  for (i = 0; i < iters; i++)
+    inflateCorpus(c, &r, 0);
+  return r;
+}
+
+/* as untar reads, a tar block at a time */
+static unsigned long k_inflate512(void *arg, long iters)
+{
+  corpus *c = (corpus *)arg;
+  unsigned long r = 0;
+  long i;
+  for (i = 0; i < iters; i++)
+    inflateCorpus(c, &r, BLOCKSIZE);
+  return r;
+}
+
+/* through gzio as untar reads, c->state is the file name; copying each
+   block out (gzread) or using it in the window (gzreadptr) */
+static unsigned long k_gzread(void *arg, long iters)
+{
+  corpus *c = (corpus *)arg;
+  unsigned long r = 0;
+  long i;
+  for (i = 0; i < iters; i++)
+  {
+    gzFile f = gzopen((const char *)c->state, "rb");
+    int n;
+    if (f == NULL) return 0;
+    while ((n = gzread(f, c->out, BLOCKSIZE)) > 0) r += n;
+    gzclose(f);
+  }
+  return r;
+}
+
+static unsigned long k_gzreadptr(void *arg, long iters)
+{
+  corpus *c = (corpus *)arg;
+  unsigned long r = 0;
+  long i;
+  for (i = 0; i < iters; i++)
+  {
+    gzFile f = gzopen((const char *)c->state, "rb");
+    const Bytef *p;
+    int n;
+    if (f == NULL) return 0;
+    while ((n = gzreadptr(f, &p, BLOCKSIZE)) > 0) r += n + p[0];
+    gzclose(f);
+  }
+  return r;
+}
+
+static long bz2Corpus(corpus *c)
+{
+  bz_stream s;
+  long outSize;
+  int err;
+
+  memset(&s, 0, sizeof(s));
+  if (BZ2_bzDecompressInit(&s, 0, 0) != BZ_OK) return -1;
+  s.next_in = (char *)c->in;
+  s.avail_in = (unsigned)c->inSize;
+  s.next_out = (char *)c->out;
+  s.avail_out = (unsigned)c->outSize;
+  err = BZ2_bzDecompress(&s);
+  outSize = (long)s.total_out_lo32;
+  BZ2_bzDecompressEnd(&s);
+  return (err == BZ_STREAM_END) ? outSize : -1;
+}
+
+static unsigned long k_bz2(void *arg, long iters)
+{
+  corpus *c = (corpus *)arg;
+  unsigned long r = 0;
+  long i;
+  for (i = 0; i < iters; i++)
+    r += bz2Corpus(c);
+  return r;
+}
+
+/* Every lzmadec configuration is built here again under its own names
+   (lzmadec_bl16 is branchless prob16 and so on), so one benchkernels
+   compares them on the same corpus.  lzma.c and xz.c use the one
+   benchkernels itself was built with, lzmadecBuilt. */
+static const char lzmadecBuilt[] = LZMADEC_CONFIG;
+#ifdef _LZMA_PROB32
+#define BUILT_PROB32
+#endif
+
+#undef LZMADEC_BRANCHY
+#undef _LZMA_PROB32
+#undef CProb
+#define CProb UInt16
+#define lzmadec lzmadec_bl16
+#define lzmadec_init lzmadec_init_bl16
+#define lzmadec_reset lzmadec_reset_bl16
+#define lzmadec_decode lzmadec_decode_bl16
+#undef _LZMADEC_H_
+#undef LZMADEC_BITS
+#undef LZMADEC_CONFIG
+#undef GET_BIT
+#include "lzma/lzmadec.c"
+static const char lzmadecConfig_bl16[] = LZMADEC_CONFIG;
+#undef lzmadec
+#undef lzmadec_init
+#undef lzmadec_reset
+#undef lzmadec_decode
+
+#undef LZMADEC_BRANCHY
+#undef _LZMA_PROB32
+#undef CProb
+#define LZMADEC_BRANCHY
+#define CProb UInt16
+#define lzmadec lzmadec_br16
+#define lzmadec_init lzmadec_init_br16
+#define lzmadec_reset lzmadec_reset_br16
+#define lzmadec_decode lzmadec_decode_br16
+#undef _LZMADEC_H_
+#undef LZMADEC_BITS
+#undef LZMADEC_CONFIG
+#undef GET_BIT
+#include "lzma/lzmadec.c"
+static const char lzmadecConfig_br16[] = LZMADEC_CONFIG;
+#undef lzmadec
+#undef lzmadec_init
+#undef lzmadec_reset
+#undef lzmadec_decode
+
+#undef LZMADEC_BRANCHY
+#undef _LZMA_PROB32
+#undef CProb
+#define _LZMA_PROB32
+#define CProb UInt32
+#define lzmadec lzmadec_bl32
+#define lzmadec_init lzmadec_init_bl32
+#define lzmadec_reset lzmadec_reset_bl32
+#define lzmadec_decode lzmadec_decode_bl32
+#undef _LZMADEC_H_
+#undef LZMADEC_BITS
+#undef LZMADEC_CONFIG
+#undef GET_BIT
+#include "lzma/lzmadec.c"
+static const char lzmadecConfig_bl32[] = LZMADEC_CONFIG;
+#undef lzmadec
+#undef lzmadec_init
+#undef lzmadec_reset
+#undef lzmadec_decode
+
+#undef LZMADEC_BRANCHY
+#undef _LZMA_PROB32
+#undef CProb
+#define LZMADEC_BRANCHY
+#define _LZMA_PROB32
+#define CProb UInt32
+#define lzmadec lzmadec_br32
+#define lzmadec_init lzmadec_init_br32
+#define lzmadec_reset lzmadec_reset_br32
+#define lzmadec_decode lzmadec_decode_br32
+#undef _LZMADEC_H_
+#undef LZMADEC_BITS
+#undef LZMADEC_CONFIG
+#undef GET_BIT
+#include "lzma/lzmadec.c"
+static const char lzmadecConfig_br32[] = LZMADEC_CONFIG;
+#undef lzmadec
+#undef lzmadec_init
+#undef lzmadec_reset
+#undef lzmadec_decode
+
+/* back to the configuration built */
+#undef LZMADEC_BRANCHY
+#undef _LZMA_PROB32
+#undef CProb
+#ifdef BUILT_PROB32
+#define _LZMA_PROB32
+#define CProb UInt32
+#else
+#define CProb UInt16
+#endif
+
+/* lzma alone format, input supplied from memory by callback */
+typedef struct lzmaBench
+{
+  ILzmaInCallback InCallback;
+  const unsigned char *data;
+  SizeT size;
+  CLzmaDecoderState state;
+  UInt32 *probs;             /* for lzmadec, room for either width */
+  unsigned char *padded;     /* stream data, LZMADEC_INMAX zeros after */
+  const char *fname;
+} lzmaBench;
+
+static int lzmaRead(void *object, const unsigned char **buffer, SizeT *size)
+{
+  lzmaBench *b = (lzmaBench *)object;
+  *buffer = b->data;
+  *size = b->size;
+  b->size = 0;
+  return LZMA_RESULT_OK;
+}
+
+static long lzmaCorpus(corpus *c)
+{
+  lzmaBench *b = (lzmaBench *)c->state;
+  SizeT outProcessed;
+
+  b->data = c->in + LZMA_PROPERTIES_SIZE + 8;
+  b->size = (SizeT)(c->inSize - LZMA_PROPERTIES_SIZE - 8);
+  LzmaDecoderInit(&b->state);
+  if (LzmaDecode(&b->state, &b->InCallback, c->out, (SizeT)c->outSize, &outProcessed) != LZMA_RESULT_OK)
+    return -1;
+  return (long)outProcessed;
+}
+
+static unsigned long k_lzma(void *arg, long iters)
+{
+  corpus *c = (corpus *)arg;
+  unsigned long r = 0;
+  long i;
+  for (i = 0; i < iters; i++)
+    r += lzmaCorpus(c);
+  return r;
+}
+
+/* lzmadec configuration v with the output buffer as its dictionary */
+#define LZMADEC_KERNEL(v) \
+static long lzmadecCorpus_##v(corpus *c) \
+{ \
+  lzmaBench *b = (lzmaBench *)c->state; \
+  long inSize = c->inSize - LZMA_PROPERTIES_SIZE - 8; \
+  const unsigned char *in = b->padded; \
+  lzmadec_##v d; \
+  int status; \
+ \
+  d.prop = b->state.Properties; \
+  d.probs = (void *)b->probs; \
+  d.dic = c->out; \
+  d.dicSize = (UInt32)c->outSize; \
+  lzmadec_init_##v(&d); \
+  status = lzmadec_decode_##v(&d, (UInt32)c->outSize, &in, b->padded + inSize + 1); \
+  if (((status != LZMADEC_OK) && (status != LZMADEC_END)) || (in > b->padded + inSize)) \
+    return -1; \
+  return (long)d.dicPos; \
+} \
+ \
+static unsigned long k_lzmadec_##v(void *arg, long iters) \
+{ \
+  corpus *c = (corpus *)arg; \
+  unsigned long r = 0; \
+  long i; \
+  for (i = 0; i < iters; i++) \
+    r += lzmadecCorpus_##v(c); \
+  return r; \
+}
+
+LZMADEC_KERNEL(bl16)
+LZMADEC_KERNEL(br16)
+LZMADEC_KERNEL(bl32)
+LZMADEC_KERNEL(br32)
+
+static const struct {
+  const char *config;
+  long (*decode)(corpus *c);
+  kernel_fn fn;
+} lzmadecs[] = {
+  { lzmadecConfig_bl16, lzmadecCorpus_bl16, k_lzmadec_bl16 },
+  { lzmadecConfig_br16, lzmadecCorpus_br16, k_lzmadec_br16 },
+  { lzmadecConfig_bl32, lzmadecCorpus_bl32, k_lzmadec_bl32 },
+  { lzmadecConfig_br32, lzmadecCorpus_br32, k_lzmadec_br32 },
+};
+
+/* lzma.c reading the corpus file, as untar does, a block at a time */
+static unsigned long k_lzmaread(void *arg, long iters)
+{
+  corpus *c = (corpus *)arg;
+  lzmaBench *b = (lzmaBench *)c->state;
+  unsigned long r = 0;
+  long i;
+  for (i = 0; i < iters; i++)
+  {
+    gzFile f = gzopen(b->fname, "rb");
+    struct LZMAFile *l;
+    long n;
+    if (f == NULL) return 0;
+    if (lzma_init(f, &l, 0) == 0)
+      while ((n = lzma_read(l, c->out, BLOCKSIZE)) > 0) r += n;
+    lzma_cleanup(l);
+    gzclose(f);
+  }
+  return r;
+}
+
+static unsigned long k_lzmareadptr(void *arg, long iters)
+{
+  corpus *c = (corpus *)arg;
+  lzmaBench *b = (lzmaBench *)c->state;
+  unsigned long r = 0;
+  long i;
+  for (i = 0; i < iters; i++)
+  {
+    gzFile f = gzopen(b->fname, "rb");
+    struct LZMAFile *l;
+    const unsigned char *p;
+    long n;
+    if (f == NULL) return 0;
+    if (lzma_init(f, &l, 0) == 0)
+      while ((n = lzma_readptr(l, &p, BLOCKSIZE)) > 0) r += n + p[0];
+    lzma_cleanup(l);
+    gzclose(f);
+  }
+  return r;
+}
+
+/* xz.c reading the corpus file a block at a time, blocks decoded on
+   threads threads; returns crc of the output, its size in *size (-1 if
+   unusable) */
+static unsigned long xzReadptr(const char *fname, int threads, long iters, long *size)
+{
+  unsigned long r = 0;
+  long i;
+  *size = 0;
+  for (i = 0; i < iters; i++)
+  {
+    gzFile f = gzopen(fname, "rb");
+    struct XZFile *x;
+    const unsigned char *p;
+    long n;
+    if (f == NULL) return 0;
+    if (xz_init(f, &x, 0, threads) == 0)
+      while ((n = xz_readptr(x, &p, BLOCKSIZE)) > 0)
+      {
+        r = crc32(r, p, n);
+        *size += n;
+      }
+    else
+      *size = -1;
+    xz_cleanup(x);
+    gzclose(f);
+  }
+  return r;
+}
+
+/* zstd.c likewise, frames decoded on threads threads */
+static unsigned long zstdReadptr(const char *fname, int threads, long iters, long *size)
+{
+  unsigned long r = 0;
+  long i;
+  *size = 0;
+  for (i = 0; i < iters; i++)
+  {
+    gzFile f = gzopen(fname, "rb");
+    struct ZSTDFile *z;
+    const unsigned char *p;
+    long n;
+    if (f == NULL) return 0;
+    if (zstd_init(f, &z, 0, threads) == 0)
+      while ((n = zstd_readptr(z, &p, BLOCKSIZE)) > 0)
+      {
+        r = crc32(r, p, n);
+        *size += n;
+      }
+    else
+      *size = -1;
+    zstd_cleanup(z);
+    gzclose(f);
+  }
+  return r;
+}
+
+/* corpus and threads for the xz and zstd kernels */
+typedef struct xzBench
+{
+  const char *fname;
+  int threads;
+} xzBench;
+
+static unsigned long k_xzreadptr(void *arg, long iters)
+{
+  xzBench *b = (xzBench *)arg;
+  long size;
+  return xzReadptr(b->fname, b->threads, iters, &size);
+}
+
+static unsigned long k_zstdreadptr(void *arg, long iters)
+{
+  xzBench *b = (xzBench *)arg;
+  long size;
+  return zstdReadptr(b->fname, b->threads, iters, &size);
+}
+
+/* lz4.c likewise */
+static unsigned long lz4Readptr(const char *fname, long iters, long *size)
+{
+  unsigned long r = 0;
+  long i;
+  *size = 0;
+  for (i = 0; i < iters; i++)
+  {
+    gzFile f = gzopen(fname, "rb");
+    struct LZ4File *z;
+    const unsigned char *p;
+    long n;
+    if (f == NULL) return 0;
+    if (lz4_init(f, &z, 0) == 0)
+      while ((n = lz4_readptr(z, &p, BLOCKSIZE)) > 0)
+      {
+        r = crc32(r, p, n);
+        *size += n;
+      }
+    else
+      *size = -1;
+    lz4_cleanup(z);
+    gzclose(f);
+  }
+  return r;
+}
+
+static unsigned long k_lz4readptr(void *arg, long iters)
+{
+  long size;
+  return lz4Readptr((const char *)arg, iters, &size);
+}
+
+/* loads corpus and sizes output buffer, returns 0 if unusable */
+static int loadCorpus(corpus *c, const char *fname, long maxOut)
+{
+  memset(c, 0, sizeof(*c));
+  if ((c->in = loadFile(fname, &c->inSize)) == NULL)
+  {
+    printf("%-32s unable to read %s\n", "", fname);
+    return 0;
+  }
+  c->outSize = maxOut;
+  c->out = (unsigned char *)malloc(maxOut);
+  return c->out != NULL;
+}
+
+static void benchInflate(const char *fname)
+{
+  corpus c;
+  unsigned long crc = 0, stored;
+  long isize;
+  if (!loadCorpus(&c, fname, 0)) return;
+  free(c.out);
+  /* gzip trailer holds uncompressed size (mod 2^32) */
+  isize = (long)(c.in[c.inSize-4] | (c.in[c.inSize-3] << 8) | (c.in[c.inSize-2] << 16) | ((unsigned long)c.in[c.inSize-1] << 24));
+  c.outSize = isize;
+  stored = c.in[c.inSize-8] | (c.in[c.inSize-7] << 8) | (c.in[c.inSize-6] << 16) | ((unsigned long)c.in[c.inSize-5] << 24);
+  c.out = (unsigned char *)malloc(isize + 1);
+  if ((c.out == NULL) || (inflateCorpus(&c, &crc, 0) != isize))
+    printf("%-32s %s is not a usable gzip corpus\n", "inflate", fname);
+  else if (crc != stored)
+    printf("%-32s %s inflates to data not matching its crc\n", "inflate", fname);
+  else
+  {
+    crc = 0;
+    if ((inflateCorpus(&c, &crc, BLOCKSIZE) != isize) || (crc != stored))
+      printf("%-32s %s inflates to different data a block at a time\n", "inflate", fname);
+    run("inflate (inflate_fast)", k_inflate, &c, (double)isize);
+    run("inflate (512 byte pieces)", k_inflate512, &c, (double)isize);
+    c.state = (void *)fname;
+    run("gzread (512 byte blocks)", k_gzread, &c, (double)isize);
+    run("gzreadptr (512 byte blocks)", k_gzreadptr, &c, (double)isize);
+  }
+  free(c.in); free(c.out);
+}
+
+static void benchBz2(const char *fname)
+{
+  corpus c;
+  long outSize;
+  if (!loadCorpus(&c, fname, 256L << 20)) return;
+  if ((outSize = bz2Corpus(&c)) < 0)
+    printf("%-32s %s is not a usable bzip2 corpus\n", "bzip2", fname);
+  else
+  {
+    c.outSize = outSize + 1;
+    run("bzip2 (unRLE_obuf_to_output)", k_bz2, &c, (double)outSize);
+  }
+  free(c.in); free(c.out);
+}
+
+static void benchLzma(const char *fname)
+{
+  corpus c;
+  lzmaBench b;
+  long outSize = 0;
+  int i;
+
+  if (!loadCorpus(&c, fname, 0)) return;
+  free(c.out);
+  c.out = NULL;
+  memset(&b, 0, sizeof(b));
+  b.InCallback.Read = lzmaRead;
+  c.state = &b;
+  /* uncompressed size from header, or -1 if unknown (end marker used) */
+  for (i = 0; (i < 4) && (c.inSize > LZMA_PROPERTIES_SIZE + 8); i++)
+    outSize |= (long)c.in[LZMA_PROPERTIES_SIZE+i] << (i * 8);
+  if (c.in[LZMA_PROPERTIES_SIZE+7] == 0xFF) outSize = 256L << 20;
+  if ((c.inSize > LZMA_PROPERTIES_SIZE + 8) && (outSize > 0) &&
+      (LzmaDecodeProperties(&b.state.Properties, c.in, LZMA_PROPERTIES_SIZE) == LZMA_RESULT_OK) &&
+      ((b.state.Probs = (CProb *)malloc(LzmaGetNumProbs(&b.state.Properties) * sizeof(CProb))) != NULL) &&
+      ((b.state.Dictionary = (unsigned char *)malloc(b.state.Properties.DictionarySize)) != NULL) &&
+      ((c.out = (unsigned char *)malloc(outSize)) != NULL))
+  {
+    c.outSize = outSize;
+    if ((outSize = lzmaCorpus(&c)) > 0)
+      run("lzma (LzmaDecode)", k_lzma, &c, (double)outSize);
+    else
+      outSize = 0;
+  }
+  else
+    outSize = 0;
+  if (outSize == 0)
+    printf("%-32s %s is not a usable lzma corpus\n", "lzma", fname);
+  else if (((b.padded = (unsigned char *)malloc(c.inSize + LZMADEC_INMAX)) != NULL) &&
+           ((b.probs = (UInt32 *)malloc(LzmaGetNumProbs(&b.state.Properties) * sizeof(UInt32))) != NULL))
+  {
+    /* same data from each lzmadec configuration, the one built starred */
+    unsigned char *ref = c.out;
+    long inSize = c.inSize - LZMA_PROPERTIES_SIZE - 8;
+    char name[64];
+    unsigned v;
+
+    memcpy(b.padded, c.in + LZMA_PROPERTIES_SIZE + 8, inSize);
+    memset(b.padded + inSize, 0, LZMADEC_INMAX);
+    if ((c.out = (unsigned char *)malloc(c.outSize)) != NULL)
+    {
+      for (v = 0; v < sizeof(lzmadecs) / sizeof(lzmadecs[0]); v++)
+      {
+        sprintf(name, "lzmadec (%s)%s", lzmadecs[v].config,
+                (strcmp(lzmadecs[v].config, lzmadecBuilt) == 0) ? "*" : "");
+        if ((lzmadecs[v].decode(&c) != outSize) || (memcmp(c.out, ref, outSize) != 0))
+          printf("%-32s %s decodes to different data\n", name, fname);
+        else
+          run(name, lzmadecs[v].fn, &c, (double)outSize);
+      }
+      b.fname = fname;
+      run("lzma_read (512 byte blocks)", k_lzmaread, &c, (double)outSize);
+      run("lzma_readptr (512 byte blocks)", k_lzmareadptr, &c, (double)outSize);
+      free(c.out);
+    }
+    c.out = ref;
+  }
+  free(b.padded); free(b.probs);
+  free(b.state.Probs); free(b.state.Dictionary);
+  free(c.in); free(c.out);
+}
+
+static void benchXz(const char *fname)
+{
+  xzBench b;
+  unsigned long crc;
+  long outSize, size;
+  char name[64];
+
+  b.fname = fname;
+  b.threads = thread_cpus();
+  crc = xzReadptr(fname, 1, 1, &outSize);
+  if (outSize <= 0)
+    printf("%-32s %s is not a usable xz corpus\n", "xz", fname);
+  else if ((b.threads > 1) && ((xzReadptr(fname, b.threads, 1, &size) != crc) || (size != outSize)))
+    printf("%-32s %s decodes to different data in parallel\n", "xz", fname);
+  else
+  {
+    b.threads = 1;
+    run("xz_readptr (1 thread)", k_xzreadptr, &b, (double)outSize);
+    if ((b.threads = thread_cpus()) > 1)
+    {
+      sprintf(name, "xz_readptr (%d threads)", b.threads);
+      run(name, k_xzreadptr, &b, (double)outSize);
+    }
+  }
+}
+
+static void benchZstd(const char *fname)
+{
+  xzBench b;
+  unsigned long crc;
+  long outSize, size;
+  char name[64];
+
+  b.fname = fname;
+  b.threads = thread_cpus();
+  crc = zstdReadptr(fname, 1, 1, &outSize);
+  if (outSize <= 0)
+    printf("%-32s %s is not a usable zstd corpus\n", "zstd", fname);
+  else if ((b.threads > 1) && ((zstdReadptr(fname, b.threads, 1, &size) != crc) || (size != outSize)))
+    printf("%-32s %s decodes to different data in parallel\n", "zstd", fname);
+  else
+  {
+    b.threads = 1;
+    run("zstd_readptr (1 thread)", k_zstdreadptr, &b, (double)outSize);
+    if ((b.threads = thread_cpus()) > 1)
+    {
+      sprintf(name, "zstd_readptr (%d threads)", b.threads);
+      run(name, k_zstdreadptr, &b, (double)outSize);
+    }
+  }
+}
+
+static void benchLz4(const char *fname)
+{
+  long outSize;
+
+  lz4Readptr(fname, 1, &outSize);
+  if (outSize <= 0)
+    printf("%-32s %s is not a usable lz4 corpus\n", "lz4", fname);
+  else
+    run("lz4_readptr", k_lz4readptr, (void *)fname, (double)outSize);
+}
+
+
+/*** crc kernels ***/
+
+typedef struct crcArg
+{
+  unsigned char *buf;
+  long len;
+} crcArg;
+
+static unsigned long k_crc32(void *arg, long iters)
+{
+  crcArg *a = (crcArg *)arg;
+  unsigned long c = 0;
+  long i;
+  for (i = 0; i < iters; i++)
+    c = crc32(c, a->buf, (uInt)a->len);
+  return c;
+}
+
+static unsigned long k_bz2crc(void *arg, long iters)
+{
+  crcArg *a = (crcArg *)arg;
+  UInt32 c = 0xFFFFFFFFUL;
+  long i;
+  for (i = 0; i < iters; i++)
+    c = BZ2_crcBlock(c, a->buf, (Int32)a->len);
+  return c;
+}
+
+static void benchCrc(void)
+{
+  static const long sizes[] = { BLOCKSIZE, 16384, 1 << 20 };
+  crcArg a;
+  char name[64];
+  long i;
+
+  if ((a.buf = (unsigned char *)malloc(1 << 20)) == NULL) return;
+  for (i = 0; i < (1 << 20); i++) a.buf[i] = (unsigned char)(i * 7 + (i >> 9));
+  for (i = 0; i < 3; i++)
+  {
+    a.len = sizes[i];
+    sprintf(name, "crc32 (gzip) %ld", a.len);
+    run(name, k_crc32, &a, (double)a.len);
+    sprintf(name, "BZ2_crcBlock (bzip2) %ld", a.len);
+    run(name, k_bz2crc, &a, (double)a.len);
+  }
+  free(a.buf);
+}
+
+
+/*** miniclib memory kernels ***/
+
+typedef struct memArg
+{
+  void *(*fn)(void *, const void *, size_t);
+  unsigned char *buf;
+  size_t len;
+  int shift;  /* offset between source and destination */
+} memArg;
+
+static unsigned long k_mem(void *arg, long iters)
+{
+  memArg *m = (memArg *)arg;
+  unsigned char *src = m->buf + 64;
+  unsigned char *dst = src + m->shift;
+  long i;
+  for (i = 0; i < iters; i++)
+    m->fn(dst, src, m->len);
+  return dst[m->len - 1];
+}
+
+static void benchMem(void)
+{
+  static const size_t sizes[] = { BLOCKSIZE, 16384, 1 << 20 };
+  memArg m;
+  char name[64];
+  int i;
+
+  m.buf = (unsigned char *)malloc((2 << 20) + 256);
+  if (m.buf == NULL) return;
+  memset(m.buf, 0x5A, (2 << 20) + 256);
+  for (i = 0; i < 3; i++)
+  {
+    m.len = sizes[i];
+    m.shift = (int)m.len + 64;
+    m.fn = mc_memcpy;
+    sprintf(name, "miniclib memcpy %lu", (unsigned long)m.len);
+    run(name, k_mem, &m, (double)m.len);
+    m.fn = memcpy;
+    sprintf(name, "host memcpy %lu", (unsigned long)m.len);
+    run(name, k_mem, &m, (double)m.len);
+    /* overlapping, as when stripping a path in place */
+    m.shift = -3;
+    m.fn = mc_memmove;
+    sprintf(name, "miniclib memmove %lu", (unsigned long)m.len);
+    run(name, k_mem, &m, (double)m.len);
+    m.fn = memmove;
+    sprintf(name, "host memmove %lu", (unsigned long)m.len);
+    run(name, k_mem, &m, (double)m.len);
+  }
+  free(m.buf);
+}
+
+
+int main(int argc, char *argv[])
+{
+  const char *gzName = "examples/example.tgz";
+  const char *bz2Name = "examples/example.tbz";
+  const char *lzmaName = "examples/example.tlz";
+  const char *xzName = "examples/example.txz";
+  const char *zstdName = "examples/example.tzst";
+  const char *lz4Name = "examples/example.tlz4";
+  long fuzz = 0;
+  int i;
+
+  filterList = (char **)malloc(argc * sizeof(char *));
+  for (i = 1; i < argc; i++)
+  {
+    if ((strcmp(argv[i], "-t") == 0) && (i+1 < argc))
+      benchTime = atof(argv[++i]);
+    else if ((strcmp(argv[i], "-gz") == 0) && (i+1 < argc))
+      gzName = argv[++i];
+    else if ((strcmp(argv[i], "-bz2") == 0) && (i+1 < argc))
+      bz2Name = argv[++i];
+    else if ((strcmp(argv[i], "-lzma") == 0) && (i+1 < argc))
+      lzmaName = argv[++i];
+    else if ((strcmp(argv[i], "-xz") == 0) && (i+1 < argc))
+      xzName = argv[++i];
+    else if ((strcmp(argv[i], "-zst") == 0) && (i+1 < argc))
+      zstdName = argv[++i];
+    else if ((strcmp(argv[i], "-lz4") == 0) && (i+1 < argc))
+      lz4Name = argv[++i];
+    else if ((strcmp(argv[i], "-fuzz") == 0) && (i+1 < argc))
+      fuzz = atol(argv[++i]);
+    else if (*argv[i] == '-')
+    {
+      printf("usage: %s [-t seconds] [-gz file] [-bz2 file] [-lzma file] [-xz file] [-zst file] [-lz4 file] [kernel ...]\n", argv[0]);
+      printf("       %s -fuzz count\n", argv[0]);
+      return 1;
+    }
+    else
+      filterList[filterCnt++] = argv[i];
+  }
+
+  makeHeaders();
+  for (i = 0; i < HDRCNT; i++) getFullName(&headers[i], names[i]);
+  if (fuzz > 0)
+  {
+    free(filterList);
+    return (fuzzDecode(fuzz) != 0) | (fuzzCrc(fuzz / 100 + 1) != 0) | (fuzzPool(fuzz / 10000 + 1) != 0);
+  }
+
+  run("valid_checksum", k_valid_checksum, NULL, BLOCKSIZE);
+  run("getoct (size+mtime)", k_getoct, NULL, 24);
+  run("tar_decode (all fields)", k_tar_decode, NULL, BLOCKSIZE);
+  run("getFullName", k_getFullName, NULL, 0);
+  run("stripPath", k_stripPath, NULL, 0);
+  run("ExprMatch", k_ExprMatch, NULL, 0);
+  run("matchname (6 patterns)", k_matchname, NULL, 0);
+  {
+    static char zeros[8 * BLOCKSIZE];
+    run("zeroblock (zero)", k_zeroblock, zeros, sizeof(zeros));
+    zeros[sizeof(zeros) - 1] = 1;
+    run("zeroblock (nonzero at end)", k_zeroblock, zeros, sizeof(zeros));
+  }
+
+  benchInflate(gzName);
+  benchBz2(bz2Name);
+  benchLzma(lzmaName);
+  benchXz(xzName);
+  benchZstd(zstdName);
+  benchLz4(lz4Name);
+
+  benchCrc();
+  benchMem();
+
+  free(filterList);
+  return 0;
+}
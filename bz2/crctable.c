@@ -139,6 +139,1166 @@ UInt32 BZ2_crc32Table[256] = {
 };
 
 
+/*--
+  The same for a byte followed by one to fifteen zero bytes, so that
+  BZ2_crcBlock can take sixteen bytes at a time.
+--*/
+
+UInt32 BZ2_crc32Slice[15][256] = {
+   {
+   0x00000000L, 0xd219c1dcL, 0xa0f29e0fL, 0x72eb5fd3L,
+   0x452421a9L, 0x973de075L, 0xe5d6bfa6L, 0x37cf7e7aL,
+   0x8a484352L, 0x5851828eL, 0x2abadd5dL, 0xf8a31c81L,
+   0xcf6c62fbL, 0x1d75a327L, 0x6f9efcf4L, 0xbd873d28L,
+   0x10519b13L, 0xc2485acfL, 0xb0a3051cL, 0x62bac4c0L,
+   0x5575babaL, 0x876c7b66L, 0xf58724b5L, 0x279ee569L,
+   0x9a19d841L, 0x4800199dL, 0x3aeb464eL, 0xe8f28792L,
+   0xdf3df9e8L, 0x0d243834L, 0x7fcf67e7L, 0xadd6a63bL,
+   0x20a33626L, 0xf2baf7faL, 0x8051a829L, 0x524869f5L,
+   0x6587178fL, 0xb79ed653L, 0xc5758980L, 0x176c485cL,
+   0xaaeb7574L, 0x78f2b4a8L, 0x0a19eb7bL, 0xd8002aa7L,
+   0xefcf54ddL, 0x3dd69501L, 0x4f3dcad2L, 0x9d240b0eL,
+   0x30f2ad35L, 0xe2eb6ce9L, 0x9000333aL, 0x4219f2e6L,
+   0x75d68c9cL, 0xa7cf4d40L, 0xd5241293L, 0x073dd34fL,
+   0xbabaee67L, 0x68a32fbbL, 0x1a487068L, 0xc851b1b4L,
+   0xff9ecfceL, 0x2d870e12L, 0x5f6c51c1L, 0x8d75901dL,
+   0x41466c4cL, 0x935fad90L, 0xe1b4f243L, 0x33ad339fL,
+   0x04624de5L, 0xd67b8c39L, 0xa490d3eaL, 0x76891236L,
+   0xcb0e2f1eL, 0x1917eec2L, 0x6bfcb111L, 0xb9e570cdL,
+   0x8e2a0eb7L, 0x5c33cf6bL, 0x2ed890b8L, 0xfcc15164L,
+   0x5117f75fL, 0x830e3683L, 0xf1e56950L, 0x23fca88cL,
+   0x1433d6f6L, 0xc62a172aL, 0xb4c148f9L, 0x66d88925L,
+   0xdb5fb40dL, 0x094675d1L, 0x7bad2a02L, 0xa9b4ebdeL,
+   0x9e7b95a4L, 0x4c625478L, 0x3e890babL, 0xec90ca77L,
+   0x61e55a6aL, 0xb3fc9bb6L, 0xc117c465L, 0x130e05b9L,
+   0x24c17bc3L, 0xf6d8ba1fL, 0x8433e5ccL, 0x562a2410L,
+   0xebad1938L, 0x39b4d8e4L, 0x4b5f8737L, 0x994646ebL,
+   0xae893891L, 0x7c90f94dL, 0x0e7ba69eL, 0xdc626742L,
+   0x71b4c179L, 0xa3ad00a5L, 0xd1465f76L, 0x035f9eaaL,
+   0x3490e0d0L, 0xe689210cL, 0x94627edfL, 0x467bbf03L,
+   0xfbfc822bL, 0x29e543f7L, 0x5b0e1c24L, 0x8917ddf8L,
+   0xbed8a382L, 0x6cc1625eL, 0x1e2a3d8dL, 0xcc33fc51L,
+   0x828cd898L, 0x50951944L, 0x227e4697L, 0xf067874bL,
+   0xc7a8f931L, 0x15b138edL, 0x675a673eL, 0xb543a6e2L,
+   0x08c49bcaL, 0xdadd5a16L, 0xa83605c5L, 0x7a2fc419L,
+   0x4de0ba63L, 0x9ff97bbfL, 0xed12246cL, 0x3f0be5b0L,
+   0x92dd438bL, 0x40c48257L, 0x322fdd84L, 0xe0361c58L,
+   0xd7f96222L, 0x05e0a3feL, 0x770bfc2dL, 0xa5123df1L,
+   0x189500d9L, 0xca8cc105L, 0xb8679ed6L, 0x6a7e5f0aL,
+   0x5db12170L, 0x8fa8e0acL, 0xfd43bf7fL, 0x2f5a7ea3L,
+   0xa22feebeL, 0x70362f62L, 0x02dd70b1L, 0xd0c4b16dL,
+   0xe70bcf17L, 0x35120ecbL, 0x47f95118L, 0x95e090c4L,
+   0x2867adecL, 0xfa7e6c30L, 0x889533e3L, 0x5a8cf23fL,
+   0x6d438c45L, 0xbf5a4d99L, 0xcdb1124aL, 0x1fa8d396L,
+   0xb27e75adL, 0x6067b471L, 0x128ceba2L, 0xc0952a7eL,
+   0xf75a5404L, 0x254395d8L, 0x57a8ca0bL, 0x85b10bd7L,
+   0x383636ffL, 0xea2ff723L, 0x98c4a8f0L, 0x4add692cL,
+   0x7d121756L, 0xaf0bd68aL, 0xdde08959L, 0x0ff94885L,
+   0xc3cab4d4L, 0x11d37508L, 0x63382adbL, 0xb121eb07L,
+   0x86ee957dL, 0x54f754a1L, 0x261c0b72L, 0xf405caaeL,
+   0x4982f786L, 0x9b9b365aL, 0xe9706989L, 0x3b69a855L,
+   0x0ca6d62fL, 0xdebf17f3L, 0xac544820L, 0x7e4d89fcL,
+   0xd39b2fc7L, 0x0182ee1bL, 0x7369b1c8L, 0xa1707014L,
+   0x96bf0e6eL, 0x44a6cfb2L, 0x364d9061L, 0xe45451bdL,
+   0x59d36c95L, 0x8bcaad49L, 0xf921f29aL, 0x2b383346L,
+   0x1cf74d3cL, 0xceee8ce0L, 0xbc05d333L, 0x6e1c12efL,
+   0xe36982f2L, 0x3170432eL, 0x439b1cfdL, 0x9182dd21L,
+   0xa64da35bL, 0x74546287L, 0x06bf3d54L, 0xd4a6fc88L,
+   0x6921c1a0L, 0xbb38007cL, 0xc9d35fafL, 0x1bca9e73L,
+   0x2c05e009L, 0xfe1c21d5L, 0x8cf77e06L, 0x5eeebfdaL,
+   0xf33819e1L, 0x2121d83dL, 0x53ca87eeL, 0x81d34632L,
+   0xb61c3848L, 0x6405f994L, 0x16eea647L, 0xc4f7679bL,
+   0x79705ab3L, 0xab699b6fL, 0xd982c4bcL, 0x0b9b0560L,
+   0x3c547b1aL, 0xee4dbac6L, 0x9ca6e515L, 0x4ebf24c9L
+   },
+   {
+   0x00000000L, 0x01d8ac87L, 0x03b1590eL, 0x0269f589L,
+   0x0762b21cL, 0x06ba1e9bL, 0x04d3eb12L, 0x050b4795L,
+   0x0ec56438L, 0x0f1dc8bfL, 0x0d743d36L, 0x0cac91b1L,
+   0x09a7d624L, 0x087f7aa3L, 0x0a168f2aL, 0x0bce23adL,
+   0x1d8ac870L, 0x1c5264f7L, 0x1e3b917eL, 0x1fe33df9L,
+   0x1ae87a6cL, 0x1b30d6ebL, 0x19592362L, 0x18818fe5L,
+   0x134fac48L, 0x129700cfL, 0x10fef546L, 0x112659c1L,
+   0x142d1e54L, 0x15f5b2d3L, 0x179c475aL, 0x1644ebddL,
+   0x3b1590e0L, 0x3acd3c67L, 0x38a4c9eeL, 0x397c6569L,
+   0x3c7722fcL, 0x3daf8e7bL, 0x3fc67bf2L, 0x3e1ed775L,
+   0x35d0f4d8L, 0x3408585fL, 0x3661add6L, 0x37b90151L,
+   0x32b246c4L, 0x336aea43L, 0x31031fcaL, 0x30dbb34dL,
+   0x269f5890L, 0x2747f417L, 0x252e019eL, 0x24f6ad19L,
+   0x21fdea8cL, 0x2025460bL, 0x224cb382L, 0x23941f05L,
+   0x285a3ca8L, 0x2982902fL, 0x2beb65a6L, 0x2a33c921L,
+   0x2f388eb4L, 0x2ee02233L, 0x2c89d7baL, 0x2d517b3dL,
+   0x762b21c0L, 0x77f38d47L, 0x759a78ceL, 0x7442d449L,
+   0x714993dcL, 0x70913f5bL, 0x72f8cad2L, 0x73206655L,
+   0x78ee45f8L, 0x7936e97fL, 0x7b5f1cf6L, 0x7a87b071L,
+   0x7f8cf7e4L, 0x7e545b63L, 0x7c3daeeaL, 0x7de5026dL,
+   0x6ba1e9b0L, 0x6a794537L, 0x6810b0beL, 0x69c81c39L,
+   0x6cc35bacL, 0x6d1bf72bL, 0x6f7202a2L, 0x6eaaae25L,
+   0x65648d88L, 0x64bc210fL, 0x66d5d486L, 0x670d7801L,
+   0x62063f94L, 0x63de9313L, 0x61b7669aL, 0x606fca1dL,
+   0x4d3eb120L, 0x4ce61da7L, 0x4e8fe82eL, 0x4f5744a9L,
+   0x4a5c033cL, 0x4b84afbbL, 0x49ed5a32L, 0x4835f6b5L,
+   0x43fbd518L, 0x4223799fL, 0x404a8c16L, 0x41922091L,
+   0x44996704L, 0x4541cb83L, 0x47283e0aL, 0x46f0928dL,
+   0x50b47950L, 0x516cd5d7L, 0x5305205eL, 0x52dd8cd9L,
+   0x57d6cb4cL, 0x560e67cbL, 0x54679242L, 0x55bf3ec5L,
+   0x5e711d68L, 0x5fa9b1efL, 0x5dc04466L, 0x5c18e8e1L,
+   0x5913af74L, 0x58cb03f3L, 0x5aa2f67aL, 0x5b7a5afdL,
+   0xec564380L, 0xed8eef07L, 0xefe71a8eL, 0xee3fb609L,
+   0xeb34f19cL, 0xeaec5d1bL, 0xe885a892L, 0xe95d0415L,
+   0xe29327b8L, 0xe34b8b3fL, 0xe1227eb6L, 0xe0fad231L,
+   0xe5f195a4L, 0xe4293923L, 0xe640ccaaL, 0xe798602dL,
+   0xf1dc8bf0L, 0xf0042777L, 0xf26dd2feL, 0xf3b57e79L,
+   0xf6be39ecL, 0xf766956bL, 0xf50f60e2L, 0xf4d7cc65L,
+   0xff19efc8L, 0xfec1434fL, 0xfca8b6c6L, 0xfd701a41L,
+   0xf87b5dd4L, 0xf9a3f153L, 0xfbca04daL, 0xfa12a85dL,
+   0xd743d360L, 0xd69b7fe7L, 0xd4f28a6eL, 0xd52a26e9L,
+   0xd021617cL, 0xd1f9cdfbL, 0xd3903872L, 0xd24894f5L,
+   0xd986b758L, 0xd85e1bdfL, 0xda37ee56L, 0xdbef42d1L,
+   0xdee40544L, 0xdf3ca9c3L, 0xdd555c4aL, 0xdc8df0cdL,
+   0xcac91b10L, 0xcb11b797L, 0xc978421eL, 0xc8a0ee99L,
+   0xcdaba90cL, 0xcc73058bL, 0xce1af002L, 0xcfc25c85L,
+   0xc40c7f28L, 0xc5d4d3afL, 0xc7bd2626L, 0xc6658aa1L,
+   0xc36ecd34L, 0xc2b661b3L, 0xc0df943aL, 0xc10738bdL,
+   0x9a7d6240L, 0x9ba5cec7L, 0x99cc3b4eL, 0x981497c9L,
+   0x9d1fd05cL, 0x9cc77cdbL, 0x9eae8952L, 0x9f7625d5L,
+   0x94b80678L, 0x9560aaffL, 0x97095f76L, 0x96d1f3f1L,
+   0x93dab464L, 0x920218e3L, 0x906bed6aL, 0x91b341edL,
+   0x87f7aa30L, 0x862f06b7L, 0x8446f33eL, 0x859e5fb9L,
+   0x8095182cL, 0x814db4abL, 0x83244122L, 0x82fceda5L,
+   0x8932ce08L, 0x88ea628fL, 0x8a839706L, 0x8b5b3b81L,
+   0x8e507c14L, 0x8f88d093L, 0x8de1251aL, 0x8c39899dL,
+   0xa168f2a0L, 0xa0b05e27L, 0xa2d9abaeL, 0xa3010729L,
+   0xa60a40bcL, 0xa7d2ec3bL, 0xa5bb19b2L, 0xa463b535L,
+   0xafad9698L, 0xae753a1fL, 0xac1ccf96L, 0xadc46311L,
+   0xa8cf2484L, 0xa9178803L, 0xab7e7d8aL, 0xaaa6d10dL,
+   0xbce23ad0L, 0xbd3a9657L, 0xbf5363deL, 0xbe8bcf59L,
+   0xbb8088ccL, 0xba58244bL, 0xb831d1c2L, 0xb9e97d45L,
+   0xb2275ee8L, 0xb3fff26fL, 0xb19607e6L, 0xb04eab61L,
+   0xb545ecf4L, 0xb49d4073L, 0xb6f4b5faL, 0xb72c197dL
+   },
+   {
+   0x00000000L, 0xdc6d9ab7L, 0xbc1a28d9L, 0x6077b26eL,
+   0x7cf54c05L, 0xa098d6b2L, 0xc0ef64dcL, 0x1c82fe6bL,
+   0xf9ea980aL, 0x258702bdL, 0x45f0b0d3L, 0x999d2a64L,
+   0x851fd40fL, 0x59724eb8L, 0x3905fcd6L, 0xe5686661L,
+   0xf7142da3L, 0x2b79b714L, 0x4b0e057aL, 0x97639fcdL,
+   0x8be161a6L, 0x578cfb11L, 0x37fb497fL, 0xeb96d3c8L,
+   0x0efeb5a9L, 0xd2932f1eL, 0xb2e49d70L, 0x6e8907c7L,
+   0x720bf9acL, 0xae66631bL, 0xce11d175L, 0x127c4bc2L,
+   0xeae946f1L, 0x3684dc46L, 0x56f36e28L, 0x8a9ef49fL,
+   0x961c0af4L, 0x4a719043L, 0x2a06222dL, 0xf66bb89aL,
+   0x1303defbL, 0xcf6e444cL, 0xaf19f622L, 0x73746c95L,
+   0x6ff692feL, 0xb39b0849L, 0xd3ecba27L, 0x0f812090L,
+   0x1dfd6b52L, 0xc190f1e5L, 0xa1e7438bL, 0x7d8ad93cL,
+   0x61082757L, 0xbd65bde0L, 0xdd120f8eL, 0x017f9539L,
+   0xe417f358L, 0x387a69efL, 0x580ddb81L, 0x84604136L,
+   0x98e2bf5dL, 0x448f25eaL, 0x24f89784L, 0xf8950d33L,
+   0xd1139055L, 0x0d7e0ae2L, 0x6d09b88cL, 0xb164223bL,
+   0xade6dc50L, 0x718b46e7L, 0x11fcf489L, 0xcd916e3eL,
+   0x28f9085fL, 0xf49492e8L, 0x94e32086L, 0x488eba31L,
+   0x540c445aL, 0x8861deedL, 0xe8166c83L, 0x347bf634L,
+   0x2607bdf6L, 0xfa6a2741L, 0x9a1d952fL, 0x46700f98L,
+   0x5af2f1f3L, 0x869f6b44L, 0xe6e8d92aL, 0x3a85439dL,
+   0xdfed25fcL, 0x0380bf4bL, 0x63f70d25L, 0xbf9a9792L,
+   0xa31869f9L, 0x7f75f34eL, 0x1f024120L, 0xc36fdb97L,
+   0x3bfad6a4L, 0xe7974c13L, 0x87e0fe7dL, 0x5b8d64caL,
+   0x470f9aa1L, 0x9b620016L, 0xfb15b278L, 0x277828cfL,
+   0xc2104eaeL, 0x1e7dd419L, 0x7e0a6677L, 0xa267fcc0L,
+   0xbee502abL, 0x6288981cL, 0x02ff2a72L, 0xde92b0c5L,
+   0xcceefb07L, 0x108361b0L, 0x70f4d3deL, 0xac994969L,
+   0xb01bb702L, 0x6c762db5L, 0x0c019fdbL, 0xd06c056cL,
+   0x3504630dL, 0xe969f9baL, 0x891e4bd4L, 0x5573d163L,
+   0x49f12f08L, 0x959cb5bfL, 0xf5eb07d1L, 0x29869d66L,
+   0xa6e63d1dL, 0x7a8ba7aaL, 0x1afc15c4L, 0xc6918f73L,
+   0xda137118L, 0x067eebafL, 0x660959c1L, 0xba64c376L,
+   0x5f0ca517L, 0x83613fa0L, 0xe3168dceL, 0x3f7b1779L,
+   0x23f9e912L, 0xff9473a5L, 0x9fe3c1cbL, 0x438e5b7cL,
+   0x51f210beL, 0x8d9f8a09L, 0xede83867L, 0x3185a2d0L,
+   0x2d075cbbL, 0xf16ac60cL, 0x911d7462L, 0x4d70eed5L,
+   0xa81888b4L, 0x74751203L, 0x1402a06dL, 0xc86f3adaL,
+   0xd4edc4b1L, 0x08805e06L, 0x68f7ec68L, 0xb49a76dfL,
+   0x4c0f7becL, 0x9062e15bL, 0xf0155335L, 0x2c78c982L,
+   0x30fa37e9L, 0xec97ad5eL, 0x8ce01f30L, 0x508d8587L,
+   0xb5e5e3e6L, 0x69887951L, 0x09ffcb3fL, 0xd5925188L,
+   0xc910afe3L, 0x157d3554L, 0x750a873aL, 0xa9671d8dL,
+   0xbb1b564fL, 0x6776ccf8L, 0x07017e96L, 0xdb6ce421L,
+   0xc7ee1a4aL, 0x1b8380fdL, 0x7bf43293L, 0xa799a824L,
+   0x42f1ce45L, 0x9e9c54f2L, 0xfeebe69cL, 0x22867c2bL,
+   0x3e048240L, 0xe26918f7L, 0x821eaa99L, 0x5e73302eL,
+   0x77f5ad48L, 0xab9837ffL, 0xcbef8591L, 0x17821f26L,
+   0x0b00e14dL, 0xd76d7bfaL, 0xb71ac994L, 0x6b775323L,
+   0x8e1f3542L, 0x5272aff5L, 0x32051d9bL, 0xee68872cL,
+   0xf2ea7947L, 0x2e87e3f0L, 0x4ef0519eL, 0x929dcb29L,
+   0x80e180ebL, 0x5c8c1a5cL, 0x3cfba832L, 0xe0963285L,
+   0xfc14cceeL, 0x20795659L, 0x400ee437L, 0x9c637e80L,
+   0x790b18e1L, 0xa5668256L, 0xc5113038L, 0x197caa8fL,
+   0x05fe54e4L, 0xd993ce53L, 0xb9e47c3dL, 0x6589e68aL,
+   0x9d1cebb9L, 0x4171710eL, 0x2106c360L, 0xfd6b59d7L,
+   0xe1e9a7bcL, 0x3d843d0bL, 0x5df38f65L, 0x819e15d2L,
+   0x64f673b3L, 0xb89be904L, 0xd8ec5b6aL, 0x0481c1ddL,
+   0x18033fb6L, 0xc46ea501L, 0xa419176fL, 0x78748dd8L,
+   0x6a08c61aL, 0xb6655cadL, 0xd612eec3L, 0x0a7f7474L,
+   0x16fd8a1fL, 0xca9010a8L, 0xaae7a2c6L, 0x768a3871L,
+   0x93e25e10L, 0x4f8fc4a7L, 0x2ff876c9L, 0xf395ec7eL,
+   0xef171215L, 0x337a88a2L, 0x530d3accL, 0x8f60a07bL
+   },
+   {
+   0x00000000L, 0x490d678dL, 0x921acf1aL, 0xdb17a897L,
+   0x20f48383L, 0x69f9e40eL, 0xb2ee4c99L, 0xfbe32b14L,
+   0x41e90706L, 0x08e4608bL, 0xd3f3c81cL, 0x9afeaf91L,
+   0x611d8485L, 0x2810e308L, 0xf3074b9fL, 0xba0a2c12L,
+   0x83d20e0cL, 0xcadf6981L, 0x11c8c116L, 0x58c5a69bL,
+   0xa3268d8fL, 0xea2bea02L, 0x313c4295L, 0x78312518L,
+   0xc23b090aL, 0x8b366e87L, 0x5021c610L, 0x192ca19dL,
+   0xe2cf8a89L, 0xabc2ed04L, 0x70d54593L, 0x39d8221eL,
+   0x036501afL, 0x4a686622L, 0x917fceb5L, 0xd872a938L,
+   0x2391822cL, 0x6a9ce5a1L, 0xb18b4d36L, 0xf8862abbL,
+   0x428c06a9L, 0x0b816124L, 0xd096c9b3L, 0x999bae3eL,
+   0x6278852aL, 0x2b75e2a7L, 0xf0624a30L, 0xb96f2dbdL,
+   0x80b70fa3L, 0xc9ba682eL, 0x12adc0b9L, 0x5ba0a734L,
+   0xa0438c20L, 0xe94eebadL, 0x3259433aL, 0x7b5424b7L,
+   0xc15e08a5L, 0x88536f28L, 0x5344c7bfL, 0x1a49a032L,
+   0xe1aa8b26L, 0xa8a7ecabL, 0x73b0443cL, 0x3abd23b1L,
+   0x06ca035eL, 0x4fc764d3L, 0x94d0cc44L, 0xddddabc9L,
+   0x263e80ddL, 0x6f33e750L, 0xb4244fc7L, 0xfd29284aL,
+   0x47230458L, 0x0e2e63d5L, 0xd539cb42L, 0x9c34accfL,
+   0x67d787dbL, 0x2edae056L, 0xf5cd48c1L, 0xbcc02f4cL,
+   0x85180d52L, 0xcc156adfL, 0x1702c248L, 0x5e0fa5c5L,
+   0xa5ec8ed1L, 0xece1e95cL, 0x37f641cbL, 0x7efb2646L,
+   0xc4f10a54L, 0x8dfc6dd9L, 0x56ebc54eL, 0x1fe6a2c3L,
+   0xe40589d7L, 0xad08ee5aL, 0x761f46cdL, 0x3f122140L,
+   0x05af02f1L, 0x4ca2657cL, 0x97b5cdebL, 0xdeb8aa66L,
+   0x255b8172L, 0x6c56e6ffL, 0xb7414e68L, 0xfe4c29e5L,
+   0x444605f7L, 0x0d4b627aL, 0xd65ccaedL, 0x9f51ad60L,
+   0x64b28674L, 0x2dbfe1f9L, 0xf6a8496eL, 0xbfa52ee3L,
+   0x867d0cfdL, 0xcf706b70L, 0x1467c3e7L, 0x5d6aa46aL,
+   0xa6898f7eL, 0xef84e8f3L, 0x34934064L, 0x7d9e27e9L,
+   0xc7940bfbL, 0x8e996c76L, 0x558ec4e1L, 0x1c83a36cL,
+   0xe7608878L, 0xae6deff5L, 0x757a4762L, 0x3c7720efL,
+   0x0d9406bcL, 0x44996131L, 0x9f8ec9a6L, 0xd683ae2bL,
+   0x2d60853fL, 0x646de2b2L, 0xbf7a4a25L, 0xf6772da8L,
+   0x4c7d01baL, 0x05706637L, 0xde67cea0L, 0x976aa92dL,
+   0x6c898239L, 0x2584e5b4L, 0xfe934d23L, 0xb79e2aaeL,
+   0x8e4608b0L, 0xc74b6f3dL, 0x1c5cc7aaL, 0x5551a027L,
+   0xaeb28b33L, 0xe7bfecbeL, 0x3ca84429L, 0x75a523a4L,
+   0xcfaf0fb6L, 0x86a2683bL, 0x5db5c0acL, 0x14b8a721L,
+   0xef5b8c35L, 0xa656ebb8L, 0x7d41432fL, 0x344c24a2L,
+   0x0ef10713L, 0x47fc609eL, 0x9cebc809L, 0xd5e6af84L,
+   0x2e058490L, 0x6708e31dL, 0xbc1f4b8aL, 0xf5122c07L,
+   0x4f180015L, 0x06156798L, 0xdd02cf0fL, 0x940fa882L,
+   0x6fec8396L, 0x26e1e41bL, 0xfdf64c8cL, 0xb4fb2b01L,
+   0x8d23091fL, 0xc42e6e92L, 0x1f39c605L, 0x5634a188L,
+   0xadd78a9cL, 0xe4daed11L, 0x3fcd4586L, 0x76c0220bL,
+   0xccca0e19L, 0x85c76994L, 0x5ed0c103L, 0x17dda68eL,
+   0xec3e8d9aL, 0xa533ea17L, 0x7e244280L, 0x3729250dL,
+   0x0b5e05e2L, 0x4253626fL, 0x9944caf8L, 0xd049ad75L,
+   0x2baa8661L, 0x62a7e1ecL, 0xb9b0497bL, 0xf0bd2ef6L,
+   0x4ab702e4L, 0x03ba6569L, 0xd8adcdfeL, 0x91a0aa73L,
+   0x6a438167L, 0x234ee6eaL, 0xf8594e7dL, 0xb15429f0L,
+   0x888c0beeL, 0xc1816c63L, 0x1a96c4f4L, 0x539ba379L,
+   0xa878886dL, 0xe175efe0L, 0x3a624777L, 0x736f20faL,
+   0xc9650ce8L, 0x80686b65L, 0x5b7fc3f2L, 0x1272a47fL,
+   0xe9918f6bL, 0xa09ce8e6L, 0x7b8b4071L, 0x328627fcL,
+   0x083b044dL, 0x413663c0L, 0x9a21cb57L, 0xd32cacdaL,
+   0x28cf87ceL, 0x61c2e043L, 0xbad548d4L, 0xf3d82f59L,
+   0x49d2034bL, 0x00df64c6L, 0xdbc8cc51L, 0x92c5abdcL,
+   0x692680c8L, 0x202be745L, 0xfb3c4fd2L, 0xb231285fL,
+   0x8be90a41L, 0xc2e46dccL, 0x19f3c55bL, 0x50fea2d6L,
+   0xab1d89c2L, 0xe210ee4fL, 0x390746d8L, 0x700a2155L,
+   0xca000d47L, 0x830d6acaL, 0x581ac25dL, 0x1117a5d0L,
+   0xeaf48ec4L, 0xa3f9e949L, 0x78ee41deL, 0x31e32653L
+   },
+   {
+   0x00000000L, 0x1b280d78L, 0x36501af0L, 0x2d781788L,
+   0x6ca035e0L, 0x77883898L, 0x5af02f10L, 0x41d82268L,
+   0xd9406bc0L, 0xc26866b8L, 0xef107130L, 0xf4387c48L,
+   0xb5e05e20L, 0xaec85358L, 0x83b044d0L, 0x989849a8L,
+   0xb641ca37L, 0xad69c74fL, 0x8011d0c7L, 0x9b39ddbfL,
+   0xdae1ffd7L, 0xc1c9f2afL, 0xecb1e527L, 0xf799e85fL,
+   0x6f01a1f7L, 0x7429ac8fL, 0x5951bb07L, 0x4279b67fL,
+   0x03a19417L, 0x1889996fL, 0x35f18ee7L, 0x2ed9839fL,
+   0x684289d9L, 0x736a84a1L, 0x5e129329L, 0x453a9e51L,
+   0x04e2bc39L, 0x1fcab141L, 0x32b2a6c9L, 0x299aabb1L,
+   0xb102e219L, 0xaa2aef61L, 0x8752f8e9L, 0x9c7af591L,
+   0xdda2d7f9L, 0xc68ada81L, 0xebf2cd09L, 0xf0dac071L,
+   0xde0343eeL, 0xc52b4e96L, 0xe853591eL, 0xf37b5466L,
+   0xb2a3760eL, 0xa98b7b76L, 0x84f36cfeL, 0x9fdb6186L,
+   0x0743282eL, 0x1c6b2556L, 0x311332deL, 0x2a3b3fa6L,
+   0x6be31dceL, 0x70cb10b6L, 0x5db3073eL, 0x469b0a46L,
+   0xd08513b2L, 0xcbad1ecaL, 0xe6d50942L, 0xfdfd043aL,
+   0xbc252652L, 0xa70d2b2aL, 0x8a753ca2L, 0x915d31daL,
+   0x09c57872L, 0x12ed750aL, 0x3f956282L, 0x24bd6ffaL,
+   0x65654d92L, 0x7e4d40eaL, 0x53355762L, 0x481d5a1aL,
+   0x66c4d985L, 0x7decd4fdL, 0x5094c375L, 0x4bbcce0dL,
+   0x0a64ec65L, 0x114ce11dL, 0x3c34f695L, 0x271cfbedL,
+   0xbf84b245L, 0xa4acbf3dL, 0x89d4a8b5L, 0x92fca5cdL,
+   0xd32487a5L, 0xc80c8addL, 0xe5749d55L, 0xfe5c902dL,
+   0xb8c79a6bL, 0xa3ef9713L, 0x8e97809bL, 0x95bf8de3L,
+   0xd467af8bL, 0xcf4fa2f3L, 0xe237b57bL, 0xf91fb803L,
+   0x6187f1abL, 0x7aaffcd3L, 0x57d7eb5bL, 0x4cffe623L,
+   0x0d27c44bL, 0x160fc933L, 0x3b77debbL, 0x205fd3c3L,
+   0x0e86505cL, 0x15ae5d24L, 0x38d64aacL, 0x23fe47d4L,
+   0x622665bcL, 0x790e68c4L, 0x54767f4cL, 0x4f5e7234L,
+   0xd7c63b9cL, 0xccee36e4L, 0xe196216cL, 0xfabe2c14L,
+   0xbb660e7cL, 0xa04e0304L, 0x8d36148cL, 0x961e19f4L,
+   0xa5cb3ad3L, 0xbee337abL, 0x939b2023L, 0x88b32d5bL,
+   0xc96b0f33L, 0xd243024bL, 0xff3b15c3L, 0xe41318bbL,
+   0x7c8b5113L, 0x67a35c6bL, 0x4adb4be3L, 0x51f3469bL,
+   0x102b64f3L, 0x0b03698bL, 0x267b7e03L, 0x3d53737bL,
+   0x138af0e4L, 0x08a2fd9cL, 0x25daea14L, 0x3ef2e76cL,
+   0x7f2ac504L, 0x6402c87cL, 0x497adff4L, 0x5252d28cL,
+   0xcaca9b24L, 0xd1e2965cL, 0xfc9a81d4L, 0xe7b28cacL,
+   0xa66aaec4L, 0xbd42a3bcL, 0x903ab434L, 0x8b12b94cL,
+   0xcd89b30aL, 0xd6a1be72L, 0xfbd9a9faL, 0xe0f1a482L,
+   0xa12986eaL, 0xba018b92L, 0x97799c1aL, 0x8c519162L,
+   0x14c9d8caL, 0x0fe1d5b2L, 0x2299c23aL, 0x39b1cf42L,
+   0x7869ed2aL, 0x6341e052L, 0x4e39f7daL, 0x5511faa2L,
+   0x7bc8793dL, 0x60e07445L, 0x4d9863cdL, 0x56b06eb5L,
+   0x17684cddL, 0x0c4041a5L, 0x2138562dL, 0x3a105b55L,
+   0xa28812fdL, 0xb9a01f85L, 0x94d8080dL, 0x8ff00575L,
+   0xce28271dL, 0xd5002a65L, 0xf8783dedL, 0xe3503095L,
+   0x754e2961L, 0x6e662419L, 0x431e3391L, 0x58363ee9L,
+   0x19ee1c81L, 0x02c611f9L, 0x2fbe0671L, 0x34960b09L,
+   0xac0e42a1L, 0xb7264fd9L, 0x9a5e5851L, 0x81765529L,
+   0xc0ae7741L, 0xdb867a39L, 0xf6fe6db1L, 0xedd660c9L,
+   0xc30fe356L, 0xd827ee2eL, 0xf55ff9a6L, 0xee77f4deL,
+   0xafafd6b6L, 0xb487dbceL, 0x99ffcc46L, 0x82d7c13eL,
+   0x1a4f8896L, 0x016785eeL, 0x2c1f9266L, 0x37379f1eL,
+   0x76efbd76L, 0x6dc7b00eL, 0x40bfa786L, 0x5b97aafeL,
+   0x1d0ca0b8L, 0x0624adc0L, 0x2b5cba48L, 0x3074b730L,
+   0x71ac9558L, 0x6a849820L, 0x47fc8fa8L, 0x5cd482d0L,
+   0xc44ccb78L, 0xdf64c600L, 0xf21cd188L, 0xe934dcf0L,
+   0xa8ecfe98L, 0xb3c4f3e0L, 0x9ebce468L, 0x8594e910L,
+   0xab4d6a8fL, 0xb06567f7L, 0x9d1d707fL, 0x86357d07L,
+   0xc7ed5f6fL, 0xdcc55217L, 0xf1bd459fL, 0xea9548e7L,
+   0x720d014fL, 0x69250c37L, 0x445d1bbfL, 0x5f7516c7L,
+   0x1ead34afL, 0x058539d7L, 0x28fd2e5fL, 0x33d52327L
+   },
+   {
+   0x00000000L, 0x4f576811L, 0x9eaed022L, 0xd1f9b833L,
+   0x399cbdf3L, 0x76cbd5e2L, 0xa7326dd1L, 0xe86505c0L,
+   0x73397be6L, 0x3c6e13f7L, 0xed97abc4L, 0xa2c0c3d5L,
+   0x4aa5c615L, 0x05f2ae04L, 0xd40b1637L, 0x9b5c7e26L,
+   0xe672f7ccL, 0xa9259fddL, 0x78dc27eeL, 0x378b4fffL,
+   0xdfee4a3fL, 0x90b9222eL, 0x41409a1dL, 0x0e17f20cL,
+   0x954b8c2aL, 0xda1ce43bL, 0x0be55c08L, 0x44b23419L,
+   0xacd731d9L, 0xe38059c8L, 0x3279e1fbL, 0x7d2e89eaL,
+   0xc824f22fL, 0x87739a3eL, 0x568a220dL, 0x19dd4a1cL,
+   0xf1b84fdcL, 0xbeef27cdL, 0x6f169ffeL, 0x2041f7efL,
+   0xbb1d89c9L, 0xf44ae1d8L, 0x25b359ebL, 0x6ae431faL,
+   0x8281343aL, 0xcdd65c2bL, 0x1c2fe418L, 0x53788c09L,
+   0x2e5605e3L, 0x61016df2L, 0xb0f8d5c1L, 0xffafbdd0L,
+   0x17cab810L, 0x589dd001L, 0x89646832L, 0xc6330023L,
+   0x5d6f7e05L, 0x12381614L, 0xc3c1ae27L, 0x8c96c636L,
+   0x64f3c3f6L, 0x2ba4abe7L, 0xfa5d13d4L, 0xb50a7bc5L,
+   0x9488f9e9L, 0xdbdf91f8L, 0x0a2629cbL, 0x457141daL,
+   0xad14441aL, 0xe2432c0bL, 0x33ba9438L, 0x7cedfc29L,
+   0xe7b1820fL, 0xa8e6ea1eL, 0x791f522dL, 0x36483a3cL,
+   0xde2d3ffcL, 0x917a57edL, 0x4083efdeL, 0x0fd487cfL,
+   0x72fa0e25L, 0x3dad6634L, 0xec54de07L, 0xa303b616L,
+   0x4b66b3d6L, 0x0431dbc7L, 0xd5c863f4L, 0x9a9f0be5L,
+   0x01c375c3L, 0x4e941dd2L, 0x9f6da5e1L, 0xd03acdf0L,
+   0x385fc830L, 0x7708a021L, 0xa6f11812L, 0xe9a67003L,
+   0x5cac0bc6L, 0x13fb63d7L, 0xc202dbe4L, 0x8d55b3f5L,
+   0x6530b635L, 0x2a67de24L, 0xfb9e6617L, 0xb4c90e06L,
+   0x2f957020L, 0x60c21831L, 0xb13ba002L, 0xfe6cc813L,
+   0x1609cdd3L, 0x595ea5c2L, 0x88a71df1L, 0xc7f075e0L,
+   0xbadefc0aL, 0xf589941bL, 0x24702c28L, 0x6b274439L,
+   0x834241f9L, 0xcc1529e8L, 0x1dec91dbL, 0x52bbf9caL,
+   0xc9e787ecL, 0x86b0effdL, 0x574957ceL, 0x181e3fdfL,
+   0xf07b3a1fL, 0xbf2c520eL, 0x6ed5ea3dL, 0x2182822cL,
+   0x2dd0ee65L, 0x62878674L, 0xb37e3e47L, 0xfc295656L,
+   0x144c5396L, 0x5b1b3b87L, 0x8ae283b4L, 0xc5b5eba5L,
+   0x5ee99583L, 0x11befd92L, 0xc04745a1L, 0x8f102db0L,
+   0x67752870L, 0x28224061L, 0xf9dbf852L, 0xb68c9043L,
+   0xcba219a9L, 0x84f571b8L, 0x550cc98bL, 0x1a5ba19aL,
+   0xf23ea45aL, 0xbd69cc4bL, 0x6c907478L, 0x23c71c69L,
+   0xb89b624fL, 0xf7cc0a5eL, 0x2635b26dL, 0x6962da7cL,
+   0x8107dfbcL, 0xce50b7adL, 0x1fa90f9eL, 0x50fe678fL,
+   0xe5f41c4aL, 0xaaa3745bL, 0x7b5acc68L, 0x340da479L,
+   0xdc68a1b9L, 0x933fc9a8L, 0x42c6719bL, 0x0d91198aL,
+   0x96cd67acL, 0xd99a0fbdL, 0x0863b78eL, 0x4734df9fL,
+   0xaf51da5fL, 0xe006b24eL, 0x31ff0a7dL, 0x7ea8626cL,
+   0x0386eb86L, 0x4cd18397L, 0x9d283ba4L, 0xd27f53b5L,
+   0x3a1a5675L, 0x754d3e64L, 0xa4b48657L, 0xebe3ee46L,
+   0x70bf9060L, 0x3fe8f871L, 0xee114042L, 0xa1462853L,
+   0x49232d93L, 0x06744582L, 0xd78dfdb1L, 0x98da95a0L,
+   0xb958178cL, 0xf60f7f9dL, 0x27f6c7aeL, 0x68a1afbfL,
+   0x80c4aa7fL, 0xcf93c26eL, 0x1e6a7a5dL, 0x513d124cL,
+   0xca616c6aL, 0x8536047bL, 0x54cfbc48L, 0x1b98d459L,
+   0xf3fdd199L, 0xbcaab988L, 0x6d5301bbL, 0x220469aaL,
+   0x5f2ae040L, 0x107d8851L, 0xc1843062L, 0x8ed35873L,
+   0x66b65db3L, 0x29e135a2L, 0xf8188d91L, 0xb74fe580L,
+   0x2c139ba6L, 0x6344f3b7L, 0xb2bd4b84L, 0xfdea2395L,
+   0x158f2655L, 0x5ad84e44L, 0x8b21f677L, 0xc4769e66L,
+   0x717ce5a3L, 0x3e2b8db2L, 0xefd23581L, 0xa0855d90L,
+   0x48e05850L, 0x07b73041L, 0xd64e8872L, 0x9919e063L,
+   0x02459e45L, 0x4d12f654L, 0x9ceb4e67L, 0xd3bc2676L,
+   0x3bd923b6L, 0x748e4ba7L, 0xa577f394L, 0xea209b85L,
+   0x970e126fL, 0xd8597a7eL, 0x09a0c24dL, 0x46f7aa5cL,
+   0xae92af9cL, 0xe1c5c78dL, 0x303c7fbeL, 0x7f6b17afL,
+   0xe4376989L, 0xab600198L, 0x7a99b9abL, 0x35ced1baL,
+   0xddabd47aL, 0x92fcbc6bL, 0x43050458L, 0x0c526c49L
+   },
+   {
+   0x00000000L, 0x5ba1dccaL, 0xb743b994L, 0xece2655eL,
+   0x6a466e9fL, 0x31e7b255L, 0xdd05d70bL, 0x86a40bc1L,
+   0xd48cdd3eL, 0x8f2d01f4L, 0x63cf64aaL, 0x386eb860L,
+   0xbecab3a1L, 0xe56b6f6bL, 0x09890a35L, 0x5228d6ffL,
+   0xadd8a7cbL, 0xf6797b01L, 0x1a9b1e5fL, 0x413ac295L,
+   0xc79ec954L, 0x9c3f159eL, 0x70dd70c0L, 0x2b7cac0aL,
+   0x79547af5L, 0x22f5a63fL, 0xce17c361L, 0x95b61fabL,
+   0x1312146aL, 0x48b3c8a0L, 0xa451adfeL, 0xfff07134L,
+   0x5f705221L, 0x04d18eebL, 0xe833ebb5L, 0xb392377fL,
+   0x35363cbeL, 0x6e97e074L, 0x8275852aL, 0xd9d459e0L,
+   0x8bfc8f1fL, 0xd05d53d5L, 0x3cbf368bL, 0x671eea41L,
+   0xe1bae180L, 0xba1b3d4aL, 0x56f95814L, 0x0d5884deL,
+   0xf2a8f5eaL, 0xa9092920L, 0x45eb4c7eL, 0x1e4a90b4L,
+   0x98ee9b75L, 0xc34f47bfL, 0x2fad22e1L, 0x740cfe2bL,
+   0x262428d4L, 0x7d85f41eL, 0x91679140L, 0xcac64d8aL,
+   0x4c62464bL, 0x17c39a81L, 0xfb21ffdfL, 0xa0802315L,
+   0xbee0a442L, 0xe5417888L, 0x09a31dd6L, 0x5202c11cL,
+   0xd4a6caddL, 0x8f071617L, 0x63e57349L, 0x3844af83L,
+   0x6a6c797cL, 0x31cda5b6L, 0xdd2fc0e8L, 0x868e1c22L,
+   0x002a17e3L, 0x5b8bcb29L, 0xb769ae77L, 0xecc872bdL,
+   0x13380389L, 0x4899df43L, 0xa47bba1dL, 0xffda66d7L,
+   0x797e6d16L, 0x22dfb1dcL, 0xce3dd482L, 0x959c0848L,
+   0xc7b4deb7L, 0x9c15027dL, 0x70f76723L, 0x2b56bbe9L,
+   0xadf2b028L, 0xf6536ce2L, 0x1ab109bcL, 0x4110d576L,
+   0xe190f663L, 0xba312aa9L, 0x56d34ff7L, 0x0d72933dL,
+   0x8bd698fcL, 0xd0774436L, 0x3c952168L, 0x6734fda2L,
+   0x351c2b5dL, 0x6ebdf797L, 0x825f92c9L, 0xd9fe4e03L,
+   0x5f5a45c2L, 0x04fb9908L, 0xe819fc56L, 0xb3b8209cL,
+   0x4c4851a8L, 0x17e98d62L, 0xfb0be83cL, 0xa0aa34f6L,
+   0x260e3f37L, 0x7dafe3fdL, 0x914d86a3L, 0xcaec5a69L,
+   0x98c48c96L, 0xc365505cL, 0x2f873502L, 0x7426e9c8L,
+   0xf282e209L, 0xa9233ec3L, 0x45c15b9dL, 0x1e608757L,
+   0x79005533L, 0x22a189f9L, 0xce43eca7L, 0x95e2306dL,
+   0x13463bacL, 0x48e7e766L, 0xa4058238L, 0xffa45ef2L,
+   0xad8c880dL, 0xf62d54c7L, 0x1acf3199L, 0x416eed53L,
+   0xc7cae692L, 0x9c6b3a58L, 0x70895f06L, 0x2b2883ccL,
+   0xd4d8f2f8L, 0x8f792e32L, 0x639b4b6cL, 0x383a97a6L,
+   0xbe9e9c67L, 0xe53f40adL, 0x09dd25f3L, 0x527cf939L,
+   0x00542fc6L, 0x5bf5f30cL, 0xb7179652L, 0xecb64a98L,
+   0x6a124159L, 0x31b39d93L, 0xdd51f8cdL, 0x86f02407L,
+   0x26700712L, 0x7dd1dbd8L, 0x9133be86L, 0xca92624cL,
+   0x4c36698dL, 0x1797b547L, 0xfb75d019L, 0xa0d40cd3L,
+   0xf2fcda2cL, 0xa95d06e6L, 0x45bf63b8L, 0x1e1ebf72L,
+   0x98bab4b3L, 0xc31b6879L, 0x2ff90d27L, 0x7458d1edL,
+   0x8ba8a0d9L, 0xd0097c13L, 0x3ceb194dL, 0x674ac587L,
+   0xe1eece46L, 0xba4f128cL, 0x56ad77d2L, 0x0d0cab18L,
+   0x5f247de7L, 0x0485a12dL, 0xe867c473L, 0xb3c618b9L,
+   0x35621378L, 0x6ec3cfb2L, 0x8221aaecL, 0xd9807626L,
+   0xc7e0f171L, 0x9c412dbbL, 0x70a348e5L, 0x2b02942fL,
+   0xada69feeL, 0xf6074324L, 0x1ae5267aL, 0x4144fab0L,
+   0x136c2c4fL, 0x48cdf085L, 0xa42f95dbL, 0xff8e4911L,
+   0x792a42d0L, 0x228b9e1aL, 0xce69fb44L, 0x95c8278eL,
+   0x6a3856baL, 0x31998a70L, 0xdd7bef2eL, 0x86da33e4L,
+   0x007e3825L, 0x5bdfe4efL, 0xb73d81b1L, 0xec9c5d7bL,
+   0xbeb48b84L, 0xe515574eL, 0x09f73210L, 0x5256eedaL,
+   0xd4f2e51bL, 0x8f5339d1L, 0x63b15c8fL, 0x38108045L,
+   0x9890a350L, 0xc3317f9aL, 0x2fd31ac4L, 0x7472c60eL,
+   0xf2d6cdcfL, 0xa9771105L, 0x4595745bL, 0x1e34a891L,
+   0x4c1c7e6eL, 0x17bda2a4L, 0xfb5fc7faL, 0xa0fe1b30L,
+   0x265a10f1L, 0x7dfbcc3bL, 0x9119a965L, 0xcab875afL,
+   0x3548049bL, 0x6ee9d851L, 0x820bbd0fL, 0xd9aa61c5L,
+   0x5f0e6a04L, 0x04afb6ceL, 0xe84dd390L, 0xb3ec0f5aL,
+   0xe1c4d9a5L, 0xba65056fL, 0x56876031L, 0x0d26bcfbL,
+   0x8b82b73aL, 0xd0236bf0L, 0x3cc10eaeL, 0x6760d264L
+   },
+   {
+   0x00000000L, 0xf200aa66L, 0xe0c0497bL, 0x12c0e31dL,
+   0xc5418f41L, 0x37412527L, 0x2581c63aL, 0xd7816c5cL,
+   0x8e420335L, 0x7c42a953L, 0x6e824a4eL, 0x9c82e028L,
+   0x4b038c74L, 0xb9032612L, 0xabc3c50fL, 0x59c36f69L,
+   0x18451bddL, 0xea45b1bbL, 0xf88552a6L, 0x0a85f8c0L,
+   0xdd04949cL, 0x2f043efaL, 0x3dc4dde7L, 0xcfc47781L,
+   0x960718e8L, 0x6407b28eL, 0x76c75193L, 0x84c7fbf5L,
+   0x534697a9L, 0xa1463dcfL, 0xb386ded2L, 0x418674b4L,
+   0x308a37baL, 0xc28a9ddcL, 0xd04a7ec1L, 0x224ad4a7L,
+   0xf5cbb8fbL, 0x07cb129dL, 0x150bf180L, 0xe70b5be6L,
+   0xbec8348fL, 0x4cc89ee9L, 0x5e087df4L, 0xac08d792L,
+   0x7b89bbceL, 0x898911a8L, 0x9b49f2b5L, 0x694958d3L,
+   0x28cf2c67L, 0xdacf8601L, 0xc80f651cL, 0x3a0fcf7aL,
+   0xed8ea326L, 0x1f8e0940L, 0x0d4eea5dL, 0xff4e403bL,
+   0xa68d2f52L, 0x548d8534L, 0x464d6629L, 0xb44dcc4fL,
+   0x63cca013L, 0x91cc0a75L, 0x830ce968L, 0x710c430eL,
+   0x61146f74L, 0x9314c512L, 0x81d4260fL, 0x73d48c69L,
+   0xa455e035L, 0x56554a53L, 0x4495a94eL, 0xb6950328L,
+   0xef566c41L, 0x1d56c627L, 0x0f96253aL, 0xfd968f5cL,
+   0x2a17e300L, 0xd8174966L, 0xcad7aa7bL, 0x38d7001dL,
+   0x795174a9L, 0x8b51decfL, 0x99913dd2L, 0x6b9197b4L,
+   0xbc10fbe8L, 0x4e10518eL, 0x5cd0b293L, 0xaed018f5L,
+   0xf713779cL, 0x0513ddfaL, 0x17d33ee7L, 0xe5d39481L,
+   0x3252f8ddL, 0xc05252bbL, 0xd292b1a6L, 0x20921bc0L,
+   0x519e58ceL, 0xa39ef2a8L, 0xb15e11b5L, 0x435ebbd3L,
+   0x94dfd78fL, 0x66df7de9L, 0x741f9ef4L, 0x861f3492L,
+   0xdfdc5bfbL, 0x2ddcf19dL, 0x3f1c1280L, 0xcd1cb8e6L,
+   0x1a9dd4baL, 0xe89d7edcL, 0xfa5d9dc1L, 0x085d37a7L,
+   0x49db4313L, 0xbbdbe975L, 0xa91b0a68L, 0x5b1ba00eL,
+   0x8c9acc52L, 0x7e9a6634L, 0x6c5a8529L, 0x9e5a2f4fL,
+   0xc7994026L, 0x3599ea40L, 0x2759095dL, 0xd559a33bL,
+   0x02d8cf67L, 0xf0d86501L, 0xe218861cL, 0x10182c7aL,
+   0xc228dee8L, 0x3028748eL, 0x22e89793L, 0xd0e83df5L,
+   0x076951a9L, 0xf569fbcfL, 0xe7a918d2L, 0x15a9b2b4L,
+   0x4c6addddL, 0xbe6a77bbL, 0xacaa94a6L, 0x5eaa3ec0L,
+   0x892b529cL, 0x7b2bf8faL, 0x69eb1be7L, 0x9bebb181L,
+   0xda6dc535L, 0x286d6f53L, 0x3aad8c4eL, 0xc8ad2628L,
+   0x1f2c4a74L, 0xed2ce012L, 0xffec030fL, 0x0deca969L,
+   0x542fc600L, 0xa62f6c66L, 0xb4ef8f7bL, 0x46ef251dL,
+   0x916e4941L, 0x636ee327L, 0x71ae003aL, 0x83aeaa5cL,
+   0xf2a2e952L, 0x00a24334L, 0x1262a029L, 0xe0620a4fL,
+   0x37e36613L, 0xc5e3cc75L, 0xd7232f68L, 0x2523850eL,
+   0x7ce0ea67L, 0x8ee04001L, 0x9c20a31cL, 0x6e20097aL,
+   0xb9a16526L, 0x4ba1cf40L, 0x59612c5dL, 0xab61863bL,
+   0xeae7f28fL, 0x18e758e9L, 0x0a27bbf4L, 0xf8271192L,
+   0x2fa67dceL, 0xdda6d7a8L, 0xcf6634b5L, 0x3d669ed3L,
+   0x64a5f1baL, 0x96a55bdcL, 0x8465b8c1L, 0x766512a7L,
+   0xa1e47efbL, 0x53e4d49dL, 0x41243780L, 0xb3249de6L,
+   0xa33cb19cL, 0x513c1bfaL, 0x43fcf8e7L, 0xb1fc5281L,
+   0x667d3eddL, 0x947d94bbL, 0x86bd77a6L, 0x74bdddc0L,
+   0x2d7eb2a9L, 0xdf7e18cfL, 0xcdbefbd2L, 0x3fbe51b4L,
+   0xe83f3de8L, 0x1a3f978eL, 0x08ff7493L, 0xfaffdef5L,
+   0xbb79aa41L, 0x49790027L, 0x5bb9e33aL, 0xa9b9495cL,
+   0x7e382500L, 0x8c388f66L, 0x9ef86c7bL, 0x6cf8c61dL,
+   0x353ba974L, 0xc73b0312L, 0xd5fbe00fL, 0x27fb4a69L,
+   0xf07a2635L, 0x027a8c53L, 0x10ba6f4eL, 0xe2bac528L,
+   0x93b68626L, 0x61b62c40L, 0x7376cf5dL, 0x8176653bL,
+   0x56f70967L, 0xa4f7a301L, 0xb637401cL, 0x4437ea7aL,
+   0x1df48513L, 0xeff42f75L, 0xfd34cc68L, 0x0f34660eL,
+   0xd8b50a52L, 0x2ab5a034L, 0x38754329L, 0xca75e94fL,
+   0x8bf39dfbL, 0x79f3379dL, 0x6b33d480L, 0x99337ee6L,
+   0x4eb212baL, 0xbcb2b8dcL, 0xae725bc1L, 0x5c72f1a7L,
+   0x05b19eceL, 0xf7b134a8L, 0xe571d7b5L, 0x17717dd3L,
+   0xc0f0118fL, 0x32f0bbe9L, 0x203058f4L, 0xd230f292L
+   },
+   {
+   0x00000000L, 0x8090a067L, 0x05e05d79L, 0x8570fd1eL,
+   0x0bc0baf2L, 0x8b501a95L, 0x0e20e78bL, 0x8eb047ecL,
+   0x178175e4L, 0x9711d583L, 0x1261289dL, 0x92f188faL,
+   0x1c41cf16L, 0x9cd16f71L, 0x19a1926fL, 0x99313208L,
+   0x2f02ebc8L, 0xaf924bafL, 0x2ae2b6b1L, 0xaa7216d6L,
+   0x24c2513aL, 0xa452f15dL, 0x21220c43L, 0xa1b2ac24L,
+   0x38839e2cL, 0xb8133e4bL, 0x3d63c355L, 0xbdf36332L,
+   0x334324deL, 0xb3d384b9L, 0x36a379a7L, 0xb633d9c0L,
+   0x5e05d790L, 0xde9577f7L, 0x5be58ae9L, 0xdb752a8eL,
+   0x55c56d62L, 0xd555cd05L, 0x5025301bL, 0xd0b5907cL,
+   0x4984a274L, 0xc9140213L, 0x4c64ff0dL, 0xccf45f6aL,
+   0x42441886L, 0xc2d4b8e1L, 0x47a445ffL, 0xc734e598L,
+   0x71073c58L, 0xf1979c3fL, 0x74e76121L, 0xf477c146L,
+   0x7ac786aaL, 0xfa5726cdL, 0x7f27dbd3L, 0xffb77bb4L,
+   0x668649bcL, 0xe616e9dbL, 0x636614c5L, 0xe3f6b4a2L,
+   0x6d46f34eL, 0xedd65329L, 0x68a6ae37L, 0xe8360e50L,
+   0xbc0baf20L, 0x3c9b0f47L, 0xb9ebf259L, 0x397b523eL,
+   0xb7cb15d2L, 0x375bb5b5L, 0xb22b48abL, 0x32bbe8ccL,
+   0xab8adac4L, 0x2b1a7aa3L, 0xae6a87bdL, 0x2efa27daL,
+   0xa04a6036L, 0x20dac051L, 0xa5aa3d4fL, 0x253a9d28L,
+   0x930944e8L, 0x1399e48fL, 0x96e91991L, 0x1679b9f6L,
+   0x98c9fe1aL, 0x18595e7dL, 0x9d29a363L, 0x1db90304L,
+   0x8488310cL, 0x0418916bL, 0x81686c75L, 0x01f8cc12L,
+   0x8f488bfeL, 0x0fd82b99L, 0x8aa8d687L, 0x0a3876e0L,
+   0xe20e78b0L, 0x629ed8d7L, 0xe7ee25c9L, 0x677e85aeL,
+   0xe9cec242L, 0x695e6225L, 0xec2e9f3bL, 0x6cbe3f5cL,
+   0xf58f0d54L, 0x751fad33L, 0xf06f502dL, 0x70fff04aL,
+   0xfe4fb7a6L, 0x7edf17c1L, 0xfbafeadfL, 0x7b3f4ab8L,
+   0xcd0c9378L, 0x4d9c331fL, 0xc8ecce01L, 0x487c6e66L,
+   0xc6cc298aL, 0x465c89edL, 0xc32c74f3L, 0x43bcd494L,
+   0xda8de69cL, 0x5a1d46fbL, 0xdf6dbbe5L, 0x5ffd1b82L,
+   0xd14d5c6eL, 0x51ddfc09L, 0xd4ad0117L, 0x543da170L,
+   0x7cd643f7L, 0xfc46e390L, 0x79361e8eL, 0xf9a6bee9L,
+   0x7716f905L, 0xf7865962L, 0x72f6a47cL, 0xf266041bL,
+   0x6b573613L, 0xebc79674L, 0x6eb76b6aL, 0xee27cb0dL,
+   0x60978ce1L, 0xe0072c86L, 0x6577d198L, 0xe5e771ffL,
+   0x53d4a83fL, 0xd3440858L, 0x5634f546L, 0xd6a45521L,
+   0x581412cdL, 0xd884b2aaL, 0x5df44fb4L, 0xdd64efd3L,
+   0x4455dddbL, 0xc4c57dbcL, 0x41b580a2L, 0xc12520c5L,
+   0x4f956729L, 0xcf05c74eL, 0x4a753a50L, 0xcae59a37L,
+   0x22d39467L, 0xa2433400L, 0x2733c91eL, 0xa7a36979L,
+   0x29132e95L, 0xa9838ef2L, 0x2cf373ecL, 0xac63d38bL,
+   0x3552e183L, 0xb5c241e4L, 0x30b2bcfaL, 0xb0221c9dL,
+   0x3e925b71L, 0xbe02fb16L, 0x3b720608L, 0xbbe2a66fL,
+   0x0dd17fafL, 0x8d41dfc8L, 0x083122d6L, 0x88a182b1L,
+   0x0611c55dL, 0x8681653aL, 0x03f19824L, 0x83613843L,
+   0x1a500a4bL, 0x9ac0aa2cL, 0x1fb05732L, 0x9f20f755L,
+   0x1190b0b9L, 0x910010deL, 0x1470edc0L, 0x94e04da7L,
+   0xc0ddecd7L, 0x404d4cb0L, 0xc53db1aeL, 0x45ad11c9L,
+   0xcb1d5625L, 0x4b8df642L, 0xcefd0b5cL, 0x4e6dab3bL,
+   0xd75c9933L, 0x57cc3954L, 0xd2bcc44aL, 0x522c642dL,
+   0xdc9c23c1L, 0x5c0c83a6L, 0xd97c7eb8L, 0x59ecdedfL,
+   0xefdf071fL, 0x6f4fa778L, 0xea3f5a66L, 0x6aaffa01L,
+   0xe41fbdedL, 0x648f1d8aL, 0xe1ffe094L, 0x616f40f3L,
+   0xf85e72fbL, 0x78ced29cL, 0xfdbe2f82L, 0x7d2e8fe5L,
+   0xf39ec809L, 0x730e686eL, 0xf67e9570L, 0x76ee3517L,
+   0x9ed83b47L, 0x1e489b20L, 0x9b38663eL, 0x1ba8c659L,
+   0x951881b5L, 0x158821d2L, 0x90f8dcccL, 0x10687cabL,
+   0x89594ea3L, 0x09c9eec4L, 0x8cb913daL, 0x0c29b3bdL,
+   0x8299f451L, 0x02095436L, 0x8779a928L, 0x07e9094fL,
+   0xb1dad08fL, 0x314a70e8L, 0xb43a8df6L, 0x34aa2d91L,
+   0xba1a6a7dL, 0x3a8aca1aL, 0xbffa3704L, 0x3f6a9763L,
+   0xa65ba56bL, 0x26cb050cL, 0xa3bbf812L, 0x232b5875L,
+   0xad9b1f99L, 0x2d0bbffeL, 0xa87b42e0L, 0x28ebe287L
+   },
+   {
+   0x00000000L, 0xf9ac87eeL, 0xf798126bL, 0x0e349585L,
+   0xebf13961L, 0x125dbe8fL, 0x1c692b0aL, 0xe5c5ace4L,
+   0xd3236f75L, 0x2a8fe89bL, 0x24bb7d1eL, 0xdd17faf0L,
+   0x38d25614L, 0xc17ed1faL, 0xcf4a447fL, 0x36e6c391L,
+   0xa287c35dL, 0x5b2b44b3L, 0x551fd136L, 0xacb356d8L,
+   0x4976fa3cL, 0xb0da7dd2L, 0xbeeee857L, 0x47426fb9L,
+   0x71a4ac28L, 0x88082bc6L, 0x863cbe43L, 0x7f9039adL,
+   0x9a559549L, 0x63f912a7L, 0x6dcd8722L, 0x946100ccL,
+   0x41ce9b0dL, 0xb8621ce3L, 0xb6568966L, 0x4ffa0e88L,
+   0xaa3fa26cL, 0x53932582L, 0x5da7b007L, 0xa40b37e9L,
+   0x92edf478L, 0x6b417396L, 0x6575e613L, 0x9cd961fdL,
+   0x791ccd19L, 0x80b04af7L, 0x8e84df72L, 0x7728589cL,
+   0xe3495850L, 0x1ae5dfbeL, 0x14d14a3bL, 0xed7dcdd5L,
+   0x08b86131L, 0xf114e6dfL, 0xff20735aL, 0x068cf4b4L,
+   0x306a3725L, 0xc9c6b0cbL, 0xc7f2254eL, 0x3e5ea2a0L,
+   0xdb9b0e44L, 0x223789aaL, 0x2c031c2fL, 0xd5af9bc1L,
+   0x839d361aL, 0x7a31b1f4L, 0x74052471L, 0x8da9a39fL,
+   0x686c0f7bL, 0x91c08895L, 0x9ff41d10L, 0x66589afeL,
+   0x50be596fL, 0xa912de81L, 0xa7264b04L, 0x5e8acceaL,
+   0xbb4f600eL, 0x42e3e7e0L, 0x4cd77265L, 0xb57bf58bL,
+   0x211af547L, 0xd8b672a9L, 0xd682e72cL, 0x2f2e60c2L,
+   0xcaebcc26L, 0x33474bc8L, 0x3d73de4dL, 0xc4df59a3L,
+   0xf2399a32L, 0x0b951ddcL, 0x05a18859L, 0xfc0d0fb7L,
+   0x19c8a353L, 0xe06424bdL, 0xee50b138L, 0x17fc36d6L,
+   0xc253ad17L, 0x3bff2af9L, 0x35cbbf7cL, 0xcc673892L,
+   0x29a29476L, 0xd00e1398L, 0xde3a861dL, 0x279601f3L,
+   0x1170c262L, 0xe8dc458cL, 0xe6e8d009L, 0x1f4457e7L,
+   0xfa81fb03L, 0x032d7cedL, 0x0d19e968L, 0xf4b56e86L,
+   0x60d46e4aL, 0x9978e9a4L, 0x974c7c21L, 0x6ee0fbcfL,
+   0x8b25572bL, 0x7289d0c5L, 0x7cbd4540L, 0x8511c2aeL,
+   0xb3f7013fL, 0x4a5b86d1L, 0x446f1354L, 0xbdc394baL,
+   0x5806385eL, 0xa1aabfb0L, 0xaf9e2a35L, 0x5632addbL,
+   0x03fb7183L, 0xfa57f66dL, 0xf46363e8L, 0x0dcfe406L,
+   0xe80a48e2L, 0x11a6cf0cL, 0x1f925a89L, 0xe63edd67L,
+   0xd0d81ef6L, 0x29749918L, 0x27400c9dL, 0xdeec8b73L,
+   0x3b292797L, 0xc285a079L, 0xccb135fcL, 0x351db212L,
+   0xa17cb2deL, 0x58d03530L, 0x56e4a0b5L, 0xaf48275bL,
+   0x4a8d8bbfL, 0xb3210c51L, 0xbd1599d4L, 0x44b91e3aL,
+   0x725fddabL, 0x8bf35a45L, 0x85c7cfc0L, 0x7c6b482eL,
+   0x99aee4caL, 0x60026324L, 0x6e36f6a1L, 0x979a714fL,
+   0x4235ea8eL, 0xbb996d60L, 0xb5adf8e5L, 0x4c017f0bL,
+   0xa9c4d3efL, 0x50685401L, 0x5e5cc184L, 0xa7f0466aL,
+   0x911685fbL, 0x68ba0215L, 0x668e9790L, 0x9f22107eL,
+   0x7ae7bc9aL, 0x834b3b74L, 0x8d7faef1L, 0x74d3291fL,
+   0xe0b229d3L, 0x191eae3dL, 0x172a3bb8L, 0xee86bc56L,
+   0x0b4310b2L, 0xf2ef975cL, 0xfcdb02d9L, 0x05778537L,
+   0x339146a6L, 0xca3dc148L, 0xc40954cdL, 0x3da5d323L,
+   0xd8607fc7L, 0x21ccf829L, 0x2ff86dacL, 0xd654ea42L,
+   0x80664799L, 0x79cac077L, 0x77fe55f2L, 0x8e52d21cL,
+   0x6b977ef8L, 0x923bf916L, 0x9c0f6c93L, 0x65a3eb7dL,
+   0x534528ecL, 0xaae9af02L, 0xa4dd3a87L, 0x5d71bd69L,
+   0xb8b4118dL, 0x41189663L, 0x4f2c03e6L, 0xb6808408L,
+   0x22e184c4L, 0xdb4d032aL, 0xd57996afL, 0x2cd51141L,
+   0xc910bda5L, 0x30bc3a4bL, 0x3e88afceL, 0xc7242820L,
+   0xf1c2ebb1L, 0x086e6c5fL, 0x065af9daL, 0xfff67e34L,
+   0x1a33d2d0L, 0xe39f553eL, 0xedabc0bbL, 0x14074755L,
+   0xc1a8dc94L, 0x38045b7aL, 0x3630ceffL, 0xcf9c4911L,
+   0x2a59e5f5L, 0xd3f5621bL, 0xddc1f79eL, 0x246d7070L,
+   0x128bb3e1L, 0xeb27340fL, 0xe513a18aL, 0x1cbf2664L,
+   0xf97a8a80L, 0x00d60d6eL, 0x0ee298ebL, 0xf74e1f05L,
+   0x632f1fc9L, 0x9a839827L, 0x94b70da2L, 0x6d1b8a4cL,
+   0x88de26a8L, 0x7172a146L, 0x7f4634c3L, 0x86eab32dL,
+   0xb00c70bcL, 0x49a0f752L, 0x479462d7L, 0xbe38e539L,
+   0x5bfd49ddL, 0xa251ce33L, 0xac655bb6L, 0x55c9dc58L
+   },
+   {
+   0x00000000L, 0x07f6e306L, 0x0fedc60cL, 0x081b250aL,
+   0x1fdb8c18L, 0x182d6f1eL, 0x10364a14L, 0x17c0a912L,
+   0x3fb71830L, 0x3841fb36L, 0x305ade3cL, 0x37ac3d3aL,
+   0x206c9428L, 0x279a772eL, 0x2f815224L, 0x2877b122L,
+   0x7f6e3060L, 0x7898d366L, 0x7083f66cL, 0x7775156aL,
+   0x60b5bc78L, 0x67435f7eL, 0x6f587a74L, 0x68ae9972L,
+   0x40d92850L, 0x472fcb56L, 0x4f34ee5cL, 0x48c20d5aL,
+   0x5f02a448L, 0x58f4474eL, 0x50ef6244L, 0x57198142L,
+   0xfedc60c0L, 0xf92a83c6L, 0xf131a6ccL, 0xf6c745caL,
+   0xe107ecd8L, 0xe6f10fdeL, 0xeeea2ad4L, 0xe91cc9d2L,
+   0xc16b78f0L, 0xc69d9bf6L, 0xce86befcL, 0xc9705dfaL,
+   0xdeb0f4e8L, 0xd94617eeL, 0xd15d32e4L, 0xd6abd1e2L,
+   0x81b250a0L, 0x8644b3a6L, 0x8e5f96acL, 0x89a975aaL,
+   0x9e69dcb8L, 0x999f3fbeL, 0x91841ab4L, 0x9672f9b2L,
+   0xbe054890L, 0xb9f3ab96L, 0xb1e88e9cL, 0xb61e6d9aL,
+   0xa1dec488L, 0xa628278eL, 0xae330284L, 0xa9c5e182L,
+   0xf979dc37L, 0xfe8f3f31L, 0xf6941a3bL, 0xf162f93dL,
+   0xe6a2502fL, 0xe154b329L, 0xe94f9623L, 0xeeb97525L,
+   0xc6cec407L, 0xc1382701L, 0xc923020bL, 0xced5e10dL,
+   0xd915481fL, 0xdee3ab19L, 0xd6f88e13L, 0xd10e6d15L,
+   0x8617ec57L, 0x81e10f51L, 0x89fa2a5bL, 0x8e0cc95dL,
+   0x99cc604fL, 0x9e3a8349L, 0x9621a643L, 0x91d74545L,
+   0xb9a0f467L, 0xbe561761L, 0xb64d326bL, 0xb1bbd16dL,
+   0xa67b787fL, 0xa18d9b79L, 0xa996be73L, 0xae605d75L,
+   0x07a5bcf7L, 0x00535ff1L, 0x08487afbL, 0x0fbe99fdL,
+   0x187e30efL, 0x1f88d3e9L, 0x1793f6e3L, 0x106515e5L,
+   0x3812a4c7L, 0x3fe447c1L, 0x37ff62cbL, 0x300981cdL,
+   0x27c928dfL, 0x203fcbd9L, 0x2824eed3L, 0x2fd20dd5L,
+   0x78cb8c97L, 0x7f3d6f91L, 0x77264a9bL, 0x70d0a99dL,
+   0x6710008fL, 0x60e6e389L, 0x68fdc683L, 0x6f0b2585L,
+   0x477c94a7L, 0x408a77a1L, 0x489152abL, 0x4f67b1adL,
+   0x58a718bfL, 0x5f51fbb9L, 0x574adeb3L, 0x50bc3db5L,
+   0xf632a5d9L, 0xf1c446dfL, 0xf9df63d5L, 0xfe2980d3L,
+   0xe9e929c1L, 0xee1fcac7L, 0xe604efcdL, 0xe1f20ccbL,
+   0xc985bde9L, 0xce735eefL, 0xc6687be5L, 0xc19e98e3L,
+   0xd65e31f1L, 0xd1a8d2f7L, 0xd9b3f7fdL, 0xde4514fbL,
+   0x895c95b9L, 0x8eaa76bfL, 0x86b153b5L, 0x8147b0b3L,
+   0x968719a1L, 0x9171faa7L, 0x996adfadL, 0x9e9c3cabL,
+   0xb6eb8d89L, 0xb11d6e8fL, 0xb9064b85L, 0xbef0a883L,
+   0xa9300191L, 0xaec6e297L, 0xa6ddc79dL, 0xa12b249bL,
+   0x08eec519L, 0x0f18261fL, 0x07030315L, 0x00f5e013L,
+   0x17354901L, 0x10c3aa07L, 0x18d88f0dL, 0x1f2e6c0bL,
+   0x3759dd29L, 0x30af3e2fL, 0x38b41b25L, 0x3f42f823L,
+   0x28825131L, 0x2f74b237L, 0x276f973dL, 0x2099743bL,
+   0x7780f579L, 0x7076167fL, 0x786d3375L, 0x7f9bd073L,
+   0x685b7961L, 0x6fad9a67L, 0x67b6bf6dL, 0x60405c6bL,
+   0x4837ed49L, 0x4fc10e4fL, 0x47da2b45L, 0x402cc843L,
+   0x57ec6151L, 0x501a8257L, 0x5801a75dL, 0x5ff7445bL,
+   0x0f4b79eeL, 0x08bd9ae8L, 0x00a6bfe2L, 0x07505ce4L,
+   0x1090f5f6L, 0x176616f0L, 0x1f7d33faL, 0x188bd0fcL,
+   0x30fc61deL, 0x370a82d8L, 0x3f11a7d2L, 0x38e744d4L,
+   0x2f27edc6L, 0x28d10ec0L, 0x20ca2bcaL, 0x273cc8ccL,
+   0x7025498eL, 0x77d3aa88L, 0x7fc88f82L, 0x783e6c84L,
+   0x6ffec596L, 0x68082690L, 0x6013039aL, 0x67e5e09cL,
+   0x4f9251beL, 0x4864b2b8L, 0x407f97b2L, 0x478974b4L,
+   0x5049dda6L, 0x57bf3ea0L, 0x5fa41baaL, 0x5852f8acL,
+   0xf197192eL, 0xf661fa28L, 0xfe7adf22L, 0xf98c3c24L,
+   0xee4c9536L, 0xe9ba7630L, 0xe1a1533aL, 0xe657b03cL,
+   0xce20011eL, 0xc9d6e218L, 0xc1cdc712L, 0xc63b2414L,
+   0xd1fb8d06L, 0xd60d6e00L, 0xde164b0aL, 0xd9e0a80cL,
+   0x8ef9294eL, 0x890fca48L, 0x8114ef42L, 0x86e20c44L,
+   0x9122a556L, 0x96d44650L, 0x9ecf635aL, 0x9939805cL,
+   0xb14e317eL, 0xb6b8d278L, 0xbea3f772L, 0xb9551474L,
+   0xae95bd66L, 0xa9635e60L, 0xa1787b6aL, 0xa68e986cL
+   },
+   {
+   0x00000000L, 0xe8a45605L, 0xd589b1bdL, 0x3d2de7b8L,
+   0xafd27ecdL, 0x477628c8L, 0x7a5bcf70L, 0x92ff9975L,
+   0x5b65e02dL, 0xb3c1b628L, 0x8eec5190L, 0x66480795L,
+   0xf4b79ee0L, 0x1c13c8e5L, 0x213e2f5dL, 0xc99a7958L,
+   0xb6cbc05aL, 0x5e6f965fL, 0x634271e7L, 0x8be627e2L,
+   0x1919be97L, 0xf1bde892L, 0xcc900f2aL, 0x2434592fL,
+   0xedae2077L, 0x050a7672L, 0x382791caL, 0xd083c7cfL,
+   0x427c5ebaL, 0xaad808bfL, 0x97f5ef07L, 0x7f51b902L,
+   0x69569d03L, 0x81f2cb06L, 0xbcdf2cbeL, 0x547b7abbL,
+   0xc684e3ceL, 0x2e20b5cbL, 0x130d5273L, 0xfba90476L,
+   0x32337d2eL, 0xda972b2bL, 0xe7bacc93L, 0x0f1e9a96L,
+   0x9de103e3L, 0x754555e6L, 0x4868b25eL, 0xa0cce45bL,
+   0xdf9d5d59L, 0x37390b5cL, 0x0a14ece4L, 0xe2b0bae1L,
+   0x704f2394L, 0x98eb7591L, 0xa5c69229L, 0x4d62c42cL,
+   0x84f8bd74L, 0x6c5ceb71L, 0x51710cc9L, 0xb9d55accL,
+   0x2b2ac3b9L, 0xc38e95bcL, 0xfea37204L, 0x16072401L,
+   0xd2ad3a06L, 0x3a096c03L, 0x07248bbbL, 0xef80ddbeL,
+   0x7d7f44cbL, 0x95db12ceL, 0xa8f6f576L, 0x4052a373L,
+   0x89c8da2bL, 0x616c8c2eL, 0x5c416b96L, 0xb4e53d93L,
+   0x261aa4e6L, 0xcebef2e3L, 0xf393155bL, 0x1b37435eL,
+   0x6466fa5cL, 0x8cc2ac59L, 0xb1ef4be1L, 0x594b1de4L,
+   0xcbb48491L, 0x2310d294L, 0x1e3d352cL, 0xf6996329L,
+   0x3f031a71L, 0xd7a74c74L, 0xea8aabccL, 0x022efdc9L,
+   0x90d164bcL, 0x787532b9L, 0x4558d501L, 0xadfc8304L,
+   0xbbfba705L, 0x535ff100L, 0x6e7216b8L, 0x86d640bdL,
+   0x1429d9c8L, 0xfc8d8fcdL, 0xc1a06875L, 0x29043e70L,
+   0xe09e4728L, 0x083a112dL, 0x3517f695L, 0xddb3a090L,
+   0x4f4c39e5L, 0xa7e86fe0L, 0x9ac58858L, 0x7261de5dL,
+   0x0d30675fL, 0xe594315aL, 0xd8b9d6e2L, 0x301d80e7L,
+   0xa2e21992L, 0x4a464f97L, 0x776ba82fL, 0x9fcffe2aL,
+   0x56558772L, 0xbef1d177L, 0x83dc36cfL, 0x6b7860caL,
+   0xf987f9bfL, 0x1123afbaL, 0x2c0e4802L, 0xc4aa1e07L,
+   0xa19b69bbL, 0x493f3fbeL, 0x7412d806L, 0x9cb68e03L,
+   0x0e491776L, 0xe6ed4173L, 0xdbc0a6cbL, 0x3364f0ceL,
+   0xfafe8996L, 0x125adf93L, 0x2f77382bL, 0xc7d36e2eL,
+   0x552cf75bL, 0xbd88a15eL, 0x80a546e6L, 0x680110e3L,
+   0x1750a9e1L, 0xfff4ffe4L, 0xc2d9185cL, 0x2a7d4e59L,
+   0xb882d72cL, 0x50268129L, 0x6d0b6691L, 0x85af3094L,
+   0x4c3549ccL, 0xa4911fc9L, 0x99bcf871L, 0x7118ae74L,
+   0xe3e73701L, 0x0b436104L, 0x366e86bcL, 0xdecad0b9L,
+   0xc8cdf4b8L, 0x2069a2bdL, 0x1d444505L, 0xf5e01300L,
+   0x671f8a75L, 0x8fbbdc70L, 0xb2963bc8L, 0x5a326dcdL,
+   0x93a81495L, 0x7b0c4290L, 0x4621a528L, 0xae85f32dL,
+   0x3c7a6a58L, 0xd4de3c5dL, 0xe9f3dbe5L, 0x01578de0L,
+   0x7e0634e2L, 0x96a262e7L, 0xab8f855fL, 0x432bd35aL,
+   0xd1d44a2fL, 0x39701c2aL, 0x045dfb92L, 0xecf9ad97L,
+   0x2563d4cfL, 0xcdc782caL, 0xf0ea6572L, 0x184e3377L,
+   0x8ab1aa02L, 0x6215fc07L, 0x5f381bbfL, 0xb79c4dbaL,
+   0x733653bdL, 0x9b9205b8L, 0xa6bfe200L, 0x4e1bb405L,
+   0xdce42d70L, 0x34407b75L, 0x096d9ccdL, 0xe1c9cac8L,
+   0x2853b390L, 0xc0f7e595L, 0xfdda022dL, 0x157e5428L,
+   0x8781cd5dL, 0x6f259b58L, 0x52087ce0L, 0xbaac2ae5L,
+   0xc5fd93e7L, 0x2d59c5e2L, 0x1074225aL, 0xf8d0745fL,
+   0x6a2fed2aL, 0x828bbb2fL, 0xbfa65c97L, 0x57020a92L,
+   0x9e9873caL, 0x763c25cfL, 0x4b11c277L, 0xa3b59472L,
+   0x314a0d07L, 0xd9ee5b02L, 0xe4c3bcbaL, 0x0c67eabfL,
+   0x1a60cebeL, 0xf2c498bbL, 0xcfe97f03L, 0x274d2906L,
+   0xb5b2b073L, 0x5d16e676L, 0x603b01ceL, 0x889f57cbL,
+   0x41052e93L, 0xa9a17896L, 0x948c9f2eL, 0x7c28c92bL,
+   0xeed7505eL, 0x0673065bL, 0x3b5ee1e3L, 0xd3fab7e6L,
+   0xacab0ee4L, 0x440f58e1L, 0x7922bf59L, 0x9186e95cL,
+   0x03797029L, 0xebdd262cL, 0xd6f0c194L, 0x3e549791L,
+   0xf7ceeec9L, 0x1f6ab8ccL, 0x22475f74L, 0xcae30971L,
+   0x581c9004L, 0xb0b8c601L, 0x8d9521b9L, 0x653177bcL
+   },
+   {
+   0x00000000L, 0x47f7cec1L, 0x8fef9d82L, 0xc8185343L,
+   0x1b1e26b3L, 0x5ce9e872L, 0x94f1bb31L, 0xd30675f0L,
+   0x363c4d66L, 0x71cb83a7L, 0xb9d3d0e4L, 0xfe241e25L,
+   0x2d226bd5L, 0x6ad5a514L, 0xa2cdf657L, 0xe53a3896L,
+   0x6c789accL, 0x2b8f540dL, 0xe397074eL, 0xa460c98fL,
+   0x7766bc7fL, 0x309172beL, 0xf88921fdL, 0xbf7eef3cL,
+   0x5a44d7aaL, 0x1db3196bL, 0xd5ab4a28L, 0x925c84e9L,
+   0x415af119L, 0x06ad3fd8L, 0xceb56c9bL, 0x8942a25aL,
+   0xd8f13598L, 0x9f06fb59L, 0x571ea81aL, 0x10e966dbL,
+   0xc3ef132bL, 0x8418ddeaL, 0x4c008ea9L, 0x0bf74068L,
+   0xeecd78feL, 0xa93ab63fL, 0x6122e57cL, 0x26d52bbdL,
+   0xf5d35e4dL, 0xb224908cL, 0x7a3cc3cfL, 0x3dcb0d0eL,
+   0xb489af54L, 0xf37e6195L, 0x3b6632d6L, 0x7c91fc17L,
+   0xaf9789e7L, 0xe8604726L, 0x20781465L, 0x678fdaa4L,
+   0x82b5e232L, 0xc5422cf3L, 0x0d5a7fb0L, 0x4aadb171L,
+   0x99abc481L, 0xde5c0a40L, 0x16445903L, 0x51b397c2L,
+   0xb5237687L, 0xf2d4b846L, 0x3acceb05L, 0x7d3b25c4L,
+   0xae3d5034L, 0xe9ca9ef5L, 0x21d2cdb6L, 0x66250377L,
+   0x831f3be1L, 0xc4e8f520L, 0x0cf0a663L, 0x4b0768a2L,
+   0x98011d52L, 0xdff6d393L, 0x17ee80d0L, 0x50194e11L,
+   0xd95bec4bL, 0x9eac228aL, 0x56b471c9L, 0x1143bf08L,
+   0xc245caf8L, 0x85b20439L, 0x4daa577aL, 0x0a5d99bbL,
+   0xef67a12dL, 0xa8906fecL, 0x60883cafL, 0x277ff26eL,
+   0xf479879eL, 0xb38e495fL, 0x7b961a1cL, 0x3c61d4ddL,
+   0x6dd2431fL, 0x2a258ddeL, 0xe23dde9dL, 0xa5ca105cL,
+   0x76cc65acL, 0x313bab6dL, 0xf923f82eL, 0xbed436efL,
+   0x5bee0e79L, 0x1c19c0b8L, 0xd40193fbL, 0x93f65d3aL,
+   0x40f028caL, 0x0707e60bL, 0xcf1fb548L, 0x88e87b89L,
+   0x01aad9d3L, 0x465d1712L, 0x8e454451L, 0xc9b28a90L,
+   0x1ab4ff60L, 0x5d4331a1L, 0x955b62e2L, 0xd2acac23L,
+   0x379694b5L, 0x70615a74L, 0xb8790937L, 0xff8ec7f6L,
+   0x2c88b206L, 0x6b7f7cc7L, 0xa3672f84L, 0xe490e145L,
+   0x6e87f0b9L, 0x29703e78L, 0xe1686d3bL, 0xa69fa3faL,
+   0x7599d60aL, 0x326e18cbL, 0xfa764b88L, 0xbd818549L,
+   0x58bbbddfL, 0x1f4c731eL, 0xd754205dL, 0x90a3ee9cL,
+   0x43a59b6cL, 0x045255adL, 0xcc4a06eeL, 0x8bbdc82fL,
+   0x02ff6a75L, 0x4508a4b4L, 0x8d10f7f7L, 0xcae73936L,
+   0x19e14cc6L, 0x5e168207L, 0x960ed144L, 0xd1f91f85L,
+   0x34c32713L, 0x7334e9d2L, 0xbb2cba91L, 0xfcdb7450L,
+   0x2fdd01a0L, 0x682acf61L, 0xa0329c22L, 0xe7c552e3L,
+   0xb676c521L, 0xf1810be0L, 0x399958a3L, 0x7e6e9662L,
+   0xad68e392L, 0xea9f2d53L, 0x22877e10L, 0x6570b0d1L,
+   0x804a8847L, 0xc7bd4686L, 0x0fa515c5L, 0x4852db04L,
+   0x9b54aef4L, 0xdca36035L, 0x14bb3376L, 0x534cfdb7L,
+   0xda0e5fedL, 0x9df9912cL, 0x55e1c26fL, 0x12160caeL,
+   0xc110795eL, 0x86e7b79fL, 0x4effe4dcL, 0x09082a1dL,
+   0xec32128bL, 0xabc5dc4aL, 0x63dd8f09L, 0x242a41c8L,
+   0xf72c3438L, 0xb0dbfaf9L, 0x78c3a9baL, 0x3f34677bL,
+   0xdba4863eL, 0x9c5348ffL, 0x544b1bbcL, 0x13bcd57dL,
+   0xc0baa08dL, 0x874d6e4cL, 0x4f553d0fL, 0x08a2f3ceL,
+   0xed98cb58L, 0xaa6f0599L, 0x627756daL, 0x2580981bL,
+   0xf686edebL, 0xb171232aL, 0x79697069L, 0x3e9ebea8L,
+   0xb7dc1cf2L, 0xf02bd233L, 0x38338170L, 0x7fc44fb1L,
+   0xacc23a41L, 0xeb35f480L, 0x232da7c3L, 0x64da6902L,
+   0x81e05194L, 0xc6179f55L, 0x0e0fcc16L, 0x49f802d7L,
+   0x9afe7727L, 0xdd09b9e6L, 0x1511eaa5L, 0x52e62464L,
+   0x0355b3a6L, 0x44a27d67L, 0x8cba2e24L, 0xcb4de0e5L,
+   0x184b9515L, 0x5fbc5bd4L, 0x97a40897L, 0xd053c656L,
+   0x3569fec0L, 0x729e3001L, 0xba866342L, 0xfd71ad83L,
+   0x2e77d873L, 0x698016b2L, 0xa19845f1L, 0xe66f8b30L,
+   0x6f2d296aL, 0x28dae7abL, 0xe0c2b4e8L, 0xa7357a29L,
+   0x74330fd9L, 0x33c4c118L, 0xfbdc925bL, 0xbc2b5c9aL,
+   0x5911640cL, 0x1ee6aacdL, 0xd6fef98eL, 0x9109374fL,
+   0x420f42bfL, 0x05f88c7eL, 0xcde0df3dL, 0x8a1711fcL
+   },
+   {
+   0x00000000L, 0xdd0fe172L, 0xbededf53L, 0x63d13e21L,
+   0x797ca311L, 0xa4734263L, 0xc7a27c42L, 0x1aad9d30L,
+   0xf2f94622L, 0x2ff6a750L, 0x4c279971L, 0x91287803L,
+   0x8b85e533L, 0x568a0441L, 0x355b3a60L, 0xe854db12L,
+   0xe13391f3L, 0x3c3c7081L, 0x5fed4ea0L, 0x82e2afd2L,
+   0x984f32e2L, 0x4540d390L, 0x2691edb1L, 0xfb9e0cc3L,
+   0x13cad7d1L, 0xcec536a3L, 0xad140882L, 0x701be9f0L,
+   0x6ab674c0L, 0xb7b995b2L, 0xd468ab93L, 0x09674ae1L,
+   0xc6a63e51L, 0x1ba9df23L, 0x7878e102L, 0xa5770070L,
+   0xbfda9d40L, 0x62d57c32L, 0x01044213L, 0xdc0ba361L,
+   0x345f7873L, 0xe9509901L, 0x8a81a720L, 0x578e4652L,
+   0x4d23db62L, 0x902c3a10L, 0xf3fd0431L, 0x2ef2e543L,
+   0x2795afa2L, 0xfa9a4ed0L, 0x994b70f1L, 0x44449183L,
+   0x5ee90cb3L, 0x83e6edc1L, 0xe037d3e0L, 0x3d383292L,
+   0xd56ce980L, 0x086308f2L, 0x6bb236d3L, 0xb6bdd7a1L,
+   0xac104a91L, 0x711fabe3L, 0x12ce95c2L, 0xcfc174b0L,
+   0x898d6115L, 0x54828067L, 0x3753be46L, 0xea5c5f34L,
+   0xf0f1c204L, 0x2dfe2376L, 0x4e2f1d57L, 0x9320fc25L,
+   0x7b742737L, 0xa67bc645L, 0xc5aaf864L, 0x18a51916L,
+   0x02088426L, 0xdf076554L, 0xbcd65b75L, 0x61d9ba07L,
+   0x68bef0e6L, 0xb5b11194L, 0xd6602fb5L, 0x0b6fcec7L,
+   0x11c253f7L, 0xcccdb285L, 0xaf1c8ca4L, 0x72136dd6L,
+   0x9a47b6c4L, 0x474857b6L, 0x24996997L, 0xf99688e5L,
+   0xe33b15d5L, 0x3e34f4a7L, 0x5de5ca86L, 0x80ea2bf4L,
+   0x4f2b5f44L, 0x9224be36L, 0xf1f58017L, 0x2cfa6165L,
+   0x3657fc55L, 0xeb581d27L, 0x88892306L, 0x5586c274L,
+   0xbdd21966L, 0x60ddf814L, 0x030cc635L, 0xde032747L,
+   0xc4aeba77L, 0x19a15b05L, 0x7a706524L, 0xa77f8456L,
+   0xae18ceb7L, 0x73172fc5L, 0x10c611e4L, 0xcdc9f096L,
+   0xd7646da6L, 0x0a6b8cd4L, 0x69bab2f5L, 0xb4b55387L,
+   0x5ce18895L, 0x81ee69e7L, 0xe23f57c6L, 0x3f30b6b4L,
+   0x259d2b84L, 0xf892caf6L, 0x9b43f4d7L, 0x464c15a5L,
+   0x17dbdf9dL, 0xcad43eefL, 0xa90500ceL, 0x740ae1bcL,
+   0x6ea77c8cL, 0xb3a89dfeL, 0xd079a3dfL, 0x0d7642adL,
+   0xe52299bfL, 0x382d78cdL, 0x5bfc46ecL, 0x86f3a79eL,
+   0x9c5e3aaeL, 0x4151dbdcL, 0x2280e5fdL, 0xff8f048fL,
+   0xf6e84e6eL, 0x2be7af1cL, 0x4836913dL, 0x9539704fL,
+   0x8f94ed7fL, 0x529b0c0dL, 0x314a322cL, 0xec45d35eL,
+   0x0411084cL, 0xd91ee93eL, 0xbacfd71fL, 0x67c0366dL,
+   0x7d6dab5dL, 0xa0624a2fL, 0xc3b3740eL, 0x1ebc957cL,
+   0xd17de1ccL, 0x0c7200beL, 0x6fa33e9fL, 0xb2acdfedL,
+   0xa80142ddL, 0x750ea3afL, 0x16df9d8eL, 0xcbd07cfcL,
+   0x2384a7eeL, 0xfe8b469cL, 0x9d5a78bdL, 0x405599cfL,
+   0x5af804ffL, 0x87f7e58dL, 0xe426dbacL, 0x39293adeL,
+   0x304e703fL, 0xed41914dL, 0x8e90af6cL, 0x539f4e1eL,
+   0x4932d32eL, 0x943d325cL, 0xf7ec0c7dL, 0x2ae3ed0fL,
+   0xc2b7361dL, 0x1fb8d76fL, 0x7c69e94eL, 0xa166083cL,
+   0xbbcb950cL, 0x66c4747eL, 0x05154a5fL, 0xd81aab2dL,
+   0x9e56be88L, 0x43595ffaL, 0x208861dbL, 0xfd8780a9L,
+   0xe72a1d99L, 0x3a25fcebL, 0x59f4c2caL, 0x84fb23b8L,
+   0x6caff8aaL, 0xb1a019d8L, 0xd27127f9L, 0x0f7ec68bL,
+   0x15d35bbbL, 0xc8dcbac9L, 0xab0d84e8L, 0x7602659aL,
+   0x7f652f7bL, 0xa26ace09L, 0xc1bbf028L, 0x1cb4115aL,
+   0x06198c6aL, 0xdb166d18L, 0xb8c75339L, 0x65c8b24bL,
+   0x8d9c6959L, 0x5093882bL, 0x3342b60aL, 0xee4d5778L,
+   0xf4e0ca48L, 0x29ef2b3aL, 0x4a3e151bL, 0x9731f469L,
+   0x58f080d9L, 0x85ff61abL, 0xe62e5f8aL, 0x3b21bef8L,
+   0x218c23c8L, 0xfc83c2baL, 0x9f52fc9bL, 0x425d1de9L,
+   0xaa09c6fbL, 0x77062789L, 0x14d719a8L, 0xc9d8f8daL,
+   0xd37565eaL, 0x0e7a8498L, 0x6dabbab9L, 0xb0a45bcbL,
+   0xb9c3112aL, 0x64ccf058L, 0x071dce79L, 0xda122f0bL,
+   0xc0bfb23bL, 0x1db05349L, 0x7e616d68L, 0xa36e8c1aL,
+   0x4b3a5708L, 0x9635b67aL, 0xf5e4885bL, 0x28eb6929L,
+   0x3246f419L, 0xef49156bL, 0x8c982b4aL, 0x5197ca38L
+   },
+   {
+   0x00000000L, 0x2fb7bf3aL, 0x5f6f7e74L, 0x70d8c14eL,
+   0xbedefce8L, 0x916943d2L, 0xe1b1829cL, 0xce063da6L,
+   0x797ce467L, 0x56cb5b5dL, 0x26139a13L, 0x09a42529L,
+   0xc7a2188fL, 0xe815a7b5L, 0x98cd66fbL, 0xb77ad9c1L,
+   0xf2f9c8ceL, 0xdd4e77f4L, 0xad96b6baL, 0x82210980L,
+   0x4c273426L, 0x63908b1cL, 0x13484a52L, 0x3cfff568L,
+   0x8b852ca9L, 0xa4329393L, 0xd4ea52ddL, 0xfb5dede7L,
+   0x355bd041L, 0x1aec6f7bL, 0x6a34ae35L, 0x4583110fL,
+   0xe1328c2bL, 0xce853311L, 0xbe5df25fL, 0x91ea4d65L,
+   0x5fec70c3L, 0x705bcff9L, 0x00830eb7L, 0x2f34b18dL,
+   0x984e684cL, 0xb7f9d776L, 0xc7211638L, 0xe896a902L,
+   0x269094a4L, 0x09272b9eL, 0x79ffead0L, 0x564855eaL,
+   0x13cb44e5L, 0x3c7cfbdfL, 0x4ca43a91L, 0x631385abL,
+   0xad15b80dL, 0x82a20737L, 0xf27ac679L, 0xddcd7943L,
+   0x6ab7a082L, 0x45001fb8L, 0x35d8def6L, 0x1a6f61ccL,
+   0xd4695c6aL, 0xfbdee350L, 0x8b06221eL, 0xa4b19d24L,
+   0xc6a405e1L, 0xe913badbL, 0x99cb7b95L, 0xb67cc4afL,
+   0x787af909L, 0x57cd4633L, 0x2715877dL, 0x08a23847L,
+   0xbfd8e186L, 0x906f5ebcL, 0xe0b79ff2L, 0xcf0020c8L,
+   0x01061d6eL, 0x2eb1a254L, 0x5e69631aL, 0x71dedc20L,
+   0x345dcd2fL, 0x1bea7215L, 0x6b32b35bL, 0x44850c61L,
+   0x8a8331c7L, 0xa5348efdL, 0xd5ec4fb3L, 0xfa5bf089L,
+   0x4d212948L, 0x62969672L, 0x124e573cL, 0x3df9e806L,
+   0xf3ffd5a0L, 0xdc486a9aL, 0xac90abd4L, 0x832714eeL,
+   0x279689caL, 0x082136f0L, 0x78f9f7beL, 0x574e4884L,
+   0x99487522L, 0xb6ffca18L, 0xc6270b56L, 0xe990b46cL,
+   0x5eea6dadL, 0x715dd297L, 0x018513d9L, 0x2e32ace3L,
+   0xe0349145L, 0xcf832e7fL, 0xbf5bef31L, 0x90ec500bL,
+   0xd56f4104L, 0xfad8fe3eL, 0x8a003f70L, 0xa5b7804aL,
+   0x6bb1bdecL, 0x440602d6L, 0x34dec398L, 0x1b697ca2L,
+   0xac13a563L, 0x83a41a59L, 0xf37cdb17L, 0xdccb642dL,
+   0x12cd598bL, 0x3d7ae6b1L, 0x4da227ffL, 0x621598c5L,
+   0x89891675L, 0xa63ea94fL, 0xd6e66801L, 0xf951d73bL,
+   0x3757ea9dL, 0x18e055a7L, 0x683894e9L, 0x478f2bd3L,
+   0xf0f5f212L, 0xdf424d28L, 0xaf9a8c66L, 0x802d335cL,
+   0x4e2b0efaL, 0x619cb1c0L, 0x1144708eL, 0x3ef3cfb4L,
+   0x7b70debbL, 0x54c76181L, 0x241fa0cfL, 0x0ba81ff5L,
+   0xc5ae2253L, 0xea199d69L, 0x9ac15c27L, 0xb576e31dL,
+   0x020c3adcL, 0x2dbb85e6L, 0x5d6344a8L, 0x72d4fb92L,
+   0xbcd2c634L, 0x9365790eL, 0xe3bdb840L, 0xcc0a077aL,
+   0x68bb9a5eL, 0x470c2564L, 0x37d4e42aL, 0x18635b10L,
+   0xd66566b6L, 0xf9d2d98cL, 0x890a18c2L, 0xa6bda7f8L,
+   0x11c77e39L, 0x3e70c103L, 0x4ea8004dL, 0x611fbf77L,
+   0xaf1982d1L, 0x80ae3debL, 0xf076fca5L, 0xdfc1439fL,
+   0x9a425290L, 0xb5f5edaaL, 0xc52d2ce4L, 0xea9a93deL,
+   0x249cae78L, 0x0b2b1142L, 0x7bf3d00cL, 0x54446f36L,
+   0xe33eb6f7L, 0xcc8909cdL, 0xbc51c883L, 0x93e677b9L,
+   0x5de04a1fL, 0x7257f525L, 0x028f346bL, 0x2d388b51L,
+   0x4f2d1394L, 0x609aacaeL, 0x10426de0L, 0x3ff5d2daL,
+   0xf1f3ef7cL, 0xde445046L, 0xae9c9108L, 0x812b2e32L,
+   0x3651f7f3L, 0x19e648c9L, 0x693e8987L, 0x468936bdL,
+   0x888f0b1bL, 0xa738b421L, 0xd7e0756fL, 0xf857ca55L,
+   0xbdd4db5aL, 0x92636460L, 0xe2bba52eL, 0xcd0c1a14L,
+   0x030a27b2L, 0x2cbd9888L, 0x5c6559c6L, 0x73d2e6fcL,
+   0xc4a83f3dL, 0xeb1f8007L, 0x9bc74149L, 0xb470fe73L,
+   0x7a76c3d5L, 0x55c17cefL, 0x2519bda1L, 0x0aae029bL,
+   0xae1f9fbfL, 0x81a82085L, 0xf170e1cbL, 0xdec75ef1L,
+   0x10c16357L, 0x3f76dc6dL, 0x4fae1d23L, 0x6019a219L,
+   0xd7637bd8L, 0xf8d4c4e2L, 0x880c05acL, 0xa7bbba96L,
+   0x69bd8730L, 0x460a380aL, 0x36d2f944L, 0x1965467eL,
+   0x5ce65771L, 0x7351e84bL, 0x03892905L, 0x2c3e963fL,
+   0xe238ab99L, 0xcd8f14a3L, 0xbd57d5edL, 0x92e06ad7L,
+   0x259ab316L, 0x0a2d0c2cL, 0x7af5cd62L, 0x55427258L,
+   0x9b444ffeL, 0xb4f3f0c4L, 0xc42b318aL, 0xeb9c8eb0L
+   }
+};
+
+
+/*--
+  x86 processors with PCLMULQDQ fold the data 64 bytes at a
+  time with carry-less multiplies instead (Gopal et al., "Fast
+  CRC Computation for Generic Polynomials Using PCLMULQDQ
+  Instruction", Intel 2009), chosen when first used.
+--*/
+
+#ifndef NO_CRC_SIMD
+#if (defined(__i386__) || defined(__x86_64__)) && (defined(__clang__) || \
+    (defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))))
+#define BZ_CRC_PCLMUL
+#define BZ_CRC_TARGET __attribute__((target("sse2,ssse3,pclmul")))
+#include <cpuid.h>
+#elif (defined(_M_IX86) || defined(_M_X64)) && defined(_MSC_VER) && (_MSC_VER >= 1500)
+#define BZ_CRC_PCLMUL
+#define BZ_CRC_TARGET
+#include <intrin.h>
+#endif
+#endif
+
+#ifdef BZ_CRC_PCLMUL
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+
+#ifdef __GNUC__
+#define BZ_CPU_LOAD(v)    __atomic_load_n(&(v), __ATOMIC_RELAXED)
+#define BZ_CPU_STORE(v,x) __atomic_store_n(&(v), (x), __ATOMIC_RELAXED)
+#else
+#define BZ_CPU_LOAD(v)    (v)
+#define BZ_CPU_STORE(v,x) ((v) = (x))
+#endif
+
+/*---------------------------------------------------*/
+/* 1 if the processor has PCLMULQDQ and SSSE3, checked
+   once (a race only repeats it) */
+static
+Int32 hasPclmul ( void )
+{
+   static volatile Int32 pclmul = -1;
+   Int32 has = BZ_CPU_LOAD(pclmul);
+
+   if (has < 0) {
+#ifdef __GNUC__
+      unsigned int a, b, c, d;
+      has = __get_cpuid ( 1, &a, &b, &c, &d ) && (c & 2) && (c & 0x200);
+#else
+      int r[4];
+      __cpuid ( r, 1 );
+      has = (r[2] & 2) && (r[2] & 0x200);
+#endif
+      BZ_CPU_STORE(pclmul, has);
+   }
+   return has;
+}
+
+
+/*---------------------------------------------------*/
+/*--
+  Lanes are loaded byte reversed, so bit 127 is the first bit
+  of the data (its highest power).  Constants are x^n mod p,
+  as pairs for the low and high 64 bits of a lane: folding 512
+  bits (four lanes) at a time, then 128 bits (one lane), then
+  96 and 64 bits for the final reduction, and the Barrett
+  reduction (x^64 divided by p, and p).  len is at least 64.
+--*/
+
+#define BZ_LOADR(p) \
+   _mm_shuffle_epi8 ( _mm_loadu_si128 ( (const __m128i*)(const void*)(p) ), swap )
+
+#define BZ_FOLD(x,k,y)                                   \
+   _mm_xor_si128 ( _mm_xor_si128 (                       \
+      _mm_clmulepi64_si128 ( x, k, 0x00 ),               \
+      _mm_clmulepi64_si128 ( x, k, 0x11 ) ), y )
+
+static BZ_CRC_TARGET
+UInt32 crcPclmul ( UInt32 crc, const UChar* buf, Int32 len )
+{
+   __m128i swap, k, x1, x2, x3, x4, t;
+
+   swap = _mm_set_epi8 ( 0, 1, 2, 3, 4, 5, 6, 7,
+                         8, 9, 10, 11, 12, 13, 14, 15 );
+
+   /* four lanes, with the crc register in the first bits */
+   x1 = _mm_xor_si128 ( BZ_LOADR(buf), _mm_set_epi32 ( (int)crc, 0, 0, 0 ) );
+   x2 = BZ_LOADR(buf + 16);
+   x3 = BZ_LOADR(buf + 32);
+   x4 = BZ_LOADR(buf + 48);
+   buf += 64; len -= 64;
+
+   k = _mm_set_epi32 ( 0, (int)0x8833794cUL, 0, (int)0xe6228b11UL );
+   while (len >= 64) {
+      x1 = BZ_FOLD(x1, k, BZ_LOADR(buf));
+      x2 = BZ_FOLD(x2, k, BZ_LOADR(buf + 16));
+      x3 = BZ_FOLD(x3, k, BZ_LOADR(buf + 32));
+      x4 = BZ_FOLD(x4, k, BZ_LOADR(buf + 48));
+      buf += 64; len -= 64;
+   }
+
+   /* fold into one lane, then take the remaining whole lanes */
+   k = _mm_set_epi32 ( 0, (int)0xc5b9cd4cUL, 0, (int)0xe8a45605UL );
+   x1 = BZ_FOLD(x1, k, x2);
+   x1 = BZ_FOLD(x1, k, x3);
+   x1 = BZ_FOLD(x1, k, x4);
+   while (len >= 16) {
+      x1 = BZ_FOLD(x1, k, BZ_LOADR(buf));
+      buf += 16; len -= 16;
+   }
+
+   /* lane times x^32 to 96 bits, then to 64 bits */
+   k = _mm_set_epi32 ( 0, (int)0x490d678dUL, 0, (int)0xf200aa66UL );
+   t = _mm_xor_si128 ( _mm_clmulepi64_si128 ( x1, k, 0x01 ),
+                       _mm_slli_si128 ( _mm_move_epi64 ( x1 ), 4 ) );
+   t = _mm_xor_si128 ( _mm_clmulepi64_si128 ( _mm_srli_si128 ( t, 8 ), k, 0x10 ),
+                       _mm_move_epi64 ( t ) );
+
+   /* Barrett reduction to 32 bits */
+   k = _mm_set_epi32 ( 1, (int)0x04c11db7UL, 1, (int)0x04d101dfUL );
+   x1 = _mm_clmulepi64_si128 ( _mm_srli_epi64 ( t, 32 ), k, 0x00 );
+   x1 = _mm_clmulepi64_si128 ( _mm_srli_epi64 ( x1, 32 ), k, 0x10 );
+   crc = (UInt32)_mm_cvtsi128_si32 ( _mm_xor_si128 ( t, x1 ) );
+
+   /* bytes left over */
+   return BZ2_crcBlock ( crc, buf, len );
+}
+#endif /* BZ_CRC_PCLMUL */
+
+
+/*---------------------------------------------------*/
+UInt32 BZ2_crcBlock ( UInt32 crc, const UChar* buf, Int32 len )
+{
+   UInt32 c = crc;
+
+#ifdef BZ_CRC_PCLMUL
+   if (len >= 64 && hasPclmul())
+      return crcPclmul ( c, buf, len );
+#endif
+
+   while (len >= 16) {
+      c ^= ((UInt32)buf[0] << 24) | ((UInt32)buf[1] << 16) |
+           ((UInt32)buf[2] << 8) | buf[3];
+      c = BZ2_crc32Slice[14][c >> 24] ^
+          BZ2_crc32Slice[13][(c >> 16) & 0xff] ^
+          BZ2_crc32Slice[12][(c >> 8) & 0xff] ^
+          BZ2_crc32Slice[11][c & 0xff] ^
+          BZ2_crc32Slice[10][buf[4]] ^ BZ2_crc32Slice[9][buf[5]] ^
+          BZ2_crc32Slice[8][buf[6]] ^ BZ2_crc32Slice[7][buf[7]] ^
+          BZ2_crc32Slice[6][buf[8]] ^ BZ2_crc32Slice[5][buf[9]] ^
+          BZ2_crc32Slice[4][buf[10]] ^ BZ2_crc32Slice[3][buf[11]] ^
+          BZ2_crc32Slice[2][buf[12]] ^ BZ2_crc32Slice[1][buf[13]] ^
+          BZ2_crc32Slice[0][buf[14]] ^ BZ2_crc32Table[buf[15]];
+      buf += 16; len -= 16;
+   }
+   while (len > 0) {
+      BZ_UPDATE_CRC ( c, *buf );
+      buf++; len--;
+   }
+   return c;
+}
+
+
 /*-------------------------------------------------------------*/
 /*--- end                                        crctable.c ---*/
 /*-------------------------------------------------------------*/
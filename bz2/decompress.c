@@ -111,6 +111,12 @@ void makeMaps_d ( DState* s )
    GET_BITS(lll,uuu,1)
 
 /*---------------------------------------------------*/
+/* Codes of up to BZ_LOOKUP_BITS bits are decoded with one
+   lookup once the bit buffer is topped up (the block is
+   always followed by at least 80 more bits, so no input
+   past the stream is taken); longer ones, or when input
+   runs short, a bit at a time through limit[].
+*/
 #define GET_MTF_VAL(label1,label2,lval)           \
 {                                                 \
    if (groupPos == 0) {                           \
@@ -123,22 +129,176 @@ void makeMaps_d ( DState* s )
       gLimit = &(s->limit[gSel][0]);              \
       gPerm = &(s->perm[gSel][0]);                \
       gBase = &(s->base[gSel][0]);                \
+      gLookup = &(s->lookup[gSel][0]);            \
    }                                              \
    groupPos--;                                    \
-   zn = gMinlen;                                  \
-   GET_BITS(label1, zvec, zn);                    \
-   while (1) {                                    \
-      if (zn > 20 /* the longest code */)         \
+   while (s->bsLive <= 24                         \
+          && s->strm->avail_in > 0) {             \
+      s->bsBuff                                   \
+         = (s->bsBuff << 8) |                     \
+           ((UInt32)                              \
+              (*((UChar*)(s->strm->next_in))));   \
+      s->bsLive += 8;                             \
+      s->strm->next_in++;                         \
+      s->strm->avail_in--;                        \
+      s->strm->total_in_lo32++;                   \
+      if (s->strm->total_in_lo32 == 0)            \
+         s->strm->total_in_hi32++;                \
+   }                                              \
+   if (s->bsLive >= BZ_LOOKUP_BITS                \
+       && (zl = gLookup[(s->bsBuff >>             \
+                  (s->bsLive - BZ_LOOKUP_BITS))   \
+                  & ((1 << BZ_LOOKUP_BITS) - 1)]) \
+          != 0) {                                 \
+      s->bsLive -= zl & 31;                       \
+      lval = zl >> 5;                             \
+   } else {                                       \
+      zn = gMinlen;                               \
+      GET_BITS(label1, zvec, zn);                 \
+      while (1) {                                 \
+         if (zn > 20 /* the longest code */)      \
+            RETURN(BZ_DATA_ERROR);                \
+         if (zvec <= gLimit[zn]) break;           \
+         zn++;                                    \
+         GET_BIT(label2, zj);                     \
+         zvec = (zvec << 1) | zj;                 \
+      };                                          \
+      if (zvec - gBase[zn] < 0                    \
+          || zvec - gBase[zn] >= BZ_MAX_ALPHA_SIZE) \
          RETURN(BZ_DATA_ERROR);                   \
-      if (zvec <= gLimit[zn]) break;              \
-      zn++;                                       \
-      GET_BIT(label2, zj);                        \
-      zvec = (zvec << 1) | zj;                    \
-   };                                             \
-   if (zvec - gBase[zn] < 0                       \
-       || zvec - gBase[zn] >= BZ_MAX_ALPHA_SIZE)  \
-      RETURN(BZ_DATA_ERROR);                      \
-   lval = gPerm[zvec - gBase[zn]];                \
+      lval = gPerm[zvec - gBase[zn]];             \
+   }                                              \
+}
+
+
+/*---------------------------------------------------*/
+/* Follows T^(-1) from tt into s->bwt.  Each step of the
+   chain is a cache miss, so BZ_CHAINS chains are followed
+   at the same time: from the start of the block and from
+   places spread over tt (somewhere in the block), each
+   stopping where another began (marked in tt).  Their
+   bytes go to BZ_CHUNK byte chunks after the first nblock
+   bytes of bwt, copied there in order once all have
+   stopped.  A corrupt block (tt not one cycle) is done
+   with one chain, as it always was.  The 8 bytes the
+   chain gives after the block follow it, as the run-length
+   decoding may read that far.
+*/
+#define BZ_MARK 0x80000000UL
+
+#define BZ_CHAIN_STEP(ccc)                        \
+   if (!done[ccc]) {                              \
+      w = tt[pos[ccc]];                           \
+      if ((w & BZ_MARK) && len[ccc] > 0) {        \
+         done[ccc] = True;                        \
+         live--;                                  \
+      } else {                                    \
+         if (out[ccc] == end[ccc]) {              \
+            chunkNext[last[ccc]] = nchunks;       \
+            last[ccc] = nchunks;                  \
+            chunkNext[nchunks] = -1;              \
+            out[ccc] = chunks + nchunks * BZ_CHUNK; \
+            end[ccc] = out[ccc] + BZ_CHUNK;       \
+            nchunks++;                            \
+         }                                        \
+         *out[ccc]++ = (UChar)w;                  \
+         len[ccc]++;                              \
+         total++;                                 \
+         pos[ccc] = (w & ~BZ_MARK) >> 8;          \
+      }                                           \
+   }
+
+static
+void unBWT ( DState* s, Int32 nblock )
+{
+   UInt32* tt     = s->tt;
+   UChar*  bwt    = s->bwt;
+   UChar*  chunks = bwt + nblock;
+   UInt32  start[BZ_CHAINS], pos[BZ_CHAINS], w;
+   UChar*  out[BZ_CHAINS];
+   UChar*  end[BZ_CHAINS];
+   Int32   len[BZ_CHAINS], last[BZ_CHAINS], next[BZ_CHAINS];
+   Bool    done[BZ_CHAINS];
+   Int32   chunkNext[BZ_MAX_CHUNKS];
+   Int32   i, j, c, at, total = 0, nchunks, live = BZ_CHAINS;
+
+   start[0] = tt[s->origPtr] >> 8;
+   for (i = 1; i < BZ_CHAINS; i++)
+      start[i] = (UInt32)((nblock / BZ_CHAINS) * i);
+   for (i = 0; i < BZ_CHAINS; i++) {
+      for (j = 0; j < i; j++)
+         if (start[j] == start[i]) live = 0;
+      pos[i] = start[i];
+      len[i] = 0;
+      done[i] = False;
+      last[i] = i;
+      chunkNext[i] = -1;
+      out[i] = chunks + i * BZ_CHUNK;
+      end[i] = out[i] + BZ_CHUNK;
+   }
+   nchunks = BZ_CHAINS;
+   if (nblock < 64 * BZ_CHAINS) live = 0;
+
+   if (live) {
+      for (i = 0; i < BZ_CHAINS; i++) tt[start[i]] |= BZ_MARK;
+
+      while (live > 0 && total + BZ_CHAINS <= nblock) {
+         BZ_CHAIN_STEP(0)
+         BZ_CHAIN_STEP(1)
+         BZ_CHAIN_STEP(2)
+         BZ_CHAIN_STEP(3)
+         BZ_CHAIN_STEP(4)
+         BZ_CHAIN_STEP(5)
+         BZ_CHAIN_STEP(6)
+         BZ_CHAIN_STEP(7)
+      }
+      /* the last few steps (or a corrupt block), one at a time */
+      while (live > 0 && total < nblock)
+         for (i = 0; i < BZ_CHAINS && total < nblock; i++) {
+            BZ_CHAIN_STEP(i)
+         }
+
+      /* each must have got to another's start (the last without
+         looking), making one cycle through them all that covers
+         the block */
+      for (i = 0; i < BZ_CHAINS; i++) {
+         next[i] = -1;
+         for (j = 0; j < BZ_CHAINS; j++)
+            if (start[j] == pos[i] && (tt[pos[i]] & BZ_MARK)) next[i] = j;
+      }
+      for (i = 0, j = 0, total = 0; i < BZ_CHAINS && j >= 0; i++) {
+         total += len[j];
+         j = next[j];
+         if (j == 0) break;
+      }
+      live = (j == 0 && i == BZ_CHAINS - 1 && total == nblock);
+
+      for (i = 0; i < BZ_CHAINS; i++) tt[start[i]] &= ~BZ_MARK;
+   }
+
+   if (live) {
+      at = 0;
+      j = 0;
+      do {
+         total = len[j];
+         for (c = j; total > 0; c = chunkNext[c]) {
+            UChar* from = chunks + c * BZ_CHUNK;
+            Int32  n = (total < BZ_CHUNK) ? total : BZ_CHUNK;
+            for (i = 0; i < n; i++) bwt[at + i] = from[i];
+            at += n;
+            total -= n;
+         }
+         j = next[j];
+      } while (j != 0);
+      w = start[0];
+   } else {
+      for (w = start[0], i = 0; i < nblock; i++) {
+         w = tt[w]; bwt[i] = (UChar)w; w >>= 8;
+      }
+   }
+   for (i = 0; i < 8; i++) {
+      w = tt[w]; bwt[nblock + i] = (UChar)w; w >>= 8;
+   }
 }
 
 
@@ -175,6 +335,8 @@ Int32 BZ2_decompress ( DState* s )
    Int32* gLimit;
    Int32* gBase;
    Int32* gPerm;
+   UInt16* gLookup;
+   UInt32 zl;
 
    if (s->state == BZ_X_MAGIC_1) {
       /*initialise the save area*/
@@ -229,6 +391,7 @@ Int32 BZ2_decompress ( DState* s )
    gLimit      = s->save_gLimit;
    gBase       = s->save_gBase;
    gPerm       = s->save_gPerm;
+   gLookup     = &(s->lookup[gSel][0]);
 
    retVal = BZ_OK;
 
@@ -256,7 +419,9 @@ Int32 BZ2_decompress ( DState* s )
          if (s->ll16 == NULL || s->ll4 == NULL) RETURN(BZ_MEM_ERROR);
       } else {
          s->tt  = BZALLOC( s->blockSize100k * 100000 * sizeof(Int32) );
-         if (s->tt == NULL) RETURN(BZ_MEM_ERROR);
+         s->bwt = BZALLOC( 2 * s->blockSize100k * 100000
+                           + BZ_CHAINS * BZ_CHUNK );
+         if (s->tt == NULL || s->bwt == NULL) RETURN(BZ_MEM_ERROR);
       }
 
       GET_UCHAR(BZ_X_BLKHDR_1, uc);
@@ -384,6 +549,13 @@ Int32 BZ2_decompress ( DState* s )
             minLen, maxLen, alphaSize
          );
          s->minLens[t] = minLen;
+         BZ2_hbCreateLookup (
+            &(s->lookup[t][0]),
+            &(s->limit[t][0]),
+            &(s->base[t][0]),
+            &(s->perm[t][0]),
+            minLen
+         );
       }
 
       /*--- Now the MTF values ---*/
@@ -582,8 +754,8 @@ Int32 BZ2_decompress ( DState* s )
             s->tt[s->cftab[uc]] |= (i << 8);
             s->cftab[uc]++;
          }
+         unBWT ( s, nblock );
 
-         s->tPos = s->tt[s->origPtr] >> 8;
          s->nblock_used = 0;
          if (s->blockRandomised) {
             BZ_RAND_INIT_MASK;
@@ -240,6 +240,34 @@ void BZ2_hbCreateDecodeTables ( Int32 *limit,
 }
 
 
+/*---------------------------------------------------*/
+/* lookup[v], for each BZ_LOOKUP_BITS bit prefix v of the input, is
+   (symbol << 5) | code length as GET_MTF_VAL would decode it, or 0 if
+   the code is longer (or not valid, left to GET_MTF_VAL to report). */
+void BZ2_hbCreateLookup ( UInt16 *lookup,
+                          Int32 *limit,
+                          Int32 *base,
+                          Int32 *perm,
+                          Int32 minLen )
+{
+   Int32 v, zn, zvec;
+
+   for (v = 0; v < (1 << BZ_LOOKUP_BITS); v++) {
+      lookup[v] = 0;
+      for (zn = minLen; zn <= BZ_LOOKUP_BITS; zn++) {
+         zvec = v >> (BZ_LOOKUP_BITS - zn);
+         if (zvec <= limit[zn]) {
+            zvec -= base[zn];
+            if (zvec >= 0 && zvec < BZ_MAX_ALPHA_SIZE &&
+                perm[zvec] >= 0 && perm[zvec] < BZ_MAX_ALPHA_SIZE)
+               lookup[v] = (UInt16)((perm[zvec] << 5) | zn);
+            break;
+         }
+      }
+   }
+}
+
+
 /*-------------------------------------------------------------*/
 /*--- end                                         huffman.c ---*/
 /*-------------------------------------------------------------*/
@@ -0,0 +1,316 @@
+/*
+ * codec - compression methods tarballs may be read with
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * The table below, in the order probes are tried, and the small adapters
+ * giving each decoder the same calls.  gzip and plain tarballs are read by
+ * gzio itself, their state is the gzFile.  Methods not built in (untar.h
+ * ENABLE_*) keep their probe and extensions, so such a tarball is still
+ * recognised and refused rather than read as gzip.
+ */
+
+#include "untar.h"
+#include "codec.h"
+
+#ifdef ENABLE_LZMA
+#include "lzma/lzma.h"
+#endif
+#ifdef ENABLE_XZ
+#include "lzma/xz.h"
+#endif
+#ifdef ENABLE_ZSTD
+#include "zstd/zstd.h"
+#endif
+#ifdef ENABLE_LZ4
+#include "lz4/lz4.h"
+#endif
+#ifdef ENABLE_BZ2
+#include "bz2/bz2.h"
+void bz_internal_error ( int errcode ) { PrintMessage(_T("BZ2: internal error decompressing!")); }
+#endif
+
+
+/* bzip2 decoder memory for block size k (1-9, hundreds of KB), the fast
+   one keeps 6 bytes per block byte (and 32 KB of chunks), the small one
+   2.5; besides the block arrays its state and buffers take about
+   BZ2_STATEMEM */
+#define BZ2_STATEMEM     (88UL << 10)
+#define BZ2_FASTMEM(k)   ((unsigned long)(k) * 600000UL + (32UL << 10) + BZ2_STATEMEM)
+#define BZ2_SMALLMEM(k)  ((unsigned long)(k) * 250000UL + BZ2_STATEMEM)
+
+
+/*** probes ***/
+
+/* gnu/posix tar, header checksum matches */
+static int probeTar(const unsigned char *buf, unsigned len)
+{
+  return ((len >= sizeof(struct tar_header)) && valid_checksum((struct tar_header *)buf)) ? PROBE_MAGIC : PROBE_NO;
+}
+
+/* "\037\213" */
+static int probeGz(const unsigned char *buf, unsigned len)
+{
+  return ((len >= 2) && (buf[0] == 0x1F) && (buf[1] == 0x8B)) ? PROBE_MAGIC : PROBE_NO;
+}
+
+/* "\037\235" */
+static int probeZ(const unsigned char *buf, unsigned len)
+{
+  return ((len >= 2) && (buf[0] == 0x1F) && (buf[1] == 0x9D)) ? PROBE_MAGIC : PROBE_NO;
+}
+
+/* "BZ" (bzip), the version "h" (2) isn't checked */
+static int probeBz2(const unsigned char *buf, unsigned len)
+{
+  return ((len >= 2) && (buf[0] == 'B') && (buf[1] == 'Z')) ? PROBE_MAGIC : PROBE_NO;
+}
+
+/* "\3757zXZ\0" */
+static int probeXz(const unsigned char *buf, unsigned len)
+{
+  return ((len >= 6) && (memcmp(buf, "\3757zXZ", 6) == 0)) ? PROBE_MAGIC : PROBE_NO;
+}
+
+/* "\050\265\057\375", or a skippable frame ("\120"-"\137" then "\052\115\030") */
+static int probeZstd(const unsigned char *buf, unsigned len)
+{
+  return ((len >= 4) && ((memcmp(buf, "\050\265\057\375", 4) == 0) ||
+          (((buf[0] & 0xF0) == 0x50) && (memcmp(buf + 1, "\052\115\030", 3) == 0)))) ? PROBE_MAGIC : PROBE_NO;
+}
+
+/* "\004\042\115\030" */
+static int probeLz4(const unsigned char *buf, unsigned len)
+{
+  return ((len >= 4) && (memcmp(buf, "\004\042\115\030", 4) == 0)) ? PROBE_MAGIC : PROBE_NO;
+}
+
+/* no marker, but the first byte is the properties byte, lc/lp/pb below 9*5*5 */
+static int probeLzma(const unsigned char *buf, unsigned len)
+{
+  return ((len >= 1) && (buf[0] < (9*5*5))) ? PROBE_WEAK : PROBE_NO;
+}
+
+
+/*** adapters ***/
+
+/* gzip and plain, read by gzio */
+static int openGz(gzFile in, void **state, unsigned long maxmem, int threads)
+{
+  *state = in;
+  return 0;
+}
+
+static long readptrGz(void *state, const Bytef **p, unsigned len)
+{
+  return gzreadptr((gzFile)state, p, len);
+}
+
+static long readGz(void *state, Bytef *buf, unsigned len)
+{
+  return gzread((gzFile)state, buf, len);
+}
+
+#ifdef ENABLE_BZ2
+static int openBz2(gzFile in, void **state, unsigned long maxmem, int threads)
+{
+  char magic[4];   /* stream header, read ahead when limited and handed back */
+  int n = 0, small = 0, bzerror;
+
+  if (maxmem != 0)
+  {
+    int k = 9;
+    if (((n = gzread(in, magic, 4)) == 4) && (magic[3] >= '1') && (magic[3] <= '9'))
+      k = magic[3] - '0';
+    if (n < 0) n = 0;
+    if (BZ2_SMALLMEM(k) > maxmem)
+    {
+      PrintMessage(_T("Error: bzip2 block size of %d00 KB needs %lu KB, over the %lu KB memory budget for decoding"),
+                   k, BZ2_SMALLMEM(k) >> 10, maxmem >> 10);
+      *state = NULL;
+      return -1;
+    }
+    small = (BZ2_FASTMEM(k) > maxmem);
+  }
+  *state = BZ2_bzReadOpen(&bzerror, in, 0, small, n ? magic : NULL, n);
+  return bzerror;
+}
+
+static void closeBz2(void *state)
+{
+  int bzerror;
+  BZ2_bzReadClose(&bzerror, (BZFILE *)state);
+}
+
+static long readBz2(void *state, Bytef *buf, unsigned len)
+{
+  int bzerror;
+  int n = BZ2_bzRead(&bzerror, (BZFILE *)state, buf, len);
+  return ((bzerror == BZ_OK) || (bzerror == BZ_STREAM_END)) ? n : -1;
+}
+#endif
+
+#ifdef ENABLE_LZMA
+static int openLzma(gzFile in, void **state, unsigned long maxmem, int threads)
+{
+  return lzma_init(in, (LZMAFile **)state, maxmem);
+}
+
+static void closeLzma(void *state)
+{
+  lzma_cleanup((LZMAFile *)state);
+}
+
+static long readptrLzma(void *state, const Bytef **p, unsigned len)
+{
+  return lzma_readptr((LZMAFile *)state, p, len);
+}
+
+static long readLzma(void *state, Bytef *buf, unsigned len)
+{
+  return lzma_read((LZMAFile *)state, buf, len);
+}
+#endif
+
+#ifdef ENABLE_XZ
+static int openXz(gzFile in, void **state, unsigned long maxmem, int threads)
+{
+  return xz_init(in, (XZFile **)state, maxmem, threads);
+}
+
+static void closeXz(void *state)
+{
+  xz_cleanup((XZFile *)state);
+}
+
+static long readptrXz(void *state, const Bytef **p, unsigned len)
+{
+  return xz_readptr((XZFile *)state, p, len);
+}
+
+static long readXz(void *state, Bytef *buf, unsigned len)
+{
+  return xz_read((XZFile *)state, buf, len);
+}
+#endif
+
+#ifdef ENABLE_ZSTD
+static int openZstd(gzFile in, void **state, unsigned long maxmem, int threads)
+{
+  return zstd_init(in, (ZSTDFile **)state, maxmem, threads);
+}
+
+static void closeZstd(void *state)
+{
+  zstd_cleanup((ZSTDFile *)state);
+}
+
+static long readptrZstd(void *state, const Bytef **p, unsigned len)
+{
+  return zstd_readptr((ZSTDFile *)state, p, len);
+}
+
+static long readZstd(void *state, Bytef *buf, unsigned len)
+{
+  return zstd_read((ZSTDFile *)state, buf, len);
+}
+
+static long skipZstd(void *state, unsigned long len)
+{
+  return zstd_skip((ZSTDFile *)state, len);
+}
+#endif
+
+#ifdef ENABLE_LZ4
+static int openLz4(gzFile in, void **state, unsigned long maxmem, int threads)
+{
+  return lz4_init(in, (LZ4File **)state, maxmem);
+}
+
+static void closeLz4(void *state)
+{
+  lz4_cleanup((LZ4File *)state);
+}
+
+static long readptrLz4(void *state, const Bytef **p, unsigned len)
+{
+  return lz4_readptr((LZ4File *)state, p, len);
+}
+
+static long readLz4(void *state, Bytef *buf, unsigned len)
+{
+  return lz4_read((LZ4File *)state, buf, len);
+}
+#endif
+
+
+/*** registry ***/
+
+/* recognised only */
+#define UNSUPPORTED(cm, exts, probe) { cm, exts, probe, NULL, NULL, NULL, NULL, NULL, 0 }
+
+/* probes are tried in this order, so stronger markers come first: a
+   valid tar header checksum (a plain tarball), then the magic bytes */
+static const struct tgz_codec codecs[] = {
+  { CM_NONE, "", probeTar, openGz, NULL, readptrGz, readGz, NULL, CODEC_SEEKABLE },
+  { CM_GZ, "tgz\0gz\0", probeGz, openGz, NULL, readptrGz, readGz, NULL, 0 },
+  UNSUPPORTED(CM_Z, "", probeZ),
+#ifdef ENABLE_BZ2
+  { CM_BZ2, "tbz\0bz2\0", probeBz2, openBz2, closeBz2, NULL, readBz2, NULL, 0 },
+#else
+  UNSUPPORTED(CM_BZ2, "tbz\0bz2\0", probeBz2),
+#endif
+#ifdef ENABLE_XZ
+  { CM_XZ, "txz\0xz\0", probeXz, openXz, closeXz, readptrXz, readXz, NULL, CODEC_PARALLEL },
+#else
+  UNSUPPORTED(CM_XZ, "txz\0xz\0", probeXz),
+#endif
+#ifdef ENABLE_ZSTD
+  { CM_ZSTD, "tzst\0zst\0", probeZstd, openZstd, closeZstd, readptrZstd, readZstd, skipZstd, CODEC_PARALLEL },
+#else
+  UNSUPPORTED(CM_ZSTD, "tzst\0zst\0", probeZstd),
+#endif
+#ifdef ENABLE_LZ4
+  { CM_LZ4, "tlz4\0lz4\0", probeLz4, openLz4, closeLz4, readptrLz4, readLz4, NULL, 0 },
+#else
+  UNSUPPORTED(CM_LZ4, "tlz4\0lz4\0", probeLz4),
+#endif
+  /* last, its probe only finds the first byte plausible */
+#ifdef ENABLE_LZMA
+  { CM_LZMA, "tlz\0lzma\0", probeLzma, openLzma, closeLzma, readptrLzma, readLzma, NULL, 0 },
+#else
+  UNSUPPORTED(CM_LZMA, "tlz\0lzma\0", probeLzma),
+#endif
+};
+#define CODECS (sizeof(codecs) / sizeof(codecs[0]))
+
+
+const struct tgz_codec *codec_find(int cm)
+{
+  unsigned i;
+  for (i = 0; i < CODECS; i++)
+    if (codecs[i].cm == cm)
+      return (codecs[i].open != NULL) ? &codecs[i] : NULL;
+  return NULL;
+}
+
+int codec_detect(const unsigned char *buf, unsigned len, const char *ext)
+{
+  unsigned i;
+  const char *e;
+
+  for (i = 0; i < CODECS; i++)
+    if (codecs[i].probe(buf, len) == PROBE_MAGIC)
+      return codecs[i].cm;
+  if (*ext)
+    for (i = 0; i < CODECS; i++)
+      for (e = codecs[i].exts; *e; e += strlen(e) + 1)
+        if (strcmpi(ext, e) == 0)
+          return codecs[i].cm;
+  for (i = 0; i < CODECS; i++)
+    if (codecs[i].probe(buf, len) == PROBE_WEAK)
+      return codecs[i].cm;
+  return CM_GZ;
+}
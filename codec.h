@@ -0,0 +1,69 @@
+/*
+ * codec - compression methods tarballs may be read with
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * One entry per CM_* value: how to recognise it from the start of the
+ * file and its extension (getFileType), and how the extraction engine
+ * opens, reads, passes over and closes it.  Adding a method is a decoder
+ * and an entry in codec.c; untar.c only calls through the entry.
+ */
+
+#ifndef _CODEC_H_
+#define _CODEC_H_
+
+#include "zlib/zlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* how sure a probe is the start of a file is its method */
+#define PROBE_NO     0
+#define PROBE_WEAK   1    /* plausible, only if nothing else fits (lzma has no magic) */
+#define PROBE_MAGIC  2    /* marker bytes (or tar header checksum) match */
+
+/* flags */
+#define CODEC_SEEKABLE 1  /* file offsets are tar offsets (plain tar), may be mapped */
+#define CODEC_PARALLEL 2  /* decodes parts (xz blocks, zstd frames) on threads of its own */
+
+struct tgz_codec {
+  int cm;                 /* CM_* */
+  const char *exts;       /* file extensions, each '\0' terminated, then an empty one */
+  /* PROBE_* for the len bytes at the start of a file */
+  int (*probe)(const unsigned char *buf, unsigned len);
+
+  /* the rest NULL when not built in (or, CM_Z, not supported at all) */
+
+  /* starts decoding in, keeping at most maxmem bytes of decoder state (0
+     no limit) and, if CODEC_PARALLEL, decoding on up to threads threads
+     (0 one per processor); 0 on success, else the error is reported and
+     close must still be called */
+  int (*open)(gzFile in, void **state, unsigned long maxmem, int threads);
+  void (*close)(void *state);           /* NULL if nothing to free */
+  /* up to len bytes decoded in place, as gzreadptr; NULL if only read */
+  long (*readptr)(void *state, const Bytef **p, unsigned len);
+  /* up to len bytes copied to buf (0 end of input, -1 error) */
+  long (*read)(void *state, Bytef *buf, unsigned len);
+  /* passes over up to len bytes (less only at the end, -1 error), NULL
+     to read through them */
+  long (*skip)(void *state, unsigned long len);
+  int flags;              /* CODEC_* */
+};
+
+/* entry for cm, NULL if unknown or not supported (not built in) */
+const struct tgz_codec *codec_find(int cm);
+
+/* CM_* of the file starting with the len bytes at buf and with extension
+   ext (after the dot, "" if none): the first method whose marker bytes
+   match, else whose extension matches, else that finds them plausible;
+   CM_GZ if none */
+int codec_detect(const unsigned char *buf, unsigned len, const char *ext);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CODEC_H_ */
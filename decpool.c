@@ -0,0 +1,166 @@
+/*
+ * decpool - decoder state kept for reuse across extractions
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * Each block has a small header holding its size so dpool_free needs
+ * only the pointer (as free, so it can stand in for the codecs' own
+ * free calls).  Kept blocks are a short list, most recently freed last;
+ * a decoder takes the newest of its exact size, and the oldest are freed
+ * when the list or its byte total would go over the limits.
+ */
+
+#include "decpool.h"
+#include "threads.h"
+
+
+#define HDRSIZE 16   /* keeps blocks 16 byte aligned as malloc's */
+
+static LOCK          lock;
+static int           ready;
+static void         *kept[DPOOL_KEEP];
+static unsigned long keptsize[DPOOL_KEEP];
+static int           nkept;
+static unsigned long keptbytes;
+static unsigned long heldbytes;   /* kept and in use, for dpool_peak */
+static unsigned long peakbytes;
+
+#define BLOCKSIZE(b) (((unsigned long *)(b))[0])
+#define COUNTED(b)   (((unsigned long *)(b))[1])   /* in heldbytes */
+
+
+void dpool_init(void)
+{
+  if (ready) return;
+  lock_init(&lock);
+  ready = 1;
+}
+
+
+void dpool_exit(void)
+{
+  if (!ready) return;
+  dpool_trim();
+  ready = 0;
+  lock_free(&lock);
+}
+
+
+void *dpool_alloc(unsigned long size)
+{
+  char *b = NULL;
+  int i;
+
+  if (ready)
+  {
+    lock_acquire(&lock);
+    for (i = nkept - 1; i >= 0; i--)
+    {
+      if (keptsize[i] == size)
+      {
+        b = (char *)kept[i];
+        keptbytes -= size;
+        for (nkept--; i < nkept; i++)
+        {
+          kept[i] = kept[i + 1];
+          keptsize[i] = keptsize[i + 1];
+        }
+        break;
+      }
+    }
+    lock_release(&lock);
+  }
+
+  if ((b == NULL) && (size <= (unsigned long)-1 - HDRSIZE))
+  {
+    if ((b = (char *)malloc(size + HDRSIZE)) == NULL) return NULL;
+    BLOCKSIZE(b) = size;
+    COUNTED(b) = ready;
+    if (ready)
+    {
+      lock_acquire(&lock);
+      heldbytes += size;
+      if (heldbytes > peakbytes) peakbytes = heldbytes;
+      lock_release(&lock);
+    }
+  }
+  return (b != NULL) ? b + HDRSIZE : NULL;
+}
+
+
+void dpool_free(void *p)
+{
+  char *b, *drop[DPOOL_KEEP + 1];
+  unsigned long size;
+  int ndrop = 0, i;
+
+  if (p == NULL) return;
+  b = (char *)p - HDRSIZE;
+  size = BLOCKSIZE(b);
+  if (!ready || !COUNTED(b))
+  {
+    free(b);
+    return;
+  }
+
+  /* the frees are done after releasing the lock */
+  lock_acquire(&lock);
+  if (size > DPOOL_MAXBYTES)
+  {
+    heldbytes -= size;
+    lock_release(&lock);
+    free(b);
+    return;
+  }
+  while ((nkept == DPOOL_KEEP) || (keptbytes + size > DPOOL_MAXBYTES))
+  {
+    drop[ndrop++] = (char *)kept[0];
+    keptbytes -= keptsize[0];
+    heldbytes -= keptsize[0];
+    for (nkept--, i = 0; i < nkept; i++)
+    {
+      kept[i] = kept[i + 1];
+      keptsize[i] = keptsize[i + 1];
+    }
+  }
+  kept[nkept] = b;
+  keptsize[nkept++] = size;
+  keptbytes += size;
+  lock_release(&lock);
+
+  while (ndrop > 0) free(drop[--ndrop]);
+}
+
+
+void dpool_trim(void)
+{
+  char *drop[DPOOL_KEEP];
+  int ndrop = 0;
+
+  if (!ready) return;
+  lock_acquire(&lock);
+  while (nkept > 0)
+  {
+    drop[ndrop++] = (char *)kept[--nkept];
+    keptbytes -= keptsize[nkept];
+    heldbytes -= keptsize[nkept];
+  }
+  lock_release(&lock);
+
+  while (ndrop > 0) free(drop[--ndrop]);
+}
+
+
+unsigned long dpool_peak(int reset)
+{
+  unsigned long peak;
+
+  if (!ready) return 0;
+  lock_acquire(&lock);
+  peak = peakbytes;
+  if (reset) peakbytes = heldbytes;
+  lock_release(&lock);
+  return peak;
+}
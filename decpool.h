@@ -0,0 +1,53 @@
+/*
+ * decpool - decoder state kept for reuse across extractions
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * The large allocations of the decoders (gzio stream, buffers and
+ * inflate window, the bzip2 state and tt array, the lzma probabilities
+ * and dictionary) and the io_uring output buffers come from here.  A freed block is kept, by size, for
+ * the next decoder asking for the same size, so a batch of archives with
+ * the same settings allocates (and page faults) its state once instead
+ * of once per archive.  Shared by all threads.
+ */
+
+#ifndef _DECPOOL_H_
+#define _DECPOOL_H_
+
+#include "miniclib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DPOOL_KEEP     16               /* most blocks kept */
+#define DPOOL_MAXBYTES (160UL << 20)    /* most bytes kept */
+
+/* sets up pool, call once before any extraction (DllMain, main); until
+   then dpool_alloc/dpool_free are plain malloc/free */
+void dpool_init(void);
+
+/* frees blocks kept and releases pool, nothing is kept after this */
+void dpool_exit(void);
+
+/* block of size bytes, reusing a kept one of that size if any; NULL if
+   out of memory */
+void *dpool_alloc(unsigned long size);
+
+/* returns block (NULL ok) to pool, freed if it can't be kept */
+void dpool_free(void *p);
+
+/* frees all blocks kept, pool remains usable */
+void dpool_trim(void);
+
+/* most bytes held (in use or kept) since pool set up or last reset;
+   reset (nonzero) starts again from the bytes held now */
+unsigned long dpool_peak(int reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DECPOOL_H_ */
@@ -0,0 +1,168 @@
+/*
+ * dedup - files written by an extraction, by size and content hash
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * Entries are kept in one growing array, names in a string pool, with two
+ * open addressed indexes into the array, one by size+hash and one by name.
+ * Removed entries stay in the array, marked dead, until dd_clear.  All of
+ * it is in the caller's struct dedup, one per extraction.
+ */
+
+#include "dedup.h"
+
+
+struct ddent {
+  FSSIZE        size;
+  unsigned long hash;
+  unsigned      name;     /* offset in pool */
+  unsigned      namehash;
+  int           live;
+};
+
+#ifdef _WIN32
+#define FOLD(c) ((((c) >= 'A') && ((c) <= 'Z')) ? ((c) + 'a' - 'A') : (c))
+#else
+#define FOLD(c) (c)
+#endif
+
+static unsigned hashname(const char *name)
+{
+  unsigned h = 2166136261U;   /* FNV-1a */
+  while (*name)
+  {
+    h ^= (unsigned char)FOLD(*name);
+    h *= 16777619U;
+    name++;
+  }
+  return h;
+}
+
+static int nameeq(const char *a, const char *b)
+{
+  while (*a && (FOLD(*a) == FOLD(*b)))
+  {
+    a++; b++;
+  }
+  return (*a == '\0') && (*b == '\0');
+}
+
+static unsigned keyslot(struct dedup *d, FSSIZE size, unsigned long hash)
+{
+  return ((unsigned)hash ^ (unsigned)size ^ (unsigned)(size >> 32)) & (d->idxsize - 1);
+}
+
+/* puts entry i in both indexes */
+static void addindex(struct dedup *d, unsigned i)
+{
+  unsigned j = keyslot(d, d->ents[i].size, d->ents[i].hash);
+  while (d->bykey[j]) j = (j + 1) & (d->idxsize - 1);
+  d->bykey[j] = i + 1;
+
+  j = d->ents[i].namehash & (d->idxsize - 1);
+  while (d->byname[j]) j = (j + 1) & (d->idxsize - 1);
+  d->byname[j] = i + 1;
+}
+
+/* doubles indexes (kept under half full), returns 0 if out of memory */
+static int grow(struct dedup *d)
+{
+  unsigned newsize = d->idxsize ? d->idxsize * 2 : 1024, i;
+  unsigned *k = (unsigned *)calloc(newsize, sizeof(unsigned));
+  unsigned *n = (unsigned *)calloc(newsize, sizeof(unsigned));
+
+  if ((k == NULL) || (n == NULL))
+  {
+    if (k != NULL) free(k);
+    if (n != NULL) free(n);
+    return 0;
+  }
+  if (d->bykey != NULL) free(d->bykey);
+  if (d->byname != NULL) free(d->byname);
+  d->bykey = k;
+  d->byname = n;
+  d->idxsize = newsize;
+  for (i = 0; i < d->entcount; i++) addindex(d, i);
+  return 1;
+}
+
+
+int dd_add(struct dedup *d, const char *fname, FSSIZE size, unsigned long hash)
+{
+  unsigned len = strlen(fname) + 1;
+  struct ddent *e;
+
+  if (((d->entcount + 1) * 2 > d->idxsize) && !grow(d)) return 0;
+  if (d->entcount == d->entsize)
+  {
+    unsigned newsize = d->entsize ? d->entsize * 2 : 256;
+    struct ddent *p = (struct ddent *)realloc(d->ents, newsize * sizeof(struct ddent));
+    if (p == NULL) return 0;
+    d->ents = p;
+    d->entsize = newsize;
+  }
+  if (d->poolused + len > d->poolsize)
+  {
+    unsigned newsize = d->poolsize ? d->poolsize : 16384;
+    char *p;
+    while (d->poolused + len > newsize) newsize *= 2;
+    if ((p = (char *)realloc(d->pool, newsize)) == NULL) return 0;
+    d->pool = p;
+    d->poolsize = newsize;
+  }
+
+  memcpy(d->pool + d->poolused, fname, len);
+  e = &d->ents[d->entcount];
+  e->size = size;
+  e->hash = hash;
+  e->name = d->poolused;
+  e->namehash = hashname(fname);
+  e->live = 1;
+  d->poolused += len;
+  addindex(d, d->entcount++);
+  return 1;
+}
+
+
+const char *dd_find(struct dedup *d, FSSIZE size, unsigned long hash)
+{
+  unsigned j;
+
+  if (d->idxsize == 0) return NULL;
+  for (j = keyslot(d, size, hash); d->bykey[j]; j = (j + 1) & (d->idxsize - 1))
+  {
+    struct ddent *e = &d->ents[d->bykey[j] - 1];
+    if (e->live && (e->size == size) && (e->hash == hash)) return d->pool + e->name;
+  }
+  return NULL;
+}
+
+
+int dd_remove(struct dedup *d, const char *fname)
+{
+  unsigned h = hashname(fname), j;
+
+  if (d->idxsize == 0) return 0;
+  for (j = h & (d->idxsize - 1); d->byname[j]; j = (j + 1) & (d->idxsize - 1))
+  {
+    struct ddent *e = &d->ents[d->byname[j] - 1];
+    if (e->live && (e->namehash == h) && nameeq(d->pool + e->name, fname))
+    {
+      e->live = 0;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+
+void dd_clear(struct dedup *d)
+{
+  if (d->ents != NULL) free(d->ents);
+  if (d->bykey != NULL) free(d->bykey);
+  if (d->byname != NULL) free(d->byname);
+  if (d->pool != NULL) free(d->pool);
+  memset(d, 0, sizeof(*d));
+}
@@ -0,0 +1,51 @@
+/*
+ * dedup - files written by an extraction, by size and content hash
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * Used by tgz_extract in dedup mode to find an earlier file that a member
+ * may duplicate.  The hash is of the member's first block only, so it is
+ * known before the rest is read; a match is just a candidate, the engine
+ * compares the remaining contents before linking to it.
+ */
+
+#ifndef _DEDUP_H_
+#define _DEDUP_H_
+
+#include "fsio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* files of one extraction, all zero when empty */
+struct dedup {
+  struct ddent *ents;
+  unsigned entcount, entsize;
+  unsigned *bykey, *byname;   /* entry index + 1, 0 if empty */
+  unsigned idxsize;           /* power of 2 */
+  char *pool;
+  unsigned poolsize, poolused;
+};
+
+/* records fname as holding size bytes with given hash, returns 0 if out of memory */
+int dd_add(struct dedup *d, const char *fname, FSSIZE size, unsigned long hash);
+
+/* returns name of a recorded file with same size and hash, or NULL;
+   valid until the next dd_add */
+const char *dd_find(struct dedup *d, FSSIZE size, unsigned long hash);
+
+/* forgets fname, returns nonzero if it was recorded (so may share its
+   data with other names through a hard link) */
+int dd_remove(struct dedup *d, const char *fname);
+
+/* forgets all files */
+void dd_clear(struct dedup *d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DEDUP_H_ */
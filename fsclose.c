@@ -0,0 +1,224 @@
+/*
+ * fsclose - finishes extracted files (timestamp and close) on worker threads
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * Workers are started on the first queued file and stopped again by
+ * fsc_flush, so none are left running once tgz_extract returns (the
+ * plugin dll may be unloaded).  Entries are taken oldest first.  Each
+ * output context has its own queue and workers, so one extraction
+ * never waits on (or reports) another's files.
+ */
+
+#include "fsclose.h"
+#include "threads.h"
+#include "untar.h"   /* BLOCKSIZE, PrintMessage */
+
+
+#define FSC_FREE   0
+#define FSC_QUEUED 1
+#define FSC_BUSY   2
+
+struct fscentry {
+  int           state;
+  unsigned long seq;           /* queue order */
+  FSCLOSEFUNC   fn;
+  FSHANDLE      h;
+  time_t        tartime;
+  char          fname[BLOCKSIZE];
+};
+
+struct fsclose {
+  int           running;       /* workers started */
+  int           nworkers;
+  int           waiting;       /* caller blocked on done */
+  int           pending;       /* entries not FSC_FREE */
+  unsigned long seq;
+  LOCK          lock;          /* protects all below and entry states */
+  SEMA          slots;         /* free entries */
+  SEMA          items;         /* queued entries */
+  SEMA          done;          /* posted when an entry completes while waiting */
+  THREAD        workers[FSC_WORKERS];
+  int           error;         /* first failure */
+  char          errname[BLOCKSIZE];
+  struct fscentry q[FSC_DEPTH];
+};
+
+
+static THREAD_PROC(fsc_worker)
+{
+  struct fsclose *c = (struct fsclose *)arg;
+
+  while (1)
+  {
+    struct fscentry *e = NULL;
+    int i, err;
+
+    sema_wait(&c->items);
+    lock_acquire(&c->lock);
+    for (i = 0; i < FSC_DEPTH; i++)
+      if ((c->q[i].state == FSC_QUEUED) && ((e == NULL) || (c->q[i].seq < e->seq)))
+        e = &c->q[i];
+    if (e == NULL)   /* only posted without an entry to stop */
+    {
+      lock_release(&c->lock);
+      break;
+    }
+    e->state = FSC_BUSY;
+    lock_release(&c->lock);
+
+    err = e->fn(e->h, e->tartime);
+
+    lock_acquire(&c->lock);
+    if (err && !c->error)
+    {
+      c->error = err;
+      strcpy(c->errname, e->fname);
+    }
+    e->state = FSC_FREE;
+    c->pending--;
+    if (c->waiting)
+    {
+      c->waiting = 0;
+      sema_post(&c->done, 1);
+    }
+    lock_release(&c->lock);
+    sema_post(&c->slots, 1);
+  }
+  THREAD_RETURN;
+}
+
+
+static int fsc_start(struct fsclose *c)
+{
+  int i;
+
+  lock_init(&c->lock);
+  if (!sema_init(&c->slots, FSC_DEPTH)) goto fail1;
+  if (!sema_init(&c->items, 0)) goto fail2;
+  if (!sema_init(&c->done, 0)) goto fail3;
+  c->waiting = c->pending = 0;
+  for (i = 0; i < FSC_DEPTH; i++) c->q[i].state = FSC_FREE;
+  for (c->nworkers = 0; c->nworkers < FSC_WORKERS; c->nworkers++)
+    if (!thread_start(&c->workers[c->nworkers], fsc_worker, c))
+      break;
+  if (c->nworkers > 0)
+  {
+    c->running = 1;
+    return 1;
+  }
+
+  sema_free(&c->done);
+fail3:
+  sema_free(&c->items);
+fail2:
+  sema_free(&c->slots);
+fail1:
+  lock_free(&c->lock);
+  return 0;
+}
+
+
+struct fsclose *fsc_new(void)
+{
+  return (struct fsclose *)calloc(1, sizeof(struct fsclose));
+}
+
+
+void fsc_free(struct fsclose *c)
+{
+  if (c == NULL) return;
+  fsc_flush(c);
+  free(c);
+}
+
+
+int fsc_queue(struct fsclose *c, FSCLOSEFUNC fn, FSHANDLE h, const char *fname, time_t tartime)
+{
+  int i;
+
+  if ((c == NULL) || (strlen(fname) >= BLOCKSIZE)) return 0;
+  if (!c->running && !fsc_start(c)) return 0;
+
+  sema_wait(&c->slots);  /* blocks while queue full */
+  lock_acquire(&c->lock);
+  for (i = 0; c->q[i].state != FSC_FREE; i++)
+    ;
+  c->q[i].fn = fn;
+  c->q[i].h = h;
+  c->q[i].tartime = tartime;
+  c->q[i].seq = c->seq++;
+  strcpy(c->q[i].fname, fname);
+  c->q[i].state = FSC_QUEUED;
+  c->pending++;
+  lock_release(&c->lock);
+  sema_post(&c->items, 1);
+  return 1;
+}
+
+
+/* returns nonzero if any entry (named fname if not NULL) not yet done,
+   called with lock held, arranges to be signalled on next completion */
+static int fsc_busy(struct fsclose *c, const char *fname)
+{
+  int i;
+
+  if (c->pending == 0) return 0;
+  for (i = 0; i < FSC_DEPTH; i++)
+  {
+    if ((c->q[i].state != FSC_FREE) &&
+        ((fname == NULL) || (strcmp(c->q[i].fname, fname) == 0)))
+    {
+      c->waiting = 1;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void fsc_wait(struct fsclose *c, const char *fname)
+{
+  int busy;
+
+  do
+  {
+    lock_acquire(&c->lock);
+    busy = fsc_busy(c, fname);
+    lock_release(&c->lock);
+    if (busy) sema_wait(&c->done);
+  } while (busy);
+}
+
+
+void fsc_sync(struct fsclose *c, const char *fname)
+{
+  if ((c != NULL) && c->running) fsc_wait(c, fname);
+}
+
+
+int fsc_flush(struct fsclose *c)
+{
+  int i, err;
+
+  if ((c == NULL) || !c->running) return 0;
+  fsc_wait(c, NULL);
+
+  /* stop workers, each wakes without an entry and returns */
+  sema_post(&c->items, c->nworkers);
+  for (i = 0; i < c->nworkers; i++)
+    thread_wait(c->workers[i]);
+  sema_free(&c->done);
+  sema_free(&c->items);
+  sema_free(&c->slots);
+  lock_free(&c->lock);
+  c->running = 0;
+
+  if ((err = c->error) != 0)
+  {
+    PrintMessage(_T("Error: unable to close %s [%d]"), _A2T(c->errname), err);
+    c->error = 0;
+  }
+  return err;
+}
@@ -0,0 +1,56 @@
+/*
+ * fsclose - finishes extracted files (timestamp and close) on worker threads
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * Used by the fsio backends so the extraction loop does not wait on the
+ * per file close, which is where virus scanners and indexers hook in on
+ * Windows and where network file systems flush.  The queue is bounded,
+ * a full queue blocks the caller until a worker takes an entry.  Errors
+ * from the workers are kept and reported by fsc_flush.
+ */
+
+#ifndef _FSCLOSE_H_
+#define _FSCLOSE_H_
+
+#include "fsio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FSC_WORKERS 4     /* threads finishing files */
+#define FSC_DEPTH   64    /* files queued or being finished */
+
+/* backend's synchronous finish, sets time and closes,
+   returns 0 or native error code of a failed close */
+typedef int (*FSCLOSEFUNC)(FSHANDLE h, time_t tartime);
+
+/* queue of one output context */
+struct fsclose;
+
+/* allocates an empty queue, no workers started yet, NULL if out of memory */
+struct fsclose *fsc_new(void);
+
+/* flushes and frees queue */
+void fsc_free(struct fsclose *c);
+
+/* queues file to be finished by fn, starting workers if needed,
+   returns 0 if unable to (caller should call fn itself);
+   c may be NULL (as from a failed fsc_new) here and below */
+int fsc_queue(struct fsclose *c, FSCLOSEFUNC fn, FSHANDLE h, const char *fname, time_t tartime);
+
+/* waits until no file named fname is queued or being finished */
+void fsc_sync(struct fsclose *c, const char *fname);
+
+/* waits for all queued files and stops the workers; returns 0 or native
+   error code of first failure since last flush, after reporting it */
+int fsc_flush(struct fsclose *c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FSCLOSE_H_ */
@@ -0,0 +1,163 @@
+/*
+ * fsio - output file system access used by tgz_extract
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * All files and directories the extraction creates go through these
+ * functions so the engine itself has no platform calls.  There is one
+ * implementation per platform, fsio_win32.c (the plugin) and fsio_posix.c
+ * (native tools on Linux/BSD), only one of them is built.
+ *
+ * Everything goes through an output context (FSCTX) made by fs_new, which
+ * holds the base directory and any queued output, directory listings and
+ * open directories.  Names passed in are relative paths as stored in the
+ * tarball (after any stripping), they are resolved against its base
+ * directory.  Each context may be used by one thread at a time, separate
+ * contexts may be used at the same time, even for the same directory.
+ *
+ * A backend may queue writes and closes, in which case errors may only be
+ * known later; fs_flush waits for everything queued and reports them.
+ */
+
+#ifndef _FSIO_H_
+#define _FSIO_H_
+
+#include "miniclib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef _WIN32
+typedef HANDLE FSHANDLE;
+#define FS_INVALID_HANDLE INVALID_HANDLE_VALUE
+typedef LONGLONG FSTIME;      /* FILETIME, 100ns intervals since 1601 */
+typedef ULONGLONG FSSIZE;
+#define FS_ERR_EXISTS ERROR_FILE_EXISTS
+#else
+typedef int FSHANDLE;
+#define FS_INVALID_HANDLE (-1)
+typedef time_t FSTIME;        /* seconds since 1970 */
+typedef unsigned long long FSSIZE;
+#define FS_ERR_EXISTS EEXIST
+#endif
+
+/* how fs_create should open the file */
+#define FS_CREATE_ALWAYS 0    /* create, truncating any existing file */
+#define FS_CREATE_NEW    1    /* create, fails with FS_ERR_EXISTS if exists */
+#define FS_OPEN_EXISTING 2    /* open existing file for writing */
+
+/* output context, contents private to the backend */
+typedef struct fsctx FSCTX;
+
+
+/* returns new context extracting to dir (current directory if NULL),
+   creating it if needed; NULL if unable to (fs_lasterror(NULL) gives why) */
+FSCTX *fs_new(const TCHAR *dir);
+
+/* waits for queued output (fs_flush) and frees context */
+void fs_free(FSCTX *c);
+
+/* returns new context on the same base directory as c, for another thread
+   writing alongside it (its output is not queued); NULL if out of memory */
+FSCTX *fs_clone(FSCTX *c);
+
+/* creates single directory, returns nonzero if created or already exists */
+int fs_mkdir(FSCTX *c, const char *dir);
+
+/* opens file for writing, returns FS_INVALID_HANDLE on error */
+FSHANDLE fs_create(FSCTX *c, const char *fname, int disposition);
+
+/* writes len bytes at offset, returns nonzero if all written;
+   the Win32 version writes sequentially, so offset must be current end
+   (or where fs_skip moved to) */
+int fs_write(FSCTX *c, FSHANDLE h, const void *buf, unsigned len, FSSIZE offset);
+
+/* skips ahead to offset of a newly created file without writing, leaving
+   a hole where the file system supports sparse files (zeros elsewhere);
+   the next fs_write is at offset, returns nonzero on success */
+int fs_skip(FSCTX *c, FSHANDLE h, FSSIZE offset);
+
+/* sets last modified time to tartime (seconds since 1970) and closes,
+   returns nonzero unless the close failed (a failure setting the time is
+   ignored); may be queued to worker threads (fsclose.c), in which case
+   failures are reported by fs_flush */
+int fs_close(FSCTX *c, FSHANDLE h, const char *fname, time_t tartime);
+
+/* sets the length of a file just made by fs_create to size, before its
+   ranges are written through fs_openrange, so each byte is written once
+   whatever order the ranges land in; returns nonzero on success */
+int fs_setsize(FSCTX *c, FSHANDLE h, FSSIZE size);
+
+/* opens existing file for writing (without truncating) positioned at
+   offset, while other threads may write other ranges of it through their
+   own handles; returns FS_INVALID_HANDLE on error */
+FSHANDLE fs_openrange(FSCTX *c, const char *fname, FSSIZE offset);
+
+/* opens existing file for reading, returns FS_INVALID_HANDLE on error */
+FSHANDLE fs_open(FSCTX *c, const char *fname);
+
+/* reads up to len bytes at offset (stopping only at end of file), returns
+   number read or -1 on error; sequential on Win32 as for fs_write */
+int fs_read(FSCTX *c, FSHANDLE h, void *buf, unsigned len, FSSIZE offset);
+
+/* closes file opened by fs_open and opens it for writing, without
+   truncating, positioned at offset; returns FS_INVALID_HANDLE on error */
+FSHANDLE fs_reopen(FSCTX *c, FSHANDLE h, const char *fname, FSSIZE offset);
+
+/* closes file opened by fs_open */
+void fs_release(FSCTX *c, FSHANDLE h);
+
+/* closes and deletes a partially written file */
+void fs_discard(FSCTX *c, FSHANDLE h, const char *fname);
+
+/* deletes file, returns nonzero on success */
+int fs_remove(FSCTX *c, const char *fname);
+
+/* creates hard link linkname referring to existing, returns nonzero on success */
+int fs_link(FSCTX *c, const char *linkname, const char *existing);
+
+/* gets last modified time of existing file, returns 0 if unable to */
+int fs_getmtime(FSCTX *c, const char *fname, FSTIME *mtime);
+
+/* returns nonzero if fname exists, with its last modified time and size;
+   answered from a listing of its directory taken the first time one of
+   its files is asked about (fssnap.c), so may miss a file that exists */
+int fs_exists(FSCTX *c, const char *fname, FSTIME *mtime, FSSIZE *size);
+
+/* maps whole of file path (as given to gzopen, not relative to any
+   context) read only, returns NULL if unable to (including empty files
+   and files too large for the address space), else its size in *size */
+const char *fs_map(const char *path, FSSIZE *size);
+
+/* unmaps file mapped by fs_map */
+void fs_unmap(const char *p, FSSIZE size);
+
+/* converts tar time (seconds since 1970) to FSTIME */
+FSTIME fs_time(time_t tartime);
+
+/* waits for any queued output to complete, returns nonzero if all
+   succeeded; failures are reported (PrintMessage) as they are found.
+   Also drops any directory listings kept for fs_exists. */
+int fs_flush(FSCTX *c);
+
+/* allows (enable nonzero) output of c to be queued, closes to worker
+   threads and on Linux writes to io_uring, on by default; returns previous */
+int fs_async(FSCTX *c, int enable);
+
+/* limits memory for output of c queued by fs_async to about maxmem
+   bytes (0 for the default), returns the most it may hold */
+unsigned long fs_buffers(FSCTX *c, unsigned long maxmem);
+
+/* native error code (GetLastError/errno) of last failed call on c, or of
+   the failed fs_new if c is NULL */
+int fs_lasterror(FSCTX *c);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FSIO_H_ */
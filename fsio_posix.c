@@ -0,0 +1,582 @@
+/*
+ * fsio - output file system access used by tgz_extract, POSIX version
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * Used for native builds (Linux/BSD) of the extraction engine.  Each
+ * context keeps its base directory open and everything is created relative
+ * to it with the *at() calls, the process' current directory is never
+ * changed.  Parent directories are kept open in a small LRU cache per
+ * context so each create
+ * only resolves the final name component, directories made (or found)
+ * by fs_mkdir go straight into it.
+ * On Linux files created with FS_CREATE_ALWAYS are queued to io_uring
+ * (fsio_uring.c) when the kernel supports it, other files are closed by
+ * the fsclose.c workers, both set up per context on first use; any other
+ * access first waits for queued files of the same name.
+ */
+
+#define _GNU_SOURCE 1
+#define _FILE_OFFSET_BITS 64   /* members over 2GB on 32 bit hosts */
+#include "fsio.h"
+#include "fsio_uring.h"
+#include "fsclose.h"
+#include "fssnap.h"
+#include "threads.h"
+#include "untar.h"   /* makedir */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+
+static int closers = -1;   /* queue closes to workers, -1 not decided yet */
+
+#ifndef ENABLE_URING
+#define uring_sync(u, dirfd, fname)
+#define uring_release(u, dirfd)
+#endif
+
+#define FAILED(x) ((c->lasterror = errno), (x))
+
+#ifdef O_PATH
+#define DIROPEN_FLAGS (O_PATH | O_DIRECTORY | O_CLOEXEC)
+#else
+#define DIROPEN_FLAGS (O_RDONLY | O_DIRECTORY | O_CLOEXEC)
+#endif
+
+
+/* open directories, keyed by path relative to base directory */
+#define DIRCACHE_SIZE 32
+
+struct dircache {
+  int           fd;            /* -1 if entry unused */
+  unsigned      len;
+  unsigned long used;          /* LRU stamp */
+  char          path[BLOCKSIZE];
+};
+
+struct fsctx {
+  int              basefd;     /* names are relative to, AT_FDCWD for current directory */
+  int              lasterror;
+  int              async;
+  struct dircache  dircache[DIRCACHE_SIZE];
+  struct dircache *lastdir;    /* members mostly share a directory */
+  unsigned long    dirclock;
+  struct fssnap    snap;
+  struct fsclose  *fsc;        /* NULL if closes can't be queued */
+#ifdef ENABLE_URING
+  struct uring    *ring;       /* NULL until first async create, or if unavailable */
+  int              ringtried;
+  unsigned long    ringmem;    /* limit on its buffers, 0 for default (fs_buffers) */
+#endif
+};
+
+static void dircache_clear(FSCTX *c)
+{
+  int i;
+  for (i = 0; i < DIRCACHE_SIZE; i++)
+  {
+    if (c->dircache[i].used && (c->dircache[i].fd >= 0))
+    {
+      uring_release(c->ring, c->dircache[i].fd);
+      close(c->dircache[i].fd);
+    }
+    c->dircache[i].fd = -1;
+    c->dircache[i].used = 0;
+  }
+  c->lastdir = NULL;
+}
+
+static struct dircache *dircache_find(FSCTX *c, const char *path, unsigned len)
+{
+  int i;
+  if ((c->lastdir != NULL) && (c->lastdir->len == len) && (memcmp(c->lastdir->path, path, len) == 0))
+    return c->lastdir;
+  for (i = 0; i < DIRCACHE_SIZE; i++)
+  {
+    struct dircache *d = &c->dircache[i];
+    if (d->used && (d->len == len) && (memcmp(d->path, path, len) == 0))
+      return d;
+  }
+  return NULL;
+}
+
+/* opens path (first len chars) and adds to cache replacing least recently
+   used entry, returns NULL if unable to open */
+static struct dircache *dircache_add(FSCTX *c, const char *path, unsigned len)
+{
+  struct dircache *d = &c->dircache[0];
+  int i, fd;
+
+  if (len >= BLOCKSIZE) return NULL;
+  for (i = 1; i < DIRCACHE_SIZE; i++)
+    if (c->dircache[i].used < d->used) d = &c->dircache[i];
+
+  {
+    char name[BLOCKSIZE];
+    memcpy(name, path, len);
+    name[len] = '\0';
+    if ((fd = openat(c->basefd, name, DIROPEN_FLAGS)) < 0) return NULL;
+  }
+  if (d->used && (d->fd >= 0))
+  {
+    /* queued files may still refer to it */
+    uring_release(c->ring, d->fd);
+    close(d->fd);
+  }
+  d->fd = fd;
+  d->len = len;
+  d->used = ++c->dirclock;
+  memcpy(d->path, path, len);
+  return d;
+}
+
+/* returns directory fd fname's final component is relative to, and sets
+   *base to that component; falls back to basefd and the full name */
+static int dirof(FSCTX *c, const char *fname, const char **base)
+{
+  const char *p = strrchr(fname, '/');
+  struct dircache *d;
+
+  *base = fname;
+  if ((p == NULL) || (p == fname) || (p[1] == '\0')) return c->basefd;
+  if ((d = dircache_find(c, fname, (unsigned)(p - fname))) == NULL)
+    if ((d = dircache_add(c, fname, (unsigned)(p - fname))) == NULL)
+      return c->basefd;
+  d->used = ++c->dirclock;
+  c->lastdir = d;
+  *base = p + 1;
+  return d->fd;
+}
+
+
+FSCTX *fs_new(const TCHAR *dir)
+{
+  FSCTX *c = (FSCTX *)calloc(1, sizeof(FSCTX));
+  int i;
+
+  if (c == NULL) return NULL;
+  c->basefd = AT_FDCWD;
+  c->async = 1;
+  for (i = 0; i < DIRCACHE_SIZE; i++) c->dircache[i].fd = -1;
+  c->snap.fs = c;
+  c->fsc = fsc_new();
+
+  if (dir != NULL)
+  {
+    int fd;
+
+    /* try to create if it doesn't exist yet */
+    makedir(c, (char *)dir);
+    dircache_clear(c);   /* entries were relative to current directory */
+    if ((fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+    {
+      int err = errno;
+      fs_free(c);
+      errno = err;
+      return NULL;
+    }
+    c->basefd = fd;
+  }
+  return c;
+}
+
+
+void fs_free(FSCTX *c)
+{
+  if (c == NULL) return;
+  fs_flush(c);
+  dircache_clear(c);
+#ifdef ENABLE_URING
+  uring_free(c->ring);
+#endif
+  fsc_free(c->fsc);
+  if (c->basefd != AT_FDCWD) close(c->basefd);
+  free(c);
+}
+
+
+FSCTX *fs_clone(FSCTX *c)
+{
+  FSCTX *n = (FSCTX *)calloc(1, sizeof(FSCTX));
+  int i;
+
+  if (n == NULL) return NULL;
+  n->basefd = AT_FDCWD;
+  for (i = 0; i < DIRCACHE_SIZE; i++) n->dircache[i].fd = -1;
+  n->snap.fs = n;
+  if ((c->basefd != AT_FDCWD) && ((n->basefd = fcntl(c->basefd, F_DUPFD_CLOEXEC, 0)) < 0))
+  {
+    free(n);
+    return NULL;
+  }
+  return n;
+}
+
+
+int fs_mkdir(FSCTX *c, const char *dir)
+{
+  const char *base;
+  unsigned len = strlen(dir);
+  int dirfd;
+
+  /* already open, so exists (makedir is called for every member) */
+  if (dircache_find(c, dir, len) != NULL) return 1;
+
+  dirfd = dirof(c, dir, &base);
+  if ((mkdirat(dirfd, base, 0777) != 0) && (errno != EEXIST)) return FAILED(0);
+  dircache_add(c, dir, len);
+  return 1;
+}
+
+
+FSHANDLE fs_create(FSCTX *c, const char *fname, int disposition)
+{
+  static const int flags[] = { O_CREAT | O_TRUNC, O_CREAT | O_EXCL, 0 };
+  const char *base;
+  int dirfd = dirof(c, fname, &base);
+  int fd;
+
+  fsc_sync(c->fsc, fname);  /* earlier file of same name still being closed */
+#ifdef ENABLE_URING
+  if (c->async && (disposition == FS_CREATE_ALWAYS) && !c->ringtried)
+  {
+    c->ring = uring_new(c->ringmem);
+    c->ringtried = 1;
+  }
+  if (c->async && (disposition == FS_CREATE_ALWAYS) && (c->ring != NULL))
+  {
+    FSHANDLE h = uring_create(c->ring, dirfd, base);
+    if (h != FS_INVALID_HANDLE)
+    {
+      snap_set(&c->snap, fname);
+      return h;
+    }
+  }
+#endif
+  uring_sync(c->ring, dirfd, base);
+  fd = openat(dirfd, base, O_WRONLY | O_CLOEXEC | flags[disposition], 0666);
+  if (fd < 0) return FAILED(FS_INVALID_HANDLE);
+  snap_set(&c->snap, fname);
+  return fd;
+}
+
+
+int fs_write(FSCTX *c, FSHANDLE h, const void *buf, unsigned len, FSSIZE offset)
+{
+  const char *p = (const char *)buf;
+
+#ifdef ENABLE_URING
+  if (IS_URING_HANDLE(h))
+  {
+    int err = uring_write(c->ring, h, buf, len, offset);
+    if (err) c->lasterror = err;
+    return !err;
+  }
+#endif
+  while (len > 0)
+  {
+    ssize_t n = pwrite(h, p, len, (off_t)offset);
+    if (n < 0)
+    {
+      if (errno == EINTR) continue;
+      return FAILED(0);
+    }
+    p += n;
+    offset += n;
+    len -= (unsigned)n;
+  }
+  return 1;
+}
+
+
+int fs_skip(FSCTX *c, FSHANDLE h, FSSIZE offset)
+{
+  return 1;  /* writes are at explicit offsets, anything skipped is a hole */
+}
+
+
+static int close_now(FSHANDLE h, time_t tartime)
+{
+  struct timespec ts[2];
+
+  ts[0].tv_sec = ts[1].tv_sec = tartime;
+  ts[0].tv_nsec = ts[1].tv_nsec = 0;
+  futimens(h, ts);
+  return (close(h) == 0) ? 0 : errno;
+}
+
+int fs_close(FSCTX *c, FSHANDLE h, const char *fname, time_t tartime)
+{
+  int err;
+
+#ifdef ENABLE_URING
+  if (IS_URING_HANDLE(h))
+  {
+    err = uring_close(c->ring, h, tartime);
+    if (err) c->lasterror = err;
+    return !err;
+  }
+#endif
+  /* local closes are cheap, only worth handing over with a spare processor */
+  if (closers < 0) closers = (thread_cpus() > 1);
+  if (c->async && closers && fsc_queue(c->fsc, close_now, h, fname, tartime)) return 1;
+  if ((err = close_now(h, tartime)) != 0)
+  {
+    c->lasterror = err;
+    return 0;
+  }
+  return 1;
+}
+
+
+int fs_setsize(FSCTX *c, FSHANDLE h, FSSIZE size)
+{
+#ifdef ENABLE_URING
+  if (IS_URING_HANDLE(h)) return 1;  /* writes are at explicit offsets */
+#endif
+  return (ftruncate(h, (off_t)size) == 0) ? 1 : FAILED(0);
+}
+
+
+FSHANDLE fs_openrange(FSCTX *c, const char *fname, FSSIZE offset)
+{
+  return fs_create(c, fname, FS_OPEN_EXISTING);  /* writes are at explicit offsets */
+}
+
+
+FSHANDLE fs_open(FSCTX *c, const char *fname)
+{
+  const char *base;
+  int dirfd = dirof(c, fname, &base);
+  int fd;
+
+  fsc_sync(c->fsc, fname);
+  uring_sync(c->ring, dirfd, base);
+  fd = openat(dirfd, base, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return FAILED(FS_INVALID_HANDLE);
+  return fd;
+}
+
+
+int fs_read(FSCTX *c, FSHANDLE h, void *buf, unsigned len, FSSIZE offset)
+{
+  char *p = (char *)buf;
+  unsigned total = 0;
+
+  while (total < len)
+  {
+    ssize_t n = pread(h, p + total, len - total, (off_t)(offset + total));
+    if (n < 0)
+    {
+      if (errno == EINTR) continue;
+      return FAILED(-1);
+    }
+    if (n == 0) break;  /* end of file */
+    total += (unsigned)n;
+  }
+  return (int)total;
+}
+
+
+FSHANDLE fs_reopen(FSCTX *c, FSHANDLE h, const char *fname, FSSIZE offset)
+{
+  close(h);
+  return fs_create(c, fname, FS_OPEN_EXISTING);  /* writes are at explicit offsets */
+}
+
+
+void fs_release(FSCTX *c, FSHANDLE h)
+{
+  close(h);
+}
+
+
+void fs_discard(FSCTX *c, FSHANDLE h, const char *fname)
+{
+  const char *base;
+  int dirfd;
+
+#ifdef ENABLE_URING
+  if (IS_URING_HANDLE(h))
+  {
+    uring_discard(c->ring, h);
+    snap_remove(&c->snap, fname);
+    return;
+  }
+#endif
+  close(h);
+  dirfd = dirof(c, fname, &base);
+  unlinkat(dirfd, base, 0);
+  snap_remove(&c->snap, fname);
+}
+
+
+int fs_remove(FSCTX *c, const char *fname)
+{
+  const char *base;
+  int dirfd = dirof(c, fname, &base);
+
+  fsc_sync(c->fsc, fname);
+  uring_sync(c->ring, dirfd, base);
+  if (unlinkat(dirfd, base, 0) != 0) return FAILED(0);
+  snap_remove(&c->snap, fname);
+  return 1;
+}
+
+
+int fs_link(FSCTX *c, const char *linkname, const char *existing)
+{
+  const char *base1, *base2;
+  int dirfd1 = dirof(c, existing, &base1);
+  int dirfd2 = dirof(c, linkname, &base2);
+
+  fsc_sync(c->fsc, existing);
+  fsc_sync(c->fsc, linkname);
+  uring_sync(c->ring, dirfd1, base1);
+  uring_sync(c->ring, dirfd2, base2);
+  if (linkat(dirfd1, base1, dirfd2, base2, 0) == 0)
+  {
+    snap_set(&c->snap, linkname);
+    return 1;
+  }
+  return FAILED(0);
+}
+
+
+static int stat_now(FSCTX *c, const char *fname, FSTIME *mtime, FSSIZE *size)
+{
+  struct stat st;
+  const char *base;
+  int dirfd = dirof(c, fname, &base);
+
+  fsc_sync(c->fsc, fname);
+  uring_sync(c->ring, dirfd, base);
+  if (fstatat(dirfd, base, &st, 0) != 0) return FAILED(0);
+  *mtime = st.st_mtime;
+  *size = st.st_size;
+  return 1;
+}
+
+int fs_getmtime(FSCTX *c, const char *fname, FSTIME *mtime)
+{
+  FSSIZE size;
+  return stat_now(c, fname, mtime, &size);
+}
+
+
+int fs_exists(FSCTX *c, const char *fname, FSTIME *mtime, FSSIZE *size)
+{
+  switch (snap_lookup(&c->snap, fname, mtime, size))
+  {
+    case SNAP_ABSENT: return 0;
+    case SNAP_EXISTS: return 1;
+    default:          return stat_now(c, fname, mtime, size);  /* listing has names only */
+  }
+}
+
+
+int fs_scandir(FSCTX *c, const char *dir, struct fssnap *s, SNAPADDFUNC add)
+{
+  struct dirent *de;
+  DIR *d;
+  int fd = openat(c->basefd, *dir ? dir : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+  if (fd < 0) return (errno == ENOENT);   /* not created yet, so nothing in it */
+  if ((d = fdopendir(fd)) == NULL)
+  {
+    close(fd);
+    return 0;
+  }
+  while ((de = readdir(d)) != NULL)
+  {
+    if (strcmp(de->d_name, ".") && strcmp(de->d_name, ".."))
+      add(s, de->d_name, 0, 0, SNAP_NOTIME);
+  }
+  closedir(d);
+  return 1;
+}
+
+
+const char *fs_map(const char *path, FSSIZE *size)
+{
+  struct stat st;
+  void *p = MAP_FAILED;
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+  if (fd < 0) return NULL;
+  if ((fstat(fd, &st) == 0) && (st.st_size > 0) && ((FSSIZE)st.st_size == (size_t)st.st_size))
+    p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);   /* mapping stays */
+  if (p == MAP_FAILED) return NULL;
+  *size = st.st_size;
+  return (const char *)p;
+}
+
+
+void fs_unmap(const char *p, FSSIZE size)
+{
+  munmap((void *)p, (size_t)size);
+}
+
+
+FSTIME fs_time(time_t tartime)
+{
+  return tartime;
+}
+
+
+int fs_flush(FSCTX *c)
+{
+  int err = fsc_flush(c->fsc);
+#ifdef ENABLE_URING
+  int err2 = uring_flush(c->ring);
+  if (!err) err = err2;
+#endif
+  snap_clear(&c->snap);
+  if (err)
+  {
+    c->lasterror = err;
+    return 0;
+  }
+  return 1;
+}
+
+
+unsigned long fs_buffers(FSCTX *c, unsigned long maxmem)
+{
+#ifdef ENABLE_URING
+  if (maxmem != c->ringmem)
+  {
+    /* made again with the new limit by the next async create */
+    fs_flush(c);
+    uring_free(c->ring);
+    c->ring = NULL;
+    c->ringtried = 0;
+    c->ringmem = maxmem;
+  }
+  return uring_bufmem(maxmem);
+#else
+  return 0;
+#endif
+}
+
+
+int fs_async(FSCTX *c, int enable)
+{
+  int prev = c->async;
+  fs_flush(c);
+  c->async = enable;
+  return prev;
+}
+
+
+int fs_lasterror(FSCTX *c)
+{
+  return (c != NULL) ? c->lasterror : errno;
+}
@@ -0,0 +1,561 @@
+/*
+ * fsio_uring - io_uring output queue used by the POSIX fsio backend
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * Extracting archives of many small files is bound by system call round
+ * trips, every member costs an open, write(s), a timestamp and a close.
+ * Here each file becomes a chain of linked requests
+ *   openat -> write -> ... -> write -> close
+ * using a direct (registered table) descriptor, so the writes need not
+ * wait for the open to return, and the chains of many files go to the
+ * kernel with a single io_uring_enter.  Completions are reaped whenever
+ * the queue is next touched.  io_uring has no utimes request, the
+ * timestamp is set with utimensat once the close has completed.
+ *
+ * Each output context has its own ring (and buffers), set up the first
+ * time it creates a file.  Bounded to URING_FILES files and URING_BUFS
+ * buffers in flight (fewer if given a memory limit); a file
+ * larger than URING_CHAIN buffers has its writes queued in groups, each
+ * group waiting for the previous one of that file.  Linked writes using
+ * a descriptor opened earlier in the chain require Linux 5.17
+ * (IORING_FEAT_LINKED_FILE), without it uring_create always fails and
+ * fsio_posix.c uses its synchronous calls.
+ *
+ * Uses the raw system calls, liburing is not required.
+ */
+
+#define _GNU_SOURCE 1
+#include "fsio_uring.h"
+#include "untar.h"   /* BLOCKSIZE, PrintMessage */
+#include "decpool.h"
+
+#ifdef ENABLE_URING
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+
+#define URING_ENTRIES 256         /* submission queue size */
+#define URING_FILES   64          /* files in flight, registered descriptor slots */
+#define URING_BUFS    64          /* output buffers */
+#define URING_BUFSIZE (64*1024)
+#define URING_CHAIN   8           /* full buffers held before writes are queued */
+#define URING_MINBUFS (URING_CHAIN + 1)  /* a file's pending buffers and the one being filled */
+
+/* user_data of each request, file slot + operation + buffer */
+#define OP_OPEN  0
+#define OP_WRITE 1
+#define OP_CLOSE 2
+#define UDATA(slot, op, buf)  ((__u64)(slot) | ((__u64)(op) << 8) | ((__u64)(buf) << 16))
+
+
+struct ufile {
+  int    busy;                /* slot in use */
+  int    submitted;           /* openat has been queued */
+  int    opened;              /* openat completed successfully */
+  int    closing;             /* close queued, slot freed once all complete */
+  int    closed;              /* closed (or discarded) by engine */
+  int    discard;             /* delete instead of setting timestamp */
+  int    inflight;            /* queued requests not yet completed */
+  int    error;               /* first errno from a request */
+  int    dirfd;
+  time_t tartime;
+  int    cur;                 /* buffer being filled, -1 if none */
+  int    npend;               /* full buffers not yet queued */
+  int    pend[URING_CHAIN];
+  char   name[BLOCKSIZE];
+};
+
+struct ubuf {
+  int           next;         /* next in free list */
+  unsigned      len;
+  FSSIZE        offset;
+  char         *data;
+};
+
+struct uring {
+  int       fd;
+  unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+  void     *sqmap, *sqemap;   /* mappings, for uring_free */
+  size_t    sqmapsize, sqemapsize;
+  unsigned  entries;
+  unsigned  tail;             /* local submission tail */
+  unsigned  tosubmit;         /* filled in but not yet given to kernel */
+  int       inflight;         /* requests given to kernel not yet reaped */
+  int       error;            /* first failure since last uring_flush */
+  struct ufile files[URING_FILES];
+  struct ubuf  bufs[URING_BUFS];
+  int       nbufs;            /* of bufs used */
+  int       freebuf;
+  char     *data;             /* all buffers */
+};
+
+
+static int sys_setup(unsigned entries, struct io_uring_params *p)
+{
+  return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_enter(struct uring *u, unsigned tosubmit, unsigned mincomplete, unsigned flags)
+{
+  return (int)syscall(__NR_io_uring_enter, u->fd, tosubmit, mincomplete, flags, NULL, 0);
+}
+
+static int sys_register(struct uring *u, unsigned opcode, void *arg, unsigned nr)
+{
+  return (int)syscall(__NR_io_uring_register, u->fd, opcode, arg, nr);
+}
+
+
+/* frees what uring_new set up, fd and mappings if made */
+static void ring_free(struct uring *u)
+{
+  dpool_free(u->data);
+  if (u->sqemap != NULL) munmap(u->sqemap, u->sqemapsize);
+  if (u->sqmap != NULL) munmap(u->sqmap, u->sqmapsize);
+  if (u->fd >= 0) close(u->fd);
+  free(u);
+}
+
+/* buffers to use within maxmem bytes (0 for no limit) */
+static int nbufs(unsigned long maxmem)
+{
+  if ((maxmem == 0) || (maxmem / URING_BUFSIZE >= URING_BUFS)) return URING_BUFS;
+  if (maxmem / URING_BUFSIZE <= URING_MINBUFS) return URING_MINBUFS;
+  return (int)(maxmem / URING_BUFSIZE);
+}
+
+unsigned long uring_bufmem(unsigned long maxmem)
+{
+  return (unsigned long)nbufs(maxmem) * URING_BUFSIZE;
+}
+
+struct uring *uring_new(unsigned long maxmem)
+{
+  struct io_uring_params p;
+  size_t sqsize, cqsize;
+  char *sq, *cq;
+  int fds[URING_FILES];
+  int i;
+  struct uring *u = (struct uring *)calloc(1, sizeof(struct uring));
+
+  if (u == NULL) return NULL;
+  u->freebuf = -1;
+  memset(&p, 0, sizeof(p));
+  if ((u->fd = sys_setup(URING_ENTRIES, &p)) < 0) goto fail;
+  if (!(p.features & IORING_FEAT_LINKED_FILE) || !(p.features & IORING_FEAT_SINGLE_MMAP))
+    goto fail;
+
+  sqsize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  cqsize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (cqsize > sqsize) sqsize = cqsize;
+  sq = cq = (char *)mmap(NULL, sqsize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+  if (sq == (char *)MAP_FAILED) goto fail;
+  u->sqmap = sq;
+  u->sqmapsize = sqsize;
+  u->sqes = (struct io_uring_sqe *)mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe),
+                  PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, u->fd, IORING_OFF_SQES);
+  if (u->sqes == (struct io_uring_sqe *)MAP_FAILED) goto fail;
+  u->sqemap = u->sqes;
+  u->sqemapsize = p.sq_entries * sizeof(struct io_uring_sqe);
+
+  u->sq_head  = (unsigned *)(sq + p.sq_off.head);
+  u->sq_tail  = (unsigned *)(sq + p.sq_off.tail);
+  u->sq_mask  = (unsigned *)(sq + p.sq_off.ring_mask);
+  u->sq_array = (unsigned *)(sq + p.sq_off.array);
+  u->cq_head  = (unsigned *)(cq + p.cq_off.head);
+  u->cq_tail  = (unsigned *)(cq + p.cq_off.tail);
+  u->cq_mask  = (unsigned *)(cq + p.cq_off.ring_mask);
+  u->cqes     = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+  u->entries  = p.sq_entries;
+  u->tail     = *u->sq_tail;
+
+  /* empty descriptor table, openat fills slots directly */
+  for (i = 0; i < URING_FILES; i++) fds[i] = -1;
+  if (sys_register(u, IORING_REGISTER_FILES, fds, URING_FILES) < 0) goto fail;
+
+  u->nbufs = nbufs(maxmem);
+  if ((u->data = (char *)dpool_alloc((unsigned long)u->nbufs * URING_BUFSIZE)) == NULL) goto fail;
+  for (i = 0; i < u->nbufs; i++)
+  {
+    u->bufs[i].data = u->data + (size_t)i * URING_BUFSIZE;
+    u->bufs[i].next = u->freebuf;
+    u->freebuf = i;
+  }
+  return u;
+
+fail:
+  ring_free(u);
+  return NULL;
+}
+
+
+void uring_free(struct uring *u)
+{
+  if (u == NULL) return;
+  uring_flush(u);
+  ring_free(u);
+}
+
+
+/* gives filled in requests to kernel, waiting for at least wait completions */
+static int submit(struct uring *u, unsigned wait)
+{
+  int n;
+
+  __atomic_store_n(u->sq_tail, u->tail, __ATOMIC_RELEASE);
+  do
+    n = sys_enter(u, u->tosubmit, wait, wait ? IORING_ENTER_GETEVENTS : 0);
+  while ((n < 0) && (errno == EINTR));
+  if (n < 0)
+  {
+    /* EAGAIN/EBUSY, completions must be reaped before more are accepted */
+    if ((errno == EAGAIN) || (errno == EBUSY)) return 1;
+    if (!u->error) u->error = errno;
+    return 0;
+  }
+  u->tosubmit -= n;
+  u->inflight += n;
+  return 1;
+}
+
+
+static void release_buf(struct uring *u, int b)
+{
+  u->bufs[b].next = u->freebuf;
+  u->freebuf = b;
+}
+
+static void seterror(struct ufile *f, int err)
+{
+  if ((err != ECANCELED) && !f->error) f->error = err;
+}
+
+/* all requests for a closed file are done, set time or report failure */
+static void finish(struct uring *u, struct ufile *f)
+{
+  if (f->discard)
+  {
+    unlinkat(f->dirfd, f->name, 0);
+  }
+  else if (f->error)
+  {
+    if (!f->opened)
+      PrintMessage(_T("Error: Could not create file %s [%d]"), _A2T(f->name), f->error);
+    else
+    {
+      PrintMessage(_T("Error: write failed for %s [%d]"), _A2T(f->name), f->error);
+      unlinkat(f->dirfd, f->name, 0);
+    }
+    if (!u->error) u->error = f->error;
+  }
+  else
+  {
+    struct timespec ts[2];
+    ts[0].tv_sec = ts[1].tv_sec = f->tartime;
+    ts[0].tv_nsec = ts[1].tv_nsec = 0;
+    utimensat(f->dirfd, f->name, ts, 0);
+  }
+  f->busy = 0;
+}
+
+/* processes any completions available, no system call */
+static void reap(struct uring *u)
+{
+  unsigned head = *u->cq_head;
+
+  while (head != __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE))
+  {
+    struct io_uring_cqe *cqe = &u->cqes[head & *u->cq_mask];
+    struct ufile *f = &u->files[cqe->user_data & 0xff];
+    int op = (int)((cqe->user_data >> 8) & 0xff);
+    int b = (int)(cqe->user_data >> 16);
+
+    if (cqe->res < 0)
+      seterror(f, -cqe->res);
+    else if (op == OP_OPEN)
+      f->opened = 1;
+    else if ((op == OP_WRITE) && ((unsigned)cqe->res != u->bufs[b].len))
+      seterror(f, ENOSPC);   /* short write */
+    if (op == OP_WRITE) release_buf(u, b);
+
+    f->inflight--;
+    u->inflight--;
+    if (f->closing && (f->inflight == 0)) finish(u, f);
+    head++;
+  }
+  __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+}
+
+/* submits anything pending and waits for a completion,
+   returns 0 if nothing to wait on or ring failed */
+static int wait_one(struct uring *u)
+{
+  if ((u->inflight == 0) && (u->tosubmit == 0)) return 0;
+  if (!submit(u, 1)) return 0;
+  reap(u);
+  return 1;
+}
+
+
+static struct io_uring_sqe *get_sqe(struct uring *u, struct ufile *f, int op, int b)
+{
+  struct io_uring_sqe *sqe = &u->sqes[u->tail & *u->sq_mask];
+  u->sq_array[u->tail & *u->sq_mask] = u->tail & *u->sq_mask;
+  u->tail++;
+  u->tosubmit++;
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->user_data = UDATA(f - u->files, op, b);
+  f->inflight++;
+  return sqe;
+}
+
+/* queues openat (if not yet done), pending writes and if closing the close,
+   all linked so a chain is given to the kernel in one submission */
+static int queue(struct uring *u, struct ufile *f, int closing)
+{
+  int slot = (int)(f - u->files);
+  int doopen, doclose;
+  unsigned n;
+  int i;
+
+  /* writes of a later group must not overtake an earlier one or its open,
+     once that has completed opened is known */
+  if (f->submitted)
+  {
+    while (f->inflight > 0)
+      if (!wait_one(u)) return 0;
+  }
+  if (f->error || f->discard)
+  {
+    for (i = 0; i < f->npend; i++) release_buf(u, f->pend[i]);
+    f->npend = 0;
+  }
+
+  doopen = !f->submitted;
+  doclose = closing && (doopen || f->opened);
+  n = doopen + f->npend + doclose;
+  if (n == 0)
+  {
+    /* open failed, nothing to close */
+    if (closing)
+    {
+      f->closing = 1;
+      finish(u, f);
+    }
+    return 1;
+  }
+
+  /* whole chain must fit in this submission or the link is broken */
+  while (u->entries - (u->tail - __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE)) < n)
+    if (!wait_one(u)) return 0;
+
+  if (doopen)
+  {
+    struct io_uring_sqe *sqe = get_sqe(u, f, OP_OPEN, 0);
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = f->dirfd;
+    sqe->addr = (__u64)(unsigned long)f->name;
+    sqe->len = 0666;
+    sqe->open_flags = O_WRONLY | O_CREAT | O_TRUNC;   /* no O_CLOEXEC for direct descriptors */
+    sqe->file_index = slot + 1;
+    if (--n) sqe->flags = IOSQE_IO_LINK;   /* failed open cancels the rest */
+    f->submitted = 1;
+  }
+  for (i = 0; i < f->npend; i++)
+  {
+    int b = f->pend[i];
+    struct io_uring_sqe *sqe = get_sqe(u, f, OP_WRITE, b);
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = slot;
+    sqe->addr = (__u64)(unsigned long)u->bufs[b].data;
+    sqe->len = u->bufs[b].len;
+    sqe->off = u->bufs[b].offset;
+    sqe->flags = IOSQE_FIXED_FILE;
+    if (--n) sqe->flags |= IOSQE_IO_HARDLINK;   /* close even if write fails */
+  }
+  f->npend = 0;
+  if (doclose)
+  {
+    struct io_uring_sqe *sqe = get_sqe(u, f, OP_CLOSE, 0);
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->file_index = slot + 1;
+  }
+  if (closing) f->closing = 1;
+
+  /* let kernel start on a batch once there is a reasonable amount */
+  if (u->tosubmit >= u->entries / 2) submit(u, 0);
+  reap(u);
+  return 1;
+}
+
+
+FSHANDLE uring_create(struct uring *u, int dirfd, const char *fname)
+{
+  struct ufile *f = NULL;
+  int i;
+
+  if (strlen(fname) >= BLOCKSIZE) return FS_INVALID_HANDLE;
+
+  /* same name still in flight (tarball with duplicates), let it finish first */
+  uring_sync(u, dirfd, fname);
+
+  while (f == NULL)
+  {
+    for (i = 0; i < URING_FILES; i++)
+      if (!u->files[i].busy) { f = &u->files[i]; break; }
+    if ((f == NULL) && !wait_one(u)) return FS_INVALID_HANDLE;
+  }
+
+  memset(f, 0, sizeof(*f) - sizeof(f->name));
+  f->busy = 1;
+  f->cur = -1;
+  f->dirfd = dirfd;
+  strcpy(f->name, fname);
+  return URING_HANDLE(f - u->files);
+}
+
+
+int uring_write(struct uring *u, FSHANDLE h, const void *buf, unsigned len, FSSIZE offset)
+{
+  struct ufile *f = &u->files[-2 - h];
+  const char *p = (const char *)buf;
+
+  while (len > 0)
+  {
+    struct ubuf *b;
+    unsigned n;
+
+    reap(u);
+    if (f->error) return f->error;
+
+    /* not contiguous with buffer being filled, start a new one */
+    if ((f->cur >= 0) && (u->bufs[f->cur].offset + u->bufs[f->cur].len != offset))
+    {
+      f->pend[f->npend++] = f->cur;
+      f->cur = -1;
+      if ((f->npend == URING_CHAIN) && !queue(u, f, 0)) return u->error;
+    }
+    if (f->cur < 0)
+    {
+      while (u->freebuf < 0)
+        if (!wait_one(u)) return u->error ? u->error : ENOBUFS;
+      f->cur = u->freebuf;
+      u->freebuf = u->bufs[u->freebuf].next;
+      u->bufs[f->cur].len = 0;
+      u->bufs[f->cur].offset = offset;
+    }
+
+    b = &u->bufs[f->cur];
+    n = URING_BUFSIZE - b->len;
+    if (n > len) n = len;
+    memcpy(b->data + b->len, p, n);
+    b->len += n;
+    p += n;
+    offset += n;
+    len -= n;
+
+    if (b->len == URING_BUFSIZE)
+    {
+      f->pend[f->npend++] = f->cur;
+      f->cur = -1;
+      if ((f->npend == URING_CHAIN) && !queue(u, f, 0)) return u->error;
+    }
+  }
+  return 0;
+}
+
+
+int uring_close(struct uring *u, FSHANDLE h, time_t tartime)
+{
+  struct ufile *f = &u->files[-2 - h];
+
+  f->tartime = tartime;
+  f->closed = 1;
+  if (f->cur >= 0)
+  {
+    f->pend[f->npend++] = f->cur;
+    f->cur = -1;
+  }
+  return queue(u, f, 1) ? 0 : u->error;
+}
+
+
+void uring_discard(struct uring *u, FSHANDLE h)
+{
+  struct ufile *f = &u->files[-2 - h];
+
+  f->closed = 1;
+  f->discard = 1;
+  if (f->cur >= 0)
+  {
+    release_buf(u, f->cur);
+    f->cur = -1;
+  }
+  if (!f->submitted)
+  {
+    /* nothing reached the file system */
+    for (; f->npend > 0; f->npend--) release_buf(u, f->pend[f->npend-1]);
+    f->busy = 0;
+    return;
+  }
+  queue(u, f, 1);
+  while (f->busy)
+    if (!wait_one(u)) break;
+}
+
+
+void uring_sync(struct uring *u, int dirfd, const char *fname)
+{
+  int i;
+
+  if (u == NULL) return;
+  for (i = 0; i < URING_FILES; i++)
+  {
+    struct ufile *f = &u->files[i];
+    if (f->busy && f->closed && (f->dirfd == dirfd) && (strcmp(f->name, fname) == 0))
+    {
+      while (f->busy)
+        if (!wait_one(u)) break;
+    }
+  }
+}
+
+
+void uring_release(struct uring *u, int dirfd)
+{
+  int i;
+
+  if (u == NULL) return;
+  for (i = 0; i < URING_FILES; i++)
+  {
+    struct ufile *f = &u->files[i];
+    while (f->busy && f->closed && (f->dirfd == dirfd))
+      if (!wait_one(u)) break;
+  }
+}
+
+
+int uring_flush(struct uring *u)
+{
+  int err;
+
+  if (u == NULL) return 0;
+  while ((u->inflight > 0) || (u->tosubmit > 0))
+    if (!wait_one(u)) break;
+  err = u->error;
+  u->error = 0;
+  return err;
+}
+
+#endif /* ENABLE_URING */
@@ -0,0 +1,78 @@
+/*
+ * fsio_uring - io_uring output queue used by the POSIX fsio backend
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * Only for use by fsio_posix.c, the engine itself uses fsio.h.  Queued
+ * files are identified by handles below FS_INVALID_HANDLE so they can be
+ * told apart from plain descriptors.  Functions other than uring_create
+ * return 0 on success or an errno value.
+ */
+
+#ifndef _FSIO_URING_H_
+#define _FSIO_URING_H_
+
+#include "fsio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* comment out to always use the synchronous calls */
+#if defined(__linux__)
+#define ENABLE_URING
+#endif
+
+#ifdef ENABLE_URING
+
+#define URING_HANDLE(slot)  (-2 - (slot))
+#define IS_URING_HANDLE(h)  ((h) < -1)
+
+/* ring with its own descriptor table and buffers, for one output context */
+struct uring;
+
+/* sets up a ring with output buffers of at most maxmem bytes (0 for
+   the default, never less than one file needs), NULL if io_uring can't
+   be used (or is too old) */
+struct uring *uring_new(unsigned long maxmem);
+
+/* bytes of output buffers a ring set up with maxmem has */
+unsigned long uring_bufmem(unsigned long maxmem);
+
+/* waits for all queued files and frees ring */
+void uring_free(struct uring *u);
+
+/* starts queueing a new file (created or truncated) relative to dirfd,
+   FS_INVALID_HANDLE if name too long; nothing is done to the file
+   system until its writes are queued */
+FSHANDLE uring_create(struct uring *u, int dirfd, const char *fname);
+
+/* copies data into the file's output buffers, fails only if an earlier
+   queued request for this file failed */
+int uring_write(struct uring *u, FSHANDLE h, const void *buf, unsigned len, FSSIZE offset);
+
+/* queues remaining writes and the close, timestamp set once done */
+int uring_close(struct uring *u, FSHANDLE h, time_t tartime);
+
+/* drops the file's data and waits for it to be closed and deleted */
+void uring_discard(struct uring *u, FSHANDLE h);
+
+/* waits for any queued file named fname to complete; u may be NULL
+   (no ring) here and below */
+void uring_sync(struct uring *u, int dirfd, const char *fname);
+
+/* waits for queued files created relative to dirfd, before it is closed */
+void uring_release(struct uring *u, int dirfd);
+
+/* waits for all queued files, returns first error since last flush */
+int uring_flush(struct uring *u);
+
+#endif /* ENABLE_URING */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FSIO_URING_H_ */
@@ -0,0 +1,504 @@
+/*
+ * fsio - output file system access used by tgz_extract, Win32 version
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * Names are joined to the context's base directory (made absolute by
+ * fs_new) before each call, the current directory is never changed so
+ * contexts don't affect one another.  Only needs Win95/NT4 level API,
+ * hard links are looked up at runtime as they require NT5 (Win 2000) or
+ * later.
+ */
+
+#include "fsio.h"
+#include "fsclose.h"
+#include "fssnap.h"
+#include "untar.h"   /* makedir, PrintMessage */
+
+
+struct fsctx {
+  char            base[MAX_PATH];  /* with trailing separator, "" for current directory */
+  unsigned        baselen;
+  char            path[2][MAX_PATH];  /* names joined to base, see join */
+  int             async;
+  struct fssnap   snap;
+  struct fsclose *fsc;             /* NULL if closes can't be queued */
+};
+
+
+/* returns fname joined to base in path[n], or NULL if too long (with
+   last error set, so callers fail as the call itself would) */
+static const char *join(FSCTX *c, int n, const char *fname)
+{
+  unsigned len = strlen(fname);
+
+  if (c->baselen + len >= MAX_PATH)
+  {
+    SetLastError(ERROR_FILENAME_EXCED_RANGE);
+    return NULL;
+  }
+  memcpy(c->path[n], c->base, c->baselen);
+  memcpy(c->path[n] + c->baselen, fname, len + 1);
+  return c->path[n];
+}
+
+
+FSCTX *fs_new(const TCHAR *dir)
+{
+  FSCTX *c = (FSCTX *)calloc(1, sizeof(FSCTX));
+  char *filepart;
+  DWORD len, attr;
+
+  if (c == NULL)
+  {
+    SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+    return NULL;
+  }
+  c->async = 1;
+  c->snap.fs = c;
+  c->fsc = fsc_new();
+
+  if (dir != NULL)
+  {
+    /* try to create if it doesn't exist yet */
+    makedir(c, _T2A((TCHAR *)dir));
+    len = GetFullPathNameA(_T2A((TCHAR *)dir), MAX_PATH - 1, c->base, &filepart);
+    attr = ((len > 0) && (len < MAX_PATH - 1)) ? GetFileAttributesA(c->base) : 0xFFFFFFFF;
+    if ((attr == 0xFFFFFFFF) || !(attr & FILE_ATTRIBUTE_DIRECTORY))
+    {
+      DWORD err = (len >= MAX_PATH - 1) ? ERROR_FILENAME_EXCED_RANGE :
+                  (attr == 0xFFFFFFFF) ? GetLastError() : ERROR_DIRECTORY;
+      fs_free(c);
+      SetLastError(err);
+      return NULL;
+    }
+    if ((c->base[len - 1] != '\\') && (c->base[len - 1] != '/')) c->base[len++] = '\\';
+    c->base[len] = '\0';
+    c->baselen = len;
+  }
+  return c;
+}
+
+
+void fs_free(FSCTX *c)
+{
+  if (c == NULL) return;
+  fs_flush(c);
+  fsc_free(c->fsc);
+  free(c);
+}
+
+
+FSCTX *fs_clone(FSCTX *c)
+{
+  FSCTX *n = (FSCTX *)calloc(1, sizeof(FSCTX));
+
+  if (n == NULL) return NULL;
+  memcpy(n->base, c->base, c->baselen + 1);
+  n->baselen = c->baselen;
+  n->snap.fs = n;
+  return n;
+}
+
+
+int fs_mkdir(FSCTX *c, const char *dir)
+{
+  const char *path = join(c, 0, dir);
+  if (path == NULL) return 0;
+  if (CreateDirectoryA(path, NULL)) return 1;
+  return (GetLastError()==ERROR_FILE_EXISTS) || (GetLastError()==ERROR_ALREADY_EXISTS);
+}
+
+
+FSHANDLE fs_create(FSCTX *c, const char *fname, int disposition)
+{
+  static const DWORD dwCreate[] = { CREATE_ALWAYS, CREATE_NEW, OPEN_EXISTING };
+  const char *path = join(c, 0, fname);
+  HANDLE h;
+
+  if (path == NULL) return INVALID_HANDLE_VALUE;
+  fsc_sync(c->fsc, fname);  /* earlier file of same name still being closed */
+  h = CreateFileA(path,GENERIC_WRITE,FILE_SHARE_READ,NULL,dwCreate[disposition],FILE_ATTRIBUTE_NORMAL,NULL);
+  if (h != INVALID_HANDLE_VALUE) snap_set(&c->snap, fname);
+  return h;
+}
+
+
+int fs_write(FSCTX *c, FSHANDLE h, const void *buf, unsigned len, FSSIZE offset)
+{
+  unsigned long bwritten;
+  /* sequential only, Win9x does not support offsets (OVERLAPPED) for files */
+  return WriteFile(h,(LPVOID)buf,len,&bwritten,NULL) && (bwritten == len);
+}
+
+
+/* moves file pointer to offset, returns nonzero on success */
+static int seek(HANDLE h, FSSIZE offset)
+{
+  LONG high = (LONG)(offset >> 32);
+  SetLastError(NO_ERROR);  /* low part of 0xFFFFFFFF is also the failure value */
+  return (SetFilePointer(h, (LONG)offset, &high, FILE_BEGIN) != 0xFFFFFFFF) || (GetLastError() == NO_ERROR);
+}
+
+
+#ifndef FSCTL_SET_SPARSE
+#define FSCTL_SET_SPARSE 0x000900C4
+#endif
+
+int fs_skip(FSCTX *c, FSHANDLE h, FSSIZE offset)
+{
+  DWORD bytes;
+  /* NTFS (NT5+) leaves unwritten ranges of sparse files unallocated, fails elsewhere */
+  DeviceIoControl(h, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &bytes, NULL);
+  return seek(h, offset);
+}
+
+
+static int close_now(FSHANDLE h, time_t tartime)
+{
+  FSTIME ftm = fs_time(tartime);
+  SetFileTime(h,(FILETIME *)&ftm,NULL,(FILETIME *)&ftm);
+  return CloseHandle(h) ? 0 : (int)GetLastError();
+}
+
+int fs_close(FSCTX *c, FSHANDLE h, const char *fname, time_t tartime)
+{
+  int err;
+
+  if (c->async && fsc_queue(c->fsc, close_now, h, fname, tartime)) return 1;
+  if ((err = close_now(h, tartime)) != 0)
+  {
+    SetLastError(err);
+    return 0;
+  }
+  return 1;
+}
+
+
+typedef BOOL (WINAPI *SetFileValidDataPtr)(HANDLE hFile, LONGLONG ValidDataLength);
+typedef BOOL (WINAPI *OpenProcessTokenPtr)(HANDLE ProcessHandle, DWORD DesiredAccess, PHANDLE TokenHandle);
+typedef BOOL (WINAPI *LookupPrivilegeValueAPtr)(LPCSTR lpSystemName, LPCSTR lpName, PLUID lpLuid);
+typedef BOOL (WINAPI *AdjustTokenPrivilegesPtr)(HANDLE TokenHandle, BOOL DisableAllPrivileges, PTOKEN_PRIVILEGES NewState, DWORD BufferLength, PTOKEN_PRIVILEGES PreviousState, PDWORD ReturnLength);
+
+/* SetFileValidData (XP+), NULL if missing or the process can't enable
+   the manage volume privilege it needs (only administrators hold it) */
+static SetFileValidDataPtr validdata(void)
+{
+  static SetFileValidDataPtr sfvd = NULL;
+  static int looked = 0;
+  HMODULE k32, adv;
+  OpenProcessTokenPtr opt;
+  LookupPrivilegeValueAPtr lpv;
+  AdjustTokenPrivilegesPtr atp;
+  TOKEN_PRIVILEGES tp;
+  HANDLE token;
+
+  if (looked) return sfvd;
+  looked = 1;
+  k32 = GetModuleHandleA("KERNEL32.DLL");
+  adv = LoadLibraryA("ADVAPI32.DLL");
+  if ((k32 == NULL) || (adv == NULL)) return NULL;
+  opt = (OpenProcessTokenPtr)GetProcAddress(adv, "OpenProcessToken");
+  lpv = (LookupPrivilegeValueAPtr)GetProcAddress(adv, "LookupPrivilegeValueA");
+  atp = (AdjustTokenPrivilegesPtr)GetProcAddress(adv, "AdjustTokenPrivileges");
+  if ((opt == NULL) || (lpv == NULL) || (atp == NULL) ||
+      !opt(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES, &token))
+    return NULL;
+  tp.PrivilegeCount = 1;
+  tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+  /* succeeds without enabling it when not held, so check the error too */
+  if (lpv(NULL, "SeManageVolumePrivilege", &tp.Privileges[0].Luid) &&
+      atp(token, FALSE, &tp, 0, NULL, NULL) && (GetLastError() == NO_ERROR))
+    sfvd = (SetFileValidDataPtr)GetProcAddress(k32, "SetFileValidData");
+  CloseHandle(token);
+  return sfvd;
+}
+
+int fs_setsize(FSCTX *c, FSHANDLE h, FSSIZE size)
+{
+  SetFileValidDataPtr sfvd = validdata();
+
+  if (!seek(h, size) || !SetEndOfFile(h)) return 0;
+  /* NTFS zero fills from the valid data length up to any write past it,
+     so unless it can be moved to the end writing a later range first
+     writes the bytes before it twice; ranges are started in order */
+  if (sfvd != NULL) sfvd(h, (LONGLONG)size);
+  return 1;
+}
+
+
+FSHANDLE fs_openrange(FSCTX *c, const char *fname, FSSIZE offset)
+{
+  const char *path = join(c, 0, fname);
+  HANDLE h;
+
+  if (path == NULL) return INVALID_HANDLE_VALUE;
+  /* each range writer has its own handle, so all must share writing */
+  h = CreateFileA(path,GENERIC_WRITE,FILE_SHARE_READ|FILE_SHARE_WRITE,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+  if ((h != INVALID_HANDLE_VALUE) && !seek(h, offset))
+  {
+    CloseHandle(h);
+    return INVALID_HANDLE_VALUE;
+  }
+  return h;
+}
+
+
+FSHANDLE fs_open(FSCTX *c, const char *fname)
+{
+  const char *path = join(c, 0, fname);
+
+  if (path == NULL) return INVALID_HANDLE_VALUE;
+  fsc_sync(c->fsc, fname);
+  return CreateFileA(path,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+}
+
+
+int fs_read(FSCTX *c, FSHANDLE h, void *buf, unsigned len, FSSIZE offset)
+{
+  unsigned long bread, total = 0;
+
+  while (total < len)
+  {
+    if (!ReadFile(h,(char *)buf + total,len - total,&bread,NULL)) return -1;
+    if (bread == 0) break;  /* end of file */
+    total += bread;
+  }
+  return (int)total;
+}
+
+
+FSHANDLE fs_reopen(FSCTX *c, FSHANDLE h, const char *fname, FSSIZE offset)
+{
+  CloseHandle(h);
+  h = fs_create(c, fname, FS_OPEN_EXISTING);
+  if ((h != INVALID_HANDLE_VALUE) && !seek(h, offset))
+  {
+    CloseHandle(h);
+    return INVALID_HANDLE_VALUE;
+  }
+  return h;
+}
+
+
+void fs_release(FSCTX *c, FSHANDLE h)
+{
+  CloseHandle(h);
+}
+
+
+void fs_discard(FSCTX *c, FSHANDLE h, const char *fname)
+{
+  const char *path = join(c, 0, fname);
+
+  CloseHandle(h);
+  if (path != NULL) DeleteFileA(path);
+  snap_remove(&c->snap, fname);
+}
+
+
+int fs_remove(FSCTX *c, const char *fname)
+{
+  const char *path = join(c, 0, fname);
+
+  if (path == NULL) return 0;
+  fsc_sync(c->fsc, fname);
+  if (!DeleteFileA(path)) return 0;
+  snap_remove(&c->snap, fname);
+  return 1;
+}
+
+
+#ifdef UNICODE
+#define funcName "CreateHardLinkW"
+#else
+#define funcName "CreateHardLinkA"
+#endif
+typedef BOOL (*CreateHardLinkTPtr)(TCHAR * linkFileName, TCHAR * existingFileName, LPSECURITY_ATTRIBUTES lpSecurityAttributes);
+int fs_link(FSCTX *c, const char *linkname, const char *existing)
+{
+	HMODULE hLib = LoadLibrary(_T("KERNEL32.DLL"));
+	CreateHardLinkTPtr chlT;
+	TCHAR f2[MAX_PATH]; /* can't call _A2T in same call as uses a static buffer */
+	const char *path1 = join(c, 0, existing), *path2 = join(c, 1, linkname);
+	if ((path1 == NULL) || (path2 == NULL)) return FALSE;
+	fsc_sync(c->fsc, existing);
+	_tcscpy(f2, _A2T((char *)path1));
+	if ((hLib != NULL) && ((chlT = (CreateHardLinkTPtr)GetProcAddress(hLib, funcName)) != NULL))
+	{
+		if (!chlT(_A2T((char *)path2), f2, NULL)) return FALSE;
+		snap_set(&c->snap, linkname);
+		return TRUE;
+	}
+	SetLastError(ERROR_CALL_NOT_IMPLEMENTED);
+	return FALSE;
+}
+
+
+static int stat_now(FSCTX *c, const char *fname, FSTIME *mtime, FSSIZE *size)
+{
+  WIN32_FIND_DATAA ffData;
+  const char *path = join(c, 0, fname);
+  HANDLE h;
+
+  if (path == NULL) return 0;
+  fsc_sync(c->fsc, fname);
+  h = FindFirstFileA(path, &ffData);
+
+  if (h == INVALID_HANDLE_VALUE) return 0;
+  FindClose(h);  /* cleanup search handle */
+  *mtime = *((LONGLONG *)&(ffData.ftLastWriteTime));
+  *size = ((FSSIZE)ffData.nFileSizeHigh << 32) | ffData.nFileSizeLow;
+  return 1;
+}
+
+int fs_getmtime(FSCTX *c, const char *fname, FSTIME *mtime)
+{
+  FSSIZE size;
+  return stat_now(c, fname, mtime, &size);
+}
+
+
+int fs_exists(FSCTX *c, const char *fname, FSTIME *mtime, FSSIZE *size)
+{
+  switch (snap_lookup(&c->snap, fname, mtime, size))
+  {
+    case SNAP_ABSENT: return 0;
+    case SNAP_EXISTS: return 1;
+    default:          return stat_now(c, fname, mtime, size);
+  }
+}
+
+
+int fs_scandir(FSCTX *c, const char *dir, struct fssnap *s, SNAPADDFUNC add)
+{
+  WIN32_FIND_DATAA ffData;
+  const char *path;
+  HANDLE h;
+  char *pattern = (char *)malloc(strlen(dir) + 3);
+
+  if (pattern == NULL) return 0;
+  strcpy(pattern, dir);
+  strcat(pattern, *dir ? "/*" : "*");
+  path = join(c, 0, pattern);
+  free(pattern);
+  if (path == NULL) return 0;
+  h = FindFirstFileA(path, &ffData);
+  if (h == INVALID_HANDLE_VALUE)
+  {
+    /* not created yet, so nothing in it */
+    return (GetLastError()==ERROR_PATH_NOT_FOUND) || (GetLastError()==ERROR_FILE_NOT_FOUND);
+  }
+  do
+  {
+    if (strcmp(ffData.cFileName, ".") && strcmp(ffData.cFileName, ".."))
+      add(s, ffData.cFileName, *((LONGLONG *)&(ffData.ftLastWriteTime)),
+          ((FSSIZE)ffData.nFileSizeHigh << 32) | ffData.nFileSizeLow, SNAP_EXISTS);
+  } while (FindNextFileA(h, &ffData));
+  FindClose(h);
+  return 1;
+}
+
+
+const char *fs_map(const char *path, FSSIZE *size)
+{
+  HANDLE h, m;
+  DWORD low, high;
+  const char *p = NULL;
+
+  h = CreateFileA(path,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+  if (h == INVALID_HANDLE_VALUE) return NULL;
+  low = GetFileSize(h, &high);
+  /* must fit in the (usually 32 bit) address space */
+  if ((low != 0xFFFFFFFF) && ((high == 0) ? (low != 0) : (sizeof(SIZE_T) > 4)) &&
+      ((m = CreateFileMappingA(h, NULL, PAGE_READONLY, 0, 0, NULL)) != NULL))
+  {
+    p = (const char *)MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(m);   /* view keeps mapping */
+  }
+  CloseHandle(h);
+  if (p != NULL) *size = ((FSSIZE)high << 32) | low;
+  return p;
+}
+
+
+void fs_unmap(const char *p, FSSIZE size)
+{
+  UnmapViewOfFile((LPCVOID)p);
+}
+
+
+#ifdef __GNUC__
+#define HUNDREDSECINTERVAL 116444772000000000LL
+#else
+#define HUNDREDSECINTERVAL 116444772000000000i64
+#endif
+FSTIME fs_time(time_t tartime)
+{
+#ifdef HAS_LIBC_CAL_FUNCS
+		  FILETIME ftLocal, ftm;
+		  SYSTEMTIME st;
+		  struct tm localt;
+
+		  localt = *localtime(&tartime);
+
+		  st.wYear = (WORD)localt.tm_year+1900;
+		  st.wMonth = (WORD)localt.tm_mon+1;    /* 1 based, not 0 based */
+		  st.wDayOfWeek = (WORD)localt.tm_wday;
+		  st.wDay = (WORD)localt.tm_mday;
+		  st.wHour = (WORD)localt.tm_hour;
+		  st.wMinute = (WORD)localt.tm_min;
+		  st.wSecond = (WORD)localt.tm_sec;
+		  st.wMilliseconds = 0;
+		  SystemTimeToFileTime(&st,&ftLocal);
+		  LocalFileTimeToFileTime(&ftLocal,&ftm);
+		  return *((LONGLONG *)&ftm);
+#else
+    LONGLONG t;
+
+	// tartime == number of seconds since midnight Jan 1 1970 (00:00:00)
+	// convert to equivalent 100 nanosecond intervals
+	t = UInt32x32To64(tartime, 10000000UL);
+
+	// now base on 1601, add number of 100 nansecond intervals between 1601 & 1970
+	t += HUNDREDSECINTERVAL;  /* 116444736000000000i64; */
+	return t;
+#endif
+}
+
+
+int fs_flush(FSCTX *c)
+{
+  int err = fsc_flush(c->fsc);
+  snap_clear(&c->snap);
+  if (err)
+  {
+    SetLastError(err);
+    return 0;
+  }
+  return 1;
+}
+
+
+/* writes are not buffered here, only closes queued (by handle) */
+unsigned long fs_buffers(FSCTX *c, unsigned long maxmem)
+{
+  return 0;
+}
+
+
+int fs_async(FSCTX *c, int enable)
+{
+  int prev = c->async;
+  fs_flush(c);
+  c->async = enable;
+  return prev;
+}
+
+
+int fs_lasterror(FSCTX *c)
+{
+  return (int)GetLastError();  /* per thread, so the last call on c */
+}
@@ -0,0 +1,225 @@
+/*
+ * fssnap - directory snapshots for the fsio backends
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * One open addressed hash table keyed by relative path holds both the
+ * entries and a marker per listed directory (its path with trailing separator,
+ * or "" for the base directory).  Names are kept in a single growing
+ * pool.  Matching ignores (ASCII) case on Windows, as does the file
+ * system.
+ */
+
+#include "fssnap.h"
+
+
+#define SNAP_DIR  8   /* directory marker, listed */
+#define SNAP_FAIL 16  /* directory marker, could not be listed */
+
+struct snapent {
+  unsigned hash;
+  unsigned key;      /* offset of name in pool, 0 if slot empty */
+  unsigned len;
+  int      flags;
+  FSTIME   mtime;
+  FSSIZE   size;
+};
+
+#ifdef _WIN32
+#define FOLD(c) ((((c) >= 'A') && ((c) <= 'Z')) ? ((c) + 'a' - 'A') : (c))
+#else
+#define FOLD(c) (c)
+#endif
+
+/* length of directory part of fname, including trailing separator */
+static unsigned dirlength(const char *fname)
+{
+  const char *p = strrchr(fname, '/');
+#ifdef _WIN32
+  const char *q = strrchr(fname, '\\');
+  if ((p == NULL) || ((q != NULL) && (q > p))) p = q;
+#endif
+  return p ? (unsigned)(p - fname) + 1 : 0;
+}
+
+static unsigned hashkey(const char *key, unsigned len)
+{
+  unsigned h = 2166136261U;   /* FNV-1a */
+  while (len--)
+  {
+    h ^= (unsigned char)FOLD(*key);
+    h *= 16777619U;
+    key++;
+  }
+  return h;
+}
+
+static int keyeq(const char *a, const char *b, unsigned len)
+{
+  while (len--)
+  {
+    if (FOLD(*a) != FOLD(*b)) return 0;
+    a++; b++;
+  }
+  return 1;
+}
+
+/* returns entry for key, or empty slot it would go in */
+static struct snapent *find(struct fssnap *s, const char *key, unsigned len, unsigned h)
+{
+  unsigned i = h & (s->tabsize - 1);
+
+  while (s->tab[i].key != 0)
+  {
+    if ((s->tab[i].hash == h) && (s->tab[i].len == len) && keyeq(s->pool + s->tab[i].key, key, len))
+      break;
+    i = (i + 1) & (s->tabsize - 1);
+  }
+  return &s->tab[i];
+}
+
+/* grows table (kept under 3/4 full), returns 0 if out of memory */
+static int grow(struct fssnap *s)
+{
+  struct snapent *old = s->tab;
+  unsigned oldsize = s->tabsize, i;
+
+  s->tabsize = oldsize ? oldsize * 2 : 1024;
+  if ((s->tab = (struct snapent *)calloc(s->tabsize, sizeof(struct snapent))) == NULL)
+  {
+    s->tab = old;
+    s->tabsize = oldsize;
+    return 0;
+  }
+  for (i = 0; i < oldsize; i++)
+  {
+    if (old[i].key != 0)
+    {
+      unsigned j = old[i].hash & (s->tabsize - 1);
+      while (s->tab[j].key != 0) j = (j + 1) & (s->tabsize - 1);
+      s->tab[j] = old[i];
+    }
+  }
+  if (old != NULL) free(old);
+  return 1;
+}
+
+/* adds (or updates) prefix+name, returns entry or NULL if out of memory */
+static struct snapent *insert(struct fssnap *s, const char *prefix, unsigned plen, const char *name, int flags, FSTIME mtime, FSSIZE size)
+{
+  unsigned nlen = strlen(name), len = plen + nlen, h;
+  struct snapent *e;
+
+  if (s->poolused + len + 1 > s->poolsize)
+  {
+    unsigned newsize = s->poolsize ? s->poolsize : 16384;
+    char *p;
+    while (s->poolused + len + 1 > newsize) newsize *= 2;
+    if ((p = (char *)realloc(s->pool, newsize)) == NULL) return NULL;
+    s->pool = p;
+    s->poolsize = newsize;
+    if (s->poolused == 0) s->poolused = 1;   /* offset 0 means empty slot */
+  }
+  if (((s->count + 1) * 4 > s->tabsize * 3) && !grow(s)) return NULL;
+
+  /* assemble key at end of pool, kept only if new */
+  memcpy(s->pool + s->poolused, prefix, plen);
+  memcpy(s->pool + s->poolused + plen, name, nlen);
+  s->pool[s->poolused + len] = '\0';
+  h = hashkey(s->pool + s->poolused, len);
+  e = find(s, s->pool + s->poolused, len, h);
+  if (e->key == 0)
+  {
+    e->key = s->poolused;
+    e->hash = h;
+    e->len = len;
+    s->poolused += len + 1;
+    s->count++;
+  }
+  e->flags = flags;
+  e->mtime = mtime;
+  e->size = size;
+  return e;
+}
+
+static void snap_scanadd(struct fssnap *s, const char *name, FSTIME mtime, FSSIZE size, int flags)
+{
+  insert(s, s->scanprefix, s->scanlen, name, flags, mtime, size);
+}
+
+
+/* lists directory of fname (first dirlen chars, including trailing separator)
+   unless already done, returns 0 if it could not be listed */
+static int listed(struct fssnap *s, const char *fname, unsigned dirlen)
+{
+  struct snapent *e;
+  char *dir;
+  int ok;
+
+  if (s->tabsize == 0 && !grow(s)) return 0;
+  e = find(s, fname, dirlen, hashkey(fname, dirlen));
+  if (e->key != 0) return (e->flags & SNAP_DIR) != 0;
+
+  /* name of directory itself, without trailing separator */
+  if ((dir = (char *)malloc(dirlen + 1)) == NULL) return 0;
+  memcpy(dir, fname, dirlen);
+  dir[dirlen ? dirlen - 1 : 0] = '\0';
+
+  s->scanprefix = fname;
+  s->scanlen = dirlen;
+  ok = fs_scandir(s->fs, dir, s, snap_scanadd);
+  free(dir);
+
+  e = insert(s, fname, dirlen, "", ok ? SNAP_DIR : SNAP_FAIL, 0, 0);
+  return ok && (e != NULL);
+}
+
+
+int snap_lookup(struct fssnap *s, const char *fname, FSTIME *mtime, FSSIZE *size)
+{
+  unsigned len = strlen(fname);
+  struct snapent *e;
+
+  if (!listed(s, fname, dirlength(fname))) return SNAP_UNKNOWN;
+
+  e = find(s, fname, len, hashkey(fname, len));
+  if ((e->key == 0) || (e->flags == SNAP_ABSENT)) return SNAP_ABSENT;
+  *mtime = e->mtime;
+  *size = e->size;
+  return e->flags;
+}
+
+
+void snap_set(struct fssnap *s, const char *fname)
+{
+  unsigned dirlen = dirlength(fname);
+  struct snapent *e;
+
+  if (s->tabsize == 0) return;
+  e = find(s, fname, dirlen, hashkey(fname, dirlen));
+  if ((e->key != 0) && (e->flags & SNAP_DIR))
+    insert(s, "", 0, fname, SNAP_NOTIME, 0, 0);
+}
+
+
+void snap_remove(struct fssnap *s, const char *fname)
+{
+  unsigned len = strlen(fname);
+  struct snapent *e;
+
+  if (s->tabsize == 0) return;
+  e = find(s, fname, len, hashkey(fname, len));
+  if (e->key != 0) e->flags = SNAP_ABSENT;
+}
+
+
+void snap_clear(struct fssnap *s)
+{
+  if (s->tab != NULL) free(s->tab);
+  if (s->pool != NULL) free(s->pool);
+  s->tab = NULL;
+  s->pool = NULL;
+  s->tabsize = s->count = s->poolsize = s->poolused = 0;
+}
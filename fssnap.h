@@ -0,0 +1,73 @@
+/*
+ * fssnap - directory snapshots for the fsio backends
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * Keep and update modes need to know, for every member, whether the file
+ * exists and its time.  Instead of probing each file, a directory is
+ * listed once, the first time a member lands in it, and the names (with
+ * size and time where the listing gives them) are kept in memory.  Files
+ * the extraction itself creates are added as they are closed.
+ *
+ * A name missing from a snapshot is only a hint, the file is still
+ * created with FS_CREATE_NEW so anything the listing missed (case or
+ * short name differences, outside changes) is caught there.
+ *
+ * Snapshots belong to an output context (FSCTX), each backend embeds a
+ * struct fssnap in its context.
+ */
+
+#ifndef _FSSNAP_H_
+#define _FSSNAP_H_
+
+#include "fsio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* snap_lookup results */
+#define SNAP_UNKNOWN -1   /* directory could not be listed */
+#define SNAP_ABSENT   0
+#define SNAP_EXISTS   1   /* size and mtime valid */
+#define SNAP_NOTIME   2   /* exists, size and mtime not known */
+
+/* snapshots of one output context, all zero (but fs) when empty */
+struct fssnap {
+  FSCTX *fs;                  /* context directories are listed through */
+  struct snapent *tab;
+  unsigned tabsize, count;    /* tabsize is a power of 2 */
+  char *pool;
+  unsigned poolsize, poolused;
+  const char *scanprefix;     /* directory being listed */
+  unsigned scanlen;
+};
+
+/* called by fs_scandir for each entry, flags SNAP_EXISTS or SNAP_NOTIME */
+typedef void (*SNAPADDFUNC)(struct fssnap *s, const char *name, FSTIME mtime, FSSIZE size, int flags);
+
+/* supplied by backend: lists directory dir ("" for base directory) passing
+   each entry to add(s, ...), returns 0 if unable to, a directory that
+   doesn't exist is empty */
+int fs_scandir(FSCTX *c, const char *dir, struct fssnap *s, SNAPADDFUNC add);
+
+/* looks up fname, listing its directory if not yet done */
+int snap_lookup(struct fssnap *s, const char *fname, FSTIME *mtime, FSSIZE *size);
+
+/* records fname as existing (SNAP_NOTIME) if its directory was listed,
+   called as the extraction creates files */
+void snap_set(struct fssnap *s, const char *fname);
+
+/* records fname as no longer existing */
+void snap_remove(struct fssnap *s, const char *fname);
+
+/* forgets all snapshots */
+void snap_clear(struct fssnap *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FSSNAP_H_ */
@@ -0,0 +1,588 @@
+/*
+ * lz4 - LZ4 frame (.lz4) streams
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * The window holds the last 64KB of output when blocks are linked (match
+ * from the block before) followed by room for blocks; once a block may
+ * not fit it is moved back to its start.  Each block's header is read
+ * with the block before, so a block and its checksum take one gzread.
+ */
+
+#include "../zlib/zlib.h"
+#include "lz4.h"
+#include "../miniclib.h"
+#include "../decpool.h"
+
+
+/* !!!USER SUPPLIED!!! */
+/* wrap around whatever you want to send error messages to user, c function */
+void PrintMessage(const char *msg, ...);
+
+
+typedef unsigned int UInt32;
+
+#define LZ4_MAGIC      0x184D2204UL
+#define LZ4_SKIPMAGIC  0x184D2A50UL    /* skippable frame, low 4 bits any */
+#define LZ4_HISTORY    (1UL << 16)     /* farthest a match reaches back */
+#define LZ4_ROOMMIN    (1UL << 20)     /* window room for linked blocks at least */
+#define LZ4_SLACK      32              /* writable bytes needed past the output */
+#define LZ4_INPAD      8               /* readable bytes needed past a block */
+
+#ifdef __GNUC__
+#define COPY8(d, s) __builtin_memcpy((d), (s), 8)
+#else
+#define COPY8(d, s) (((UInt32 *)(d))[0] = ((const UInt32 *)(s))[0], \
+                     ((UInt32 *)(d))[1] = ((const UInt32 *)(s))[1])
+#endif
+
+/* errors, lz4_read reports them */
+#define LZ_OK          0
+#define LZ_DATA        1
+#define LZ_EOF         2
+#define LZ_CHECK       3
+#define LZ_UNSUPPORTED 4
+#define LZ_NOMEM       5
+#define LZ_REPORTED    6
+static const char *const errors[] = {
+  NULL,
+  "lz4_read: Decoding error",
+  "lz4_read: Unexpected end of input",
+  "lz4_read: Checksum mismatch, data is corrupt",
+  "lz4_read: Unsupported frame (dictionary or version)",
+  "lz4_read: Out of memory",
+  NULL
+};
+
+
+/* XXH32, of frame descriptors, blocks and content */
+typedef struct xxh32
+{
+  UInt32 v[4];
+  UInt32 total;
+  int large;                  /* 16 bytes or more added */
+  unsigned char mem[16];      /* start of a stripe not yet added */
+  unsigned memSize;
+} xxh32;
+
+typedef struct LZ4File
+{
+  gzFile File;
+  unsigned long maxmem;
+  int ended;                  /* end of input reached between frames */
+
+  /* frame */
+  int linked;                 /* blocks match from the block before */
+  int blockCheck, contentCheck;
+  int haveSize;
+  UInt32 sizeLo, sizeHi;      /* content size, if haveSize */
+  UInt32 producedLo, producedHi;
+  UInt32 blockMax;
+  UInt32 next;                /* header of next block, 0 ends the frame */
+  xxh32 xxh;                  /* of content, if contentCheck */
+
+  unsigned char *in;          /* a block, its checksum and the next header */
+  UInt32 inSize;
+  unsigned char *win;         /* history and room for blocks */
+  UInt32 winSize, winPos;     /* output is up to winPos, */
+  UInt32 outPos;              /* handed out up to here */
+} LZ4File;
+
+
+static UInt32 get32(const unsigned char *p)
+{
+  return (UInt32)p[0] | ((UInt32)p[1] << 8) | ((UInt32)p[2] << 16) | ((UInt32)p[3] << 24);
+}
+
+
+/*
+XXH32
+-----
+Four accumulators take 16 byte stripes, 4 bytes each, then are merged
+and the rest added.
+*/
+
+#define P1 ((UInt32)0x9E3779B1U)
+#define P2 ((UInt32)0x85EBCA77U)
+#define P3 ((UInt32)0xC2B2AE3DU)
+#define P4 ((UInt32)0x27D4EB2FU)
+#define P5 ((UInt32)0x165667B1U)
+#define ROTL32(x, r) (((x) << (r)) | ((x) >> (32 - (r))))
+
+static UInt32 xxhRound(UInt32 acc, UInt32 in)
+{
+  acc += in * P2;
+  acc = ROTL32(acc, 13);
+  return acc * P1;
+}
+
+static void xxhInit(xxh32 *x)
+{
+  x->v[0] = P1 + P2;
+  x->v[1] = P2;
+  x->v[2] = 0;
+  x->v[3] = 0 - P1;
+  x->total = 0;
+  x->large = 0;
+  x->memSize = 0;
+}
+
+/* adds n / 16 stripes at p */
+static void xxhStripes(xxh32 *x, const unsigned char *p, UInt32 n)
+{
+  UInt32 v0 = x->v[0], v1 = x->v[1], v2 = x->v[2], v3 = x->v[3];
+
+  for (; n >= 16; n -= 16, p += 16)
+  {
+    v0 = xxhRound(v0, get32(p));
+    v1 = xxhRound(v1, get32(p + 4));
+    v2 = xxhRound(v2, get32(p + 8));
+    v3 = xxhRound(v3, get32(p + 12));
+  }
+  x->v[0] = v0;
+  x->v[1] = v1;
+  x->v[2] = v2;
+  x->v[3] = v3;
+}
+
+static void xxhUpdate(xxh32 *x, const unsigned char *p, UInt32 n)
+{
+  x->total += n;
+  x->large |= (n >= 16) || (x->total >= 16);
+  if (x->memSize != 0)
+  {
+    UInt32 k = 16 - x->memSize;
+    if (k > n)
+      k = n;
+    memcpy(x->mem + x->memSize, p, k);
+    x->memSize += k;
+    p += k;
+    n -= k;
+    if (x->memSize < 16)
+      return;
+    xxhStripes(x, x->mem, 16);
+    x->memSize = 0;
+  }
+  xxhStripes(x, p, n & ~(UInt32)15);
+  p += n & ~(UInt32)15;
+  n &= 15;
+  memcpy(x->mem, p, n);
+  x->memSize = n;
+}
+
+static UInt32 xxhDigest(const xxh32 *x)
+{
+  const unsigned char *p = x->mem;
+  unsigned n = x->memSize;
+  UInt32 h;
+
+  if (x->large)
+    h = ROTL32(x->v[0], 1) + ROTL32(x->v[1], 7) + ROTL32(x->v[2], 12) + ROTL32(x->v[3], 18);
+  else
+    h = P5;
+  h += x->total;
+  for (; n >= 4; n -= 4, p += 4)
+  {
+    h += get32(p) * P3;
+    h = ROTL32(h, 17) * P4;
+  }
+  for (; n > 0; n--)
+  {
+    h += *p++ * P5;
+    h = ROTL32(h, 11) * P1;
+  }
+  h ^= h >> 15;
+  h *= P2;
+  h ^= h >> 13;
+  h *= P3;
+  h ^= h >> 16;
+  return h;
+}
+
+static UInt32 xxh(const unsigned char *p, UInt32 n)
+{
+  xxh32 x;
+  xxhInit(&x);
+  xxhUpdate(&x, p, n);
+  return xxhDigest(&x);
+}
+
+
+/*
+LZ4 blocks
+----------
+Sequences of a token (literal count in the high 4 bits, match length - 4
+in the low), more literal count bytes while 255 if it was 15, the
+literals, a 2 byte offset back from the end of output and more match
+length bytes likewise; the last sequence stops after its literals.
+*/
+
+/* copies n bytes 8 at a time, reading and writing up to 7 more */
+static void wildcopy(unsigned char *dst, const unsigned char *src, UInt32 n)
+{
+  unsigned char *end = dst + n;
+  do
+  {
+    COPY8(dst, src);
+    dst += 8;
+    src += 8;
+  } while (dst < end);
+}
+
+/* decodes the block in[0..size) (LZ4_INPAD bytes readable after) to out,
+   making at most outMax bytes (LZ4_SLACK more writable), matches
+   reaching up to history bytes before out; returns the number made or
+   -1 if the block is corrupt */
+static long decodeBlock(const unsigned char *in, UInt32 size,
+                        unsigned char *out, UInt32 outMax, UInt32 history)
+{
+  const unsigned char *ip = in, *iend = in + size, *match;
+  unsigned char *op = out, *oend = out + outMax;
+
+  for (;;)
+  {
+    unsigned token, s;
+    UInt32 len, offset;
+
+    if (ip >= iend)
+      return -1;
+    token = *ip++;
+
+    /* literals */
+    if ((len = token >> 4) == 15)
+      do
+      {
+        if (ip >= iend)
+          return -1;
+        len += (s = *ip++);
+      } while (s == 255);
+    if ((len > (UInt32)(iend - ip)) || (len > (UInt32)(oend - op)))
+      return -1;
+    if (len != 0)
+    {
+      wildcopy(op, ip, len);
+      op += len;
+      ip += len;
+    }
+    if (ip == iend)
+      break;
+
+    /* match */
+    if (iend - ip < 2)
+      return -1;
+    offset = ip[0] | ((UInt32)ip[1] << 8);
+    ip += 2;
+    if ((len = token & 15) == 15)
+      do
+      {
+        if (ip >= iend)
+          return -1;
+        len += (s = *ip++);
+      } while (s == 255);
+    len += 4;
+    if ((len > (UInt32)(oend - op)) || (offset == 0) || (offset > (UInt32)(op - out) + history))
+      return -1;
+    match = op - offset;
+    if (offset >= 8)
+      wildcopy(op, match, len);
+    else if (offset == 1)
+      memset(op, *match, len);
+    else
+    {
+      UInt32 k;
+      for (k = 0; k < len; k++)
+        op[k] = match[k];
+    }
+    op += len;
+  }
+  return (long)(op - out);
+}
+
+
+/* reads n bytes of input to p, returns the number read, less only at the end */
+static UInt32 readFull(LZ4File *f, unsigned char *p, UInt32 n)
+{
+  UInt32 done = 0;
+
+  while (done < n)
+  {
+    int len = gzread(f->File, p + done, n - done);
+    if (len <= 0)
+      break;
+    done += len;
+  }
+  return done;
+}
+
+/* passes over n bytes of input, seeking if the file allows, returns
+   LZ_OK or LZ_EOF */
+static int skipInput(LZ4File *f, UInt32 n)
+{
+  unsigned char buf[512];
+
+  if (gzseek(f->File, (long)n, SEEK_CUR) >= 0)
+    return LZ_OK;
+  while (n > 0)
+  {
+    UInt32 k = (n < sizeof(buf)) ? n : (UInt32)sizeof(buf);
+    if (readFull(f, buf, k) != k)
+      return LZ_EOF;
+    n -= k;
+  }
+  return LZ_OK;
+}
+
+/* reads the next frame's header and first block header, passing over
+   skippable frames, or sets ended at the end of input; returns LZ_* */
+static int startFrame(LZ4File *f)
+{
+  unsigned char h[4 + 2 + 8 + 4 + 1 + 4];
+  UInt32 n, m, desc, inSize, winSize;
+  unsigned flg, bd;
+
+  for (;;)
+  {
+    if ((n = readFull(f, h, 4)) == 0)
+    {
+      f->ended = 1;
+      return LZ_OK;
+    }
+    if (n < 4)
+      return LZ_EOF;
+    m = get32(h);
+    if (m == LZ4_MAGIC)
+      break;
+    if ((m & 0xFFFFFFF0UL) != LZ4_SKIPMAGIC)
+      return LZ_DATA;
+    if (readFull(f, h, 4) != 4)
+      return LZ_EOF;
+    if (skipInput(f, get32(h)) != LZ_OK)
+      return LZ_EOF;
+  }
+
+  /* descriptor: flags, block size, content size, dictionary id, checksum */
+  if (readFull(f, h + 4, 2) != 2)
+    return LZ_EOF;
+  flg = h[4];
+  bd = h[5];
+  if ((flg >> 6) != 1)
+    return LZ_UNSUPPORTED;
+  if ((flg & 2) || (bd & 0x8F) || (((bd >> 4) & 7) < 4))
+    return LZ_DATA;
+  desc = 2 + ((flg & 8) ? 8 : 0) + ((flg & 1) ? 4 : 0);
+  if (readFull(f, h + 6, desc - 2 + 1 + 4) != desc - 2 + 1 + 4)
+    return LZ_EOF;
+  if (h[4 + desc] != ((xxh(h + 4, desc) >> 8) & 0xFF))
+    return LZ_CHECK;
+  if (flg & 1)
+    return LZ_UNSUPPORTED;    /* needs a dictionary */
+
+  f->linked = !(flg & 0x20);
+  f->blockCheck = (flg >> 4) & 1;
+  f->contentCheck = (flg >> 2) & 1;
+  f->haveSize = (flg >> 3) & 1;
+  if (f->haveSize)
+  {
+    f->sizeLo = get32(h + 6);
+    f->sizeHi = get32(h + 10);
+  }
+  f->producedLo = f->producedHi = 0;
+  f->blockMax = (UInt32)1 << (8 + 2 * ((bd >> 4) & 7));
+  f->next = get32(h + 4 + desc + 1);
+  if (f->contentCheck)
+    xxhInit(&f->xxh);
+
+  /* buffers, kept while large enough */
+  inSize = f->blockMax + 4 + 4 + LZ4_INPAD;
+  winSize = f->blockMax + LZ4_SLACK;
+  if (f->linked)
+    winSize += LZ4_HISTORY + ((f->blockMax < LZ4_ROOMMIN) ? 3 * f->blockMax : 0);
+  if ((f->maxmem != 0) && (inSize + winSize + sizeof(LZ4File) > f->maxmem))
+  {
+    PrintMessage("Error: lz4 block size of %lu KB needs %lu KB, over the %lu KB memory budget for decoding",
+                 (unsigned long)(f->blockMax >> 10),
+                 (unsigned long)((inSize + winSize + sizeof(LZ4File)) >> 10), f->maxmem >> 10);
+    return LZ_REPORTED;
+  }
+  if (f->inSize < inSize)
+  {
+    dpool_free(f->in);
+    f->inSize = 0;
+    if ((f->in = (unsigned char *)dpool_alloc(inSize)) == NULL)
+      return LZ_NOMEM;
+    f->inSize = inSize;
+  }
+  if (f->winSize < winSize)
+  {
+    dpool_free(f->win);
+    f->winSize = 0;
+    if ((f->win = (unsigned char *)dpool_alloc(winSize)) == NULL)
+      return LZ_NOMEM;
+    f->winSize = winSize;
+  }
+  f->winPos = f->outPos = 0;
+  return LZ_OK;
+}
+
+/* decodes the next block into the window, or ends the frame (checking
+   it) and starts the next; all output has been taken; returns LZ_* */
+static int advance(LZ4File *f)
+{
+  UInt32 size, extra, history;
+  unsigned char *out;
+  int raw;
+
+  if (f->next == 0)
+  {
+    /* end of frame */
+    if (f->contentCheck)
+    {
+      unsigned char c[4];
+      if (readFull(f, c, 4) != 4)
+        return LZ_EOF;
+      if (get32(c) != xxhDigest(&f->xxh))
+        return LZ_CHECK;
+    }
+    if (f->haveSize && ((f->sizeLo != f->producedLo) || (f->sizeHi != f->producedHi)))
+      return LZ_DATA;
+    return startFrame(f);
+  }
+
+  size = f->next & 0x7FFFFFFFUL;
+  raw = (f->next >> 31) != 0;
+  if (size > f->blockMax)
+    return LZ_DATA;
+
+  /* room for a block, keeping the last 64KB if linked */
+  if (f->winPos + f->blockMax + LZ4_SLACK > f->winSize)
+  {
+    UInt32 keep = (!f->linked) ? 0 : (f->winPos < LZ4_HISTORY) ? f->winPos : LZ4_HISTORY;
+    memmove(f->win, f->win + f->winPos - keep, keep);
+    f->winPos = f->outPos = keep;
+  }
+  out = f->win + f->winPos;
+  history = f->linked ? f->winPos : 0;
+
+  /* the block, its checksum and the next header in one read */
+  extra = (f->blockCheck ? 4 : 0) + 4;
+  if (raw)
+  {
+    if ((readFull(f, out, size) != size) || (readFull(f, f->in, extra) != extra))
+      return LZ_EOF;
+    if (f->blockCheck && (xxh(out, size) != get32(f->in)))
+      return LZ_CHECK;
+    f->next = get32(f->in + extra - 4);
+  }
+  else
+  {
+    long len;
+
+    if (readFull(f, f->in, size + extra) != size + extra)
+      return LZ_EOF;
+    if (f->blockCheck && (xxh(f->in, size) != get32(f->in + size)))
+      return LZ_CHECK;
+    f->next = get32(f->in + size + extra - 4);
+    memset(f->in + size, 0, LZ4_INPAD);
+    if ((len = decodeBlock(f->in, size, out, f->blockMax, history)) < 0)
+      return LZ_DATA;
+    size = (UInt32)len;
+  }
+
+  if (f->contentCheck)
+    xxhUpdate(&f->xxh, out, size);
+  f->winPos += size;
+  if ((f->producedLo += size) < size)
+    f->producedHi++;
+  return LZ_OK;
+}
+
+
+static void report(int result)
+{
+  if (errors[result] != NULL)
+    PrintMessage(errors[result]);
+}
+
+int lz4_init(gzFile infile, struct LZ4File **lz4File, unsigned long maxmem)
+{
+  LZ4File *f;
+  int result;
+
+  *lz4File = f = (LZ4File *)dpool_alloc(sizeof(struct LZ4File));
+  if (f == NULL) return -1;
+
+  memset(f, 0, sizeof(LZ4File));
+  f->File = infile;
+  f->maxmem = maxmem;
+
+  if ((result = startFrame(f)) != LZ_OK)
+  {
+    report(result);
+    return -1;
+  }
+  if (f->ended)
+  {
+    PrintMessage("lz4: Can not read input file.");
+    return -1;
+  }
+  return 0;
+}
+
+
+void lz4_cleanup(struct LZ4File *lz4File)
+{
+  if (lz4File != NULL)
+  {
+    dpool_free(lz4File->in);
+    dpool_free(lz4File->win);
+    dpool_free(lz4File);
+  }
+}
+
+
+long lz4_readptr(struct LZ4File *lz4File,
+                 const unsigned char **buffer,
+                 unsigned len)
+{
+  UInt32 n;
+  int result;
+
+  while ((n = lz4File->winPos - lz4File->outPos) == 0)
+  {
+    if (lz4File->ended)
+      return 0;
+    if ((result = advance(lz4File)) != LZ_OK)
+    {
+      report(result);
+      return -1;
+    }
+  }
+  if (n > len)
+    n = len;
+  *buffer = lz4File->win + lz4File->outPos;
+  lz4File->outPos += n;
+  return (long)n;
+}
+
+
+long lz4_read(struct LZ4File *lz4File,
+              unsigned char *buffer,
+              unsigned len)
+{
+  unsigned done = 0;
+
+  while (done < len)
+  {
+    const unsigned char *p;
+    long n = lz4_readptr(lz4File, &p, len - done);
+    if (n < 0)
+      return -1;
+    if (n == 0)
+      break;
+    memcpy(buffer + done, p, n);
+    done += n;
+  }
+  return (long)done;
+}
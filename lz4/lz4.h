@@ -0,0 +1,43 @@
+/*
+ * lz4 - LZ4 frame (.lz4) streams
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * LZ4 trades size for decoding speed, for installers where time to
+ * installed matters more than download size.  Each block is read with
+ * one gzread (straight into the window when stored uncompressed) and
+ * decoded into a window buffer that lz4_readptr hands out from, so tar
+ * blocks are used where they were decoded, as with lzma.c.  Block and
+ * content checksums are verified, concatenated and skippable frames
+ * handled; dictionaries and the legacy format (lz4 -l) are not
+ * supported.
+ */
+
+#ifndef _LZ4_H_
+#define _LZ4_H_
+
+/* prototypes for our read function */
+typedef void * gzFile;
+int gzread(gzFile file, void * buf, unsigned len);
+
+/* holds any information needed about stream */
+struct LZ4File;
+typedef struct LZ4File LZ4File;
+
+/* routines implemented */
+/* maxmem (0 for no limit) refuses frames whose block size needs more
+   than maxmem bytes of buffers */
+int lz4_init(gzFile infile, struct LZ4File **lz4File, unsigned long maxmem);
+void lz4_cleanup(struct LZ4File *lz4File);
+long lz4_read(struct LZ4File *lz4File,
+              unsigned char *buffer,
+              unsigned len);
+/* as lz4_read, but returns a pointer to up to len bytes decoded in the
+   window (valid until the next read) rather than copying them */
+long lz4_readptr(struct LZ4File *lz4File,
+                 const unsigned char **buffer,
+                 unsigned len);
+
+#endif /* _LZ4_H_ */
@@ -1,158 +1,260 @@
-#include "lzma.h"
-#include "../miniclib.h"
-
-
-/* !!!USER SUPPLIED!!! */
-/* wrap around whatever you want to send error messages to user, c function */
-void PrintMessage(const char *msg, ...);
-
-
-/* holds any information needed about stream */
-
-#define kInBufferSize (1 << 15)  /* 32KB */
-typedef struct LZMAFile
-{
-  ILzmaInCallback InCallback;
-  gzFile File;
-  unsigned char Buffer[kInBufferSize];
-
-  CLzmaDecoderState state;  /* it's about 24-80 bytes structure, if int is 32-bit */
-  unsigned char properties[LZMA_PROPERTIES_SIZE];
-
-  UInt32 outSize;     /* init to 0 */
-  UInt32 outSizeHigh; /* init to 0 */
-  int waitEOS;        /* init to 1 */
-  /* waitEOS = 1, if there is no uncompressed size in headers, 
-   so decoder will wait EOS (End of Stream Marker) in compressed stream */
-} LZMAFile;
-
-int LzmaReadCompressed(void *object, const unsigned char **buffer, SizeT *size)
-{
-  LZMAFile *b = (LZMAFile *)object;
-  *buffer = b->Buffer;
-  *size = (SizeT)gzread(b->File, b->Buffer, kInBufferSize);
-  return LZMA_RESULT_OK;
-}
-
-/* returns nonzero if error reading */
-int MyReadFileAndCheck(gzFile file, void *data, long size)
-{ 
-  register long len = gzread(file, data, size);
-  if (len != size)
-  {
-    PrintMessage("lzma: Can not read input file.");
-    return 0;
-  }
-  return 1;
-} 
-
-
-/* routines implemented */
-
-/*
-LZMA compressed file format
----------------------------
-Offset Size Description
-  0     1   Special LZMA properties for compressed data
-  1     4   Dictionary size (little endian)
-  5     8   Uncompressed size (little endian). -1 means unknown size
- 13         Compressed data
-*/
-
-int lzma_init(gzFile infile, struct LZMAFile **lzmaFile)
-{
-  LZMAFile *inBuffer;
-  *lzmaFile = inBuffer = (LZMAFile *)malloc(sizeof(struct LZMAFile));
-  if (inBuffer == NULL) return -1;
-
-  memset(inBuffer, 0, sizeof(LZMAFile));
-  inBuffer->File = infile;
-  inBuffer->InCallback.Read = LzmaReadCompressed;
-  inBuffer->waitEOS = 1;
-
-
-  /* Read LZMA properties for compressed stream */
-  if (!MyReadFileAndCheck(infile, inBuffer->properties, LZMA_PROPERTIES_SIZE))
-    return -1;
-
-  /* Read uncompressed size */
-  {
-    int i;
-    for (i = 0; i < 8; i++)
-    {
-      unsigned char b;
-      if (!MyReadFileAndCheck(infile, &b, 1))
-        return -1;
-      if (b != 0xFF)
-        inBuffer->waitEOS = 0;
-      if (i < 4)
-        inBuffer->outSize += (UInt32)(b) << (i * 8);
-      else
-        inBuffer->outSizeHigh += (UInt32)(b) << ((i - 4) * 8);
-    }
-  }
-
-  /* Decode LZMA properties and allocate memory */
-  if (LzmaDecodeProperties(&(inBuffer->state.Properties), inBuffer->properties, LZMA_PROPERTIES_SIZE) != LZMA_RESULT_OK)
-  {
-    PrintMessage("Incorrect stream properties");
-    return -1;
-  }
-  inBuffer->state.Probs = (CProb *)malloc(LzmaGetNumProbs(&(inBuffer->state.Properties)) * sizeof(CProb));
-  if (inBuffer->state.Probs == NULL) return -1;
-  inBuffer->state.Dictionary = (unsigned char *)malloc(inBuffer->state.Properties.DictionarySize);
-  if (inBuffer->state.Dictionary == NULL) return -1;
-
-  LzmaDecoderInit(&(inBuffer->state));
-
-  return 0;
-}
-
-
-void lzma_cleanup(struct LZMAFile *lzmaFile)
-{
-  if (lzmaFile != NULL)
-  {  
-    if (lzmaFile->state.Probs != NULL) free(lzmaFile->state.Probs);
-    if (lzmaFile->state.Dictionary != NULL) free(lzmaFile->state.Dictionary);
-    free(lzmaFile);
-  }
-}
-
-
-long lzma_read(struct LZMAFile *lzmaFile,
-               unsigned char *buffer,
-               unsigned len)
-{
-  SizeT outProcessed;
-  SizeT outAvail = len;
-  int res;
-
-  if (!lzmaFile->waitEOS && lzmaFile->outSizeHigh == 0 && outAvail > lzmaFile->outSize)
-        outAvail = (SizeT)(lzmaFile->outSize);
-
-  res = LzmaDecode(&(lzmaFile->state),
-        &(lzmaFile->InCallback),
-        buffer, outAvail, &outProcessed);
-  if (res != 0)
-  {
-    PrintMessage("lzma_read: Decoding error (%d)", res);
-    return -1;
-  }
-      
-  if (lzmaFile->outSize < outProcessed)
-    lzmaFile->outSizeHigh--;
-  lzmaFile->outSize -= (UInt32)outProcessed;
-  lzmaFile->outSize &= 0xFFFFFFFF;
-        
-  if (outProcessed == 0)
-  {
-    if (!lzmaFile->waitEOS && (lzmaFile->outSize != 0 || lzmaFile->outSizeHigh != 0))
-    {
-      PrintMessage("lzma_read: Unexpected EOS");
-      return -1;
-    }
-  }
-
-  return outProcessed;
-}
+#include "lzma.h"
+#include "lzmadec.h"
+#include "../miniclib.h"
+#include "../decpool.h"
+
+
+/* !!!USER SUPPLIED!!! */
+/* wrap around whatever you want to send error messages to user, c function */
+void PrintMessage(const char *msg, ...);
+
+
+/* holds any information needed about stream */
+
+#define kInBufferSize (1 << 15)  /* 32KB */
+#define kOutChunk (1 << 16)      /* most decoded at a time, 64KB */
+typedef struct LZMAFile
+{
+  gzFile File;
+  unsigned char Buffer[kInBufferSize + LZMADEC_INMAX];
+  unsigned inPos, inEnd;  /* input not yet decoded */
+  int inEOF;              /* no more to read, LZMADEC_INMAX zeros follow inEnd */
+
+  lzmadec dec;
+  UInt32 outPos;          /* output is dec.dic from here to dec.dicPos */
+  unsigned char properties[LZMA_PROPERTIES_SIZE];
+
+  UInt32 outSize;     /* init to 0 */
+  UInt32 outSizeHigh; /* init to 0 */
+  int waitEOS;        /* init to 1 */
+  /* waitEOS = 1, if there is no uncompressed size in headers, 
+   so decoder will wait EOS (End of Stream Marker) in compressed stream */
+} LZMAFile;
+
+/* moves input not yet decoded to the start of Buffer and fills the rest */
+static void fillBuffer(LZMAFile *b)
+{
+  unsigned n = b->inEnd - b->inPos;
+  memmove(b->Buffer, b->Buffer + b->inPos, n);
+  while (!b->inEOF && (n < kInBufferSize))
+  {
+    int len = gzread(b->File, b->Buffer + n, kInBufferSize - n);
+    if (len <= 0)
+      b->inEOF = 1;
+    else
+      n += len;
+  }
+  b->inPos = 0;
+  b->inEnd = n;
+  if (b->inEOF)
+    memset(b->Buffer + n, 0, LZMADEC_INMAX);
+}
+
+/* returns nonzero if error reading */
+int MyReadFileAndCheck(gzFile file, void *data, long size)
+{ 
+  register long len = gzread(file, data, size);
+  if (len != size)
+  {
+    PrintMessage("lzma: Can not read input file.");
+    return 0;
+  }
+  return 1;
+} 
+
+
+/* routines implemented */
+
+/*
+LZMA compressed file format
+---------------------------
+Offset Size Description
+  0     1   Special LZMA properties for compressed data
+  1     4   Dictionary size (little endian)
+  5     8   Uncompressed size (little endian). -1 means unknown size
+ 13         Compressed data
+*/
+
+int lzma_init(gzFile infile, struct LZMAFile **lzmaFile, unsigned long maxmem)
+{
+  LZMAFile *inBuffer;
+  unsigned long probsize;
+  UInt32 dicSize;
+  *lzmaFile = inBuffer = (LZMAFile *)dpool_alloc(sizeof(struct LZMAFile));
+  if (inBuffer == NULL) return -1;
+
+  memset(inBuffer, 0, sizeof(LZMAFile));
+  inBuffer->File = infile;
+  inBuffer->waitEOS = 1;
+
+
+  /* Read LZMA properties for compressed stream */
+  if (!MyReadFileAndCheck(infile, inBuffer->properties, LZMA_PROPERTIES_SIZE))
+    return -1;
+
+  /* Read uncompressed size */
+  {
+    int i;
+    for (i = 0; i < 8; i++)
+    {
+      unsigned char b;
+      if (!MyReadFileAndCheck(infile, &b, 1))
+        return -1;
+      if (b != 0xFF)
+        inBuffer->waitEOS = 0;
+      if (i < 4)
+        inBuffer->outSize += (UInt32)(b) << (i * 8);
+      else
+        inBuffer->outSizeHigh += (UInt32)(b) << ((i - 4) * 8);
+    }
+  }
+
+  /* Decode LZMA properties and allocate memory */
+  if (LzmaDecodeProperties(&(inBuffer->dec.prop), inBuffer->properties, LZMA_PROPERTIES_SIZE) != LZMA_RESULT_OK)
+  {
+    PrintMessage("Incorrect stream properties");
+    return -1;
+  }
+  /* the dictionary ring is a multiple of 512 bytes, so reads of whole tar
+     blocks are never split by its end */
+  dicSize = (inBuffer->dec.prop.DictionarySize + 511) & ~(UInt32)511;
+  if (dicSize < (1 << 12))
+    dicSize = 1 << 12;
+  probsize = LzmaGetNumProbs(&(inBuffer->dec.prop)) * sizeof(CProb);
+  if ((maxmem != 0) &&
+      ((dicSize > maxmem) ||
+       (probsize + sizeof(LZMAFile) > maxmem - dicSize)))
+  {
+    PrintMessage("Error: lzma dictionary of %lu KB is over the %lu KB memory budget for decoding",
+                 (unsigned long)(dicSize >> 10), maxmem >> 10);
+    return -1;
+  }
+  inBuffer->dec.probs = (CProb *)dpool_alloc(probsize);
+  if (inBuffer->dec.probs == NULL) return -1;
+  inBuffer->dec.dic = (unsigned char *)dpool_alloc(dicSize);
+  if (inBuffer->dec.dic == NULL) return -1;
+  inBuffer->dec.dicSize = dicSize;
+
+  lzmadec_init(&(inBuffer->dec));
+
+  return 0;
+}
+
+
+void lzma_cleanup(struct LZMAFile *lzmaFile)
+{
+  if (lzmaFile != NULL)
+  {  
+    dpool_free(lzmaFile->dec.probs);
+    dpool_free(lzmaFile->dec.dic);
+    dpool_free(lzmaFile);
+  }
+}
+
+
+/* decodes up to limit more bytes into the dictionary, returns 0 or -1 on error */
+static int decode(LZMAFile *lzmaFile, UInt32 limit)
+{
+  lzmadec *dec = &(lzmaFile->dec);
+  UInt32 dicLimit = dec->dicPos + limit;
+  int status = dec->status;
+
+  while ((dec->dicPos < dicLimit) && ((status == LZMADEC_INIT) || (status == LZMADEC_OK)))
+  {
+    const unsigned char *in, *inLimit;
+
+    if (!lzmaFile->inEOF && (lzmaFile->inEnd - lzmaFile->inPos <= LZMADEC_INMAX))
+      fillBuffer(lzmaFile);
+    /* at the end of input a symbol may start on its last byte */
+    in = lzmaFile->Buffer + lzmaFile->inPos;
+    inLimit = lzmaFile->Buffer + lzmaFile->inEnd + (lzmaFile->inEOF ? 1 : -LZMADEC_INMAX);
+    status = lzmadec_decode(dec, dicLimit, &in, inLimit);
+    lzmaFile->inPos = (unsigned)(in - lzmaFile->Buffer);
+
+    if (lzmaFile->inPos > lzmaFile->inEnd)
+    {
+      PrintMessage("lzma_read: Unexpected end of input");
+      return -1;
+    }
+    if (status == LZMADEC_ERROR)
+    {
+      PrintMessage("lzma_read: Decoding error (%d)", LZMA_RESULT_DATA_ERROR);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+
+long lzma_readptr(struct LZMAFile *lzmaFile,
+                  const unsigned char **buffer,
+                  unsigned len)
+{
+  lzmadec *dec = &(lzmaFile->dec);
+  UInt32 outProcessed;
+
+  if (lzmaFile->outPos == dec->dicPos)
+  {
+    /* all read, decode more (up to the ring's end) */
+    UInt32 outAvail;
+
+    if (dec->dicPos == dec->dicSize)
+    {
+      lzmaFile->outPos = dec->dicPos = 0;
+      dec->checkDicSize = dec->dicSize;
+    }
+    outAvail = dec->dicSize - dec->dicPos;
+    if (outAvail > kOutChunk)
+      outAvail = kOutChunk;
+    if (!lzmaFile->waitEOS && lzmaFile->outSizeHigh == 0 && outAvail > lzmaFile->outSize)
+      outAvail = lzmaFile->outSize;
+    if (dec->status == LZMADEC_END)
+      outAvail = 0;
+
+    if ((outAvail != 0) && (decode(lzmaFile, outAvail) != 0))
+      return -1;
+
+    outProcessed = dec->dicPos - lzmaFile->outPos;
+    if (lzmaFile->outSize < outProcessed)
+      lzmaFile->outSizeHigh--;
+    lzmaFile->outSize -= outProcessed;
+    lzmaFile->outSize &= 0xFFFFFFFF;
+
+    if (outProcessed == 0)
+    {
+      if (!lzmaFile->waitEOS && (lzmaFile->outSize != 0 || lzmaFile->outSizeHigh != 0))
+      {
+        PrintMessage("lzma_read: Unexpected EOS");
+        return -1;
+      }
+    }
+  }
+
+  outProcessed = dec->dicPos - lzmaFile->outPos;
+  if (outProcessed > len)
+    outProcessed = len;
+  *buffer = dec->dic + lzmaFile->outPos;
+  lzmaFile->outPos += outProcessed;
+  return (long)outProcessed;
+}
+
+
+long lzma_read(struct LZMAFile *lzmaFile,
+               unsigned char *buffer,
+               unsigned len)
+{
+  unsigned done = 0;
+
+  while (done < len)
+  {
+    const unsigned char *p;
+    long n = lzma_readptr(lzmaFile, &p, len - done);
+    if (n < 0)
+      return -1;
+    if (n == 0)
+      break;
+    memcpy(buffer + done, p, n);
+    done += n;
+  }
+  return (long)done;
+}
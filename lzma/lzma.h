@@ -1,21 +1,28 @@
-#ifndef _LZMA_H_
-#define _LZMA_H_
-
-#include "LzmaDecode.h"
-
-/* prototypes for our read function */
-typedef void * gzFile;
-int gzread(gzFile file, void * buf, unsigned len);
-
-/* holds any information needed about stream */
-struct LZMAFile;
-typedef struct LZMAFile LZMAFile;
-
-/* routines implemented */
-int lzma_init(gzFile infile, struct LZMAFile **lzmaFile);
-void lzma_cleanup(struct LZMAFile *lzmaFile);
-long lzma_read(struct LZMAFile *lzmaFile,
-               unsigned char *buffer,
-               unsigned len);
-
-#endif /* _LZMA_H_ */
+#ifndef _LZMA_H_
+#define _LZMA_H_
+
+#include "LzmaDecode.h"
+
+/* prototypes for our read function */
+typedef void * gzFile;
+int gzread(gzFile file, void * buf, unsigned len);
+
+/* holds any information needed about stream */
+struct LZMAFile;
+typedef struct LZMAFile LZMAFile;
+
+/* routines implemented */
+/* maxmem (0 for no limit) refuses streams whose dictionary and
+   probabilities need more than maxmem bytes */
+int lzma_init(gzFile infile, struct LZMAFile **lzmaFile, unsigned long maxmem);
+void lzma_cleanup(struct LZMAFile *lzmaFile);
+long lzma_read(struct LZMAFile *lzmaFile,
+               unsigned char *buffer,
+               unsigned len);
+/* as lzma_read, but returns a pointer to up to len bytes decoded in the
+   dictionary (valid until the next read) rather than copying them */
+long lzma_readptr(struct LZMAFile *lzmaFile,
+                  const unsigned char **buffer,
+                  unsigned len);
+
+#endif /* _LZMA_H_ */
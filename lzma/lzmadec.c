@@ -0,0 +1,411 @@
+/*
+ * lzmadec - LZMA decoder decoding into its dictionary
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * The model (probabilities layout, states, lengths and distances) is that
+ * of LzmaDecode.c.  All of the decoder lives in locals for the length of
+ * a call, and as every symbol starts with LZMADEC_INMAX bytes of input to
+ * hand the range coder reads without any check.
+ */
+
+#include "lzmadec.h"
+
+#define kNumTopBits 24
+#define kTopValue ((UInt32)1 << kNumTopBits)
+
+#define kNumBitModelTotalBits 11
+#define kBitModelTotal (1 << kNumBitModelTotalBits)
+#define kNumMoveBits 5
+
+#define NORMALIZE if (range < kTopValue) { range <<= 8; code = (code << 8) | *in++; }
+
+#define IF_BIT0(p) ttt = *(p); NORMALIZE; bound = (range >> kNumBitModelTotalBits) * ttt; if (code < bound)
+#define UPDATE_0(p) range = bound; *(p) = (CProb)(ttt + ((kBitModelTotal - ttt) >> kNumMoveBits));
+#define UPDATE_1(p) range -= bound; code -= bound; *(p) = (CProb)(ttt - (ttt >> kNumMoveBits));
+
+/* GET_BIT shifts the next bit into sym, setting mask to all ones for a 1 */
+#ifdef LZMADEC_BRANCHY
+#define GET_BIT(p, sym) { IF_BIT0(p) { UPDATE_0(p); sym <<= 1; mask = 0; } \
+  else { UPDATE_1(p); sym = (sym << 1) + 1; mask = ~(UInt32)0; } }
+#else
+#define GET_BIT(p, sym) { ttt = *(p); NORMALIZE; bound = (range >> kNumBitModelTotalBits) * ttt; \
+  mask = 0 - (UInt32)(code >= bound); \
+  range = ((range - bound) & mask) | (bound & ~mask); \
+  code -= bound & mask; \
+  *(p) = (CProb)(ttt - ((ttt >> kNumMoveBits) & mask) + (((kBitModelTotal - ttt) >> kNumMoveBits) & ~mask)); \
+  sym = (sym << 1) - mask; }
+#endif
+
+/* decodes numBits bit tree at probs to res */
+#define TREE_DECODE(probs, numBits, res) { res = 1; \
+  do GET_BIT((probs) + res, res) while (res < ((UInt32)1 << (numBits))); \
+  res -= (UInt32)1 << (numBits); }
+
+
+#define kNumPosBitsMax 4
+#define kNumPosStatesMax (1 << kNumPosBitsMax)
+
+#define kLenNumLowBits 3
+#define kLenNumLowSymbols (1 << kLenNumLowBits)
+#define kLenNumMidBits 3
+#define kLenNumMidSymbols (1 << kLenNumMidBits)
+#define kLenNumHighBits 8
+#define kLenNumHighSymbols (1 << kLenNumHighBits)
+
+#define LenChoice 0
+#define LenChoice2 (LenChoice + 1)
+#define LenLow (LenChoice2 + 1)
+#define LenMid (LenLow + (kNumPosStatesMax << kLenNumLowBits))
+#define LenHigh (LenMid + (kNumPosStatesMax << kLenNumMidBits))
+#define kNumLenProbs (LenHigh + kLenNumHighSymbols)
+
+#define kNumStates 12
+#define kNumLitStates 7
+
+#define kStartPosModelIndex 4
+#define kEndPosModelIndex 14
+#define kNumFullDistances (1 << (kEndPosModelIndex >> 1))
+
+#define kNumPosSlotBits 6
+#define kNumLenToPosStates 4
+
+#define kNumAlignBits 4
+#define kAlignTableSize (1 << kNumAlignBits)
+
+#define kMatchMinLen 2
+
+#define IsMatch 0
+#define IsRep (IsMatch + (kNumStates << kNumPosBitsMax))
+#define IsRepG0 (IsRep + kNumStates)
+#define IsRepG1 (IsRepG0 + kNumStates)
+#define IsRepG2 (IsRepG1 + kNumStates)
+#define IsRep0Long (IsRepG2 + kNumStates)
+#define PosSlot (IsRep0Long + (kNumStates << kNumPosBitsMax))
+#define SpecPos (PosSlot + (kNumLenToPosStates << kNumPosSlotBits))
+#define Align (SpecPos + kNumFullDistances - kEndPosModelIndex)
+#define LenCoder (Align + kAlignTableSize)
+#define RepLenCoder (LenCoder + kNumLenProbs)
+#define Literal (RepLenCoder + kNumLenProbs)
+
+#if Literal != LZMA_BASE_SIZE
+StopCompilingDueBUG
+#endif
+
+
+void lzmadec_reset(lzmadec *d)
+{
+  UInt32 numProbs = LzmaGetNumProbs(&d->prop), i;
+
+  for (i = 0; i < numProbs; i++)
+    d->probs[i] = kBitModelTotal >> 1;
+  d->reps[0] = d->reps[1] = d->reps[2] = d->reps[3] = 1;
+  d->state = 0;
+  d->remainLen = 0;
+  d->status = LZMADEC_INIT;
+}
+
+void lzmadec_init(lzmadec *d)
+{
+  lzmadec_reset(d);
+  d->dicPos = 0;
+  d->checkDicSize = 0;
+  d->processed = 0;
+}
+
+
+int lzmadec_decode(lzmadec *d, UInt32 dicLimit, const Byte **inp, const Byte *inLimit)
+{
+  CProb *probs = d->probs;
+  Byte *dic = d->dic;
+  UInt32 dicSize = d->dicSize;
+  UInt32 dicPos = d->dicPos;
+  UInt32 checkDicSize = d->checkDicSize;
+  UInt32 processed = d->processed;
+  UInt32 range = d->range, code = d->code;
+  UInt32 rep0 = d->reps[0], rep1 = d->reps[1], rep2 = d->reps[2], rep3 = d->reps[3];
+  UInt32 len = d->remainLen;
+  unsigned state = d->state;
+  UInt32 pbMask = ((UInt32)1 << d->prop.pb) - 1;
+  UInt32 lpMask = ((UInt32)1 << d->prop.lp) - 1;
+  int lc = d->prop.lc;
+  int status = d->status;
+  const Byte *in = *inp;
+
+  if (status == LZMADEC_INIT)
+  {
+    int i;
+    code = 0;
+    range = 0xFFFFFFFF;
+    for (i = 0; i < 5; i++)
+      code = (code << 8) | *in++;
+    status = LZMADEC_OK;
+  }
+  if (status != LZMADEC_OK)
+    return status;
+
+  /* rest of a match cut short last time */
+  for (; (len != 0) && (dicPos < dicLimit); len--)
+  {
+    dic[dicPos] = dic[dicPos - rep0 + ((dicPos < rep0) ? dicSize : 0)];
+    dicPos++;
+    processed++;
+  }
+
+  while ((dicPos < dicLimit) && (in < inLimit))
+  {
+    CProb *prob;
+    UInt32 bound, ttt, mask;
+    UInt32 posState = processed & pbMask;
+
+    prob = probs + IsMatch + (state << kNumPosBitsMax) + posState;
+    IF_BIT0(prob)
+    {
+      UInt32 symbol = 1;
+      UPDATE_0(prob);
+      /* previous byte is 0 after a dictionary reset */
+      prob = probs + Literal;
+      if ((processed != 0) || (checkDicSize != 0))
+        prob += LZMA_LIT_SIZE *
+          (((processed & lpMask) << lc) + (dic[(dicPos ? dicPos : dicSize) - 1] >> (8 - lc)));
+      processed++;
+      if (state < kNumLitStates)
+      {
+        state -= (state < 4) ? state : 3;
+        GET_BIT(prob + symbol, symbol);
+        GET_BIT(prob + symbol, symbol);
+        GET_BIT(prob + symbol, symbol);
+        GET_BIT(prob + symbol, symbol);
+        GET_BIT(prob + symbol, symbol);
+        GET_BIT(prob + symbol, symbol);
+        GET_BIT(prob + symbol, symbol);
+        GET_BIT(prob + symbol, symbol);
+      }
+      else
+      {
+        /* offs stays 0x100 while the bits decoded follow matchByte's */
+        UInt32 matchByte = dic[dicPos - rep0 + ((dicPos < rep0) ? dicSize : 0)];
+        UInt32 offs = 0x100;
+        state -= (state < 10) ? 3 : 6;
+        do
+        {
+          UInt32 bit;
+          matchByte <<= 1;
+          bit = matchByte & offs;
+          GET_BIT(prob + offs + bit + symbol, symbol);
+          offs &= bit ^ ~mask;
+        }
+        while (symbol < 0x100);
+      }
+      dic[dicPos++] = (Byte)symbol;
+      continue;
+    }
+
+    UPDATE_1(prob);
+    prob = probs + IsRep + state;
+    IF_BIT0(prob)
+    {
+      UPDATE_0(prob);
+      state = (state < kNumLitStates) ? 0 : 3;
+      prob = probs + LenCoder;
+    }
+    else
+    {
+      UPDATE_1(prob);
+      if ((checkDicSize == 0) && (processed == 0))
+      {
+        status = LZMADEC_ERROR;
+        break;
+      }
+      prob = probs + IsRepG0 + state;
+      IF_BIT0(prob)
+      {
+        UPDATE_0(prob);
+        prob = probs + IsRep0Long + (state << kNumPosBitsMax) + posState;
+        IF_BIT0(prob)
+        {
+          /* short rep, one byte at rep0 */
+          UPDATE_0(prob);
+          dic[dicPos] = dic[dicPos - rep0 + ((dicPos < rep0) ? dicSize : 0)];
+          dicPos++;
+          processed++;
+          state = (state < kNumLitStates) ? 9 : 11;
+          continue;
+        }
+        UPDATE_1(prob);
+      }
+      else
+      {
+        UInt32 distance;
+        UPDATE_1(prob);
+        prob = probs + IsRepG1 + state;
+        IF_BIT0(prob)
+        {
+          UPDATE_0(prob);
+          distance = rep1;
+        }
+        else
+        {
+          UPDATE_1(prob);
+          prob = probs + IsRepG2 + state;
+          IF_BIT0(prob)
+          {
+            UPDATE_0(prob);
+            distance = rep2;
+          }
+          else
+          {
+            UPDATE_1(prob);
+            distance = rep3;
+            rep3 = rep2;
+          }
+          rep2 = rep1;
+        }
+        rep1 = rep0;
+        rep0 = distance;
+      }
+      state = (state < kNumLitStates) ? 8 : 11;
+      prob = probs + RepLenCoder;
+    }
+
+    {
+      CProb *probLen = prob + LenChoice;
+      UInt32 offset;
+      IF_BIT0(probLen)
+      {
+        UPDATE_0(probLen);
+        probLen = prob + LenLow + (posState << kLenNumLowBits);
+        TREE_DECODE(probLen, kLenNumLowBits, len);
+        offset = 0;
+      }
+      else
+      {
+        UPDATE_1(probLen);
+        probLen = prob + LenChoice2;
+        IF_BIT0(probLen)
+        {
+          UPDATE_0(probLen);
+          probLen = prob + LenMid + (posState << kLenNumMidBits);
+          TREE_DECODE(probLen, kLenNumMidBits, len);
+          offset = kLenNumLowSymbols;
+        }
+        else
+        {
+          UPDATE_1(probLen);
+          probLen = prob + LenHigh;
+          TREE_DECODE(probLen, kLenNumHighBits, len);
+          offset = kLenNumLowSymbols + kLenNumMidSymbols;
+        }
+      }
+      len += offset;
+    }
+
+    if (state < 4)
+    {
+      /* new match, its distance follows */
+      UInt32 posSlot;
+      state += kNumLitStates;
+      prob = probs + PosSlot +
+          (((len < kNumLenToPosStates) ? len : kNumLenToPosStates - 1) << kNumPosSlotBits);
+      TREE_DECODE(prob, kNumPosSlotBits, posSlot);
+      rep3 = rep2;
+      rep2 = rep1;
+      rep1 = rep0;
+      if (posSlot >= kStartPosModelIndex)
+      {
+        unsigned numDirectBits = (unsigned)(posSlot >> 1) - 1;
+        UInt32 i = 1, mi = 1;
+        rep0 = 2 | (posSlot & 1);
+        if (posSlot < kEndPosModelIndex)
+        {
+          rep0 <<= numDirectBits;
+          prob = probs + SpecPos + rep0 - posSlot - 1;
+        }
+        else
+        {
+          numDirectBits -= kNumAlignBits;
+          do
+          {
+            /* t is all ones if code was below range (a 0 bit) */
+            UInt32 t;
+            NORMALIZE;
+            range >>= 1;
+            code -= range;
+            t = 0 - (code >> 31);
+            code += range & t;
+            rep0 = (rep0 << 1) + (t + 1);
+          }
+          while (--numDirectBits != 0);
+          prob = probs + Align;
+          rep0 <<= kNumAlignBits;
+          numDirectBits = kNumAlignBits;
+        }
+        /* reverse bit tree, low bit first */
+        do
+        {
+          GET_BIT(prob + mi, mi);
+          rep0 |= i & mask;
+          i <<= 1;
+        }
+        while (--numDirectBits != 0);
+      }
+      else
+        rep0 = posSlot;
+      if (++rep0 == 0)
+      {
+        len = 0;
+        status = LZMADEC_END;
+        break;
+      }
+    }
+
+    if (rep0 > (checkDicSize ? checkDicSize : processed))
+    {
+      status = LZMADEC_ERROR;
+      break;
+    }
+
+    len += kMatchMinLen;
+    {
+      UInt32 rem = dicLimit - dicPos;
+      UInt32 cur = (len < rem) ? len : rem;
+      UInt32 pos = dicPos - rep0 + ((dicPos < rep0) ? dicSize : 0);
+
+      processed += cur;
+      len -= cur;
+      if (pos + cur <= dicSize)
+      {
+        Byte *dest = dic + dicPos;
+        const Byte *src = dic + pos;
+        dicPos += cur;
+        do *dest++ = *src++; while (--cur != 0);
+      }
+      else
+      {
+        do
+        {
+          dic[dicPos++] = dic[pos++];
+          if (pos == dicSize)
+            pos = 0;
+        }
+        while (--cur != 0);
+      }
+    }
+  }
+
+  d->dicPos = dicPos;
+  d->processed = processed;
+  d->range = range;
+  d->code = code;
+  d->reps[0] = rep0;
+  d->reps[1] = rep1;
+  d->reps[2] = rep2;
+  d->reps[3] = rep3;
+  d->remainLen = len;
+  d->state = state;
+  d->status = status;
+  *inp = in;
+  return status;
+}
@@ -0,0 +1,75 @@
+/*
+ * lzmadec - LZMA decoder decoding into its dictionary
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * Decodes the same raw LZMA data as LzmaDecode.c, but each byte is only
+ * stored in the dictionary, a ring the caller (lzma.c) reads the output
+ * from, rather than to both the dictionary and an output buffer, and one
+ * call decodes as much as the ring and input allow.  Input is taken
+ * without checking for its end: the caller keeps LZMADEC_INMAX bytes
+ * readable past the limit it passes.
+ *
+ * Bits of literals and bit trees are decoded without branches unless
+ * LZMADEC_BRANCHY is defined; which is faster depends on the processor,
+ * benchkernels times each configuration.
+ */
+
+#ifndef _LZMADEC_H_
+#define _LZMADEC_H_
+
+#include "LzmaDecode.h"
+
+/* most input one symbol takes */
+#define LZMADEC_INMAX 20
+
+/* status */
+#define LZMADEC_INIT  0   /* range coder not started yet */
+#define LZMADEC_OK    1
+#define LZMADEC_END   2   /* end marker decoded */
+#define LZMADEC_ERROR 3   /* data error */
+
+#ifdef LZMADEC_BRANCHY
+#define LZMADEC_BITS "branchy"
+#else
+#define LZMADEC_BITS "branchless"
+#endif
+#ifdef _LZMA_PROB32
+#define LZMADEC_CONFIG LZMADEC_BITS " prob32"
+#else
+#define LZMADEC_CONFIG LZMADEC_BITS " prob16"
+#endif
+
+typedef struct lzmadec
+{
+  CLzmaProperties prop;     /* lc, lp and pb of stream */
+  CProb  *probs;            /* LzmaGetNumProbs(&prop) of them */
+  Byte   *dic;              /* ring of dicSize bytes */
+  UInt32  dicSize;
+  UInt32  dicPos;           /* where next byte decoded goes */
+  UInt32  checkDicSize;     /* dicSize once the ring has wrapped, else 0 */
+  UInt32  processed;        /* bytes decoded since dictionary reset (mod 2^32) */
+  UInt32  range, code;
+  UInt32  reps[4];          /* distances + 1 */
+  UInt32  remainLen;        /* of a match cut short by dicLimit */
+  unsigned state;
+  int     status;
+} lzmadec;
+
+/* starts a stream, prop, probs, dic and dicSize must be set */
+void lzmadec_init(lzmadec *d);
+
+/* resets probabilities and state, keeping the dictionary (LZMA2); a
+   dictionary reset is processed and checkDicSize set to 0 */
+void lzmadec_reset(lzmadec *d);
+
+/* decodes to d->dic from d->dicPos up to dicLimit (at most dicSize),
+   starting symbols while *in is below inLimit, and returns the status,
+   LZMADEC_OK once either limit is reached; once dicPos reaches dicSize
+   the caller, having taken the output, sets it to 0 and checkDicSize
+   to dicSize */
+int lzmadec_decode(lzmadec *d, UInt32 dicLimit, const Byte **in, const Byte *inLimit);
+
+#endif /* _LZMADEC_H_ */
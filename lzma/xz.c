@@ -0,0 +1,1135 @@
+/*
+ * xz - .xz streams of LZMA2 blocks
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * An LZMA2 chunk is a run of LZMA data (or stored bytes) of known packed
+ * and unpacked size, optionally resetting the dictionary, state or
+ * properties first; lzma2_decode walks the chunks and has lzmadec do the
+ * rest.  A block decoded in parallel is its own dictionary, the output
+ * buffer; in sequence blocks share a ring sized for the largest.  Errors
+ * in parallel blocks are kept until the block's turn, so they are
+ * reported in order, from the thread reading.
+ */
+
+#include "../zlib/zlib.h"
+#include "xz.h"
+#include "lzmadec.h"
+#include "../miniclib.h"
+#include "../decpool.h"
+#include "../pool.h"
+
+
+/* !!!USER SUPPLIED!!! */
+/* wrap around whatever you want to send error messages to user, c function */
+void PrintMessage(const char *msg, ...);
+
+
+#ifdef _MSC_VER
+typedef unsigned __int64 UInt64;
+#else
+typedef unsigned long long UInt64;
+#endif
+
+#define kInBufferSize (1 << 15)  /* 32KB */
+#define kOutChunk (1 << 16)      /* most decoded at a time in sequence, 64KB */
+#define XZ_HEADERSIZE 12         /* stream header and footer */
+#define XZ_UNKNOWN ((UInt64)0 - 1)
+#define XZ_PARMEM (256UL << 20)  /* most blocks in flight take */
+#define XZ_MAXSLOTS (2 * POOL_MAXWORKERS)
+
+/* probabilities for the largest lc + lp LZMA2 allows */
+#define LZMA2_PROBS (LZMA_BASE_SIZE + (LZMA_LIT_SIZE << 4))
+
+#define XZ_CHECK_CRC32 1
+#define XZ_CHECK_CRC64 4
+static const unsigned char checkSizes[16] = { 0, 4, 4, 4, 8, 8, 8, 16, 16, 16, 32, 32, 32, 64, 64, 64 };
+
+/* errors, xz_read reports them */
+#define XZ_OK          0
+#define XZ_DATA        1
+#define XZ_EOF         2
+#define XZ_CHECK       3
+#define XZ_UNSUPPORTED 4
+#define XZ_NOMEM       5
+#define XZ_REPORTED    6
+static const char *const errors[] = {
+  NULL,
+  "xz_read: Decoding error",
+  "xz_read: Unexpected end of input",
+  "xz_read: Check mismatch, data is corrupt",
+  "xz_read: Unsupported filter or options",
+  "xz_read: Out of memory",
+  NULL
+};
+
+
+/* LZMA2 chunk being decoded */
+#define CHUNK_CONTROL 0   /* next is a control byte */
+#define CHUNK_LZMA    1
+#define CHUNK_COPY    2
+#define CHUNK_END     3   /* end of LZMA2 data reached */
+
+/* lzma2_decode results */
+#define LZMA2_OK    0
+#define LZMA2_END   1
+#define LZMA2_ERROR 2
+
+typedef struct lzma2
+{
+  lzmadec dec;
+  int     chunk;
+  UInt32  unpacked;       /* left of chunk to decode */
+  UInt32  packed;         /* left of LZMA chunk's input */
+  int     needDicReset;
+  int     needProps;
+} lzma2;
+
+/* block header, as parsed */
+struct blockhdr
+{
+  unsigned size;
+  UInt64   packed, unpacked;    /* XZ_UNKNOWN if not given */
+  UInt32   dicSize;
+};
+
+/* index record */
+struct xzrecord
+{
+  UInt64 unpadded, unpacked;
+};
+
+/* block decoded in parallel */
+struct parblock
+{
+  struct XZFile *f;
+  unsigned char *in;      /* whole block as in the file, LZMADEC_INMAX zeros after */
+  UInt32         inSize;
+  UInt64         unpadded;
+  unsigned char *out;
+  UInt32         outSize;
+  int            done;    /* set (under lock) once decoded */
+  int            result;  /* XZ_* */
+};
+
+/* decoding in sequence */
+#define SEQ_HEADER  0     /* block header or index next */
+#define SEQ_BLOCK   1
+#define SEQ_CHECK   2     /* block padding and check next */
+#define SEQ_INDEX   3
+#define SEQ_PADDING 4     /* stream padding, then another stream or the end */
+#define SEQ_DONE    5
+
+typedef struct XZFile
+{
+  gzFile File;
+  unsigned long maxmem;
+  unsigned char flags[2];       /* of stream, flags[1] is the check type */
+  UInt64 crc64Table[256];
+  UInt64 maxUnpacked;           /* largest block, XZ_UNKNOWN if index not read */
+
+  /* blocks decoded in parallel, pool NULL if in sequence */
+  struct pool *pool;
+  struct xzrecord *index;
+  UInt32 blocks;                /* in index */
+  UInt32 next;                  /* next block to read */
+  UInt32 cur;                   /* next block to hand out */
+  unsigned slots;               /* most blocks in flight */
+  struct parblock slot[XZ_MAXSLOTS];  /* block n in slot n % slots */
+  struct parblock *outBlock;    /* being handed out */
+  UInt32 outPos;                /* output is outBlock->out, or lz.dec.dic up to lz.dec.dicPos, from here */
+  LOCK lock;
+  SEMA done;                    /* posted as each block is decoded */
+
+  /* blocks decoded in sequence */
+  int seq;
+  unsigned char Buffer[kInBufferSize + LZMADEC_INMAX];
+  unsigned inPos, inEnd;        /* input not yet decoded */
+  int inEOF;                    /* no more to read, LZMADEC_INMAX zeros follow inEnd */
+  lzma2 lz;
+  struct blockhdr hdr;
+  UInt64 blockIn, blockOut;     /* of block so far, input after header */
+  uLong crc32;                  /* of block's output */
+  UInt64 crc64;
+  UInt64 count, sumUnpadded, sumUnpacked;   /* blocks of stream so far */
+} XZFile;
+
+
+static UInt32 get32(const unsigned char *p)
+{
+  return (UInt32)p[0] | ((UInt32)p[1] << 8) | ((UInt32)p[2] << 16) | ((UInt32)p[3] << 24);
+}
+
+static void crc64Init(UInt64 *table)
+{
+  unsigned i, j;
+
+  for (i = 0; i < 256; i++)
+  {
+    UInt64 c = i;
+    for (j = 0; j < 8; j++)
+      c = (c >> 1) ^ ((c & 1) ? ((UInt64)0xC96C5795 << 32 | 0xD7870F42) : 0);
+    table[i] = c;
+  }
+}
+
+static UInt64 crc64(const UInt64 *table, UInt64 crc, const unsigned char *p, UInt32 n)
+{
+  crc = ~crc;
+  while (n--)
+    crc = table[(unsigned char)crc ^ *p++] ^ (crc >> 8);
+  return ~crc;
+}
+
+/* nonzero if the check at p matches the output's crc */
+static int checkMatch(int type, uLong c32, UInt64 c64, const unsigned char *p)
+{
+  int i;
+
+  if (type == XZ_CHECK_CRC32)
+    return get32(p) == (UInt32)c32;
+  if (type == XZ_CHECK_CRC64)
+  {
+    for (i = 0; i < 8; i++, c64 >>= 8)
+      if (p[i] != (unsigned char)c64)
+        return 0;
+  }
+  return 1;   /* others not verified */
+}
+
+/* decodes a multibyte integer at p, below end, returns its length or 0
+   if invalid (shifts are by constants, no 64-bit helpers with MSVC) */
+static unsigned getVarint(const unsigned char *p, const unsigned char *end, UInt64 *v)
+{
+  unsigned i = 0, n;
+
+  do
+  {
+    if ((i == 9) || (p + i >= end))
+      return 0;
+  } while (p[i++] & 0x80);
+  if ((i > 1) && (p[i - 1] == 0))
+    return 0;
+  for (*v = 0, n = i; n > 0; n--)
+    *v = (*v << 7) | (p[n - 1] & 0x7F);
+  return i;
+}
+
+
+/*
+LZMA2 data
+----------
+Control byte, then
+  0x00             end of data
+  0x01             stored chunk, dictionary reset
+  0x02             stored chunk
+  0x80-0xFF        LZMA chunk, bits 0-4 are bits 16-20 of unpacked size - 1,
+                   bits 5-6 reset 0 nothing, 1 state, 2 state and properties,
+                   3 dictionary as well
+Stored chunks then have 2 bytes of unpacked size - 1 (big endian), LZMA
+chunks 2 bytes of unpacked size - 1, 2 of packed size - 1 and, if new,
+the properties byte ((pb * 5 + lp) * 9 + lc).
+*/
+
+static void lzma2_start(lzma2 *d)
+{
+  d->chunk = CHUNK_CONTROL;
+  d->needDicReset = 1;
+  d->needProps = 1;
+}
+
+/* decodes from *in into d->dec.dic up to dicLimit, end is the end of the
+   input so far (LZMADEC_INMAX bytes readable past it) and of all input
+   unless more; returns LZMA2_OK once dicLimit is reached or more input
+   is needed */
+static int lzma2_decode(lzma2 *d, UInt32 dicLimit, const unsigned char **in, const unsigned char *end, int more)
+{
+  lzmadec *dec = &(d->dec);
+  const unsigned char *p = *in;
+  int result = LZMA2_OK;
+
+  while (result == LZMA2_OK)
+  {
+    UInt32 avail = (UInt32)(end - p);
+
+    if (d->chunk == CHUNK_END)
+      result = LZMA2_END;
+    else if (d->chunk == CHUNK_CONTROL)
+    {
+      unsigned c, size;
+
+      if (avail == 0)
+      {
+        if (!more) result = LZMA2_ERROR;
+        break;
+      }
+      c = p[0];
+      size = (c == 0) ? 1 : (c >= 0xC0) ? 6 : (c >= 0x80) ? 5 : 3;
+      if (avail < size)
+      {
+        if (!more) result = LZMA2_ERROR;
+        break;
+      }
+      if (c == 0)
+      {
+        p++;
+        d->chunk = CHUNK_END;
+        continue;
+      }
+      if ((c >= 0xE0) || (c == 1))
+      {
+        d->needDicReset = 0;
+        dec->processed = 0;
+        dec->checkDicSize = 0;
+      }
+      else if (d->needDicReset)
+      {
+        result = LZMA2_ERROR;
+        break;
+      }
+
+      if (c >= 0x80)
+      {
+        d->unpacked = ((UInt32)(c & 0x1F) << 16) + ((UInt32)p[1] << 8) + p[2] + 1;
+        d->packed = ((UInt32)p[3] << 8) + p[4] + 1;
+        if (c >= 0xC0)
+        {
+          unsigned b = p[5];
+          if (b >= 9 * 5 * 5)
+          {
+            result = LZMA2_ERROR;
+            break;
+          }
+          dec->prop.lc = b % 9;
+          b /= 9;
+          dec->prop.lp = b % 5;
+          dec->prop.pb = b / 5;
+          if (dec->prop.lc + dec->prop.lp > 4)
+          {
+            result = LZMA2_ERROR;
+            break;
+          }
+          d->needProps = 0;
+          lzmadec_reset(dec);
+        }
+        else if (d->needProps)
+        {
+          result = LZMA2_ERROR;
+          break;
+        }
+        else if (c >= 0xA0)
+          lzmadec_reset(dec);
+        dec->status = LZMADEC_INIT;   /* each chunk starts the range coder */
+        d->chunk = CHUNK_LZMA;
+      }
+      else if (c > 2)
+      {
+        result = LZMA2_ERROR;
+        break;
+      }
+      else
+      {
+        d->unpacked = ((UInt32)p[1] << 8) + p[2] + 1;
+        d->chunk = CHUNK_COPY;
+      }
+      p += size;
+    }
+    else if (d->chunk == CHUNK_LZMA)
+    {
+      UInt32 start = dec->dicPos, limit = dicLimit - start;
+      const unsigned char *from = p, *inLimit;
+      int status;
+
+      if (limit > d->unpacked)
+        limit = d->unpacked;
+      if (limit == 0)
+        break;
+      /* a symbol may start at the chunk's end, or on the last byte of all input */
+      if (d->packed < avail)
+        inLimit = p + d->packed + 1;
+      else if (!more)
+        inLimit = end + 1;
+      else if (avail > LZMADEC_INMAX)
+        inLimit = end - LZMADEC_INMAX;
+      else
+        break;
+
+      status = lzmadec_decode(dec, start + limit, &p, inLimit);
+      d->unpacked -= dec->dicPos - start;
+      if (((UInt32)(p - from) > d->packed) || (status == LZMADEC_ERROR) || (status == LZMADEC_END))
+      {
+        result = LZMA2_ERROR;
+        break;
+      }
+      d->packed -= (UInt32)(p - from);
+      if (d->unpacked == 0)
+      {
+        /* the range coder's last normalization, then it must be done */
+        if ((dec->range < ((UInt32)1 << 24)) && (d->packed != 0))
+        {
+          dec->code = (dec->code << 8) | *p++;
+          d->packed--;
+        }
+        if ((d->packed != 0) || (dec->remainLen != 0) || (dec->code != 0))
+        {
+          result = LZMA2_ERROR;
+          break;
+        }
+        d->chunk = CHUNK_CONTROL;
+      }
+      else if (dec->dicPos != start + limit)
+      {
+        /* stopped at inLimit, more needed */
+        if (!more) result = LZMA2_ERROR;
+        break;
+      }
+    }
+    else /* CHUNK_COPY */
+    {
+      UInt32 n = dicLimit - dec->dicPos;
+
+      if (n > d->unpacked)
+        n = d->unpacked;
+      if (n > avail)
+        n = avail;
+      if (n == 0)
+      {
+        if (!more && (dec->dicPos != dicLimit)) result = LZMA2_ERROR;
+        break;
+      }
+      memcpy(dec->dic + dec->dicPos, p, n);
+      dec->dicPos += n;
+      dec->processed += n;
+      p += n;
+      d->unpacked -= n;
+      if (d->unpacked == 0)
+        d->chunk = CHUNK_CONTROL;
+    }
+  }
+
+  *in = p;
+  return result;
+}
+
+
+/*
+xz file format
+--------------
+Stream header (12 bytes): FD '7zXZ' 00, flags 00 and check type, CRC32
+of flags.  Blocks, each
+  header   size / 4 - 1, flags (number of filters - 1, 0x40 packed size
+           follows, 0x80 unpacked size follows), sizes, filters (id,
+           size of properties, properties), zeros to a multiple of 4,
+           CRC32 of the header
+  data     of the filters, here LZMA2 only
+  padding  zeros to a multiple of 4
+  check    of the unpacked data
+The index: 00, number of blocks, for each its unpadded (header, data and
+check) and unpacked size, zeros to a multiple of 4, CRC32 of the index.
+Stream footer (12 bytes): CRC32 of the next 6, index size / 4 - 1, flags,
+'YZ'.  Streams may be followed by zeros (multiples of 4) and more streams.
+Sizes are multibyte integers, 7 bits a byte, lowest first, little endian
+otherwise.
+*/
+
+/* reads stream header h, returns XZ_* */
+static int streamHeader(XZFile *f, const unsigned char *h)
+{
+  static const unsigned char magic[6] = { 0xFD, '7', 'z', 'X', 'Z', 0 };
+
+  if ((memcmp(h, magic, 6) != 0) || (crc32(0L, h + 6, 2) != get32(h + 8)))
+    return XZ_DATA;
+  if ((h[6] != 0) || (h[7] > 15))
+    return XZ_UNSUPPORTED;
+  f->flags[0] = h[6];
+  f->flags[1] = h[7];
+  return XZ_OK;
+}
+
+/* parses block header at h (h[0] nonzero, (h[0] + 1) * 4 bytes of it), returns XZ_* */
+static int blockHeader(const unsigned char *h, struct blockhdr *b)
+{
+  unsigned size = ((unsigned)h[0] + 1) * 4, n;
+  const unsigned char *p = h + 2, *end = h + size - 4;
+  UInt64 id, propSize;
+
+  if (crc32(0L, h, size - 4) != get32(end))
+    return XZ_DATA;
+  if ((h[1] & 0x3F) != 0)
+    return XZ_UNSUPPORTED;   /* several filters, or reserved flags */
+
+  b->size = size;
+  b->packed = b->unpacked = XZ_UNKNOWN;
+  if (h[1] & 0x40)
+  {
+    if (((n = getVarint(p, end, &b->packed)) == 0) || (b->packed == 0))
+      return XZ_DATA;
+    p += n;
+  }
+  if (h[1] & 0x80)
+  {
+    if ((n = getVarint(p, end, &b->unpacked)) == 0)
+      return XZ_DATA;
+    p += n;
+  }
+
+  if ((n = getVarint(p, end, &id)) == 0)
+    return XZ_DATA;
+  p += n;
+  if ((n = getVarint(p, end, &propSize)) == 0)
+    return XZ_DATA;
+  p += n;
+  if ((id != 0x21) || (propSize != 1) || (p >= end) || (*p > 40))
+    return XZ_UNSUPPORTED;
+  b->dicSize = (*p == 40) ? 0xFFFFFFFF : (UInt32)(2 | (*p & 1)) << (*p / 2 + 11);
+
+  for (p++; p < end; p++)
+    if (*p != 0)
+      return XZ_DATA;
+  return XZ_OK;
+}
+
+
+/* decodes block b, on a pool thread */
+static void parDecode(struct pool *pool, int worker, void *arg)
+{
+  struct parblock *b = (struct parblock *)arg;
+  XZFile *f = b->f;
+  unsigned checkSize = checkSizes[f->flags[1]];
+  const unsigned char *in = b->in, *end = b->in + b->inSize;
+  struct blockhdr hdr;
+  lzma2 lz;
+  int result;
+
+  (void)pool;
+  (void)worker;
+  memset(&lz, 0, sizeof(lz));
+  if ((b->in[0] == 0) || (((UInt32)b->in[0] + 1) * 4 > b->inSize))
+    result = XZ_DATA;
+  else if ((result = blockHeader(b->in, &hdr)) == XZ_OK)
+  {
+    if (((hdr.packed != XZ_UNKNOWN) && (hdr.packed != b->unpadded - hdr.size - checkSize)) ||
+        ((hdr.unpacked != XZ_UNKNOWN) && (hdr.unpacked != b->outSize)))
+      result = XZ_DATA;
+    else if ((lz.dec.probs = (CProb *)dpool_alloc(LZMA2_PROBS * sizeof(CProb))) == NULL)
+      result = XZ_NOMEM;
+  }
+
+  if (result == XZ_OK)
+  {
+    lz.dec.dic = b->out;
+    lz.dec.dicSize = b->outSize;
+    lzmadec_init(&lz.dec);
+    lzma2_start(&lz);
+    in += hdr.size;
+    if ((lzma2_decode(&lz, b->outSize, &in, end, 0) != LZMA2_END) ||
+        (lz.dec.dicPos != b->outSize) ||
+        ((UInt64)(in - b->in) + checkSize != b->unpadded))
+      result = XZ_DATA;
+    else
+    {
+      uLong c32 = 0;
+      UInt64 c64 = 0;
+
+      /* padding, then check */
+      for (; (in - b->in) & 3; in++)
+        if (*in != 0)
+          result = XZ_DATA;
+      if (f->flags[1] == XZ_CHECK_CRC32)
+        c32 = crc32(0L, b->out, b->outSize);
+      else if (f->flags[1] == XZ_CHECK_CRC64)
+        c64 = crc64(f->crc64Table, 0, b->out, b->outSize);
+      if ((result == XZ_OK) && !checkMatch(f->flags[1], c32, c64, in))
+        result = XZ_CHECK;
+    }
+  }
+
+  dpool_free(lz.dec.probs);
+  dpool_free(b->in);
+  lock_acquire(&f->lock);
+  b->in = NULL;
+  b->result = result;
+  b->done = 1;
+  lock_release(&f->lock);
+  sema_post(&f->done, 1);
+}
+
+/* reads block f->next and queues it, returns XZ_* */
+static int parSubmit(XZFile *f)
+{
+  struct parblock *b = &f->slot[f->next % f->slots];
+  const struct xzrecord *r = &f->index[f->next];
+
+  b->f = f;
+  b->unpadded = r->unpadded;
+  b->inSize = (UInt32)((r->unpadded + 3) & ~(UInt64)3);
+  b->outSize = (UInt32)r->unpacked;
+  b->done = 0;
+  b->result = XZ_OK;
+  b->in = (unsigned char *)dpool_alloc(b->inSize + LZMADEC_INMAX);
+  b->out = (unsigned char *)dpool_alloc(b->outSize ? b->outSize : 1);
+  if ((b->in == NULL) || (b->out == NULL))
+    return XZ_NOMEM;
+  if (gzread(f->File, b->in, b->inSize) != (int)b->inSize)
+    return XZ_EOF;
+  memset(b->in + b->inSize, 0, LZMADEC_INMAX);
+  if (!pool_submit(f->pool, -1, parDecode, b))
+    return XZ_NOMEM;
+  f->next++;
+  return XZ_OK;
+}
+
+/* reads the index at the end of the file and, if it lists several blocks
+   small enough, starts decoding them in parallel; returns 0 if blocks are
+   to be decoded in sequence (then only maxUnpacked may have been set) */
+static int parInit(XZFile *f, int threads)
+{
+  unsigned char footer[XZ_HEADERSIZE], *ix = NULL;
+  const unsigned char *p, *end;
+  long size;
+  UInt32 ixSize, i;
+  UInt64 count, total = 0, most = 0, v;
+  unsigned long budget = (f->maxmem && (f->maxmem < XZ_PARMEM)) ? f->maxmem : XZ_PARMEM;
+  unsigned n, slots;
+  unsigned long per;
+
+  if (((size = gzseek(f->File, 0L, SEEK_END)) < 2 * XZ_HEADERSIZE + 8) ||
+      (gzseek(f->File, size - XZ_HEADERSIZE, SEEK_SET) < 0) ||
+      (gzread(f->File, footer, XZ_HEADERSIZE) != XZ_HEADERSIZE) ||
+      (footer[10] != 'Y') || (footer[11] != 'Z') ||
+      (crc32(0L, footer + 4, 6) != get32(footer)) ||
+      (footer[8] != f->flags[0]) || (footer[9] != f->flags[1]))
+    goto sequence;    /* padded, several streams, or corrupt */
+
+  ixSize = (get32(footer + 4) + 1) * 4;
+  if ((ixSize == 0) || (ixSize > (UInt32)(size - 2 * XZ_HEADERSIZE)) ||
+      ((ix = (unsigned char *)dpool_alloc(ixSize)) == NULL) ||
+      (gzseek(f->File, size - XZ_HEADERSIZE - (long)ixSize, SEEK_SET) < 0) ||
+      (gzread(f->File, ix, ixSize) != (int)ixSize) ||
+      (ix[0] != 0) || (crc32(0L, ix, ixSize - 4) != get32(ix + ixSize - 4)))
+    goto sequence;
+  p = ix + 1;
+  end = ix + ixSize - 4;
+  if (((n = getVarint(p, end, &count)) == 0) || (count > ixSize / 2))
+    goto sequence;
+  p += n;
+  f->index = (struct xzrecord *)dpool_alloc((unsigned long)count * sizeof(struct xzrecord) + 1);
+  if (f->index == NULL)
+    goto sequence;
+  for (i = 0; i < (UInt32)count; i++)
+  {
+    struct xzrecord *r = &f->index[i];
+    if ((n = getVarint(p, end, &r->unpadded)) == 0)
+      goto sequence;
+    p += n;
+    if ((n = getVarint(p, end, &r->unpacked)) == 0)
+      goto sequence;
+    p += n;
+    if ((r->unpadded < (UInt64)5 + checkSizes[f->flags[1]]) || (r->unpadded > XZ_UNKNOWN / 2))
+      goto sequence;
+    total += (r->unpadded + 3) & ~(UInt64)3;
+    if (r->unpacked > most)
+      most = r->unpacked;
+    v = ((r->unpadded + 3) & ~(UInt64)3) + r->unpacked;
+    if (v > budget)
+      budget = 0;     /* one block over it, none in parallel */
+  }
+  for (; p < end; p++)
+    if (*p != 0)
+      goto sequence;
+  if (total + ixSize + 2 * XZ_HEADERSIZE != (UInt64)size)
+    goto sequence;    /* several streams */
+  f->maxUnpacked = most;
+
+  /* blocks in flight, each at most in + out + probabilities */
+  if (threads == 0)
+    threads = thread_cpus();
+  if ((threads < 2) || (count < 2) || (budget == 0))
+    goto sequence;
+  for (i = 0, v = 0; i < (UInt32)count; i++)
+  {
+    UInt64 m = ((f->index[i].unpadded + 3) & ~(UInt64)3) + f->index[i].unpacked;
+    if (m > v)
+      v = m;
+  }
+  /* each under budget, so 32 bits will do */
+  per = (unsigned long)v + LZMADEC_INMAX + LZMA2_PROBS * sizeof(CProb);
+  slots = (unsigned)((budget / per < XZ_MAXSLOTS) ? budget / per : XZ_MAXSLOTS);
+  if ((unsigned)(2 * threads) < slots)
+    slots = 2 * threads;
+  if ((UInt64)slots > count)
+    slots = (unsigned)count;
+  if ((slots < 2) || (gzseek(f->File, XZ_HEADERSIZE, SEEK_SET) != XZ_HEADERSIZE))
+    goto sequence;
+  if (!sema_init(&f->done, 0))
+    goto sequence;
+  if ((f->pool = pool_new(threads)) == NULL)
+  {
+    sema_free(&f->done);
+    goto sequence;
+  }
+  lock_init(&f->lock);
+  if ((unsigned)(2 * pool_size(f->pool)) < slots)
+    slots = 2 * pool_size(f->pool);
+  f->slots = slots;
+  f->blocks = (UInt32)count;
+  dpool_free(ix);
+  return 1;
+
+sequence:
+  dpool_free(ix);
+  dpool_free(f->index);
+  f->index = NULL;
+  return 0;
+}
+
+/* hands out the next block decoded in parallel, returns XZ_* */
+static int parNext(XZFile *f)
+{
+  struct parblock *b;
+  int result;
+
+  if (f->outBlock != NULL)
+  {
+    dpool_free(f->outBlock->out);
+    f->outBlock->out = NULL;
+    f->outBlock = NULL;
+  }
+  if (f->cur == f->blocks)
+    return XZ_OK;   /* end */
+
+  while ((f->next < f->blocks) && (f->next - f->cur < f->slots))
+    if ((result = parSubmit(f)) != XZ_OK)
+      return result;
+
+  b = &f->slot[f->cur % f->slots];
+  lock_acquire(&f->lock);
+  while (!b->done)
+  {
+    lock_release(&f->lock);
+    sema_wait(&f->done);
+    lock_acquire(&f->lock);
+  }
+  result = b->result;
+  lock_release(&f->lock);
+  if (result != XZ_OK)
+    return result;
+
+  f->cur++;
+  f->outBlock = b;
+  f->outPos = 0;
+  return XZ_OK;
+}
+
+
+/* moves input not yet decoded to the start of Buffer and fills the rest */
+static void fillBuffer(XZFile *b)
+{
+  unsigned n = b->inEnd - b->inPos;
+  memmove(b->Buffer, b->Buffer + b->inPos, n);
+  while (!b->inEOF && (n < kInBufferSize))
+  {
+    int len = gzread(b->File, b->Buffer + n, kInBufferSize - n);
+    if (len <= 0)
+      b->inEOF = 1;
+    else
+      n += len;
+  }
+  b->inPos = 0;
+  b->inEnd = n;
+  if (b->inEOF)
+    memset(b->Buffer + n, 0, LZMADEC_INMAX);
+}
+
+/* makes n (at most kInBufferSize) bytes of input available at inPos,
+   returns 0 if input ends first */
+static int avail(XZFile *f, unsigned n)
+{
+  if (f->inEnd - f->inPos < n)
+    fillBuffer(f);
+  return f->inEnd - f->inPos >= n;
+}
+
+/* starts block f->hdr in sequence, growing the ring if too small */
+static int seqStart(XZFile *f)
+{
+  lzmadec *dec = &(f->lz.dec);
+  UInt32 need = f->hdr.dicSize;
+
+  if (need > f->hdr.unpacked)
+    need = (UInt32)f->hdr.unpacked;
+  if (need > f->maxUnpacked)
+    need = (UInt32)f->maxUnpacked;
+  /* a multiple of 512 bytes, so reads of whole tar blocks are never split by its end */
+  if (need > 0xFFFFF000)
+    need = 0xFFFFF000;
+  need = (need + 511) & ~(UInt32)511;
+  if (need < (1 << 12))
+    need = 1 << 12;
+
+  if (need > dec->dicSize)
+  {
+    unsigned long probsize = LZMA2_PROBS * sizeof(CProb);
+    if ((f->maxmem != 0) &&
+        ((need > f->maxmem) ||
+         (probsize + sizeof(XZFile) > f->maxmem - need)))
+    {
+      PrintMessage("Error: xz dictionary of %lu KB is over the %lu KB memory budget for decoding",
+                   (unsigned long)(need >> 10), f->maxmem >> 10);
+      return XZ_REPORTED;
+    }
+    /* all output has been taken, nothing before the block is needed */
+    dpool_free(dec->dic);
+    dec->dicSize = 0;
+    if ((dec->dic = (Byte *)dpool_alloc(need)) == NULL)
+      return XZ_NOMEM;
+    dec->dicSize = need;
+    dec->dicPos = f->outPos = 0;
+    dec->checkDicSize = 0;
+  }
+  lzma2_start(&(f->lz));
+  f->blockIn = f->blockOut = 0;
+  f->crc32 = crc32(0L, Z_NULL, 0);
+  f->crc64 = 0;
+  return XZ_OK;
+}
+
+/* reads the index and stream footer in sequence, checking them against
+   the blocks read, returns XZ_* */
+static int seqIndex(XZFile *f)
+{
+  uLong crc = crc32(0L, Z_NULL, 0);
+  UInt64 count, i, unpadded = 0, unpacked = 0, u, v;
+  unsigned n, m, size = 1;
+  const unsigned char *p;
+
+  /* indicator and count (at least 16 bytes follow them) */
+  avail(f, 1 + 9);
+  p = f->Buffer + f->inPos;
+  if ((n = getVarint(p + 1, f->Buffer + f->inEnd, &count)) == 0)
+    return XZ_EOF;
+  if (count != f->count)
+    return XZ_DATA;
+  crc = crc32(crc, p, 1 + n);
+  f->inPos += 1 + n;
+  size += n;
+
+  for (i = 0; i < count; i++)
+  {
+    avail(f, 2 * 9);
+    p = f->Buffer + f->inPos;
+    if (((n = getVarint(p, f->Buffer + f->inEnd, &u)) == 0) ||
+        ((m = getVarint(p + n, f->Buffer + f->inEnd, &v)) == 0))
+      return XZ_EOF;
+    unpadded += u;
+    unpacked += v;
+    crc = crc32(crc, p, n + m);
+    f->inPos += n + m;
+    size += n + m;
+  }
+  if ((unpadded != f->sumUnpadded) || (unpacked != f->sumUnpacked))
+    return XZ_DATA;
+
+  /* padding, CRC32, footer */
+  n = (0 - size) & 3;
+  if (!avail(f, n + 4 + XZ_HEADERSIZE))
+    return XZ_EOF;
+  p = f->Buffer + f->inPos;
+  for (i = 0; i < n; i++)
+    if (p[i] != 0)
+      return XZ_DATA;
+  crc = crc32(crc, p, n);
+  size += n + 4;
+  p += n;
+  if (get32(p) != (UInt32)crc)
+    return XZ_DATA;
+  p += 4;
+  if ((crc32(0L, p + 4, 6) != get32(p)) || ((get32(p + 4) + 1) * 4 != size) ||
+      (p[8] != f->flags[0]) || (p[9] != f->flags[1]) || (p[10] != 'Y') || (p[11] != 'Z'))
+    return XZ_DATA;
+  f->inPos += n + 4 + XZ_HEADERSIZE;
+  return XZ_OK;
+}
+
+/* decodes blocks in sequence up to limit bytes into the ring, stopping
+   early only at the end of a block or of all streams, returns XZ_* */
+static int seqDecode(XZFile *f, UInt32 limit)
+{
+  lzmadec *dec = &(f->lz.dec);
+  UInt32 start = dec->dicPos;
+  unsigned checkSize = checkSizes[f->flags[1]];
+  int result;
+
+  while (1)
+  {
+    switch (f->seq)
+    {
+      case SEQ_HEADER:
+      {
+        unsigned size;
+
+        if (dec->dicPos != start)
+          return XZ_OK;   /* output of the last block first */
+        if (!avail(f, 1))
+          return XZ_EOF;
+        if (f->Buffer[f->inPos] == 0)
+        {
+          f->seq = SEQ_INDEX;
+          break;
+        }
+        size = ((unsigned)f->Buffer[f->inPos] + 1) * 4;
+        if (!avail(f, size))
+          return XZ_EOF;
+        if ((result = blockHeader(f->Buffer + f->inPos, &f->hdr)) != XZ_OK)
+          return result;
+        f->inPos += size;
+        if ((result = seqStart(f)) != XZ_OK)
+          return result;
+        start = dec->dicPos;
+        f->seq = SEQ_BLOCK;
+        break;
+      }
+
+      case SEQ_BLOCK:
+      {
+        UInt32 before = dec->dicPos;
+        const unsigned char *in, *from;
+
+        if (!f->inEOF && (f->inEnd - f->inPos <= LZMADEC_INMAX))
+          fillBuffer(f);
+        in = from = f->Buffer + f->inPos;
+        result = lzma2_decode(&(f->lz), start + limit, &in, f->Buffer + f->inEnd, !f->inEOF);
+        f->inPos = (unsigned)(in - f->Buffer);
+        f->blockIn += (UInt32)(in - from);
+        f->blockOut += dec->dicPos - before;
+        if (f->flags[1] == XZ_CHECK_CRC32)
+          f->crc32 = crc32(f->crc32, dec->dic + before, dec->dicPos - before);
+        else if (f->flags[1] == XZ_CHECK_CRC64)
+          f->crc64 = crc64(f->crc64Table, f->crc64, dec->dic + before, dec->dicPos - before);
+
+        if ((result == LZMA2_ERROR) || (f->blockOut > f->hdr.unpacked))
+          return XZ_DATA;
+        if (result == LZMA2_END)
+          f->seq = SEQ_CHECK;
+        else if (dec->dicPos == start + limit)
+          return XZ_OK;
+        break;
+      }
+
+      case SEQ_CHECK:
+      {
+        unsigned pad = (unsigned)(0 - f->blockIn) & 3, i;
+        const unsigned char *p;
+
+        if (!avail(f, pad + checkSize))
+          return XZ_EOF;
+        p = f->Buffer + f->inPos;
+        for (i = 0; i < pad; i++)
+          if (p[i] != 0)
+            return XZ_DATA;
+        if (((f->hdr.packed != XZ_UNKNOWN) && (f->hdr.packed != f->blockIn)) ||
+            ((f->hdr.unpacked != XZ_UNKNOWN) && (f->hdr.unpacked != f->blockOut)))
+          return XZ_DATA;
+        if (!checkMatch(f->flags[1], f->crc32, f->crc64, p + pad))
+          return XZ_CHECK;
+        f->inPos += pad + checkSize;
+        f->count++;
+        f->sumUnpadded += f->hdr.size + f->blockIn + checkSize;
+        f->sumUnpacked += f->blockOut;
+        f->seq = SEQ_HEADER;
+        break;
+      }
+
+      case SEQ_INDEX:
+        if ((result = seqIndex(f)) != XZ_OK)
+          return result;
+        f->seq = SEQ_PADDING;
+        break;
+
+      case SEQ_PADDING:
+        while (avail(f, 4) && (get32(f->Buffer + f->inPos) == 0))
+          f->inPos += 4;
+        if (!avail(f, 1))
+        {
+          f->seq = SEQ_DONE;
+          break;
+        }
+        if (!avail(f, XZ_HEADERSIZE))
+          return XZ_DATA;
+        if ((result = streamHeader(f, f->Buffer + f->inPos)) != XZ_OK)
+          return result;
+        f->inPos += XZ_HEADERSIZE;
+        checkSize = checkSizes[f->flags[1]];
+        f->count = f->sumUnpadded = f->sumUnpacked = 0;
+        f->maxUnpacked = XZ_UNKNOWN;   /* index was of the first stream */
+        f->seq = SEQ_HEADER;
+        break;
+
+      default: /* SEQ_DONE */
+        return XZ_OK;
+    }
+  }
+}
+
+
+static void report(int result)
+{
+  if (errors[result] != NULL)
+    PrintMessage(errors[result]);
+}
+
+int xz_init(gzFile infile, struct XZFile **xzFile, unsigned long maxmem, int threads)
+{
+  XZFile *f;
+  unsigned char h[XZ_HEADERSIZE];
+  int result;
+
+  *xzFile = f = (XZFile *)dpool_alloc(sizeof(struct XZFile));
+  if (f == NULL) return -1;
+
+  memset(f, 0, sizeof(XZFile));
+  f->File = infile;
+  f->maxmem = maxmem;
+  f->maxUnpacked = XZ_UNKNOWN;
+  crc64Init(f->crc64Table);
+
+  if (gzread(infile, h, XZ_HEADERSIZE) != XZ_HEADERSIZE)
+  {
+    PrintMessage("xz: Can not read input file.");
+    return -1;
+  }
+  if ((result = streamHeader(f, h)) != XZ_OK)
+  {
+    report(result);
+    return -1;
+  }
+
+  if (parInit(f, threads))
+    return 0;
+
+  /* in sequence, from the first block */
+  if (gzseek(infile, XZ_HEADERSIZE, SEEK_SET) != XZ_HEADERSIZE)
+  {
+    PrintMessage("xz: Can not read input file.");
+    return -1;
+  }
+  f->lz.dec.probs = (CProb *)dpool_alloc(LZMA2_PROBS * sizeof(CProb));
+  if (f->lz.dec.probs == NULL) return -1;
+  f->seq = SEQ_HEADER;
+  if ((result = seqDecode(f, 0)) != XZ_OK)
+  {
+    report(result);
+    return -1;
+  }
+  return 0;
+}
+
+
+void xz_cleanup(struct XZFile *xzFile)
+{
+  unsigned i;
+
+  if (xzFile != NULL)
+  {
+    if (xzFile->pool != NULL)
+    {
+      pool_free(xzFile->pool);
+      lock_free(&xzFile->lock);
+      sema_free(&xzFile->done);
+    }
+    for (i = 0; i < XZ_MAXSLOTS; i++)
+    {
+      dpool_free(xzFile->slot[i].in);
+      dpool_free(xzFile->slot[i].out);
+    }
+    dpool_free(xzFile->index);
+    dpool_free(xzFile->lz.dec.probs);
+    dpool_free(xzFile->lz.dec.dic);
+    dpool_free(xzFile);
+  }
+}
+
+
+long xz_readptr(struct XZFile *xzFile,
+                const unsigned char **buffer,
+                unsigned len)
+{
+  UInt32 n;
+  int result;
+
+  if (xzFile->pool != NULL)
+  {
+    /* next block once this one is all read (blocks may be empty) */
+    while ((xzFile->outBlock == NULL) || (xzFile->outPos == xzFile->outBlock->outSize))
+    {
+      if ((result = parNext(xzFile)) != XZ_OK)
+      {
+        report(result);
+        return -1;
+      }
+      if (xzFile->outBlock == NULL)
+        return 0;   /* end */
+    }
+    n = xzFile->outBlock->outSize - xzFile->outPos;
+    if (n > len)
+      n = len;
+    *buffer = xzFile->outBlock->out + xzFile->outPos;
+    xzFile->outPos += n;
+    return (long)n;
+  }
+  else
+  {
+    lzmadec *dec = &(xzFile->lz.dec);
+
+    if (xzFile->outPos == dec->dicPos)
+    {
+      /* all read, decode more (up to the ring's end) */
+      UInt32 limit;
+
+      if (dec->dicPos == dec->dicSize)
+      {
+        xzFile->outPos = dec->dicPos = 0;
+        if (dec->processed >= dec->dicSize)
+          dec->checkDicSize = dec->dicSize;
+      }
+      limit = dec->dicSize - dec->dicPos;
+      if (limit > kOutChunk)
+        limit = kOutChunk;
+      if ((result = seqDecode(xzFile, limit)) != XZ_OK)
+      {
+        report(result);
+        return -1;
+      }
+    }
+
+    n = dec->dicPos - xzFile->outPos;
+    if (n > len)
+      n = len;
+    *buffer = dec->dic + xzFile->outPos;
+    xzFile->outPos += n;
+    return (long)n;
+  }
+}
+
+
+long xz_read(struct XZFile *xzFile,
+             unsigned char *buffer,
+             unsigned len)
+{
+  unsigned done = 0;
+
+  while (done < len)
+  {
+    const unsigned char *p;
+    long n = xz_readptr(xzFile, &p, len - done);
+    if (n < 0)
+      return -1;
+    if (n == 0)
+      break;
+    memcpy(buffer + done, p, n);
+    done += n;
+  }
+  return (long)done;
+}
@@ -0,0 +1,47 @@
+/*
+ * xz - .xz streams of LZMA2 blocks
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * xz_init reads the stream header and, if the input can seek to its end,
+ * the index there, which gives every block's compressed and uncompressed
+ * size.  Blocks start with a fresh dictionary, so when the index lists
+ * several (xz --block-size, or -T) they are read in turn, decoded a few
+ * at a time on a pool of threads (pool.c), each into a buffer of its own,
+ * and handed out in order.  Otherwise blocks are decoded one after
+ * another through a dictionary ring as lzma.c does, and the index is
+ * checked against them when reached.  LZMA2 chunks are decoded by
+ * lzmadec; LZMA2 is the only filter supported, and of the checks only
+ * CRC32 and CRC64 are verified.
+ */
+
+#ifndef _XZ_H_
+#define _XZ_H_
+
+/* prototypes for our read function */
+typedef void * gzFile;
+int gzread(gzFile file, void * buf, unsigned len);
+
+/* holds any information needed about stream */
+struct XZFile;
+typedef struct XZFile XZFile;
+
+/* routines implemented */
+/* maxmem (0 for no limit) refuses streams that need more than maxmem
+   bytes decoding blocks one after another, and bounds the blocks decoded
+   at the same time; threads (0 for one per processor) decode blocks,
+   with fewer than 2 they are decoded one after another */
+int xz_init(gzFile infile, struct XZFile **xzFile, unsigned long maxmem, int threads);
+void xz_cleanup(struct XZFile *xzFile);
+long xz_read(struct XZFile *xzFile,
+             unsigned char *buffer,
+             unsigned len);
+/* as xz_read, but returns a pointer to up to len bytes decoded (valid
+   until the next read) rather than copying them */
+long xz_readptr(struct XZFile *xzFile,
+                const unsigned char **buffer,
+                unsigned len);
+
+#endif /* _XZ_H_ */
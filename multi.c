@@ -0,0 +1,206 @@
+/*
+ * multi - extracting several tarballs at the same time
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * One pool task per job.  Everything a job uses (tarball, output and
+ * extraction contexts) is made by the task itself, only the counts and
+ * progress callback are shared, under one lock.
+ */
+
+#include "multi.h"
+#include "pool.h"
+#include "codec.h"
+
+
+struct many {
+  int             total;
+  int             stopOnError;
+  MANYFUNC        progress;
+  void           *arg;
+  LOCK            lock;          /* protects below, progress called holding it */
+  int             done;
+  int             failed;
+  int             stop;          /* a job failed and stopOnError */
+  int             decthreads;    /* each job's decoder threads (tgz_decthreads) */
+};
+
+struct manytask {
+  struct many    *m;
+  struct tgz_job *job;
+};
+
+
+void tgz_job_init(struct tgz_job *job, const char *tarball, const TCHAR *dest)
+{
+  memset(job, 0, sizeof(*job));
+  job->tarball = tarball;
+  job->dest = dest;
+  job->cm = CM_AUTO;
+  job->keep = OVERWRITE;
+}
+
+
+/* copies next blank separated word of *opts to opt (truncated), returns 0 if none */
+static int nextopt(const char **opts, char *opt, unsigned size)
+{
+  const char *p = *opts;
+  unsigned len = 0;
+
+  while ((*p == ' ') || (*p == '\t')) p++;
+  while (*p && (*p != ' ') && (*p != '\t'))
+  {
+    if (len < size - 1) opt[len++] = *p;
+    p++;
+  }
+  opt[len] = '\0';
+  *opts = p;
+  return len != 0;
+}
+
+int tgz_job_options(struct tgz_job *job, const char *opts)
+{
+  char opt[16];
+  int ok = 1;
+
+  while (nextopt(&opts, opt, sizeof(opt)))
+  {
+    if (strcmp(opt, "-j") == 0) job->junkPaths = 1;
+    else if (strcmp(opt, "-h") == 0) job->failOnHardLinks = 1;
+    else if (strcmp(opt, "-l") == 0) job->dedup = 1;
+    else if (strcmp(opt, "-S") == 0) job->holes = 1;
+    else if (strcmp(opt, "-k") == 0) job->keep = SKIP;
+    else if (strcmp(opt, "-u") == 0) job->keep = UPDATE;
+    else if (strcmp(opt, "-c") == 0) job->keep = SYNC;
+    else if ((strcmp(opt, "-z") == 0) || (strcmp(opt, "-zgz") == 0)) job->cm = CM_GZ;
+    else if (strcmp(opt, "-znone") == 0) job->cm = CM_NONE;
+    else if (strcmp(opt, "-zlzma") == 0) job->cm = CM_LZMA;
+    else if (strcmp(opt, "-zxz") == 0) job->cm = CM_XZ;
+    else if (strcmp(opt, "-zzstd") == 0) job->cm = CM_ZSTD;
+    else if (strcmp(opt, "-zlz4") == 0) job->cm = CM_LZ4;
+    else if (strcmp(opt, "-zbz2") == 0) job->cm = CM_BZ2;
+    else if (strcmp(opt, "-zZ") == 0) job->cm = CM_Z;
+    else if (strcmp(opt, "-zauto") == 0) job->cm = CM_AUTO;
+    else if ((opt[0] == '-') && (opt[1] == 'p'))
+    {
+      const char *p;
+      job->parallel = 1;
+      for (job->writers = 0, p = opt + 2; (*p >= '0') && (*p <= '9'); p++)
+        job->writers = job->writers * 10 + (*p - '0');
+    }
+    else if (strcmp(opt, "-m") == 0)
+    {
+      const char *p;
+      if (!nextopt(&opts, opt, sizeof(opt)) || (*opt < '0') || (*opt > '9')) ok = 0;
+      for (job->memlimit = 0, p = opt; (*p >= '0') && (*p <= '9'); p++)
+        job->memlimit = job->memlimit * 10 + (*p - '0');
+    }
+    else if ((strcmp(opt, "-x") == 0) || (strcmp(opt, "-f") == 0)) ; /* ignored, as by extract */
+    else ok = 0;
+  }
+  return ok;
+}
+
+
+/* extracts one job, returns its result */
+static int run_job(struct tgz_job *job, int decthreads)
+{
+  int cm = job->cm;
+  gzFile in;
+  FSCTX *out;
+  TGZCTX *ctx;
+  int result;
+
+  if ((in = gzopen(job->tarball, "rb")) == NULL) return MANY_OPEN;
+  if (cm == CM_AUTO) cm = getFileType(in, job->tarball);
+  if (codec_find(cm) == NULL)
+  {
+    gzclose(in);
+    return MANY_UNSUPPORTED;
+  }
+  if ((out = fs_new(job->dest)) == NULL)
+  {
+    gzclose(in);
+    return MANY_BASEDIR;
+  }
+  if ((ctx = tgz_new(out)) == NULL)
+  {
+    gzclose(in);
+    return MANY_NOMEM;
+  }
+  if (job->memlimit) tgz_memlimit(ctx, job->memlimit);
+  tgz_decthreads(ctx, decthreads);
+  if (job->parallel)
+    result = tgz_extract_parallel(ctx, in, job->tarball, job->writers, cm, job->junkPaths, job->keep, 0, NULL, 0, NULL, job->failOnHardLinks, job->dedup, job->holes);
+  else
+    result = tgz_extract(ctx, in, cm, job->junkPaths, job->keep, 0, NULL, 0, NULL, job->failOnHardLinks, job->dedup, job->holes);
+  tgz_free(ctx);
+  return result;
+}
+
+static void many_task(struct pool *p, int worker, void *arg)
+{
+  struct manytask *t = (struct manytask *)arg;
+  struct many *m = t->m;
+  int skip;
+
+  lock_acquire(&m->lock);
+  skip = m->stop;
+  lock_release(&m->lock);
+
+  t->job->result = skip ? MANY_SKIPPED : run_job(t->job, m->decthreads);
+
+  lock_acquire(&m->lock);
+  m->done++;
+  if (t->job->result < 0)
+  {
+    m->failed++;
+    if (m->stopOnError) m->stop = 1;
+  }
+  if (m->progress != NULL) m->progress(t->job, m->done, m->total, m->arg);
+  lock_release(&m->lock);
+}
+
+
+int tgz_extract_many(struct tgz_job *jobs, int cnt, int nthreads, int stopOnError, MANYFUNC progress, void *arg)
+{
+  struct many m;
+  struct manytask *tasks;
+  struct pool *p = NULL;
+  int i;
+
+  if (cnt <= 0) return 0;
+  memset(&m, 0, sizeof(m));
+  m.total = cnt;
+  m.stopOnError = stopOnError;
+  m.progress = progress;
+  m.arg = arg;
+  lock_init(&m.lock);
+
+  if (nthreads <= 0) nthreads = thread_cpus();
+  if (nthreads > cnt) nthreads = cnt;
+  if ((tasks = (struct manytask *)malloc(cnt * sizeof(struct manytask))) != NULL)
+    p = pool_new(nthreads);
+  /* tarballs extracted at once share the processors among their decoders */
+  if ((p != NULL) && (nthreads > 1))
+    m.decthreads = (thread_cpus() > nthreads) ? thread_cpus() / nthreads : 1;
+
+  /* without a pool (or its memory) the jobs run here, one after another */
+  for (i = 0; i < cnt; i++)
+  {
+    struct manytask one;
+    struct manytask *t = (tasks != NULL) ? &tasks[i] : &one;
+
+    t->m = &m;
+    t->job = &jobs[i];
+    if ((p == NULL) || !pool_submit(p, -1, many_task, t))
+      many_task(NULL, 0, t);
+  }
+  pool_free(p);  /* waits for all jobs */
+
+  if (tasks != NULL) free(tasks);
+  lock_free(&m.lock);
+  return m.failed;
+}
@@ -0,0 +1,68 @@
+/*
+ * multi - extracting several tarballs at the same time
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * Each tarball is a job with its own options and base directory, run
+ * with its own extraction context (tgz_new) on a work-stealing pool
+ * (pool.c).  Used by the plugin's extractMany and untgzcli -M.
+ */
+
+#ifndef _MULTI_H_
+#define _MULTI_H_
+
+#include "untar.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* job results besides those of tgz_extract */
+#define MANY_OPEN        -4   /* unable to open tarball */
+#define MANY_BASEDIR     -5   /* unable to create or use base directory */
+#define MANY_UNSUPPORTED -6   /* compression method not supported */
+#define MANY_NOMEM       -7   /* out of memory */
+#define MANY_SKIPPED     -8   /* not started, an earlier job failed (stopOnError) */
+
+/* one tarball to extract, as extract [options] [-d dest] tarball */
+struct tgz_job {
+  const char   *tarball;
+  const TCHAR  *dest;            /* base directory, NULL for current */
+  int           cm;              /* CM_*, CM_AUTO to guess from contents */
+  int           junkPaths;
+  enum KeepMode keep;
+  int           failOnHardLinks;
+  int           dedup;
+  int           holes;
+  int           parallel;        /* tgz_extract_parallel with writers threads */
+  int           writers;
+  unsigned long memlimit;        /* MB, 0 for none (tgz_memlimit) */
+  int           result;          /* once run, tgz_extract result or MANY_* */
+};
+
+/* called as each job finishes, done of total jobs finished so far; calls
+   are one at a time but from the pool's threads */
+typedef void (*MANYFUNC)(struct tgz_job *job, int done, int total, void *arg);
+
+/* sets up job with default options (as extract without any) */
+void tgz_job_init(struct tgz_job *job, const char *tarball, const TCHAR *dest);
+
+/* applies blank separated options (-p[n] -m MB -j -h -l -S -k -u -c -z<type>) to job,
+   returns 0 if any not recognized (those are ignored) */
+int tgz_job_options(struct tgz_job *job, const char *opts);
+
+/* runs the cnt jobs, started in order, on nthreads threads (one per processor if 0, never
+   more than jobs), with the processors shared among the decoder threads
+   of jobs run at once (tgz_decthreads), calling progress (if not NULL)
+   as each finishes; if stopOnError, jobs not yet started when one
+   fails are skipped;
+   returns number of jobs that failed (or were skipped) */
+int tgz_extract_many(struct tgz_job *jobs, int cnt, int nthreads, int stopOnError, MANYFUNC progress, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MULTI_H_ */
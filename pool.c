@@ -0,0 +1,235 @@
+/*
+ * pool - work-stealing thread pool
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * Queues are rings guarded by their own lock (tasks here are whole
+ * archives or files, so a lock per take costs nothing next to the task).
+ * The work semaphore is posted once per queued task, so a worker woken
+ * by it is sure to find one, in its own queue, the shared one or by
+ * stealing.
+ */
+
+#include "pool.h"
+
+
+struct task {
+  POOLFUNC fn;
+  void    *arg;
+};
+
+struct queue {
+  LOCK         lock;
+  struct task *t;
+  unsigned     size;            /* power of 2 */
+  unsigned     head, tail;      /* oldest task, next free slot */
+};
+
+struct worker {
+  struct pool *p;
+  int          index;
+};
+
+struct pool {
+  int           nworkers;
+  int           stop;           /* workers return once no task found */
+  struct queue  shared;         /* tasks submitted from outside, oldest first */
+  LOCK          lock;           /* protects pending and waiting */
+  int           pending;        /* tasks submitted and not yet finished */
+  int           waiting;        /* pool_wait blocked on done */
+  SEMA          work;           /* posted once per queued task */
+  SEMA          done;
+  THREAD        threads[POOL_MAXWORKERS];
+  struct worker workers[POOL_MAXWORKERS];
+  struct queue  q[POOL_MAXWORKERS];
+};
+
+
+/* adds task at tail, returns 0 if out of memory */
+static int push(struct queue *q, POOLFUNC fn, void *arg)
+{
+  lock_acquire(&q->lock);
+  if (q->tail - q->head == q->size)
+  {
+    unsigned newsize = q->size ? q->size * 2 : 16, i;
+    struct task *t = (struct task *)malloc(newsize * sizeof(struct task));
+    if (t == NULL)
+    {
+      lock_release(&q->lock);
+      return 0;
+    }
+    for (i = 0; i < q->tail - q->head; i++)
+      t[i] = q->t[(q->head + i) & (q->size - 1)];
+    if (q->t != NULL) free(q->t);
+    q->t = t;
+    q->tail -= q->head;
+    q->head = 0;
+    q->size = newsize;
+  }
+  q->t[q->tail & (q->size - 1)].fn = fn;
+  q->t[q->tail & (q->size - 1)].arg = arg;
+  q->tail++;
+  lock_release(&q->lock);
+  return 1;
+}
+
+/* takes newest (own queue) or oldest (shared queue, stealing) task, returns 0 if empty */
+static int take(struct queue *q, int newest, struct task *t)
+{
+  int found = 0;
+
+  lock_acquire(&q->lock);
+  if (q->tail != q->head)
+  {
+    *t = newest ? q->t[--q->tail & (q->size - 1)] : q->t[q->head++ & (q->size - 1)];
+    found = 1;
+  }
+  lock_release(&q->lock);
+  return found;
+}
+
+
+static THREAD_PROC(pool_worker)
+{
+  struct worker *w = (struct worker *)arg;
+  struct pool *p = w->p;
+
+  while (1)
+  {
+    struct task t;
+    int found = 0, i;
+
+    sema_wait(&p->work);
+    while (!found && !p->stop)
+    {
+      found = take(&p->q[w->index], 1, &t) || take(&p->shared, 0, &t);
+      for (i = 1; !found && (i < p->nworkers); i++)
+        found = take(&p->q[(w->index + i) % p->nworkers], 0, &t);
+    }
+    if (!found) break;   /* stopping */
+
+    t.fn(p, w->index, t.arg);
+
+    lock_acquire(&p->lock);
+    if ((--p->pending == 0) && p->waiting)
+    {
+      p->waiting = 0;
+      sema_post(&p->done, 1);
+    }
+    lock_release(&p->lock);
+  }
+  THREAD_RETURN;
+}
+
+
+struct pool *pool_new(int nworkers)
+{
+  struct pool *p = (struct pool *)calloc(1, sizeof(struct pool));
+  int i;
+
+  if (p == NULL) return NULL;
+  if (nworkers <= 0) nworkers = thread_cpus();
+  if (nworkers > POOL_MAXWORKERS) nworkers = POOL_MAXWORKERS;
+
+  if (!sema_init(&p->work, 0))
+  {
+    free(p);
+    return NULL;
+  }
+  if (!sema_init(&p->done, 0))
+  {
+    sema_free(&p->work);
+    free(p);
+    return NULL;
+  }
+  lock_init(&p->lock);
+  lock_init(&p->shared.lock);
+  for (i = 0; i < nworkers; i++) lock_init(&p->q[i].lock);
+
+  p->nworkers = nworkers;
+  for (i = 0; i < nworkers; i++)
+  {
+    p->workers[i].p = p;
+    p->workers[i].index = i;
+    if (!thread_start(&p->threads[i], pool_worker, &p->workers[i])) break;
+  }
+
+  /* fewer started, none has a task yet so safe to shrink */
+  for (; nworkers > i; nworkers--) lock_free(&p->q[nworkers - 1].lock);
+  p->nworkers = nworkers;
+  if (nworkers == 0)
+  {
+    lock_free(&p->shared.lock);
+    lock_free(&p->lock);
+    sema_free(&p->done);
+    sema_free(&p->work);
+    free(p);
+    return NULL;
+  }
+  return p;
+}
+
+
+int pool_size(struct pool *p)
+{
+  return p->nworkers;
+}
+
+
+int pool_submit(struct pool *p, int worker, POOLFUNC fn, void *arg)
+{
+  lock_acquire(&p->lock);
+  p->pending++;
+  lock_release(&p->lock);
+
+  if (!push((worker < 0) ? &p->shared : &p->q[worker], fn, arg))
+  {
+    lock_acquire(&p->lock);
+    p->pending--;
+    lock_release(&p->lock);
+    return 0;
+  }
+  sema_post(&p->work, 1);
+  return 1;
+}
+
+
+void pool_wait(struct pool *p)
+{
+  int busy;
+
+  lock_acquire(&p->lock);
+  busy = (p->pending > 0);
+  if (busy) p->waiting = 1;
+  lock_release(&p->lock);
+  if (busy) sema_wait(&p->done);
+}
+
+
+void pool_free(struct pool *p)
+{
+  int i;
+
+  if (p == NULL) return;
+  pool_wait(p);
+
+  /* each worker wakes, finds no task and returns */
+  p->stop = 1;
+  sema_post(&p->work, p->nworkers);
+  for (i = 0; i < p->nworkers; i++)
+    thread_wait(p->threads[i]);
+
+  for (i = 0; i < p->nworkers; i++)
+  {
+    if (p->q[i].t != NULL) free(p->q[i].t);
+    lock_free(&p->q[i].lock);
+  }
+  if (p->shared.t != NULL) free(p->shared.t);
+  lock_free(&p->shared.lock);
+  lock_free(&p->lock);
+  sema_free(&p->done);
+  sema_free(&p->work);
+  free(p);
+}
@@ -0,0 +1,56 @@
+/*
+ * pool - work-stealing thread pool
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * Tasks submitted from outside the pool go to a shared queue that is
+ * taken from oldest first, so they start in the order submitted.  Tasks
+ * may submit further tasks, which go to the submitting worker's own
+ * queue.  A worker takes the newest task from its own queue, then the
+ * oldest from the shared queue and, once both are empty, the oldest from
+ * another's, so long tasks given to one worker don't leave the others
+ * idle.
+ * Only uses threads.h, so runs on Win95/NT4 as well as POSIX.
+ */
+
+#ifndef _POOL_H_
+#define _POOL_H_
+
+#include "threads.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define POOL_MAXWORKERS 64
+
+struct pool;
+
+/* task, worker is the index of the worker running it (for pool_submit) */
+typedef void (*POOLFUNC)(struct pool *p, int worker, void *arg);
+
+/* starts pool of nworkers threads (thread_cpus() if 0, at most
+   POOL_MAXWORKERS), NULL if unable to start any */
+struct pool *pool_new(int nworkers);
+
+/* number of workers actually started */
+int pool_size(struct pool *p);
+
+/* queues fn(arg) on worker's queue, or on the shared queue if worker is
+   -1 (submitting from outside the pool); returns 0 if out of memory */
+int pool_submit(struct pool *p, int worker, POOLFUNC fn, void *arg);
+
+/* waits until all submitted tasks (and any they submitted) have run,
+   must not be called from a task */
+void pool_wait(struct pool *p);
+
+/* waits for tasks (pool_wait), stops workers and frees pool */
+void pool_free(struct pool *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _POOL_H_ */
@@ -0,0 +1,621 @@
+/*
+ * tar header and member name helpers used by tgz_extract,
+ * kept apart from the extraction logic (and its Win32 calls)
+ * so they can be reused or timed by themselves.
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * based on untgz.c from zlib
+ * written by "Pedro A. Aranda Guti\irrez" <paag@tid.es>
+ * adaptation to Unix by Jean-loup Gailly <jloup@gzip.org>
+ */
+
+
+#include "untar.h"
+
+/* vector versions of the per header and zero block kernels, chosen when
+   compiling (the x86 plugin must run on processors without SSE2 unless
+   built with /arch:SSE2, x64 and ARM64 always have them) */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define TAR_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define TAR_NEON
+#endif
+
+
+/* help functions */
+
+/* NOTE: FSSIZE arithmetic here and in the engine sticks to shifts, adds
+   and compares, 64 bit multiply/divide on x86 would need CRT helpers */
+
+FSSIZE getoct(char *p,int width)
+{
+  FSSIZE result = 0;
+  char c;
+
+  if (*p & 0x80)  /* base-256, sign in bit 6 of first byte */
+  {
+    result = (*p & 0x40) ? ~(FSSIZE)0 : 0;
+    result = (result << 6) | (*p & 0x3F);
+    while (--width)
+      result = (result << 8) | (unsigned char)*++p;
+    return result;
+  }
+  
+  while (width --)
+    {
+      c = *p++;
+      if (c == ' ') /* ignore padding */
+        continue;
+      if (c == 0)   /* ignore padding, but also marks end of string */
+        break;
+      if (c < '0' || c > '7')
+        return result; /* really an error, but we just ignore invalid values */
+      result = (result << 3) + (c - '0');
+    }
+  return result;
+}
+
+/* regular expression matching */
+
+#define ISSPECIAL(c) (((c) == '*') || ((c) == '/'))
+
+int ExprMatch(char *string,char *expr)
+{
+  while (1)
+    {
+      if (ISSPECIAL(*expr))
+	{
+	  if (*expr == '/')
+	    {
+	      if (*string != '\\' && *string != '/')
+		return 0;
+	      string ++; expr++;
+	    }
+	  else if (*expr == '*')
+	    {
+	      if (*expr ++ == 0)
+		return 1;
+	      while (*++string != *expr)
+		if (*string == 0)
+		  return 0;
+	    }
+	}
+      else
+	{
+	  if (*string != *expr)
+	    return 0;
+	  if (*expr++ == 0)
+	    return 1;
+	  string++;
+	}
+    }
+}
+
+
+/* returns 0 on failed checksum, nonzero if probably ok 
+   it was noted that some versions of tar compute
+   signed chksums, though unsigned appears to be the
+   standard; chksum is simple sum of all bytes in header
+   as integers (using at least 17 bits) with chksum
+   values treated as ASCII spaces.
+*/
+int valid_checksum(struct tar_header *header)
+{
+  unsigned hdrchksum = (unsigned)getoct(header->chksum,8);
+  signed schksum = 0;
+  unsigned uchksum = 0;
+  int i;
+
+  for (i=0; i < sizeof(struct tar_header); i++)
+  {
+    unsigned char val = ((unsigned char *)header)[i];
+    if ((i >= 148) && (i < 156)) /* chksum */
+    {
+      val = ' ';
+    }
+    schksum += (signed char)val;
+    uchksum += val;
+  }
+
+  if (hdrchksum == uchksum) return 1;
+  if ((int)hdrchksum == schksum) return 2;
+  return 0;
+}
+
+
+/* one pass header kernel
+ *
+ * The block is read 16 bytes at a time, summing (unsigned) bytes and
+ * bytes with the high bit set, so the signed sum is the unsigned one
+ * less 256 for each, and or'ing them for the zero check.  Numeric
+ * fields are decoded from a 16 byte window: a digits mask gives the
+ * run of octal digits (the field may be padded with spaces before or
+ * after it, ends at the first other character), those digits are
+ * packed 3 bits each by shifts and adds of widening lanes into a 48 bit
+ * value, which shifted down by the digits missing after the run gives
+ * the field.  Anything else (base-256, spaces between digits) is left
+ * to getoct.  Windows stay within the block: mtime at 136 + 16, the
+ * checksum at 148 + 16.
+ */
+
+#define CHKSUM_OFF 148
+
+#if defined(TAR_SSE2) || defined(TAR_NEON)
+
+/* bits set in a 16 bit mask */
+static unsigned ones16(unsigned m)
+{
+  m = m - ((m >> 1) & 0x5555);
+  m = (m & 0x3333) + ((m >> 2) & 0x3333);
+  m = (m + (m >> 4)) & 0x0F0F;
+  return (m + (m >> 8)) & 0x1F;
+}
+
+/* given the masks of octal digit and space bytes of the window at p,
+   returns the end of the run of digits to decode (0 if none), or -1 if
+   only getoct can decode it */
+static int octrun(const char *p, int width, unsigned digits, unsigned spaces)
+{
+  unsigned stop = ~(digits | spaces) | (0xFFFFu << width);
+  unsigned end = ones16(((stop & (0u - stop)) - 1) & 0xFFFF);  /* first stop */
+  unsigned d = digits & ((1u << end) - 1);
+
+  if (*p & 0x80) return -1;                 /* base-256 */
+  if (d == 0) return 0;
+  if ((d + (d & (0u - d))) & d) return -1;  /* spaces between digits */
+  return (int)ones16((d + (d & (0u - d)) - 1) & 0xFFFF);
+}
+
+#endif
+
+#ifdef TAR_SSE2
+
+/* 16 octal digits (0..7 per byte, first most significant) packed */
+static FSSIZE octpack(__m128i d)
+{
+  __m128i t;
+  t = _mm_add_epi16(_mm_slli_epi16(_mm_and_si128(d, _mm_set1_epi16(0xFF)), 3), _mm_srli_epi16(d, 8));
+  t = _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(t, _mm_set1_epi32(0xFFFF)), 6), _mm_srli_epi32(t, 16));
+  t = _mm_add_epi64(_mm_slli_epi64(_mm_and_si128(t, _mm_set_epi32(0, -1, 0, -1)), 12), _mm_srli_epi64(t, 32));
+  return ((FSSIZE)(unsigned)_mm_cvtsi128_si32(t) << 24) | (unsigned)_mm_cvtsi128_si32(_mm_srli_si128(t, 8));
+}
+
+static FSSIZE getoct16(const char *p, int width)
+{
+  __m128i x = _mm_loadu_si128((const __m128i *)p);
+  __m128i d = _mm_sub_epi8(x, _mm_set1_epi8('0'));
+  __m128i isdigit = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(7)), d);
+  int last = octrun(p, width, _mm_movemask_epi8(isdigit), _mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8(' '))));
+  __m128i keep;
+
+  if (last <= 0) return last ? getoct((char *)p, width) : 0;
+  keep = _mm_cmplt_epi8(_mm_setr_epi8(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15), _mm_set1_epi8((char)last));
+  return octpack(_mm_and_si128(d, _mm_and_si128(isdigit, keep))) >> (3 * (16 - last));
+}
+
+/* unsigned and signed sums of the block, nonzero zero if all zero */
+static void blocksums(const char *p, unsigned *u, int *s, int *zero)
+{
+  const __m128i z = _mm_setzero_si128();
+  __m128i usum = z, nhigh = z, any = z;
+  int i;
+
+  for (i = 0; i < BLOCKSIZE; i += 16)
+  {
+    __m128i x = _mm_loadu_si128((const __m128i *)(p + i));
+    usum = _mm_add_epi64(usum, _mm_sad_epu8(x, z));
+    nhigh = _mm_add_epi64(nhigh, _mm_sad_epu8(_mm_and_si128(_mm_cmplt_epi8(x, z), _mm_set1_epi8(1)), z));
+    any = _mm_or_si128(any, x);
+  }
+  *u = (unsigned)_mm_cvtsi128_si32(usum) + (unsigned)_mm_cvtsi128_si32(_mm_srli_si128(usum, 8));
+  *s = (int)*u - 256 * (_mm_cvtsi128_si32(nhigh) + _mm_cvtsi128_si32(_mm_srli_si128(nhigh, 8)));
+  *zero = (_mm_movemask_epi8(_mm_cmpeq_epi8(any, z)) == 0xFFFF);
+}
+
+#elif defined(TAR_NEON)
+
+static const unsigned char bitweight[16] = { 1,2,4,8,16,32,64,128, 1,2,4,8,16,32,64,128 };
+static const unsigned char byteindex[16] = { 0,1,2,3,4,5,6,7, 8,9,10,11,12,13,14,15 };
+
+/* as _mm_movemask_epi8, for bytes 0 or 0xFF */
+static unsigned movemask(uint8x16_t m)
+{
+  uint8x8_t t;
+  m = vandq_u8(m, vld1q_u8(bitweight));
+  t = vpadd_u8(vget_low_u8(m), vget_high_u8(m));
+  t = vpadd_u8(t, t);
+  t = vpadd_u8(t, t);
+  return vget_lane_u8(t, 0) | ((unsigned)vget_lane_u8(t, 1) << 8);
+}
+
+/* 16 octal digits (0..7 per byte, first most significant) packed */
+static FSSIZE octpack(uint8x16_t d)
+{
+  uint16x8_t t16 = vreinterpretq_u16_u8(d);
+  uint32x4_t t32;
+  uint64x2_t t64;
+  t16 = vaddq_u16(vshlq_n_u16(vandq_u16(t16, vdupq_n_u16(0xFF)), 3), vshrq_n_u16(t16, 8));
+  t32 = vreinterpretq_u32_u16(t16);
+  t32 = vaddq_u32(vshlq_n_u32(vandq_u32(t32, vdupq_n_u32(0xFFFF)), 6), vshrq_n_u32(t32, 16));
+  t64 = vreinterpretq_u64_u32(t32);
+  t64 = vaddq_u64(vshlq_n_u64(vandq_u64(t64, vdupq_n_u64(0xFFFFFFFF)), 12), vshrq_n_u64(t64, 32));
+  return ((FSSIZE)vgetq_lane_u64(t64, 0) << 24) | (FSSIZE)vgetq_lane_u64(t64, 1);
+}
+
+static FSSIZE getoct16(const char *p, int width)
+{
+  uint8x16_t x = vld1q_u8((const unsigned char *)p);
+  uint8x16_t d = vsubq_u8(x, vdupq_n_u8('0'));
+  uint8x16_t isdigit = vcleq_u8(d, vdupq_n_u8(7));
+  int last = octrun(p, width, movemask(isdigit), movemask(vceqq_u8(x, vdupq_n_u8(' '))));
+  uint8x16_t keep;
+
+  if (last <= 0) return last ? getoct((char *)p, width) : 0;
+  keep = vcltq_u8(vld1q_u8(byteindex), vdupq_n_u8((unsigned char)last));
+  return octpack(vandq_u8(d, vandq_u8(isdigit, keep))) >> (3 * (16 - last));
+}
+
+/* unsigned and signed sums of the block, nonzero zero if all zero */
+static void blocksums(const char *p, unsigned *u, int *s, int *zero)
+{
+  uint16x8_t usum = vdupq_n_u16(0), nhigh = vdupq_n_u16(0);
+  uint8x16_t any = vdupq_n_u8(0);
+  uint64x2_t t;
+  int i;
+
+  /* each 16 bit lane adds 32 pairs of bytes, at most 32 * 510 */
+  for (i = 0; i < BLOCKSIZE; i += 16)
+  {
+    uint8x16_t x = vld1q_u8((const unsigned char *)p + i);
+    usum = vaddq_u16(usum, vpaddlq_u8(x));
+    nhigh = vaddq_u16(nhigh, vpaddlq_u8(vshrq_n_u8(x, 7)));
+    any = vorrq_u8(any, x);
+  }
+  t = vpaddlq_u32(vpaddlq_u16(usum));
+  *u = (unsigned)(vgetq_lane_u64(t, 0) + vgetq_lane_u64(t, 1));
+  t = vpaddlq_u32(vpaddlq_u16(nhigh));
+  *s = (int)*u - 256 * (int)(vgetq_lane_u64(t, 0) + vgetq_lane_u64(t, 1));
+  t = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(any)));
+  *zero = ((vgetq_lane_u64(t, 0) | vgetq_lane_u64(t, 1)) == 0);
+}
+
+#else
+
+#define getoct16(p, width) getoct((char *)(p), width)
+
+static void blocksums(const char *p, unsigned *u, int *s, int *zero)
+{
+  unsigned any = 0;
+  int i;
+
+  for (*u = 0, *s = 0, i = 0; i < BLOCKSIZE; i++)
+  {
+    *u += (unsigned char)p[i];
+    *s += (signed char)p[i];
+    any |= (unsigned char)p[i];
+  }
+  *zero = (any == 0);
+}
+
+#endif
+
+int tar_decode(const union tar_buffer *b, struct tar_fields *f)
+{
+  unsigned u;
+  int s, i;
+
+  blocksums(b->buffer, &u, &s, &f->zero);
+  f->size = getoct16(b->header.size, 12);
+  f->mtime = getoct16(b->header.mtime, 12);
+  f->chksum = (unsigned)getoct16(b->header.chksum, 8);
+
+  /* checksum field counts as spaces */
+  for (i = CHKSUM_OFF; i < CHKSUM_OFF + 8; i++)
+  {
+    u -= (unsigned char)b->buffer[i];
+    s -= (signed char)b->buffer[i];
+  }
+  u += 8 * ' ';
+  s += 8 * ' ';
+
+  if (f->chksum == u) return 1;
+  if ((int)f->chksum == s) return 2;
+  return 0;
+}
+
+
+/* NOTE: This should be modified to perform whatever steps
+   deemed necessary to make embedded paths safe prior to
+   creating directory or file of given [path]filename.
+   Must modify fname in place, always leaving either
+   same or smaller strlen than current string.
+   Current version (if not #defined out) removes any
+   leading parent (..) or root (/)(\) references.
+*/
+void safetyStrip(char * fname)
+{
+#if 0
+  /* strip root from path */
+  if ((*fname == '/') || (*fname == '\\'))
+  {
+    MoveMemory(fname, fname+1, strlen(fname+1) + 1 );
+  }
+
+  /* now strip leading ../ */
+  while ((*fname == '.') && (*(fname+1) == '.') && ((*(fname+2) == '/') || (*(fname+2) == '\\')) )
+  {
+    MoveMemory(fname, fname+3, strlen(fname+3) + 1 );
+  }
+#endif
+}
+
+
+/* combines elements from tar header to produce
+ * full [long] filename; prefix + [/] + name
+ */
+void getFullName(union tar_buffer *buffer, char *fname)
+{
+	int len = 0;
+
+	/* NOTE: prepend buffer.head.prefix if tar archive expected to have it */
+	if (*(buffer->header.prefix) && (*(buffer->header.prefix) != ' '))
+	{
+		/* copy over prefix, all of field may be used (no terminator) */
+		memcpy(fname,buffer->header.prefix, sizeof(buffer->header.prefix));
+		fname[sizeof(buffer->header.prefix)] = '\0';
+		/* ensure ends in dir separator, implied after if full prefix size used */
+		len = strlen(fname)-1; /* assumed by test above at least 1 character */
+		if ((fname[len]!='/') && (fname[len]!='\\'))
+		{
+			len++;
+			fname[len]='/';
+		}
+		len++; /* index of 1st character after dir separator */
+	}
+
+	/* copy over filename portion, again may fill whole field */
+	memcpy(fname+len,buffer->header.name, sizeof(buffer->header.name));
+	fname[len+sizeof(buffer->header.name)] = '\0'; /* ensure terminated */
+}
+
+
+/* returns a pointer into fname past all
+ * but the last path_sep_cnt path separators
+ * if there are less than path_sep_cnt
+ * separators then all will still be there.
+ */
+char * stripPath(int path_sep_cnt, char *fname)
+{
+  char *fname_use = fname + strlen(fname);
+  register int i=path_sep_cnt;
+  do
+  {
+    if ( (*fname_use == '/') || (*fname_use == '\\') ) 
+	{ 
+      i--;
+	  if (i < 0) fname_use++;
+	  else fname_use--;
+    }
+	else
+      fname_use--;
+  } while ((i >= 0) && (fname_use > fname));
+  
+  return fname_use;
+}
+
+/* returns 1 if fname in list else return 0 
+ * returns 0 if list is NULL or cnt is < 0
+ */
+int matchname (char *fname, int cnt, char *list[], int junkPaths)
+{
+  register char *t;
+  int i;
+  int path_sep;
+
+  /* if nothing to compare with then return failure */
+  if ((list == NULL) || (cnt <= 0))
+    return 0;
+
+  for (i = 0; i < cnt; i++)
+  {
+    /* get count of path components in current filelist entry */
+    path_sep = 0;
+    if (!junkPaths)
+	{
+      for(t = list[i]; *t != '\0'; t++)
+        if ((*t == '/') || (*t == '\\'))
+          path_sep++;
+	}
+    if (ExprMatch(stripPath(path_sep, fname), list[i]))
+      return 1;
+  }
+
+  return 0; /* no match */
+}
+
+
+/* returns nonzero if len bytes at p are all zero
+ * checks 64 bytes at a time so data blocks (usually nonzero
+ * near the start) are rejected after the first compare
+ */
+int zeroblock(const char *p, unsigned len)
+{
+#ifdef TAR_SSE2
+  const __m128i zero = _mm_setzero_si128();
+
+  for (; len >= 64; len -= 64, p += 64)
+  {
+    __m128i v = _mm_or_si128(_mm_or_si128(_mm_loadu_si128((const __m128i *)p), _mm_loadu_si128((const __m128i *)(p+16))),
+                             _mm_or_si128(_mm_loadu_si128((const __m128i *)(p+32)), _mm_loadu_si128((const __m128i *)(p+48))));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) != 0xFFFF) return 0;
+  }
+#else
+  /* word at a time, assumes block buffers are word aligned */
+  for (; len >= 8 * sizeof(unsigned long); len -= 8 * sizeof(unsigned long), p += 8 * sizeof(unsigned long))
+  {
+    const unsigned long *w = (const unsigned long *)p;
+    if (w[0] | w[1] | w[2] | w[3] | w[4] | w[5] | w[6] | w[7]) return 0;
+  }
+#endif
+  while (len--)
+    if (*p++) return 0;
+  return 1;
+}
+
+
+/* sparse members */
+
+int sparse_add(struct sparse_map *map, FSSIZE offset, FSSIZE size)
+{
+  if (map->cnt == map->alloc)
+  {
+    unsigned n = map->alloc ? map->alloc * 2 : 16;
+    struct sparse_chunk *c = (struct sparse_chunk *)realloc(map->chunk, n * sizeof(struct sparse_chunk));
+    if (c == NULL) return 0;
+    map->chunk = c;
+    map->alloc = n;
+  }
+  map->chunk[map->cnt].offset = offset;
+  map->chunk[map->cnt].size = size;
+  map->cnt++;
+  return 1;
+}
+
+int sparse_gnu(struct sparse_map *map, char *p, int cnt)
+{
+  for (; (cnt > 0) && *p; cnt--, p += 24)  /* unused entries are empty */
+    if (!sparse_add(map, getoct(p, 12), getoct(p + 12, 12))) return 0;
+  return 1;
+}
+
+/* decimal number at *p, advances *p past it */
+static FSSIZE getdec(char **p)
+{
+  FSSIZE result = 0;
+  while ((**p >= '0') && (**p <= '9'))
+    result = (result << 3) + (result << 1) + (*(*p)++ - '0');
+  return result;
+}
+
+long sparse_pax1(struct sparse_map *map, char *data, unsigned long len)
+{
+  char *p = data, *end = data + len;
+  FSSIZE cnt = 0, i, v[2];
+  int j;
+
+  map->cnt = 0;
+  for (i = 0; (i == 0) || (i <= cnt); i++)
+  {
+    for (j = 0; j < ((i == 0) ? 1 : 2); j++)
+    {
+      char *start = p;
+      while ((p < end) && (*p >= '0') && (*p <= '9')) p++;
+      if (p >= end) return 0;  /* number not complete yet */
+      if ((*p != '\n') || (p == start)) return -1;
+      p = start;
+      v[j] = getdec(&p);
+      p++;
+    }
+    if (i == 0)
+      cnt = v[0];
+    else if (!sparse_add(map, v[0], v[1]))
+      return -1;
+  }
+  return (long)(((p - data) + BLOCKSIZE - 1) / BLOCKSIZE * BLOCKSIZE);
+}
+
+int sparse_valid(struct sparse_map *map)
+{
+  FSSIZE end = 0;
+  unsigned i;
+
+  for (i = 0; i < map->cnt; i++)
+  {
+    struct sparse_chunk *c = &map->chunk[i];
+    if ((c->offset < end) || (c->offset > map->realsize) || (c->size > map->realsize - c->offset))
+      return 0;
+    end = c->offset + c->size;
+  }
+  return 1;
+}
+
+
+/* pax extended headers, records are "<length> <key>=<value>\n" */
+
+static void pax_value(struct pax_info *pax, char *key, char *value, FSSIZE *offset)
+{
+  char *p = value;
+
+  if (strcmp(key, "path") == 0)
+    pax->path = value;
+  else if (strcmp(key, "linkpath") == 0)
+    pax->linkpath = value;
+  else if (strcmp(key, "size") == 0)
+  {
+    pax->size = getdec(&p);
+    pax->have |= PAX_SIZE;
+  }
+  else if (strcmp(key, "mtime") == 0)  /* seconds[.fraction], fraction ignored */
+  {
+    /* times before 1970 are not representable on Win32, use the epoch */
+    pax->mtime = (*p == '-') ? 0 : (time_t)getdec(&p);
+    pax->have |= PAX_MTIME;
+  }
+  else if (strcmp(key, "GNU.sparse.major") == 0)
+  {
+    if (getdec(&p) == 1) pax->sparse = PAX_SPARSE_1;
+  }
+  else if (strcmp(key, "GNU.sparse.name") == 0)
+    pax->name = value;
+  else if ((strcmp(key, "GNU.sparse.realsize") == 0) || (strcmp(key, "GNU.sparse.size") == 0))
+  {
+    pax->map.realsize = getdec(&p);
+    if (pax->sparse == PAX_SPARSE_NONE) pax->sparse = PAX_SPARSE_0;
+  }
+  else if (strcmp(key, "GNU.sparse.offset") == 0)  /* 0.0, followed by numbytes */
+    *offset = getdec(&p);
+  else if (strcmp(key, "GNU.sparse.numbytes") == 0)
+  {
+    if (!sparse_add(&pax->map, *offset, getdec(&p))) pax->sparse = -1;
+  }
+  else if (strcmp(key, "GNU.sparse.map") == 0)     /* 0.1, offset,size,... */
+  {
+    while (*p)
+    {
+      FSSIZE o = getdec(&p);
+      if (*p++ != ',') break;
+      if (!sparse_add(&pax->map, o, getdec(&p))) pax->sparse = -1;
+      if (*p == ',') p++;
+    }
+  }
+  /* anything else is ignored */
+}
+
+int pax_parse(char *data, unsigned long len, struct pax_info *pax)
+{
+  char *end = data + len;
+  FSSIZE offset = 0;
+
+  while ((data < end) && *data)
+  {
+    char *p = data, *key;
+    unsigned long reclen = (unsigned long)getdec(&p);
+
+    if ((*p != ' ') || (reclen <= (unsigned long)(p - data) + 1) || (reclen > (unsigned long)(end - data)) ||
+        (data[reclen-1] != '\n'))
+      return 0;
+    data[reclen-1] = '\0';
+    key = ++p;
+    while (*p && (*p != '=')) p++;
+    if (*p != '=') return 0;
+    *p++ = '\0';
+    pax_value(pax, key, p, &offset);
+    data += reclen;
+  }
+  return pax->sparse >= 0;
+}
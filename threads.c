@@ -0,0 +1,117 @@
+/*
+ * threads - minimal thread, lock and semaphore wrappers
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ */
+
+#ifndef _WIN32
+#define _GNU_SOURCE 1
+#endif
+#include "threads.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+
+int thread_start(THREAD *t, THREADFUNC fn, void *arg)
+{
+  DWORD id;  /* Win9x requires pointer for thread id */
+  *t = CreateThread(NULL, 0, fn, arg, 0, &id);
+  return (*t != NULL);
+}
+
+void thread_wait(THREAD t)
+{
+  WaitForSingleObject(t, INFINITE);
+  CloseHandle(t);
+}
+
+int thread_cpus(void)
+{
+  SYSTEM_INFO si;
+  GetSystemInfo(&si);
+  return (si.dwNumberOfProcessors > 0) ? (int)si.dwNumberOfProcessors : 1;
+}
+
+void lock_init(LOCK *l)    { InitializeCriticalSection(l); }
+void lock_free(LOCK *l)    { DeleteCriticalSection(l); }
+void lock_acquire(LOCK *l) { EnterCriticalSection(l); }
+void lock_release(LOCK *l) { LeaveCriticalSection(l); }
+
+int sema_init(SEMA *s, unsigned count)
+{
+  *s = CreateSemaphore(NULL, count, 0x7FFFFFFF, NULL);
+  return (*s != NULL);
+}
+
+void sema_free(SEMA *s) { CloseHandle(*s); }
+void sema_wait(SEMA *s) { WaitForSingleObject(*s, INFINITE); }
+void sema_post(SEMA *s, unsigned n) { ReleaseSemaphore(*s, n, NULL); }
+
+#else /* POSIX threads */
+
+int thread_start(THREAD *t, THREADFUNC fn, void *arg)
+{
+  return pthread_create(t, NULL, fn, arg) == 0;
+}
+
+void thread_wait(THREAD t)
+{
+  pthread_join(t, NULL);
+}
+
+int thread_cpus(void)
+{
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return (n > 0) ? (int)n : 1;
+}
+
+void lock_init(LOCK *l)    { pthread_mutex_init(l, NULL); }
+void lock_free(LOCK *l)    { pthread_mutex_destroy(l); }
+void lock_acquire(LOCK *l) { pthread_mutex_lock(l); }
+void lock_release(LOCK *l) { pthread_mutex_unlock(l); }
+
+int sema_init(SEMA *s, unsigned count)
+{
+  s->count = count;
+  if (pthread_mutex_init(&s->m, NULL) != 0) return 0;
+  if (pthread_cond_init(&s->c, NULL) != 0)
+  {
+    pthread_mutex_destroy(&s->m);
+    return 0;
+  }
+  return 1;
+}
+
+void sema_free(SEMA *s)
+{
+  pthread_cond_destroy(&s->c);
+  pthread_mutex_destroy(&s->m);
+}
+
+void sema_wait(SEMA *s)
+{
+  pthread_mutex_lock(&s->m);
+  while (s->count == 0)
+    pthread_cond_wait(&s->c, &s->m);
+  s->count--;
+  pthread_mutex_unlock(&s->m);
+}
+
+void sema_post(SEMA *s, unsigned n)
+{
+  pthread_mutex_lock(&s->m);
+  s->count += n;
+  if (n == 1)
+    pthread_cond_signal(&s->c);
+  else
+    pthread_cond_broadcast(&s->c);
+  pthread_mutex_unlock(&s->m);
+}
+
+#endif
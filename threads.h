@@ -0,0 +1,66 @@
+/*
+ * threads - minimal thread, lock and semaphore wrappers
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * Win32 version only uses calls available on Win95/NT4 (no condition
+ * variables), so waiting is done with counting semaphores; the POSIX
+ * version builds the semaphore from a pthread mutex and condition.
+ */
+
+#ifndef _THREADS_H_
+#define _THREADS_H_
+
+#include "miniclib.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef _WIN32
+typedef HANDLE THREAD;
+typedef CRITICAL_SECTION LOCK;
+typedef HANDLE SEMA;
+typedef LPTHREAD_START_ROUTINE THREADFUNC;
+#define THREAD_PROC(fn) DWORD WINAPI fn(LPVOID arg)
+#define THREAD_RETURN   return 0
+#else
+typedef pthread_t THREAD;
+typedef pthread_mutex_t LOCK;
+typedef struct { pthread_mutex_t m; pthread_cond_t c; unsigned count; } SEMA;
+typedef void *(*THREADFUNC)(void *);
+#define THREAD_PROC(fn) void *fn(void *arg)
+#define THREAD_RETURN   return NULL
+#endif
+
+/* starts fn(arg) on a new thread, returns nonzero on success */
+int thread_start(THREAD *t, THREADFUNC fn, void *arg);
+
+/* waits for thread to return and releases it */
+void thread_wait(THREAD t);
+
+/* number of processors available, at least 1 */
+int thread_cpus(void);
+
+void lock_init(LOCK *l);
+void lock_free(LOCK *l);
+void lock_acquire(LOCK *l);
+void lock_release(LOCK *l);
+
+/* counting semaphore, returns nonzero on success */
+int  sema_init(SEMA *s, unsigned count);
+void sema_free(SEMA *s);
+void sema_wait(SEMA *s);
+void sema_post(SEMA *s, unsigned n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _THREADS_H_ */
@@ -1,772 +1,1627 @@
-/*
- * tgz_extract functions based on code within zlib library
- * No additional copyright added, KJD <jeremyd@computer.org>
- *
- *   This software is provided 'as-is', without any express or implied
- *   warranty.  In no event will the authors be held liable for any damages
- *   arising from the use of this software.
- *
- * untgz.c -- Display contents and/or extract file from
- * a gzip'd TAR file
- * written by "Pedro A. Aranda Guti\irrez" <paag@tid.es>
- * adaptation to Unix by Jean-loup Gailly <jloup@gzip.org>
- * various fixes by Cosmin Truta <cosmint@cs.ubbcluj.ro>
-*/
-
-/*
-  For tar format see
-  http://cdrecord.berlios.de/old/private/man/star/star.4.html
-  http://www.mkssoftware.com/docs/man4/tar.4.asp 
-  http://www.delorie.com/gnu/docs/tar/tar_toc.html
-
-  TODO:
-    without -j there is a security issue as no checking is done to directories
-    change to better support -d option, presently we just chdir there
-*/
-
-
-#include "untar.h"
-
-
-/** the rest heavily based on (ie mostly) untgz.c from zlib **/
-
-/* Values used in typeflag field.  */
-
-#define REGTYPE  '0'		/* regular file */
-#define AREGTYPE '\0'		/* regular file */
-#define LNKTYPE  '1'		/* link */
-#define SYMTYPE  '2'		/* reserved */
-#define CHRTYPE  '3'		/* character special */
-#define BLKTYPE  '4'		/* block special */
-#define DIRTYPE  '5'		/* directory */
-#define FIFOTYPE '6'		/* FIFO special */
-#define CONTTYPE '7'		/* reserved, for compatibility with gnu tar,
-                               treat as regular file, where it represents
-                               a regular file, but saved contiguously on disk */
-
-/* GNU tar extensions */
-
-#define GNUTYPE_DUMPDIR  'D'    /* file names from dumped directory */
-#define GNUTYPE_LONGLINK 'K'    /* long link name */
-#define GNUTYPE_LONGNAME 'L'    /* long file name */
-#define GNUTYPE_MULTIVOL 'M'    /* continuation of file from another volume */
-#define GNUTYPE_NAMES    'N'    /* file name that does not fit into main hdr */
-#define GNUTYPE_SPARSE   'S'    /* sparse file */
-#define GNUTYPE_VOLHDR   'V'    /* tape/volume header */
-
-
-
-/* help functions */
-
-unsigned long getoct(char *p,int width)
-{
-  unsigned long result = 0;
-  char c;
-  
-  while (width --)
-    {
-      c = *p++;
-      if (c == ' ') /* ignore padding */
-        continue;
-      if (c == 0)   /* ignore padding, but also marks end of string */
-        break;
-      if (c < '0' || c > '7')
-        return result; /* really an error, but we just ignore invalid values */
-      result = result * 8 + (c - '0');
-    }
-  return result;
-}
-
-/* regular expression matching */
-
-#define ISSPECIAL(c) (((c) == '*') || ((c) == '/'))
-
-int ExprMatch(char *string,char *expr)
-{
-  while (1)
-    {
-      if (ISSPECIAL(*expr))
-	{
-	  if (*expr == '/')
-	    {
-	      if (*string != '\\' && *string != '/')
-		return 0;
-	      string ++; expr++;
-	    }
-	  else if (*expr == '*')
-	    {
-	      if (*expr ++ == 0)
-		return 1;
-	      while (*++string != *expr)
-		if (*string == 0)
-		  return 0;
-	    }
-	}
-      else
-	{
-	  if (*string != *expr)
-	    return 0;
-	  if (*expr++ == 0)
-	    return 1;
-	  string++;
-	}
-    }
-}
-
-
-/* returns 0 on failed checksum, nonzero if probably ok 
-   it was noted that some versions of tar compute
-   signed chksums, though unsigned appears to be the
-   standard; chksum is simple sum of all bytes in header
-   as integers (using at least 17 bits) with chksum
-   values treated as ASCII spaces.
-*/
-int valid_checksum(struct tar_header *header)
-{
-  unsigned hdrchksum = (unsigned)getoct(header->chksum,8);
-  signed schksum = 0;
-  unsigned uchksum = 0;
-  int i;
-
-  for (i=0; i < sizeof(struct tar_header); i++)
-  {
-    unsigned char val = ((unsigned char *)header)[i];
-    if ((i >= 148) && (i < 156)) /* chksum */
-    {
-      val = ' ';
-    }
-    schksum += (signed char)val;
-    uchksum += val;
-  }
-
-  if (hdrchksum == uchksum) return 1;
-  if ((int)hdrchksum == schksum) return 2;
-  return 0;
-}
-
-
-/* recursive make directory */
-/* abort if you get an ENOENT errno somewhere in the middle */
-/* e.g. ignore error "mkdir on existing directory" */
-/* */
-/* return 1 if OK */
-/*        0 on error */
-
-int makedir (char *newdir)
-{
-  char *buffer = strdup(newdir);
-  char *p;
-  int  len = strlen(buffer);
-  
-  if (len <= 0) {
-    free(buffer);
-    return 0;
-  }
-  if (buffer[len-1] == '/') {
-    buffer[len-1] = '\0';
-  }
-  if (CreateDirectoryA(buffer, NULL) != 0)
-    {
-      free(buffer);
-      return 1;
-    }
-
-  p = buffer+1;
-  while (1)
-    {
-      char hold;
-      
-      while(*p && *p != '\\' && *p != '/')
-        p++;
-      hold = *p;
-      *p = 0;
-      //if ((mkdir(buffer, 0775) == -1) && (errno == ENOENT /* != EEXIST */))
-      if (!CreateDirectoryA(buffer, NULL) && !((GetLastError()==ERROR_FILE_EXISTS) || (GetLastError()==ERROR_ALREADY_EXISTS)) )
-      {
-        // fprintf(stderr,"Unable to create directory %s\n", buffer);
-        PrintMessage(_T("Unable to create directory %s\n"), _A2T(buffer));
-        free(buffer);
-	  return 0;
-      }
-      if (hold == 0)
-        break;
-      *p++ = hold;
-    }
-  free(buffer);
-  return 1;
-}
-
-
-#ifdef UNICODE
-#define funcName "CreateHardLinkW"
-#else
-#define funcName "CreateHardLinkA"
-#endif
-typedef BOOL (*CreateHardLinkTPtr)(TCHAR * linkFileName, TCHAR * existingFileName, LPSECURITY_ATTRIBUTES lpSecurityAttributes);
-BOOL MakeHardLink(char *linkFileName, char *existingFileName)
-{
-	HMODULE hLib = LoadLibrary(_T("KERNEL32.DLL"));
-	CreateHardLinkTPtr chlT;
-	TCHAR f2[1024]; /* can't call _A2T in same call as uses a static buffer */
-	_tcscpy(f2, _A2T(existingFileName));
-	PrintMessage(_T("Hard link %s to %s"), _A2T(linkFileName), f2);
-	if ((hLib != NULL) && ((chlT = (CreateHardLinkTPtr)GetProcAddress(hLib, funcName)) != NULL))
-		return chlT(_A2T(linkFileName), f2, NULL);
-	SetLastError(ERROR_CALL_NOT_IMPLEMENTED);
-	return FALSE;
-}
-
-
-
-/* NOTE: This should be modified to perform whatever steps
-   deemed necessary to make embedded paths safe prior to
-   creating directory or file of given [path]filename.
-   Must modify fname in place, always leaving either
-   same or smaller strlen than current string.
-   Current version (if not #defined out) removes any
-   leading parent (..) or root (/)(\) references.
-*/
-void safetyStrip(char * fname)
-{
-#if 0
-  /* strip root from path */
-  if ((*fname == '/') || (*fname == '\\'))
-  {
-    MoveMemory(fname, fname+1, strlen(fname+1) + 1 );
-  }
-
-  /* now strip leading ../ */
-  while ((*fname == '.') && (*(fname+1) == '.') && ((*(fname+2) == '/') || (*(fname+2) == '\\')) )
-  {
-    MoveMemory(fname, fname+3, strlen(fname+3) + 1 );
-  }
-#endif
-}
-
-
-/* combines elements from tar header to produce
- * full [long] filename; prefix + [/] + name
- */
-void getFullName(union tar_buffer *buffer, char *fname)
-{
-	int len = 0;
-
-	/* NOTE: prepend buffer.head.prefix if tar archive expected to have it */
-	if (*(buffer->header.prefix) && (*(buffer->header.prefix) != ' '))
-	{
-		/* copy over prefix */
-		strncpy(fname,buffer->header.prefix, sizeof(buffer->header.prefix));
-		fname[sizeof(buffer->header.prefix)-1] = '\0';
-		/* ensure ends in dir separator, implied after if full prefix size used */
-		len = strlen(fname)-1; /* assumed by test above at least 1 character */
-		if ((fname[len]!='/') && (fname[len]!='\\'))
-		{
-			len++;
-			fname[len]='/';
-		}
-		len++; /* index of 1st character after dir separator */
-	}
-
-	/* copy over filename portion */
-	strncpy(fname+len,buffer->header.name, sizeof(buffer->header.name));
-	fname[len+sizeof(buffer->header.name)-1] = '\0'; /* ensure terminated */
-}
-
-
-/* returns a pointer to a static buffer
- * containing fname after removing all but
- * path_sep_cnt path separators
- * if there are less than path_sep_cnt
- * separators then all will still be there.
- */
-char * stripPath(int path_sep_cnt, char *fname)
-{
-  static char buffer[1024];
-  char *fname_use = fname + strlen(fname);
-  register int i=path_sep_cnt;
-  do
-  {
-    if ( (*fname_use == '/') || (*fname_use == '\\') ) 
-	{ 
-      i--;
-	  if (i < 0) fname_use++;
-	  else fname_use--;
-    }
-	else
-      fname_use--;
-  } while ((i >= 0) && (fname_use > fname));
-  
-  strcpy(buffer, fname_use);
-  return buffer;
-}
-
-/* returns 1 if fname in list else return 0 
- * returns 0 if list is NULL or cnt is < 0
- */
-int matchname (char *fname, int cnt, char *list[], int junkPaths)
-{
-  register char *t;
-  int i;
-  int path_sep;
-
-  /* if nothing to compare with then return failure */
-  if ((list == NULL) || (cnt <= 0))
-    return 0;
-
-  for (i = 0; i < cnt; i++)
-  {
-    /* get count of path components in current filelist entry */
-    path_sep = 0;
-    if (!junkPaths)
-	{
-      for(t = list[i]; *t != '\0'; t++)
-        if ((*t == '/') || (*t == '\\'))
-          path_sep++;
-	}
-    if (ExprMatch(stripPath(path_sep, fname), list[i]))
-      return 1;
-  }
-
-  return 0; /* no match */
-}
-
-
-typedef unsigned long time_t;
-
-#ifdef __GNUC__
-#define HUNDREDSECINTERVAL 116444772000000000LL
-#else
-#define HUNDREDSECINTERVAL 116444772000000000i64
-#endif
-void cnv_tar2win_time(time_t tartime, FILETIME *ftm)
-{
-#ifdef HAS_LIBC_CAL_FUNCS
-		  FILETIME ftLocal;
-		  SYSTEMTIME st;
-		  struct tm localt;
- 
-		  localt = *localtime(&tartime);
-		  
-		  st.wYear = (WORD)localt.tm_year+1900;
-		  st.wMonth = (WORD)localt.tm_mon+1;    /* 1 based, not 0 based */
-		  st.wDayOfWeek = (WORD)localt.tm_wday;
-		  st.wDay = (WORD)localt.tm_mday;
-		  st.wHour = (WORD)localt.tm_hour;
-		  st.wMinute = (WORD)localt.tm_min;
-		  st.wSecond = (WORD)localt.tm_sec;
-		  st.wMilliseconds = 0;
-		  SystemTimeToFileTime(&st,&ftLocal);
-		  LocalFileTimeToFileTime(&ftLocal,ftm);
-#else
-	// avoid casts further below
-    LONGLONG *t = (LONGLONG *)ftm;
-
-	// tartime == number of seconds since midnight Jan 1 1970 (00:00:00)
-	// convert to equivalent 100 nanosecond intervals
-	*t = UInt32x32To64(tartime, 10000000UL);
-
-	// now base on 1601, add number of 100 nansecond intervals between 1601 & 1970
-	*t += HUNDREDSECINTERVAL;  /* 116444736000000000i64; */
-#endif
-}
-
-
-#ifdef ENABLE_LZMA
-#include "lzma/lzma.h"
-LZMAFile *lzmaFile;
-#endif
-#ifdef ENABLE_BZ2
-#include "bz2/bz2.h"
-static int bzerror;
-BZFILE *bzfile;
-void bz_internal_error ( int errcode ) { PrintMessage(_T("BZ2: internal error decompressing!")); }
-#endif
-gzFile infile;
-
-/* Initialize decompression library (if needed)
-   0=success, nonzero means error during initialization
- */
-int cm_init(gzFile in, int cm)
-{
-  infile = in; /* save gzFile for reading/cleanup */
-
-  switch (cm)
-  {
-#ifdef ENABLE_BZ2
-    case CM_BZ2:
-      bzfile = BZ2_bzReadOpen(&bzerror, in, 0, 0, NULL, 0);
-	return bzerror;
-#endif
-#ifdef ENABLE_LZMA
-    case CM_LZMA:
-      return lzma_init(in, &lzmaFile);
-#endif
-    default: /* CM_NONE, CM_GZ */
-      return 0; /* success */
-  }
-}
-
-
-/* properly cleanup any resources decompression library allocated 
- */
-void cm_cleanup(int cm)
-{
-  switch (cm)
-  {
-#ifdef ENABLE_BZ2
-    case CM_BZ2:
-      BZ2_bzReadClose(&bzerror, bzfile);
-      break;
-#endif
-#ifdef ENABLE_LZMA
-    case CM_LZMA:
-      lzma_cleanup(lzmaFile);
-      break;
-#endif
-    default: /* CM_NONE, CM_GZ */
-      break;
-  }
-
-  /* close the input stream */
-  if (gzclose(infile) != Z_OK)
-  {
-    PrintMessage(_T("failed gzclose"));
-    /* return -1; */
-  }
-}
-
-
-/* Reads in a single TAR block
- */
-long readBlock(int cm, void *buffer)
-{
-  long len = -1;
-  switch (cm)
-  {
-#ifdef ENABLE_BZ2
-    case CM_BZ2:
-	len = BZ2_bzRead(&bzerror, bzfile, buffer, BLOCKSIZE);
-      break;
-#endif
-#ifdef ENABLE_LZMA
-    case CM_LZMA:
-      len = lzma_read(lzmaFile, buffer, BLOCKSIZE);
-      break;
-#endif
-    default: /* CM_NONE, CM_GZ */
-      len = gzread(infile, buffer, BLOCKSIZE);
-      break;
-  }
-
-  /* check for read errors and abort */
-  if (len < 0)
-  {
-    PrintMessage(_T("gzread: error decompressing"));
-    cm_cleanup(cm);
-    return -1;
-  }
-  /*
-   * Always expect complete blocks to process
-   * the tar information.
-   */
-  if (len != BLOCKSIZE)
-  {
-    PrintMessage(_T("gzread: incomplete block read"));
-    cm_cleanup(cm);
-    return -1;
-  }
-
-  return len; /* success */
-}
-
-
-/* Tar file extraction
- * gzFile in, handle of input tarball opened with gzopen
- * int cm, compressionMethod
- * int junkPaths, nonzero indicates to ignore stored path (don't create directories)
- * enum KeepMode keep, indicates to perform if file exists
- * int iCnt, char *iList[], argv style list of files to extract, {0,NULL} for all
- * int xCnt, char *xList[], argv style list of files NOT to extract, {0,NULL} for none
- * int failOnHardLinks, if nonzero then will treat failure to create a hard link same as
- *   failure to create a regular file, 0 prints a warning if fails - note that hardlinks
- *   will always fail on Windows prior to NT 5 (Win 2000) or later and non NTFS file systems.
- *
- * returns 0 (or positive value) on success
- * returns negative value on error, where
- *   -1 means error reading from tarball
- *   -2 means error extracting file from tarball
- *   -3 means error creating hard link
- */
-int tgz_extract(gzFile in, int cm, int junkPaths, enum KeepMode keep, int iCnt, char *iList[], int xCnt, char *xList[], int failOnHardLinks)
-{
-  int           getheader = 1;    /* assume initial input has a tar header */
-  HANDLE        outfile = INVALID_HANDLE_VALUE;
-
-  union         tar_buffer buffer;
-  unsigned long remaining;
-  char          fname[BLOCKSIZE]; /* must be >= BLOCKSIZE bytes */
-  time_t        tartime;
-
-  /* do any prep work for extracting from compressed TAR file */
-  if (cm_init(in, cm))
-  {
-    PrintMessage(_T("tgz_extract: unable to initialize decompression method."));
-    cm_cleanup(cm);
-    return -1;
-  }
-  
-  while (1)
-  {
-    if (readBlock(cm, &buffer) < 0) return -1;
-      
-    /*
-     * If we have to get a tar header
-     */
-    if (getheader >= 1)
-    {
-      /*
-       * if we met the end of the tar
-       * or the end-of-tar block,
-       * we are done
-       */
-      if (/* (len == 0)  || */ (buffer.header.name[0]== 0)) break;
-
-      /* compute and check header checksum, support signed or unsigned */
-      if (!valid_checksum(&(buffer.header)))
-      {
-        PrintMessage(_T("tgz_extract: bad header checksum"));
-        cm_cleanup(cm);
-        return -1;
-      }
-
-      /* store time, so we can set the timestamp on files */
-      tartime = (time_t)getoct(buffer.header.mtime,12);
-
-      /* copy over filename chunk from header, avoiding overruns */
-      if (getheader == 1) /* use normal (short or posix long) filename from header */
-      {
-        /* NOTE: prepends any prefix, including separator, and ensures terminated */
-		getFullName(&buffer, fname);
-      }
-      else /* use (GNU) long filename that preceeded this header */
-      {
-#if 0
-        /* if (strncmp(fname,buffer.header.name,SHORTNAMESIZE-1) != 0) */
-        char fs[SHORTNAMESIZE];   /* force strings to same max len, then compare */
-        lstrcpyn(fs, fname, SHORTNAMESIZE);
-        fs[SHORTNAMESIZE-1] = '\0';
-        buffer.header.name[SHORTNAMESIZE-1] = '\0';
-        if (lstrcmp(fs, buffer.header.name) != 0)
-        {
-          PrintMessage(_T("tgz_extract: mismatched long filename"));
-          cm_cleanup(cm);
-          return -1;
-        }
-#else
-		PrintMessage(_T("tgz_extract: using GNU long filename [%s]"), _A2T(fname));
-#endif
-      }
-      /* LogMessage("buffer.header.name is:");  LogMessage(fname); */
-
-
-      switch (buffer.header.typeflag)
-      {
-        case DIRTYPE:
-		  dirEntry:
-          if (!junkPaths)
-          {
-            safetyStrip(fname);
-            makedir(fname);
-          }
-	      break;
-		case LNKTYPE:   /* hard link */ 
-		case CONTTYPE:  /* contiguous file, for compatibility treat as normal */
-        case REGTYPE:
-        case AREGTYPE:
-	      /* Note: a file ending with a / may actually be a BSD tar directory entry */
-	      if (fname[strlen(fname)-1] == '/')
-	        goto dirEntry;
-
-	      remaining = getoct(buffer.header.size,12);
-	      if ( /* add (remaining > 0) && to ignore 0 zero byte files */
-               ( (iList == NULL) || (matchname(fname, iCnt, iList, junkPaths)) ) &&
-               (!matchname(fname, xCnt, xList, junkPaths))
-             )
-	      {
-			  if (!junkPaths) /* if we want to use paths as stored */
-			  {
-	              /* try creating directory */
-	              char *p = strrchr(fname, '/');
-	              if (p != NULL) 
-	              {
-	                *p = '\0';
-	                makedir(fname);
-	                *p = '/';
-	              }
-			  }
-			  else
-			  {
-	              /* try ignoring directory */
-	              char *p = strrchr(fname, '/');
-	              if (p != NULL) 
-	              {
-	                /* be sure terminating '\0' is copied and */
-	                /* use ansi memcpy equivalent that handles overlapping regions */
-	                MoveMemory(fname, p+1, strlen(p+1) + 1 );
-	              }
-	          }
-	          if (*fname) /* if after stripping path a fname still exists */
-	          {
-	            /* Attempt to open the output file and report action taken to user */
-	            const TCHAR szERRMsg[] = _T("Error: Could not create file "),
-	                        szSUCMsg[] = _T("Writing "),
-	                        szSKPMsg[] = _T("Skipping ");
-	            const TCHAR * szMsg = szSUCMsg;
-
-	            safetyStrip(fname);
-
-				if (buffer.header.typeflag == LNKTYPE)
-				{
-					outfile = INVALID_HANDLE_VALUE;
-					/* create a hardlink if possible, else produce just a warning unless failOnHardLinks is true */
-					if (!MakeHardLink(fname, buffer.header.linkname))
-					{
-						PrintMessage(_T("Warning: unable to create hard link %s [%d]"), _A2T(fname), GetLastError());
-						if (failOnHardLinks) 
-						{
-							cm_cleanup(cm);
-							return -3;
-						}
-					}
-					else
-					{
-						outfile = CreateFileA(fname,GENERIC_WRITE,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
-						goto setTimeAndCloseFile;
-					}
-				} else 
-				{
-	            /* Open the file for writing mode, creating if doesn't exist and truncating if exists and overwrite mode */
-	            outfile = CreateFileA(fname,GENERIC_WRITE,FILE_SHARE_READ,NULL,(keep==OVERWRITE)?CREATE_ALWAYS:CREATE_NEW,FILE_ATTRIBUTE_NORMAL,NULL);
-
-	            /* failed to open file, either valid error (like open) or it already exists and in a keep mode */
-	            if (outfile == INVALID_HANDLE_VALUE)
-	            {
-	              /* if skip existing or only update existing and failed to open becauses exists */
-	              if ((keep!=OVERWRITE) && (GetLastError()==ERROR_FILE_EXISTS))
-	              {
-	                /* assume skipping initially (mode==SKIP or ==UPDATE with existing file newer) */
-	                szMsg = szSKPMsg; /* and update output message accordingly */
-
-					/* if in update mode, check filetimes and reopen in overwrite mode */
-	                if (keep == UPDATE)
-	                {
-	                  FILETIME ftm_a;
-                      HANDLE h;
-                      WIN32_FIND_DATAA ffData;
- 
-	                  cnv_tar2win_time(tartime, &ftm_a); /* archive file time */
-	                  h = FindFirstFileA(fname, &ffData); /* existing file time */
-
-                      if (h!=INVALID_HANDLE_VALUE)
-                        FindClose(h);  /* cleanup search handle */
-                      else
-                        goto ERR_OPENING;
-
-                      /* compare date+times, is one in tarball newer? */
-                      if (*((LONGLONG *)&ftm_a) > *((LONGLONG *)&(ffData.ftLastWriteTime)))
-                      {
-                        outfile = CreateFileA(fname,GENERIC_WRITE,FILE_SHARE_READ,NULL,CREATE_ALWAYS,FILE_ATTRIBUTE_NORMAL,NULL);
-                        if (outfile == INVALID_HANDLE_VALUE) goto ERR_OPENING;
-                        szMsg = szSUCMsg;
-                      }
-	                }
-	              }
-	              else /* in overwrite mode or failed for some other error than exists */
-	              {
-                    ERR_OPENING:
-	                PrintMessage(_T("%s%s [%d]"), szERRMsg, _A2T(fname), GetLastError());
-	                cm_cleanup(cm);
-	                return -2;
-	              }
-	            }
-
- 	            /* Inform user of current extraction action (writing, skipping file XYZ) */
-	            PrintMessage(_T("%s%s"), szMsg, _A2T(fname));
-				}
-	          }
-	      }
-	      else
-	          outfile = INVALID_HANDLE_VALUE;
-
-	      /*
-	       * could have no contents, in which case we close the file and set the times
-	       */
-	      if (remaining > 0)
-	          getheader = 0;
-		  else
-	      {
-	          setTimeAndCloseFile:
-	          getheader = 1;
-	          if (outfile != INVALID_HANDLE_VALUE)
-	          {
-	              FILETIME ftm;
- 
-	              cnv_tar2win_time(tartime, &ftm);
-	              SetFileTime(outfile,&ftm,NULL,&ftm);
-	              CloseHandle(outfile);
-	              outfile = INVALID_HANDLE_VALUE;
-	          }
-		  }
-
-	      break;
-		case GNUTYPE_LONGLINK:
-		case GNUTYPE_LONGNAME:
-		{
-	      remaining = getoct(buffer.header.size,12);
-	      if (readBlock(cm, fname) < 0) return -1;
-	      fname[BLOCKSIZE-1] = '\0';
-	      if ((remaining >= BLOCKSIZE) || ((unsigned)strlen(fname) > remaining))
-	      {
-	          PrintMessage(_T("tgz_extract: invalid long name"));
-	          cm_cleanup(cm);
-	          return -1;
-	      }
-	      getheader = 2;
-	      break;
-		}
-        default:
-/*
-	      if (action == TGZ_LIST)
-	          printf(" %s     <---> %s\n",strtime(&tartime),fname);
-*/
-	      break;
-      }
-    }
-    else  /* (getheader == 0) */
-    {
-      unsigned int bytes = (remaining > BLOCKSIZE) ? BLOCKSIZE : remaining;
-	  unsigned long bwritten;
-
-      if (outfile != INVALID_HANDLE_VALUE)
-      {
-          WriteFile(outfile,buffer.buffer,bytes,&bwritten,NULL);
-		  if (bwritten != bytes)
-          {
-			  PrintMessage(_T("Error: write failed for %s"), _A2T(fname));
-              CloseHandle(outfile);
-              DeleteFileA(fname);
-
-              cm_cleanup(cm);
-              return -2;
-          }
-      }
-      remaining -= bytes;
-      if (remaining == 0) goto setTimeAndCloseFile;
-    }
-  } /* while(1) */
-  
-  cm_cleanup(cm);
-
-  return 0;
-}
-
+/*
+ * tgz_extract functions based on code within zlib library
+ * No additional copyright added, KJD <jeremyd@computer.org>
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * untgz.c -- Display contents and/or extract file from
+ * a gzip'd TAR file
+ * written by "Pedro A. Aranda Guti\irrez" <paag@tid.es>
+ * adaptation to Unix by Jean-loup Gailly <jloup@gzip.org>
+ * various fixes by Cosmin Truta <cosmint@cs.ubbcluj.ro>
+*/
+
+/*
+  For tar format see
+  http://cdrecord.berlios.de/old/private/man/star/star.4.html
+  http://www.mkssoftware.com/docs/man4/tar.4.asp 
+  http://www.delorie.com/gnu/docs/tar/tar_toc.html
+
+  TODO:
+    without -j there is a security issue as no checking is done to directories
+*/
+
+
+#include "untar.h"
+#include "fsio.h"
+#include "dedup.h"
+#include "pool.h"
+#include "decpool.h"
+#include "codec.h"
+
+
+/** the rest heavily based on (ie mostly) untgz.c from zlib **/
+
+/* Values used in typeflag field.  */
+
+#define REGTYPE  '0'		/* regular file */
+#define AREGTYPE '\0'		/* regular file */
+#define LNKTYPE  '1'		/* link */
+#define SYMTYPE  '2'		/* reserved */
+#define CHRTYPE  '3'		/* character special */
+#define BLKTYPE  '4'		/* block special */
+#define DIRTYPE  '5'		/* directory */
+#define FIFOTYPE '6'		/* FIFO special */
+#define CONTTYPE '7'		/* reserved, for compatibility with gnu tar,
+                               treat as regular file, where it represents
+                               a regular file, but saved contiguously on disk */
+
+/* GNU tar extensions */
+
+#define GNUTYPE_DUMPDIR  'D'    /* file names from dumped directory */
+#define GNUTYPE_LONGLINK 'K'    /* long link name */
+#define GNUTYPE_LONGNAME 'L'    /* long file name */
+#define GNUTYPE_MULTIVOL 'M'    /* continuation of file from another volume */
+#define GNUTYPE_NAMES    'N'    /* file name that does not fit into main hdr */
+#define GNUTYPE_SPARSE   'S'    /* sparse file */
+#define GNUTYPE_VOLHDR   'V'    /* tape/volume header */
+
+/* POSIX.1-2001 (pax) extensions */
+
+#define XHDTYPE  'x'            /* extended header for next member */
+#define XGLTYPE  'g'            /* global extended header */
+#define XHDRMAX  (16UL << 20)   /* larger extended headers (or sparse maps) are rejected */
+
+/* existing file is read in chunks this size when comparing (SYNC), multiple of BLOCKSIZE */
+#define CMPCHUNK 65536
+
+
+/* recursive make directory */
+/* abort if you get an ENOENT errno somewhere in the middle */
+/* e.g. ignore error "mkdir on existing directory" */
+/* */
+/* return 1 if OK */
+/*        0 on error */
+
+int makedir (FSCTX *fs, char *newdir)
+{
+  char *buffer = strdup(newdir);
+  char *p;
+  int  len = strlen(buffer);
+  
+  if (len <= 0) {
+    free(buffer);
+    return 0;
+  }
+  if (buffer[len-1] == '/') {
+    buffer[len-1] = '\0';
+  }
+  if (fs_mkdir(fs, buffer))
+    {
+      free(buffer);
+      return 1;
+    }
+
+  p = buffer+1;
+  while (1)
+    {
+      char hold;
+      
+      while(*p && *p != '\\' && *p != '/')
+        p++;
+      hold = *p;
+      *p = 0;
+      //if ((mkdir(buffer, 0775) == -1) && (errno == ENOENT /* != EEXIST */))
+      if (!fs_mkdir(fs, buffer))
+      {
+        // fprintf(stderr,"Unable to create directory %s\n", buffer);
+        PrintMessage(_T("Unable to create directory %s\n"), _A2T(buffer));
+        free(buffer);
+	  return 0;
+      }
+      if (hold == 0)
+        break;
+      *p++ = hold;
+    }
+  free(buffer);
+  return 1;
+}
+
+
+/* buffer grown as needed and reused from member to member */
+struct membuf {
+  char           *data;
+  unsigned long   size;
+};
+
+/* everything one extraction uses, buffers kept until tgz_free */
+struct tgz_ctx {
+  FSCTX          *fs;       /* output */
+  gzFile          infile;   /* tarball being read, for reading/cleanup */
+  const struct tgz_codec *codec; /* its compression method (codec.c) */
+  void           *cmstate;  /* decoder state codec keeps */
+  unsigned long   decmem;   /* memory decoder may use, 0 no limit (tgz_memlimit) */
+  int             decthreads; /* threads a CODEC_PARALLEL decoder may use (tgz_decthreads) */
+  union tar_buffer block;   /* block read by readBlock when not decoded in place */
+  char           *cmpbuf;   /* CMPCHUNK bytes for SYNC and dedup modes, else NULL */
+  struct membuf   xbuf;     /* extended header and sparse map data */
+  struct membuf   name;     /* member name, at least BLOCKSIZE */
+  struct membuf   link;     /* hard link target, at least BLOCKSIZE */
+  struct pax_info pax;      /* from extended header, for next member */
+  int             globaltime; /* nonzero if gmtime set by global header */
+  time_t          gmtime;
+  struct dedup    dd;       /* files written, for dedup mode */
+};
+
+/* Initialize decompression library (if needed)
+   0=success, nonzero means error during initialization
+ */
+static int cm_init(TGZCTX *ctx, gzFile in, int cm)
+{
+  ctx->infile = in; /* save gzFile for reading/cleanup */
+  ctx->cmstate = NULL;
+  if ((ctx->codec = codec_find(cm)) == NULL)
+  {
+    PrintMessage(_T("Error: Unsupported compression format."));
+    return -1;
+  }
+  return ctx->codec->open(in, &ctx->cmstate, ctx->decmem,
+                          (ctx->codec->flags & CODEC_PARALLEL) ? ctx->decthreads : 1);
+}
+
+
+/* properly cleanup any resources decompression library allocated 
+ */
+static void cm_cleanup(TGZCTX *ctx)
+{
+  if ((ctx->codec != NULL) && (ctx->codec->close != NULL))
+    ctx->codec->close(ctx->cmstate);
+  ctx->codec = NULL;
+
+  /* close the input stream */
+  if (gzclose(ctx->infile) != Z_OK)
+  {
+    PrintMessage(_T("failed gzclose"));
+    /* return -1; */
+  }
+}
+
+
+/* Reads in a single TAR block, returns it (valid until the next read)
+   or NULL on error; blocks of codecs decoding in place (readptr: gzip,
+   lzma, xz, zstd, lz4) are used where the decoder put them, unless split
+   by the end of its window or a member
+ */
+static const union tar_buffer *readBlock(TGZCTX *ctx)
+{
+  const struct tgz_codec *c = ctx->codec;
+  const union tar_buffer *block = &ctx->block;
+  const Bytef *p;
+  long len;
+
+  if (c->readptr == NULL)
+    len = c->read(ctx->cmstate, (Bytef *)ctx->block.buffer, BLOCKSIZE);
+  else if ((len = c->readptr(ctx->cmstate, &p, BLOCKSIZE)) == BLOCKSIZE)
+    block = (const union tar_buffer *)p;
+  else if (len > 0)
+  {
+    /* assemble the pieces */
+    long more = 0;
+    memcpy(ctx->block.buffer, p, len);
+    while ((len < BLOCKSIZE) && ((more = c->readptr(ctx->cmstate, &p, BLOCKSIZE - len)) > 0))
+    {
+      memcpy(ctx->block.buffer + len, p, more);
+      len += more;
+    }
+    if (more < 0) len = -1;
+  }
+
+  /* check for read errors and abort */
+  if (len < 0)
+  {
+    PrintMessage(_T("gzread: error decompressing"));
+    cm_cleanup(ctx);
+    return NULL;
+  }
+  /*
+   * Always expect complete blocks to process
+   * the tar information.
+   */
+  if (len != BLOCKSIZE)
+  {
+    PrintMessage(_T("gzread: incomplete block read"));
+    cm_cleanup(ctx);
+    return NULL;
+  }
+
+  return block; /* success */
+}
+
+/* Passes over len bytes (whole blocks) of member data not extracted,
+   without a readBlock per block; codecs that can skip (zstd passes over
+   the frames lying wholly inside them without decoding them) do
+   0=success, -1 error reading (reported and cleaned up, as readBlock)
+ */
+#define SKIPCHUNK 0x40000000UL
+static int skipData(TGZCTX *ctx, FSSIZE len)
+{
+  const struct tgz_codec *c = ctx->codec;
+
+  while (len > 0)
+  {
+    unsigned long step = (len > SKIPCHUNK) ? SKIPCHUNK : (unsigned long)len;
+    long n;
+    if (c->skip != NULL)
+      n = c->skip(ctx->cmstate, step);
+    else if (c->readptr != NULL)
+    {
+      const Bytef *p;
+      n = c->readptr(ctx->cmstate, &p, (step > CMPCHUNK) ? CMPCHUNK : (unsigned)step);
+    }
+    else
+      n = c->read(ctx->cmstate, (Bytef *)ctx->block.buffer, BLOCKSIZE);
+    if (n <= 0)
+    {
+      PrintMessage((n < 0) ? _T("gzread: error decompressing") : _T("gzread: incomplete block read"));
+      cm_cleanup(ctx);
+      return -1;
+    }
+    len -= n;
+  }
+  return 0;
+}
+
+
+/* makes b at least len bytes, returns 0 if out of memory */
+static int reserve(struct membuf *b, unsigned long len)
+{
+  if (len > b->size)
+  {
+    unsigned long n = b->size ? b->size : 4 * BLOCKSIZE;
+    char *p;
+    while (len > n) n *= 2;
+    if ((p = (char *)realloc(b->data, n)) == NULL) return 0;
+    b->data = p;
+    b->size = n;
+  }
+  return 1;
+}
+
+/* reads len bytes (whole blocks) of member data to b + at, growing it as
+   needed and terminating data, returns 0 on success, -1 on read error
+   or -2 if out of memory */
+static int readData(TGZCTX *ctx, struct membuf *b, unsigned long at, unsigned long len)
+{
+  unsigned long end = at + ((len + BLOCKSIZE - 1) & ~(unsigned long)(BLOCKSIZE - 1));
+
+  if (!reserve(b, end + 1)) return -2;
+  for (; at < end; at += BLOCKSIZE)
+  {
+    const union tar_buffer *blk = readBlock(ctx);
+    if (blk == NULL) return -1;
+    memcpy(b->data + at, blk->buffer, BLOCKSIZE);
+  }
+  b->data[at] = '\0';
+  return 0;
+}
+
+/* copies string to b, returns 0 if out of memory */
+static int setString(struct membuf *b, const char *s)
+{
+  if (!reserve(b, strlen(s) + 1)) return 0;
+  strcpy(b->data, s);
+  return 1;
+}
+
+static void pax_reset(struct pax_info *pax)
+{
+  pax->have = 0;
+  pax->sparse = PAX_SPARSE_NONE;
+  pax->name = pax->path = pax->linkpath = NULL;
+}
+
+/* data size of member, from extended header if it gave one */
+static FSSIZE memberSize(struct tar_fields *hdr, struct pax_info *pax)
+{
+  return (pax->have & PAX_SIZE) ? pax->size : hdr->size;
+}
+
+/* writes len bytes at offset of file being extracted, a gap since the
+   end of the previous write (*wpos) is left as a hole */
+static int put(FSCTX *fs, FSHANDLE h, const char *p, unsigned len, FSSIZE offset, FSSIZE *wpos)
+{
+  if ((offset != *wpos) && !fs_skip(fs, h, offset)) return 0;
+  if (!fs_write(fs, h, p, len, offset)) return 0;
+  *wpos = offset + len;
+  return 1;
+}
+
+/* copies first len bytes of file src to dst, returns nonzero on success */
+static int copy_file(FSCTX *fs, const char *src, FSHANDLE dst, FSSIZE len, char *buf)
+{
+  FSHANDLE h = fs_open(fs, src);
+  FSSIZE done = 0;
+  int ok = (h != FS_INVALID_HANDLE);
+
+  while (ok && (done < len))
+  {
+    unsigned int n = (len - done > CMPCHUNK) ? CMPCHUNK : (unsigned int)(len - done);
+    ok = (fs_read(fs, h, buf, n, done) == (int)n) && fs_write(fs, dst, buf, n, done);
+    done += n;
+  }
+  if (h != FS_INVALID_HANDLE) fs_release(fs, h);
+  return ok;
+}
+
+
+/* Tar file extraction
+ * TGZCTX *ctx, context holding output, decoder state and buffers
+ * gzFile in, handle of input tarball opened with gzopen
+ * int cm, compressionMethod
+ * int junkPaths, nonzero indicates to ignore stored path (don't create directories)
+ * enum KeepMode keep, indicates to perform if file exists
+ * int iCnt, char *iList[], argv style list of files to extract, {0,NULL} for all
+ * int xCnt, char *xList[], argv style list of files NOT to extract, {0,NULL} for none
+ * int failOnHardLinks, if nonzero then will treat failure to create a hard link same as
+ *   failure to create a regular file, 0 prints a warning if fails - note that hardlinks
+ *   will always fail on Windows prior to NT 5 (Win 2000) or later and non NTFS file systems.
+ * int dedup, if nonzero a member with the same contents as a file already written
+ *   is hard linked to it instead of written (copied if unable to link)
+ * int holes, if nonzero blocks of zeros in members are skipped, leaving holes
+ *
+ * returns 0 (or positive value) on success
+ * returns negative value on error, where
+ *   -1 means error reading from tarball
+ *   -2 means error extracting file from tarball
+ *   -3 means error creating hard link
+ */
+static int extract_members(TGZCTX *ctx, gzFile in, int cm, int junkPaths, enum KeepMode keep, int iCnt, char *iList[], int xCnt, char *xList[], int failOnHardLinks, int dedup, int holes)
+{
+  int           getheader = 1;    /* assume initial input has a tar header */
+  FSHANDLE      outfile = FS_INVALID_HANDLE;
+  FSHANDLE      cmpfile = FS_INVALID_HANDLE;  /* existing file being compared (SYNC, dedup) */
+  int           cmplen = 0;       /* bytes of it in cmpbuf */
+  const char   *dupname = NULL;   /* earlier file being compared (dedup), valid until next dd_add */
+  FSSIZE        ddsize = 0;       /* member size to record once written (dedup), 0 if none */
+  unsigned long ddhash = 0;       /* and hash of its first block */
+  int           sparse = 0;       /* member is sparse, ctx->pax.map holds its chunks */
+  unsigned      spi = 0;          /* chunk being written */
+  FSSIZE        spoff = 0;        /* offset within it */
+  FSSIZE        wpos = 0;         /* end of last write, anything skipped is a hole */
+  int           skipzero = 0;     /* leave zero blocks as holes, file was newly created */
+  char         *cmpbuf = ctx->cmpbuf;
+
+  const union   tar_buffer *blk;  /* block just read, valid until the next read */
+  union         tar_buffer buffer; /* header, kept as member data is read */
+  struct        tar_fields hdr;   /* decoded from header in buffer */
+  int           valid;            /* its checksum matched */
+  FSSIZE        remaining;
+  FSSIZE        offset = 0;       /* of next data block within file */
+  char         *fname;            /* ctx->name, >= BLOCKSIZE bytes */
+  char         *linkname = NULL;  /* ctx->link if long link name given for next member */
+  time_t        tartime = 0;
+
+  /* do any prep work for extracting from compressed TAR file */
+  if (cm_init(ctx, in, cm))
+  {
+    PrintMessage(_T("tgz_extract: unable to initialize decompression method."));
+    cm_cleanup(ctx);
+    return -1;
+  }
+
+  if (!reserve(&ctx->name, BLOCKSIZE) || !reserve(&ctx->link, BLOCKSIZE))
+  {
+    PrintMessage(_T("tgz_extract: out of memory"));
+    cm_cleanup(ctx);
+    return -2;
+  }
+  fname = ctx->name.data;
+  
+  while (1)
+  {
+    if ((blk = readBlock(ctx)) == NULL) return -1;
+      
+    /*
+     * If we have to get a tar header
+     */
+    if (getheader >= 1)
+    {
+      buffer = *blk;
+
+      /* compute header checksum, support signed or unsigned, decoding
+         the numeric fields and spotting a zero block in the same pass */
+      valid = tar_decode(&buffer, &hdr);
+
+      /*
+       * if we met the end of the tar
+       * or the end-of-tar block,
+       * we are done
+       */
+      if (/* (len == 0)  || */ hdr.zero || (buffer.header.name[0]== 0)) break;
+
+      if (!valid)
+      {
+        PrintMessage(_T("tgz_extract: bad header checksum"));
+        cm_cleanup(ctx);
+        return -1;
+      }
+
+      /* store time, so we can set the timestamp on files */
+      if (ctx->pax.have & PAX_MTIME)
+        tartime = ctx->pax.mtime;
+      else if (ctx->globaltime)
+        tartime = ctx->gmtime;
+      else
+        tartime = (time_t)hdr.mtime;
+
+      /* copy over filename chunk from header, avoiding overruns */
+      if (getheader == 1) /* use normal (short or posix long) filename from header */
+      {
+        /* NOTE: prepends any prefix, including separator, and ensures terminated */
+		getFullName(&buffer, fname);
+      }
+      else if (getheader == 2) /* use (GNU) long filename that preceeded this header */
+      {
+#if 0
+        /* if (strncmp(fname,buffer.header.name,SHORTNAMESIZE-1) != 0) */
+        char fs[SHORTNAMESIZE];   /* force strings to same max len, then compare */
+        lstrcpyn(fs, fname, SHORTNAMESIZE);
+        fs[SHORTNAMESIZE-1] = '\0';
+        buffer.header.name[SHORTNAMESIZE-1] = '\0';
+        if (lstrcmp(fs, buffer.header.name) != 0)
+        {
+          PrintMessage(_T("tgz_extract: mismatched long filename"));
+          cm_cleanup(ctx);
+          return -1;
+        }
+#else
+		PrintMessage(_T("tgz_extract: using GNU long filename [%s]"), _A2T(fname));
+#endif
+      }
+      /* else (getheader == 3) name from pax header already in fname */
+      /* LogMessage("buffer.header.name is:");  LogMessage(fname); */
+
+
+      switch (buffer.header.typeflag)
+      {
+        case DIRTYPE:
+		  dirEntry:
+          if (!junkPaths)
+          {
+            safetyStrip(fname);
+            makedir(ctx->fs, fname);
+          }
+	      break;
+		case LNKTYPE:   /* hard link */ 
+		case CONTTYPE:  /* contiguous file, for compatibility treat as normal */
+        case REGTYPE:
+        case AREGTYPE:
+        case GNUTYPE_SPARSE:
+	      /* Note: a file ending with a / may actually be a BSD tar directory entry */
+	      if (*fname && (fname[strlen(fname)-1] == '/'))
+	        goto dirEntry;
+
+	      remaining = memberSize(&hdr, &ctx->pax);
+	      offset = 0;
+	      ddsize = 0;
+	      dupname = NULL;
+	      wpos = 0;
+	      skipzero = 0;
+	      spi = 0;
+	      spoff = 0;
+
+	      /* sparse map, from old GNU header (and extension blocks), pax header or start of data */
+	      sparse = (buffer.header.typeflag == GNUTYPE_SPARSE) || (ctx->pax.sparse != PAX_SPARSE_NONE);
+	      if (buffer.header.typeflag == GNUTYPE_SPARSE)
+	      {
+	          int ext = buffer.buffer[GNU_ISEXTENDED];
+
+	          ctx->pax.map.cnt = 0;
+	          ctx->pax.map.realsize = getoct(buffer.buffer + GNU_REALSIZE, 12);
+	          if (!sparse_gnu(&ctx->pax.map, buffer.buffer + GNU_SPARSE, 4)) goto ERR_SPARSE;
+	          while (ext)
+	          {
+	              int r = readData(ctx, &ctx->xbuf, 0, BLOCKSIZE);
+	              if (r == -1) return -1;
+	              if ((r < 0) || !sparse_gnu(&ctx->pax.map, ctx->xbuf.data, GNU_EXTENTRIES)) goto ERR_SPARSE;
+	              ext = ctx->xbuf.data[GNU_EXTISEXTENDED];
+	          }
+	      }
+	      else if (ctx->pax.sparse == PAX_SPARSE_1)
+	      {
+	          unsigned long n = 0;
+	          long used = 0;
+
+	          while ((used == 0) && (n < remaining) && (n < XHDRMAX))
+	          {
+	              int r = readData(ctx, &ctx->xbuf, n, BLOCKSIZE);
+	              if (r == -1) return -1;
+	              if (r < 0) goto ERR_SPARSE;
+	              n += BLOCKSIZE;
+	              used = sparse_pax1(&ctx->pax.map, ctx->xbuf.data, n);
+	          }
+	          if ((used <= 0) || (n > remaining)) goto ERR_SPARSE;
+	          remaining -= n;  /* rest is the data */
+	      }
+	      if (sparse && !sparse_valid(&ctx->pax.map))
+	      {
+	          ERR_SPARSE:
+	          PrintMessage(_T("tgz_extract: invalid sparse map for %s"), _A2T(fname));
+	          cm_cleanup(ctx);
+	          return -1;
+	      }
+	      if ( /* add (remaining > 0) && to ignore 0 zero byte files */
+               ( (iList == NULL) || (matchname(fname, iCnt, iList, junkPaths)) ) &&
+               (!matchname(fname, xCnt, xList, junkPaths))
+             )
+	      {
+			  if (!junkPaths) /* if we want to use paths as stored */
+			  {
+	              /* try creating directory */
+	              char *p = strrchr(fname, '/');
+	              if (p != NULL) 
+	              {
+	                *p = '\0';
+	                makedir(ctx->fs, fname);
+	                *p = '/';
+	              }
+			  }
+			  else
+			  {
+	              /* try ignoring directory */
+	              char *p = strrchr(fname, '/');
+	              if (p != NULL) 
+	              {
+	                /* be sure terminating '\0' is copied and */
+	                /* use ansi memcpy equivalent that handles overlapping regions */
+	                MoveMemory(fname, p+1, strlen(p+1) + 1 );
+	              }
+	          }
+	          if (*fname) /* if after stripping path a fname still exists */
+	          {
+	            /* Attempt to open the output file and report action taken to user */
+	            const TCHAR szERRMsg[] = _T("Error: Could not create file "),
+	                        szSUCMsg[] = _T("Writing "),
+	                        szSKPMsg[] = _T("Skipping ");
+	            const TCHAR * szMsg = szSUCMsg;
+
+	            safetyStrip(fname);
+
+				if (buffer.header.typeflag == LNKTYPE)
+				{
+					TCHAR f2[1024]; /* can't call _A2T in same call as uses a static buffer */
+					if (linkname == NULL)  /* header field, may fill it without terminator */
+					{
+						memcpy(ctx->link.data, buffer.header.linkname, sizeof(buffer.header.linkname));
+						ctx->link.data[sizeof(buffer.header.linkname)] = '\0';
+						linkname = ctx->link.data;
+					}
+					_tcscpyn(f2, _A2T(linkname), 1024);
+					f2[1023] = '\0';
+					PrintMessage(_T("Hard link %s to %s"), _A2T(fname), f2);
+
+					outfile = FS_INVALID_HANDLE;
+					/* create a hardlink if possible, else produce just a warning unless failOnHardLinks is true */
+					if (!fs_link(ctx->fs, fname, linkname))
+					{
+						PrintMessage(_T("Warning: unable to create hard link %s [%d]"), _A2T(fname), fs_lasterror(ctx->fs));
+						if (failOnHardLinks) 
+						{
+							cm_cleanup(ctx);
+							return -3;
+						}
+					}
+					else
+					{
+						outfile = fs_create(ctx->fs, fname, FS_OPEN_EXISTING);
+						goto setTimeAndCloseFile;
+					}
+				} else 
+				{
+	            FSTIME ftm_e;
+	            FSSIZE fsz_e;
+
+	            /* written earlier so may share its data through a link (dedup), replace rather than overwrite */
+	            if (dedup && (keep != SKIP) && dd_remove(&ctx->dd, fname)) fs_remove(ctx->fs, fname);
+
+	            /* in a keep mode, decide from directory snapshot when it knows the file exists */
+	            if ((keep!=OVERWRITE) && fs_exists(ctx->fs, fname, &ftm_e, &fsz_e))
+	            {
+	              szMsg = szSKPMsg;
+	              outfile = FS_INVALID_HANDLE;
+	              /* same size, compare contents as they are read and only write from first difference on */
+	              if ((keep == SYNC) && !sparse && (fsz_e == remaining) && ((cmpfile = fs_open(ctx->fs, fname)) != FS_INVALID_HANDLE))
+	              {
+	                szMsg = NULL;  /* reported once known */
+	              }
+	              else if ((keep == SYNC) || ((keep == UPDATE) && (fs_time(tartime) > ftm_e)))
+	              {
+	                outfile = fs_create(ctx->fs, fname, FS_CREATE_ALWAYS);
+	                if (outfile == FS_INVALID_HANDLE) goto ERR_OPENING;
+	                szMsg = szSUCMsg;
+	              }
+	            }
+	            /* Open the file for writing mode, creating if doesn't exist and truncating if exists and overwrite mode */
+	            /* failed to open file, either valid error (like open) or it already exists and in a keep mode */
+	            else if ((outfile = fs_create(ctx->fs, fname, (keep==OVERWRITE)?FS_CREATE_ALWAYS:FS_CREATE_NEW)) == FS_INVALID_HANDLE)
+	            {
+	              /* if skip existing or only update existing and failed to open becauses exists */
+	              if ((keep!=OVERWRITE) && (fs_lasterror(ctx->fs)==FS_ERR_EXISTS))
+	              {
+	                /* assume skipping initially (mode==SKIP or ==UPDATE with existing file newer) */
+	                szMsg = szSKPMsg; /* and update output message accordingly */
+
+					/* if in update mode, check filetimes and reopen in overwrite mode */
+	                if (keep == SYNC)
+	                {
+                      outfile = fs_create(ctx->fs, fname, FS_CREATE_ALWAYS);
+                      if (outfile == FS_INVALID_HANDLE) goto ERR_OPENING;
+                      szMsg = szSUCMsg;
+	                }
+	                else if (keep == UPDATE)
+	                {
+                      if (!fs_getmtime(ctx->fs, fname, &ftm_e)) /* existing file time */
+                        goto ERR_OPENING;
+
+                      /* compare date+times, is one in tarball newer? */
+                      if (fs_time(tartime) > ftm_e)
+                      {
+                        outfile = fs_create(ctx->fs, fname, FS_CREATE_ALWAYS);
+                        if (outfile == FS_INVALID_HANDLE) goto ERR_OPENING;
+                        szMsg = szSUCMsg;
+                      }
+	                }
+	              }
+	              else /* in overwrite mode or failed for some other error than exists */
+	              {
+                    ERR_OPENING:
+	                PrintMessage(_T("%s%s [%d]"), szERRMsg, _A2T(fname), fs_lasterror(ctx->fs));
+	                cm_cleanup(ctx);
+	                return -2;
+	              }
+	            }
+
+ 	            /* Inform user of current extraction action (writing, skipping file XYZ) */
+	            if (szMsg != NULL) PrintMessage(_T("%s%s"), szMsg, _A2T(fname));
+
+	            /* created or truncated, so anything not written reads as zeros */
+	            skipzero = holes && (outfile != FS_INVALID_HANDLE);
+				}
+	          }
+	      }
+	      else
+	          outfile = FS_INVALID_HANDLE;
+
+	      /*
+	       * could have no contents, in which case we close the file and set the times
+	       */
+	      if (remaining > 0)
+	          getheader = 0;
+		  else
+	      {
+	          setTimeAndCloseFile:
+	          getheader = 1;
+	          if (cmpfile != FS_INVALID_HANDLE)  /* compared equal to the end */
+	          {
+	              fs_release(ctx->fs, cmpfile);
+	              cmpfile = FS_INVALID_HANDLE;
+	              if (dupname != NULL)
+	              {
+	                  /* same as earlier file, link to it instead, copy if links not supported */
+	                  TCHAR f2[1024]; /* can't call _A2T in same call as uses a static buffer */
+	                  _tcscpyn(f2, _A2T((char *)dupname), 1024);
+	                  f2[1023] = '\0';
+	                  fs_discard(ctx->fs, outfile, fname);
+	                  outfile = FS_INVALID_HANDLE;
+	                  wpos = offset;
+	                  if (fs_link(ctx->fs, fname, dupname))
+	                      PrintMessage(_T("Linked %s to %s"), _A2T(fname), f2);
+	                  else if (((outfile = fs_create(ctx->fs, fname, FS_CREATE_ALWAYS)) == FS_INVALID_HANDLE) ||
+	                           !copy_file(ctx->fs, dupname, outfile, ddsize, cmpbuf))
+	                  {
+	                      PrintMessage(_T("Error: unable to copy %s to %s"), f2, _A2T(fname));
+	                      if (outfile != FS_INVALID_HANDLE) fs_discard(ctx->fs, outfile, fname);
+	                      cm_cleanup(ctx);
+	                      return -2;
+	                  }
+	              }
+	              else
+	                  PrintMessage(_T("Unchanged %s"), _A2T(fname));
+	          }
+	          /* ends in a hole, write last byte to give file its size */
+	          if ((outfile != FS_INVALID_HANDLE) && (wpos < (sparse ? ctx->pax.map.realsize : offset)) &&
+	              !put(ctx->fs, outfile, "", 1, (sparse ? ctx->pax.map.realsize : offset) - 1, &wpos))
+	          {
+	              PrintMessage(_T("Error: write failed for %s"), _A2T(fname));
+	              fs_discard(ctx->fs, outfile, fname);
+	              cm_cleanup(ctx);
+	              return -2;
+	          }
+	          if (outfile != FS_INVALID_HANDLE)
+	          {
+	              if (!fs_close(ctx->fs, outfile, fname, tartime))
+	              {
+	                  PrintMessage(_T("Error: unable to close %s [%d]"), _A2T(fname), fs_lasterror(ctx->fs));
+	                  cm_cleanup(ctx);
+	                  return -2;
+	              }
+	              outfile = FS_INVALID_HANDLE;
+	          }
+	          if (ddsize > 0)
+	          {
+	              dd_add(&ctx->dd, fname, ddsize, ddhash);
+	              ddsize = 0;
+	          }
+		  }
+
+	      break;
+		case GNUTYPE_LONGLINK:
+		case GNUTYPE_LONGNAME:
+		{
+	      struct membuf *b = (buffer.header.typeflag == GNUTYPE_LONGNAME) ? &ctx->name : &ctx->link;
+	      int r;
+
+	      /* any length, read into buffer kept for the whole extraction */
+	      remaining = hdr.size;
+	      if ((remaining > XHDRMAX) || ((r = readData(ctx, b, 0, (unsigned long)remaining)) == -2))
+	      {
+	          PrintMessage(_T("tgz_extract: invalid long name"));
+	          cm_cleanup(ctx);
+	          return -1;
+	      }
+	      if (r < 0) return -1;
+	      b->data[(unsigned long)remaining] = '\0';
+	      if (buffer.header.typeflag == GNUTYPE_LONGNAME)
+	      {
+	          fname = ctx->name.data;
+	          getheader = 2;
+	      }
+	      else
+	          linkname = ctx->link.data;
+	      break;
+		}
+		case XHDTYPE:
+		case XGLTYPE:
+		{
+	      struct pax_info g;
+	      char *path;
+	      int r, ok;
+
+	      remaining = hdr.size;
+	      if ((remaining > XHDRMAX) || ((r = readData(ctx, &ctx->xbuf, 0, (unsigned long)remaining)) == -2))
+	      {
+	          PrintMessage(_T("tgz_extract: extended header too large"));
+	          cm_cleanup(ctx);
+	          return -1;
+	      }
+	      if (r < 0) return -1;
+	      if (buffer.header.typeflag == XHDTYPE)
+	      {
+	          pax_reset(&ctx->pax);
+	          ctx->pax.map.cnt = 0;
+	          ctx->pax.map.realsize = 0;
+	          ok = pax_parse(ctx->xbuf.data, (unsigned long)remaining, &ctx->pax);
+	          path = (ctx->pax.name != NULL) ? ctx->pax.name : ctx->pax.path;  /* sparse file's real name wins */
+	          if (ok && (path != NULL))
+	          {
+	              ok = setString(&ctx->name, path);
+	              fname = ctx->name.data;
+	              getheader = 3;
+	          }
+	          if (ok && (ctx->pax.linkpath != NULL))
+	          {
+	              ok = setString(&ctx->link, ctx->pax.linkpath);
+	              linkname = ctx->link.data;
+	          }
+	      }
+	      else  /* global, only the time applies to every member */
+	      {
+	          memset(&g, 0, sizeof(g));
+	          ok = pax_parse(ctx->xbuf.data, (unsigned long)remaining, &g);
+	          if (g.have & PAX_MTIME)
+	          {
+	              ctx->globaltime = 1;
+	              ctx->gmtime = g.mtime;
+	          }
+	          if (g.map.chunk != NULL) free(g.map.chunk);
+	      }
+	      if (!ok)
+	      {
+	          PrintMessage(_T("tgz_extract: invalid extended header"));
+	          cm_cleanup(ctx);
+	          return -1;
+	      }
+	      break;
+		}
+        default:
+/*
+	      if (action == TGZ_LIST)
+	          printf(" %s     <---> %s\n",strtime(&tartime),fname);
+*/
+	      /* skip over any contents of member types not extracted */
+	      remaining = memberSize(&hdr, &ctx->pax);
+	      offset = 0;
+	      sparse = 0;
+	      outfile = FS_INVALID_HANDLE;
+	      if (remaining > 0) getheader = 0;
+	      break;
+      }
+
+      /* extended header values (and long names) only apply to the member following it */
+      if ((buffer.header.typeflag != XHDTYPE) && (buffer.header.typeflag != XGLTYPE) &&
+          (buffer.header.typeflag != GNUTYPE_LONGNAME) && (buffer.header.typeflag != GNUTYPE_LONGLINK))
+      {
+          pax_reset(&ctx->pax);
+          linkname = NULL;
+      }
+    }
+    else  /* (getheader == 0) */
+    {
+      unsigned int bytes = (remaining > BLOCKSIZE) ? BLOCKSIZE : (unsigned int)remaining;
+
+      /* first block of a new file, look for an earlier one it may duplicate */
+      if (dedup && !sparse && (offset == 0) && (outfile != FS_INVALID_HANDLE))
+      {
+          const char *dup;
+
+          ddsize = remaining;
+          ddhash = crc32(crc32(0L, Z_NULL, 0), (const Bytef *)blk->buffer, bytes);
+          if (((dup = dd_find(&ctx->dd, ddsize, ddhash)) != NULL) && ((cmpfile = fs_open(ctx->fs, dup)) != FS_INVALID_HANDLE))
+              dupname = dup;
+      }
+
+      if (cmpfile != FS_INVALID_HANDLE)
+      {
+          unsigned int pos = (unsigned int)offset & (CMPCHUNK - 1);
+
+          if (pos == 0) cmplen = fs_read(ctx->fs, cmpfile, cmpbuf, CMPCHUNK, offset);
+          if ((cmplen < (int)(pos + bytes)) || (memcmp(cmpbuf + pos, blk->buffer, bytes) != 0))
+          {
+              if (dupname != NULL)
+              {
+                  /* differs from earlier file here, copy the part that matched then write the rest */
+                  fs_release(ctx->fs, cmpfile);
+                  cmpfile = FS_INVALID_HANDLE;
+                  if ((offset > 0) && !copy_file(ctx->fs, dupname, outfile, offset, cmpbuf))
+                  {
+                      PrintMessage(_T("Error: write failed for %s"), _A2T(fname));
+                      fs_discard(ctx->fs, outfile, fname);
+                      cm_cleanup(ctx);
+                      return -2;
+                  }
+                  dupname = NULL;
+                  wpos = offset;
+              }
+              else
+              {
+                  /* differs from here, earlier part already matches so write just the rest */
+                  PrintMessage(_T("Writing %s"), _A2T(fname));
+                  outfile = fs_reopen(ctx->fs, cmpfile, fname, offset);
+                  cmpfile = FS_INVALID_HANDLE;
+                  wpos = offset;
+                  if (outfile == FS_INVALID_HANDLE)
+                  {
+                      PrintMessage(_T("Error: Could not create file %s [%d]"), _A2T(fname), fs_lasterror(ctx->fs));
+                      cm_cleanup(ctx);
+                      return -2;
+                  }
+              }
+          }
+      }
+      if ((outfile != FS_INVALID_HANDLE) && (cmpfile == FS_INVALID_HANDLE))
+      {
+          int ok = 1;
+
+          if (!sparse)
+          {
+              if (!(skipzero && zeroblock(blk->buffer, bytes)))
+                  ok = put(ctx->fs, outfile, blk->buffer, bytes, offset, &wpos);
+          }
+          else
+          {
+              /* stored data is the map's chunks back to back, a block may span several */
+              const char *p = blk->buffer;
+              unsigned int n = bytes;
+
+              while (ok && (n > 0) && (spi < ctx->pax.map.cnt))
+              {
+                  struct sparse_chunk *c = &ctx->pax.map.chunk[spi];
+                  unsigned int take = (c->size - spoff < n) ? (unsigned int)(c->size - spoff) : n;
+
+                  if ((take > 0) && !(skipzero && zeroblock(p, take)))
+                      ok = put(ctx->fs, outfile, p, take, c->offset + spoff, &wpos);
+                  p += take;
+                  n -= take;
+                  spoff += take;
+                  if (spoff == c->size)
+                  {
+                      spi++;
+                      spoff = 0;
+                  }
+              }
+          }
+		  if (!ok)
+          {
+			  PrintMessage(_T("Error: write failed for %s"), _A2T(fname));
+              fs_discard(ctx->fs, outfile, fname);
+
+              cm_cleanup(ctx);
+              return -2;
+          }
+      }
+      /* nothing written from the rest either, pass over it */
+      if ((outfile == FS_INVALID_HANDLE) && (cmpfile == FS_INVALID_HANDLE) && (remaining > BLOCKSIZE))
+      {
+          if (skipData(ctx, (remaining - 1) & ~(FSSIZE)(BLOCKSIZE - 1)) < 0)
+              return -1;
+          remaining = bytes;
+      }
+      remaining -= bytes;
+      offset += bytes;
+      if (remaining == 0) goto setTimeAndCloseFile;
+    }
+  } /* while(1) */
+  
+  cm_cleanup(ctx);
+
+  return 0;
+}
+
+TGZCTX *tgz_new(FSCTX *out)
+{
+  TGZCTX *ctx = (TGZCTX *)calloc(1, sizeof(TGZCTX));
+
+  if (ctx == NULL)
+  {
+    fs_free(out);
+    return NULL;
+  }
+  ctx->fs = out;
+  return ctx;
+}
+
+
+void tgz_free(TGZCTX *ctx)
+{
+  if (ctx == NULL) return;
+  if (ctx->cmpbuf != NULL) free(ctx->cmpbuf);
+  if (ctx->xbuf.data != NULL) free(ctx->xbuf.data);
+  if (ctx->name.data != NULL) free(ctx->name.data);
+  if (ctx->link.data != NULL) free(ctx->link.data);
+  if (ctx->pax.map.chunk != NULL) free(ctx->pax.map.chunk);
+  fs_free(ctx->fs);
+  free(ctx);
+}
+
+
+void tgz_memlimit(TGZCTX *ctx, unsigned long mb)
+{
+  unsigned long maxmem, bufmem;
+
+  maxmem = (mb > ((unsigned long)-1 >> 20)) ? (unsigned long)-1 : mb << 20;
+  if (maxmem == 0)
+  {
+    fs_buffers(ctx->fs, 0);
+    ctx->decmem = 0;
+    return;
+  }
+
+  /* a quarter for queued output, the rest (at least 1) for the decoder;
+     state kept from earlier extractions would only count against it */
+  bufmem = fs_buffers(ctx->fs, maxmem / 4);
+  ctx->decmem = (bufmem < maxmem) ? maxmem - bufmem : 1;
+  dpool_trim();
+}
+
+
+void tgz_decthreads(TGZCTX *ctx, int n)
+{
+  ctx->decthreads = (n < 0) ? 0 : n;
+}
+
+
+int tgz_extract(TGZCTX *ctx, gzFile in, int cm, int junkPaths, enum KeepMode keep, int iCnt, char *iList[], int xCnt, char *xList[], int failOnHardLinks, int dedup, int holes)
+{
+  int result;
+
+  /* state left from any earlier extraction */
+  pax_reset(&ctx->pax);
+  ctx->pax.map.cnt = 0;
+  ctx->globaltime = 0;
+
+  /* without a buffer to compare with, sync is just overwrite and no dedup */
+  if (((keep == SYNC) || dedup) && (ctx->cmpbuf == NULL) &&
+      ((ctx->cmpbuf = (char *)malloc(CMPCHUNK)) == NULL))
+  {
+    if (keep == SYNC) keep = OVERWRITE;
+    dedup = 0;
+  }
+
+  result = extract_members(ctx, in, cm, junkPaths, keep, iCnt, iList, xCnt, xList, failOnHardLinks, dedup, holes);
+  dd_clear(&ctx->dd);
+
+  /* wait for any queued output, even if stopped early, so nothing (worker
+     threads included) is left running; failures have been reported */
+  if (!fs_flush(ctx->fs) && (result >= 0)) result = -2;
+  return result;
+}
+
+
+
+/* Parallel extraction of a mapped uncompressed tarball
+ *
+ * The headers are scanned first (they are at known offsets once the
+ * tarball is mapped), then directories are made and the members handed
+ * to writer threads, each with its own output context (fs_clone).
+ * Members over 2 * RANGESIZE are split into ranges written at once.
+ * Only an earlier member whose name is written again later is dropped
+ * (last one wins); members of names a hard link uses (as either name)
+ * are written in archive order here, and links wait for writes already
+ * handed out, so links see the same files as they would extracting in
+ * order.
+ */
+
+#define RANGESHIFT 23
+#define RANGESIZE  (1UL << RANGESHIFT)  /* members are split into ranges this size */
+#define WRITECHUNK (1UL << 20)  /* largest single fs_write */
+
+/* member found by the header scan */
+struct pmember {
+  unsigned  name;       /* offset in plan names as extracted, 0 if directory only */
+  unsigned  link;       /* hard link target, 0 if a file */
+  unsigned  dir;        /* directory to make first, 0 if none */
+  int       write;      /* 0 if a later member has the same name */
+  int       linked;     /* name is used by a hard link, write in order */
+  FSSIZE    data;       /* offset of data in tarball */
+  FSSIZE    size;
+  time_t    tartime;
+  unsigned  left;       /* ranges not yet finished, under plan lock */
+  int       failed;     /* a range failed, under plan lock */
+};
+
+/* part of a member for one writer */
+struct prange {
+  struct plan    *p;
+  struct pmember *m;
+  FSSIZE          offset;
+  FSSIZE          len;
+  int             whole;     /* creates and finishes file itself */
+};
+
+/* name seen by the scan, for finding later members of the same name */
+struct pname {
+  unsigned  name;       /* offset in plan names, 0 if slot empty */
+  unsigned  hash;
+  int       last;       /* latest file member of this name, -1 if none */
+  int       linked;
+};
+
+struct plan {
+  TGZCTX         *ctx;
+  const char     *map;      /* whole tarball */
+  FSSIZE          size;
+  struct pmember *m;
+  unsigned        cnt, alloc;
+  struct membuf   names;    /* member names back to back */
+  unsigned long   namesused;
+  struct pname   *tab;
+  unsigned        tabsize;
+  struct prange  *r;
+  unsigned        rcnt;
+  LOCK            lock;     /* protects result and member left/failed */
+  int             result;   /* -2 once a writer fails */
+  FSCTX          *fs[POOL_MAXWORKERS];
+};
+
+#ifdef _WIN32
+#define PFOLD(c) ((((c) >= 'A') && ((c) <= 'Z')) ? ((c) + 'a' - 'A') : (c))
+#else
+#define PFOLD(c) (c)
+#endif
+
+/* returns table entry for name (as matched by the file system), adding it
+   if new; NULL if out of memory */
+static struct pname *pname_find(struct plan *p, unsigned name)
+{
+  const char *s = p->names.data + name, *a, *b;
+  unsigned h = 2166136261U, i;   /* FNV-1a */
+
+  for (a = s; *a; a++)
+  {
+    h ^= (unsigned char)PFOLD(*a);
+    h *= 16777619U;
+  }
+  if (p->tabsize == 0)
+  {
+    for (p->tabsize = 1024; p->tabsize < 4 * p->cnt; p->tabsize *= 2) ;  /* names and link targets, under half full */
+    if ((p->tab = (struct pname *)calloc(p->tabsize, sizeof(struct pname))) == NULL) return NULL;
+  }
+  for (i = h & (p->tabsize - 1); p->tab[i].name != 0; i = (i + 1) & (p->tabsize - 1))
+  {
+    if (p->tab[i].hash != h) continue;
+    for (a = s, b = p->names.data + p->tab[i].name; *a && (PFOLD(*a) == PFOLD(*b)); a++, b++) ;
+    if (PFOLD(*a) == PFOLD(*b)) return &p->tab[i];
+  }
+  p->tab[i].name = name;
+  p->tab[i].hash = h;
+  p->tab[i].last = -1;
+  return &p->tab[i];
+}
+
+/* appends len chars of s to names, returns its offset or 0 if out of memory */
+static unsigned addname(struct plan *p, const char *s, unsigned len)
+{
+  unsigned long at = p->namesused ? p->namesused : 1;   /* 0 means none */
+
+  if (!reserve(&p->names, at + len + 1)) return 0;
+  memcpy(p->names.data + at, s, len);
+  p->names.data[at + len] = '\0';
+  p->namesused = at + len + 1;
+  return (unsigned)at;
+}
+
+/* adds member, NULL if out of memory */
+static struct pmember *addmember(struct plan *p)
+{
+  if (p->cnt == p->alloc)
+  {
+    unsigned n = p->alloc ? p->alloc * 2 : 1024;
+    struct pmember *m = (struct pmember *)realloc(p->m, n * sizeof(struct pmember));
+    if (m == NULL) return NULL;
+    p->m = m;
+    p->alloc = n;
+  }
+  memset(&p->m[p->cnt], 0, sizeof(struct pmember));
+  p->m[p->cnt].write = 1;
+  return &p->m[p->cnt++];
+}
+
+/* copies len bytes of member data at pos to b, terminated */
+static int copyData(struct plan *p, struct membuf *b, FSSIZE pos, unsigned long len)
+{
+  if (!reserve(b, len + 1)) return 0;
+  memcpy(b->data, p->map + pos, len);
+  b->data[len] = '\0';
+  return 1;
+}
+
+/* scans headers into plan, as extract_members would take them; returns
+   0 if tgz_extract should extract the tarball instead, as it has members
+   only it handles (sparse) or is invalid (so the usual messages report
+   it) or memory ran out */
+static int scan(struct plan *p, int junkPaths, int iCnt, char *iList[], int xCnt, char *xList[])
+{
+  TGZCTX *ctx = p->ctx;
+  union tar_buffer buffer;
+  struct tar_fields hdr;
+  int valid;
+  FSSIZE pos = 0, remaining;
+  char *linkname = NULL;    /* long link name for next member */
+  int longname = 0;         /* ctx->name holds name for next member */
+  time_t tartime;
+  unsigned i;
+
+  if (!reserve(&ctx->name, BLOCKSIZE) || !reserve(&ctx->link, BLOCKSIZE)) return 0;
+  while (1)
+  {
+    char *fname;
+
+    if (p->size - pos < BLOCKSIZE) return 0;   /* no end of archive block */
+    memcpy(&buffer, p->map + pos, BLOCKSIZE);
+    pos += BLOCKSIZE;
+    valid = tar_decode(&buffer, &hdr);
+    if (hdr.zero || (buffer.header.name[0] == 0)) break;
+    if (!valid) return 0;
+
+    if (ctx->pax.have & PAX_MTIME)
+      tartime = ctx->pax.mtime;
+    else if (ctx->globaltime)
+      tartime = ctx->gmtime;
+    else
+      tartime = (time_t)hdr.mtime;
+    if (!longname) getFullName(&buffer, ctx->name.data);
+    fname = ctx->name.data;
+
+    remaining = memberSize(&hdr, &ctx->pax);
+    if (remaining > p->size - pos) return 0;   /* truncated */
+
+    switch (buffer.header.typeflag)
+    {
+      case LNKTYPE:
+      case CONTTYPE:
+      case REGTYPE:
+      case AREGTYPE:
+        if (!(*fname && (fname[strlen(fname)-1] == '/')))
+        {
+          struct pmember *m;
+          char *sep;
+
+          /* a link's data would be taken as headers, leave such oddities to tgz_extract */
+          if ((ctx->pax.sparse != PAX_SPARSE_NONE) || ((buffer.header.typeflag == LNKTYPE) && (remaining > 0)))
+            return 0;
+          if (!(((iList == NULL) || matchname(fname, iCnt, iList, junkPaths)) && !matchname(fname, xCnt, xList, junkPaths)))
+            break;
+          if ((m = addmember(p)) == NULL) return 0;
+          m->data = pos;
+          m->size = remaining;
+          m->tartime = tartime;
+          sep = strrchr(fname, '/');
+          if (!junkPaths)
+          {
+            if ((sep != NULL) && ((m->dir = addname(p, fname, (unsigned)(sep - fname))) == 0)) return 0;
+          }
+          else if (sep != NULL)
+            MoveMemory(fname, sep+1, strlen(sep+1) + 1);
+          if (!*fname)
+          {
+            if (!m->dir) p->cnt--;   /* nothing left of name, at most its directory made */
+            break;
+          }
+          safetyStrip(fname);
+          if ((m->name = addname(p, fname, strlen(fname))) == 0) return 0;
+          if (buffer.header.typeflag == LNKTYPE)
+          {
+            if (linkname == NULL)  /* header field, may fill it without terminator */
+            {
+              memcpy(ctx->link.data, buffer.header.linkname, sizeof(buffer.header.linkname));
+              ctx->link.data[sizeof(buffer.header.linkname)] = '\0';
+              linkname = ctx->link.data;
+            }
+            if ((m->link = addname(p, linkname, strlen(linkname))) == 0) return 0;
+          }
+          break;
+        }
+        /* else a BSD tar directory entry */
+      case DIRTYPE:
+        if (!junkPaths)
+        {
+          struct pmember *m;
+
+          safetyStrip(fname);
+          if (((m = addmember(p)) == NULL) || ((m->dir = addname(p, fname, strlen(fname))) == 0)) return 0;
+        }
+        break;
+      case GNUTYPE_SPARSE:
+        return 0;
+      case GNUTYPE_LONGLINK:
+      case GNUTYPE_LONGNAME:
+        if ((remaining > XHDRMAX) ||
+            !copyData(p, (buffer.header.typeflag == GNUTYPE_LONGNAME) ? &ctx->name : &ctx->link, pos, (unsigned long)remaining))
+          return 0;
+        if (buffer.header.typeflag == GNUTYPE_LONGNAME)
+          longname = 1;
+        else
+          linkname = ctx->link.data;
+        break;
+      case XHDTYPE:
+      case XGLTYPE:
+      {
+        struct pax_info g;
+        char *path;
+        int ok;
+
+        if ((remaining > XHDRMAX) || !copyData(p, &ctx->xbuf, pos, (unsigned long)remaining)) return 0;
+        if (buffer.header.typeflag == XHDTYPE)
+        {
+          pax_reset(&ctx->pax);
+          ctx->pax.map.cnt = 0;
+          ctx->pax.map.realsize = 0;
+          ok = pax_parse(ctx->xbuf.data, (unsigned long)remaining, &ctx->pax);
+          path = (ctx->pax.name != NULL) ? ctx->pax.name : ctx->pax.path;
+          if (ok && (path != NULL))
+          {
+            ok = setString(&ctx->name, path);
+            longname = 1;
+          }
+          if (ok && (ctx->pax.linkpath != NULL))
+          {
+            ok = setString(&ctx->link, ctx->pax.linkpath);
+            linkname = ctx->link.data;
+          }
+        }
+        else
+        {
+          memset(&g, 0, sizeof(g));
+          ok = pax_parse(ctx->xbuf.data, (unsigned long)remaining, &g);
+          if (g.have & PAX_MTIME)
+          {
+            ctx->globaltime = 1;
+            ctx->gmtime = g.mtime;
+          }
+          if (g.map.chunk != NULL) free(g.map.chunk);
+        }
+        if (!ok) return 0;
+        break;
+      }
+      default:
+        break;   /* data skipped */
+    }
+
+    if ((buffer.header.typeflag != XHDTYPE) && (buffer.header.typeflag != XGLTYPE) &&
+        (buffer.header.typeflag != GNUTYPE_LONGNAME) && (buffer.header.typeflag != GNUTYPE_LONGLINK))
+    {
+      pax_reset(&ctx->pax);
+      linkname = NULL;
+      longname = 0;
+    }
+    pos += (remaining + BLOCKSIZE - 1) & ~(FSSIZE)(BLOCKSIZE - 1);
+  }
+
+  /* last member of a name wins, unless a hard link uses it in between */
+  for (i = 0; i < p->cnt; i++)
+  {
+    struct pmember *m = &p->m[i];
+    struct pname *n, *t;
+
+    if (m->name == 0) continue;
+    if ((n = pname_find(p, m->name)) == NULL) return 0;
+    if (m->link)
+    {
+      if ((t = pname_find(p, m->link)) == NULL) return 0;
+      n->linked = t->linked = 1;
+    }
+    else
+    {
+      if ((n->last >= 0) && !n->linked) p->m[n->last].write = 0;
+      n->last = (int)i;
+    }
+  }
+  for (i = 0; i < p->cnt; i++)
+    if (p->m[i].name && !p->m[i].link) p->m[i].linked = pname_find(p, p->m[i].name)->linked;
+  return 1;
+}
+
+
+/* writes range of member, run by a writer (or here, with fs the plan's) */
+static void write_range(struct plan *p, FSCTX *fs, struct prange *r)
+{
+  struct pmember *m = r->m;
+  const char *fname = p->names.data + m->name;
+  FSHANDLE h = FS_INVALID_HANDLE;
+  FSSIZE done = 0;
+  int ok, last;
+
+  lock_acquire(&p->lock);
+  ok = (p->result >= 0);   /* nothing more once one fails */
+  lock_release(&p->lock);
+
+  if (ok)
+  {
+    h = r->whole ? fs_create(fs, fname, FS_CREATE_ALWAYS) : fs_openrange(fs, fname, r->offset);
+    if (h == FS_INVALID_HANDLE)
+    {
+      PrintMessage(_T("Error: Could not create file %s [%d]"), _A2T((char *)fname), fs_lasterror(fs));
+      ok = 0;
+    }
+  }
+  while (ok && (done < r->len))
+  {
+    unsigned n = (r->len - done > WRITECHUNK) ? WRITECHUNK : (unsigned)(r->len - done);
+    ok = fs_write(fs, h, p->map + m->data + r->offset + done, n, r->offset + done);
+    done += n;
+  }
+  if ((h != FS_INVALID_HANDLE) && !ok)
+    PrintMessage(_T("Error: write failed for %s"), _A2T((char *)fname));
+
+  if (r->whole)
+  {
+    if ((h != FS_INVALID_HANDLE) && !ok)
+      fs_discard(fs, h, fname);
+    else if (ok && !fs_close(fs, h, fname, m->tartime))
+    {
+      PrintMessage(_T("Error: unable to close %s [%d]"), _A2T((char *)fname), fs_lasterror(fs));
+      ok = 0;
+    }
+    last = 0;
+  }
+  else
+  {
+    /* last range to finish sets the time, once every other handle is closed */
+    if (h != FS_INVALID_HANDLE) fs_release(fs, h);
+    lock_acquire(&p->lock);
+    if (!ok) m->failed = 1;
+    last = (--m->left == 0);
+    lock_release(&p->lock);
+    if (last && m->failed)
+      fs_remove(fs, fname);
+    else if (last && (((h = fs_openrange(fs, fname, 0)) == FS_INVALID_HANDLE) || !fs_close(fs, h, fname, m->tartime)))
+    {
+      PrintMessage(_T("Error: unable to close %s [%d]"), _A2T((char *)fname), fs_lasterror(fs));
+      ok = 0;
+    }
+  }
+  if (!ok)
+  {
+    lock_acquire(&p->lock);
+    p->result = -2;
+    lock_release(&p->lock);
+  }
+}
+
+static void write_task(struct pool *pl, int worker, void *arg)
+{
+  struct prange *r = (struct prange *)arg;
+  write_range(r->p, r->p->fs[worker], r);
+}
+
+/* hands range to a writer, or writes it here if none can take it */
+static void submit(struct plan *p, struct pool *pl, struct prange *r)
+{
+  if ((pl == NULL) || !pool_submit(pl, -1, write_task, r))
+    write_range(p, p->ctx->fs, r);
+}
+
+
+/* makes directories then writes members of scanned plan, returns as tgz_extract */
+static int write_members(struct plan *p, int nthreads, int failOnHardLinks)
+{
+  FSCTX *fs = p->ctx->fs;
+  struct pool *pl;
+  const char *lastdir = NULL;
+  int handed = 0;       /* ranges handed out since last pool_wait */
+  int result = 0, nw = 0;
+  unsigned i, rcnt = 0;
+
+  /* one range per member, more for large ones */
+  for (i = 0; i < p->cnt; i++)
+    if (p->m[i].name && !p->m[i].link && p->m[i].write)
+      rcnt += (p->m[i].size > 2 * RANGESIZE) ? (unsigned)((p->m[i].size + RANGESIZE - 1) >> RANGESHIFT) : 1;
+  if ((p->r = (struct prange *)malloc((rcnt ? rcnt : 1) * sizeof(struct prange))) == NULL)
+  {
+    PrintMessage(_T("tgz_extract: out of memory"));
+    return -2;
+  }
+
+  for (i = 0; i < p->cnt; i++)
+  {
+    const char *dir = p->names.data + p->m[i].dir;
+    if (p->m[i].dir && ((lastdir == NULL) || (strcmp(dir, lastdir) != 0)))
+    {
+      makedir(fs, (char *)dir);
+      lastdir = dir;
+    }
+  }
+
+  if ((pl = pool_new(nthreads)) != NULL)
+  {
+    for (nw = 0; nw < pool_size(pl); nw++)
+      if ((p->fs[nw] = fs_clone(fs)) == NULL) break;
+    if (nw < pool_size(pl))
+    {
+      pool_free(pl);
+      pl = NULL;
+    }
+  }
+
+  for (i = 0; i < p->cnt; i++)
+  {
+    struct pmember *m = &p->m[i];
+    const char *fname = p->names.data + m->name;
+
+    lock_acquire(&p->lock);
+    result = p->result;
+    lock_release(&p->lock);
+    if (result < 0) break;
+    if ((m->name == 0) || !m->write) continue;
+
+    if (m->link)
+    {
+      const char *linkname = p->names.data + m->link;
+      TCHAR f2[1024]; /* can't call _A2T in same call as uses a static buffer */
+      FSHANDLE h;
+
+      /* target may be a file just handed out */
+      if (handed && (pl != NULL)) pool_wait(pl);
+      handed = 0;
+      _tcscpyn(f2, _A2T((char *)linkname), 1024);
+      f2[1023] = '\0';
+      PrintMessage(_T("Hard link %s to %s"), _A2T((char *)fname), f2);
+      if (!fs_link(fs, fname, linkname))
+      {
+        PrintMessage(_T("Warning: unable to create hard link %s [%d]"), _A2T((char *)fname), fs_lasterror(fs));
+        if (failOnHardLinks)
+        {
+          result = -3;
+          break;
+        }
+      }
+      else if (((h = fs_create(fs, fname, FS_OPEN_EXISTING)) != FS_INVALID_HANDLE) && !fs_close(fs, h, fname, m->tartime))
+      {
+        PrintMessage(_T("Error: unable to close %s [%d]"), _A2T((char *)fname), fs_lasterror(fs));
+        result = -2;
+        break;
+      }
+    }
+    else
+    {
+      struct prange *r = &p->r[p->rcnt];
+
+      PrintMessage(_T("Writing %s"), _A2T((char *)fname));
+      r->p = p;
+      r->m = m;
+      r->offset = 0;
+      r->len = m->size;
+      r->whole = 1;
+      if (m->linked)
+      {
+        /* may share its data with another name, so written in order */
+        p->rcnt++;
+        write_range(p, fs, r);
+      }
+      else if (m->size <= 2 * RANGESIZE)
+      {
+        p->rcnt++;
+        submit(p, pl, r);
+        handed++;
+      }
+      else
+      {
+        /* created here at its full size, then ranges written at once,
+           started in order (the pool takes them oldest first) */
+        FSHANDLE h = fs_create(fs, fname, FS_CREATE_ALWAYS);
+        FSSIZE at;
+
+        if ((h == FS_INVALID_HANDLE) || !fs_setsize(fs, h, m->size))
+        {
+          PrintMessage(_T("Error: Could not create file %s [%d]"), _A2T((char *)fname), fs_lasterror(fs));
+          if (h != FS_INVALID_HANDLE) fs_discard(fs, h, fname);
+          result = -2;
+          break;
+        }
+        fs_release(fs, h);
+        m->left = (unsigned)((m->size + RANGESIZE - 1) >> RANGESHIFT);
+        for (at = 0; at < m->size; at += RANGESIZE)
+        {
+          r = &p->r[p->rcnt++];
+          r->p = p;
+          r->m = m;
+          r->offset = at;
+          r->len = (m->size - at > RANGESIZE) ? RANGESIZE : m->size - at;
+          r->whole = 0;
+        }
+        for (r = &p->r[p->rcnt - m->left]; r < &p->r[p->rcnt]; r++)
+        {
+          submit(p, pl, r);
+          handed++;
+        }
+      }
+    }
+  }
+
+  pool_free(pl);   /* waits for every range handed out */
+  while (nw > 0) fs_free(p->fs[--nw]);
+  if ((result >= 0) && (p->result < 0)) result = p->result;
+  return result;
+}
+
+
+int tgz_extract_parallel(TGZCTX *ctx, gzFile in, const char *tarball, int nthreads, int cm, int junkPaths, enum KeepMode keep, int iCnt, char *iList[], int xCnt, char *xList[], int failOnHardLinks, int dedup, int holes)
+{
+  const struct tgz_codec *c = codec_find(cm);
+  struct plan p;
+  int result, async;
+
+  /* plain overwrite of an uncompressed tarball only, all else as before */
+  memset(&p, 0, sizeof(p));
+  if ((c == NULL) || !(c->flags & CODEC_SEEKABLE) || (keep != OVERWRITE) || dedup || holes ||
+      ((p.map = fs_map(tarball, &p.size)) == NULL))
+    return tgz_extract(ctx, in, cm, junkPaths, keep, iCnt, iList, xCnt, xList, failOnHardLinks, dedup, holes);
+
+  p.ctx = ctx;
+  pax_reset(&ctx->pax);
+  ctx->pax.map.cnt = 0;
+  ctx->globaltime = 0;
+  if (!scan(&p, junkPaths, iCnt, iList, xCnt, xList))
+    result = 1;   /* extract in order instead */
+  else
+  {
+    gzclose(in);
+    lock_init(&p.lock);
+    async = fs_async(ctx->fs, 0);   /* files made here must exist for the writers */
+    result = write_members(&p, nthreads, failOnHardLinks);
+    fs_async(ctx->fs, async);
+    lock_free(&p.lock);
+    if (!fs_flush(ctx->fs) && (result >= 0)) result = -2;
+  }
+
+  if (p.m != NULL) free(p.m);
+  if (p.names.data != NULL) free(p.names.data);
+  if (p.tab != NULL) free(p.tab);
+  if (p.r != NULL) free(p.r);
+  fs_unmap(p.map, p.size);
+  if (result > 0)
+    result = tgz_extract(ctx, in, cm, junkPaths, keep, iCnt, iList, xCnt, xList, failOnHardLinks, dedup, holes);
+  return result;
+}
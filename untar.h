@@ -1,107 +1,245 @@
-/*
- * tgz_extract functions based on code within zlib library
- * No additional copyright added, KJD <jeremyd@computer.org>
- *
- *   This software is provided 'as-is', without any express or implied
- *   warranty.  In no event will the authors be held liable for any damages
- *   arising from the use of this software.
- *
- * untgz.c -- Display contents and/or extract file from
- * a gzip'd TAR file
- * written by "Pedro A. Aranda Guti\irrez" <paag@tid.es>
- * adaptation to Unix by Jean-loup Gailly <jloup@gzip.org>
- */
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-/* mini Standard C library replacement */
-#include "miniclib.h"
-
-/* library upon which all this work based on/requires */
-#include "zlib/zlib.h"
-
-#define CM_AUTO -1 /* flags during init to auto guess file type */
-#define CM_NONE 0  /* no compression */
-#define CM_GZ   1  /* gz compressed */
-#define CM_LZMA 2  /* lzma compressed */
-#define CM_BZ2  3  /* bzip2 compressed */
-#define CM_Z    4  /* unsupported, compress compressed */
-
-/* comment out to disable support for unneeded compression methods */
-/* NONE and GZ are always enabled */
-#define ENABLE_LZMA
-#define ENABLE_BZ2
-/* #define ENABLE_Z */
-
-/* action to perform when extracting file from tarball */
-enum KeepMode {
-  OVERWRITE=0, /* default, overwrite file if exists */
-  SKIP,        /* if file exists, skip extraction (keep all existing files) */
-  UPDATE,      /* if file exists and newer, skip extraction (extract only if archived file is newer) */
-};
-
-/* actual extraction routine */
-int tgz_extract(gzFile tgzFile, int cm, int junkPaths, enum KeepMode keep, int iCnt, char *iList[], int xCnt, char *xList[], int failOnHardLinks);
-
-/* recursive make directory */
-/* abort if you get an ENOENT errno somewhere in the middle */
-/* e.g. ignore error "mkdir on existing directory" */
-/* */
-/* return 1 if OK */
-/*        0 on error */
-int makedir (char *newdir);
-
-
-/* tar header */
-
-#define BLOCKSIZE 512
-#define SHORTNAMESIZE 100
-#define PFXNAMESIZE 155
-
-struct tar_header
-{                       /* byte offset */
-  char name[100];       /*   0 */
-  char mode[8];         /* 100 */
-  char uid[8];          /* 108 */
-  char gid[8];          /* 116 */
-  char size[12];        /* 124 */
-  char mtime[12];       /* 136 */
-  char chksum[8];       /* 148 */
-  char typeflag;        /* 156 */
-  char linkname[100];   /* 157 */
-  char magic[6];        /* 257 */ /* older gnu tar combines magic+version = 'uname  \0' */
-  char version[2];      /* 263 */ /* posix has magic = 'uname\0' and version = '00' */
-  char uname[32];       /* 265 */
-  char gname[32];       /* 297 */
-  char devmajor[8];     /* 329 */
-  char devminor[8];     /* 337 */
-  char prefix[155];     /* 345 */
-  char fill[12];         /* 500 */ /* unused */
-};
-
-union tar_buffer {
-  char               buffer[BLOCKSIZE];
-  struct tar_header  header;
-};
-
-
-/* validate checksum */
-/* returns 0 if failed check */
-/* returns nonzero if either or signed/unsigned checksum matches */
-int valid_checksum(struct tar_header *header);
-
-
-/* uses filename & file contents and returns best guess of file type CM_* */
-int getFileType(const char *fname);
-
-
-/* !!!USER SUPPLIED!!! */
-/* wrap around whatever you want to send error messages to user, c function */
-void PrintMessage(const TCHAR *msg, ...);
-
-
-#ifdef __cplusplus
-}
-#endif
+/*
+ * tgz_extract functions based on code within zlib library
+ * No additional copyright added, KJD <jeremyd@computer.org>
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * untgz.c -- Display contents and/or extract file from
+ * a gzip'd TAR file
+ * written by "Pedro A. Aranda Guti\irrez" <paag@tid.es>
+ * adaptation to Unix by Jean-loup Gailly <jloup@gzip.org>
+ */
+
+#ifndef _UNTAR_H_
+#define _UNTAR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* mini Standard C library replacement */
+#include "miniclib.h"
+
+/* library upon which all this work based on/requires */
+#include "zlib/zlib.h"
+
+/* FSSIZE, 64 bit member sizes and offsets */
+#include "fsio.h"
+
+#define CM_AUTO -1 /* flags during init to auto guess file type */
+#define CM_NONE 0  /* no compression */
+#define CM_GZ   1  /* gz compressed */
+#define CM_LZMA 2  /* lzma compressed */
+#define CM_BZ2  3  /* bzip2 compressed */
+#define CM_Z    4  /* unsupported, compress compressed */
+#define CM_XZ   5  /* xz compressed */
+#define CM_ZSTD 6  /* zstd compressed */
+#define CM_LZ4  7  /* lz4 compressed */
+
+/* comment out to disable support for unneeded compression methods */
+/* NONE and GZ are always enabled */
+#define ENABLE_LZMA
+#define ENABLE_BZ2
+#define ENABLE_XZ
+#define ENABLE_ZSTD
+#define ENABLE_LZ4
+/* #define ENABLE_Z */
+
+/* action to perform when extracting file from tarball */
+enum KeepMode {
+  OVERWRITE=0, /* default, overwrite file if exists */
+  SKIP,        /* if file exists, skip extraction (keep all existing files) */
+  UPDATE,      /* if file exists and newer, skip extraction (extract only if archived file is newer) */
+  SYNC,        /* if file exists with same size, compare contents and only write if they differ */
+};
+
+/* extraction context, owns decoder state, buffers (reused from one
+   tgz_extract to the next) and the output context; separate contexts
+   may extract at the same time from different threads */
+typedef struct tgz_ctx TGZCTX;
+
+/* returns new context writing through out, which it takes over (it is
+   freed by tgz_free, or here if out of memory); NULL if out of memory */
+TGZCTX *tgz_new(FSCTX *out);
+
+/* frees context and its output context */
+void tgz_free(TGZCTX *ctx);
+
+/* limits memory of following extractions (decoder state and queued
+   output) to about mb megabytes (MiB), 0 for no limit: bzip2 uses its
+   small decoder if the fast one won't fit, output buffers are reduced,
+   and streams needing more (lzma dictionaries) fail with a message (-1) */
+void tgz_memlimit(TGZCTX *ctx, unsigned long mb);
+
+/* decoders that decode parts of a stream on threads of their own
+   (CODEC_PARALLEL: xz, zstd) use up to n of them in following
+   extractions, 0 for one per processor (the default); the others always
+   decode on the extracting thread */
+void tgz_decthreads(TGZCTX *ctx, int n);
+
+/* actual extraction routine */
+int tgz_extract(TGZCTX *ctx, gzFile tgzFile, int cm, int junkPaths, enum KeepMode keep, int iCnt, char *iList[], int xCnt, char *xList[], int failOnHardLinks, int dedup, int holes);
+
+/* as tgz_extract, but an uncompressed tarball (cm CM_NONE) extracted
+   with plain overwrite is mapped (tarball is the name it was opened by)
+   and its members written by nthreads threads at once, one per processor
+   if 0; anything else, or a tarball it can't map or that has members
+   only tgz_extract handles (sparse), is passed on to tgz_extract */
+int tgz_extract_parallel(TGZCTX *ctx, gzFile tgzFile, const char *tarball, int nthreads, int cm, int junkPaths, enum KeepMode keep, int iCnt, char *iList[], int xCnt, char *xList[], int failOnHardLinks, int dedup, int holes);
+
+/* recursive make directory */
+/* abort if you get an ENOENT errno somewhere in the middle */
+/* e.g. ignore error "mkdir on existing directory" */
+/* */
+/* return 1 if OK */
+/*        0 on error */
+int makedir (FSCTX *fs, char *newdir);
+
+
+/* tar header */
+
+#define BLOCKSIZE 512
+#define SHORTNAMESIZE 100
+#define PFXNAMESIZE 155
+
+struct tar_header
+{                       /* byte offset */
+  char name[100];       /*   0 */
+  char mode[8];         /* 100 */
+  char uid[8];          /* 108 */
+  char gid[8];          /* 116 */
+  char size[12];        /* 124 */
+  char mtime[12];       /* 136 */
+  char chksum[8];       /* 148 */
+  char typeflag;        /* 156 */
+  char linkname[100];   /* 157 */
+  char magic[6];        /* 257 */ /* older gnu tar combines magic+version = 'uname  \0' */
+  char version[2];      /* 263 */ /* posix has magic = 'uname\0' and version = '00' */
+  char uname[32];       /* 265 */
+  char gname[32];       /* 297 */
+  char devmajor[8];     /* 329 */
+  char devminor[8];     /* 337 */
+  char prefix[155];     /* 345 */
+  char fill[12];         /* 500 */ /* unused */
+};
+
+union tar_buffer {
+  char               buffer[BLOCKSIZE];
+  struct tar_header  header;
+};
+
+/* old GNU sparse member ('S'), map entries overlay the ustar prefix */
+#define GNU_SPARSE       386    /* 4 entries of offset[12] + numbytes[12] */
+#define GNU_ISEXTENDED   482    /* nonzero if extension blocks follow header */
+#define GNU_REALSIZE     483    /* [12] size of file once extracted */
+#define GNU_EXTENTRIES   21     /* entries per extension block */
+#define GNU_EXTISEXTENDED 504   /* in extension block */
+
+/* data chunks of a sparse member, stored back to back in the tarball,
+   anything between them (or after the last up to realsize) is a hole */
+struct sparse_chunk {
+  FSSIZE offset;
+  FSSIZE size;
+};
+
+struct sparse_map {
+  struct sparse_chunk *chunk;   /* grown as needed, reused for each member */
+  unsigned cnt, alloc;
+  FSSIZE realsize;
+};
+
+/* values taken from a pax extended header ('x') for the next member, or
+   a global one ('g') for all following; strings point into the header */
+struct pax_info {
+  int have;                     /* PAX_SIZE, PAX_MTIME if given */
+  int sparse;                   /* PAX_SPARSE_*, -1 if out of memory */
+  char *name;                   /* GNU.sparse.name, NULL if none */
+  char *path;                   /* path, NULL if none */
+  char *linkpath;               /* linkpath, NULL if none */
+  FSSIZE size;                  /* size, replaces header field */
+  time_t mtime;                 /* mtime (whole seconds), replaces header field */
+  struct sparse_map map;        /* 0.x sparse map and realsize */
+};
+#define PAX_SIZE        1
+#define PAX_MTIME       2
+#define PAX_SPARSE_NONE 0
+#define PAX_SPARSE_0    1       /* GNU 0.0/0.1, map in extended header */
+#define PAX_SPARSE_1    2       /* GNU 1.0, map at start of member data */
+
+
+/* validate checksum */
+/* returns 0 if failed check */
+/* returns nonzero if either or signed/unsigned checksum matches */
+int valid_checksum(struct tar_header *header);
+
+/* header fields tar_decode gives */
+struct tar_fields {
+  unsigned chksum;              /* as getoct(chksum, 8) */
+  FSSIZE   size;                /* as getoct(size, 12) */
+  FSSIZE   mtime;               /* as getoct(mtime, 12) */
+  int      zero;                /* nonzero if whole block is zero (end of archive) */
+};
+
+/* decodes header in one pass (SSE2 or NEON when compiled for them):
+   fills in f and returns as valid_checksum would */
+int tar_decode(const union tar_buffer *b, struct tar_fields *f);
+
+/* returns value of numeric header field (such as size or mtime), octal
+   or, if the high bit of the first byte is set, GNU base-256 (two's
+   complement, so negative values wrap) */
+FSSIZE getoct(char *p, int width);
+
+/* simple pattern match, '*' matches any run and '/' either separator */
+int ExprMatch(char *string, char *expr);
+
+/* combines prefix + [/] + name from header, fname must be >= BLOCKSIZE */
+void getFullName(union tar_buffer *buffer, char *fname);
+
+/* returns tail of fname holding its last path_sep_cnt separators */
+char * stripPath(int path_sep_cnt, char *fname);
+
+/* returns 1 if fname matches any entry in list, 0 otherwise */
+int matchname(char *fname, int cnt, char *list[], int junkPaths);
+
+/* returns nonzero if len bytes at p are all zero */
+int zeroblock(const char *p, unsigned len);
+
+/* appends chunk to map, returns 0 if out of memory */
+int sparse_add(struct sparse_map *map, FSSIZE offset, FSSIZE size);
+
+/* appends the (up to cnt) old GNU map entries at p, returns 0 if out of memory */
+int sparse_gnu(struct sparse_map *map, char *p, int cnt);
+
+/* parses GNU 1.0 map (decimal count then offset/size pairs, one per line)
+   at start of len bytes of member data, returns bytes used by it rounded
+   up to BLOCKSIZE, 0 if more data needed or -1 if invalid/out of memory */
+long sparse_pax1(struct sparse_map *map, char *data, unsigned long len);
+
+/* returns 0 if chunks overlap, are out of order or extend past realsize */
+int sparse_valid(struct sparse_map *map);
+
+/* parses len bytes of pax extended header records into pax, modifying
+   data (values are terminated in place), returns 0 if malformed */
+int pax_parse(char *data, unsigned long len, struct pax_info *pax);
+
+/* hook to make stored [path]filename safe, modifies fname in place */
+void safetyStrip(char *fname);
+
+
+/* uses filename & file contents and returns best guess of file type CM_*,
+   from the tarball opened (in) before anything is read from it */
+int getFileType(gzFile in, const char *fname);
+
+
+/* !!!USER SUPPLIED!!! */
+/* wrap around whatever you want to send error messages to user, c function */
+void PrintMessage(const TCHAR *msg, ...);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _UNTAR_H_ */
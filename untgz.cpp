@@ -1,464 +1,728 @@
-/*
-  untgz - unzip like replacement plugin, except for tarballs
-  KJD <jeremyd@computer.org> 2002-2005
-
-  Initial plugin and TAR extraction logic derived from untgz.c
-  included with zlib.
-  * written by "Pedro A. Aranda Guti\irrez" <paag@tid.es>
-  * adaptation to Unix by Jean-loup Gailly <jloup@gzip.org>
-
-  Copyright and license:
-  I personally add no additional copyright, so the license is the
-  combination of NSIS exDLL (example plugin) and decompression
-  libraries used.  For basic gzip'd tarballs (which rely on zlib),
-  this is essentially MIT/BSD licensed.  Support for lzma compressed
-  tarballs requires the LZMA files and their LGPL/CPL with exception
-  license.  Please see the included readme and/or libraries for
-  complete copyright and license information.
-  
-  This software is provided 'as-is', without any express or implied
-  warranty.  In no event will the authors (or copyright holders) be
-  held liable for any damages arising from the use of this software.
-
-*/
-
-
-/*
-  USAGE:
-  untgz::extract [-j] [-d basedir] [-h] [-k|-u] [-z<type>] [-x] [-f] tarball.tgz
-    extracts files from tarball.tgz
-      if [option] is specified then:
-         -j       ignore paths in tarball (junkpaths)
-         -d       will extract relative to basedir
-		 -h       return error if fail to create hard link
-         -k is    will not overwrite existing files (keep)
-         -u is    will only overwrite older files (update)
-         -z is    determines compression used, see below
-  untgz::extractV [-j] [-d basedir] [-h] [-k|-u] [-z<type>] [-x] [-f] tarball.tgz [-i {iList}] [-x {xList}] --
-    extracts files from tarball.tgz
-      if [option] is specified then:
-         -j       ignore paths in tarball (junkpaths)
-         -d       will extract relative to basedir
-		 -h       return error if fail to create hard link
-         -k is    will not overwrite existing files (keep)
-         -u is    will only overwrite older files (update)
-         -z is    determines compression used, see below
-      if -i is specified will only extract files whose filename matches
-      if -x is specified will NOT extract files whose filename matches
-      the -- is required and marks the end of the file lists
-  untgz::extractFile [-d basedir] [-z<type>] tarball.tgz file
-    extracts just the file specified
-      path information is ignored, 
-	  implictly -j and -h are specified (may also be explicit)
-
-  For compatibility with tar command, the following option specifiers may be
-  used (must appear prior to filename argument), however, they are simply ignored.
-      -x indicates action to perform is extraction (extract)
-      -f archive-name indicates name of tarball (filename), note
-         even when used, the filename must be last argument
-
-  If -h is used on any Windows 9x or NT prior to 2000 or if the destination
-    file system is not NTFS or accessing NTFS via a share then the creation of
-	hard links are not supported by Windows so if any hard links exist
-	in the tar file then an error will be returned; 
-	the default action is to simply print a warning if hard links can't be created.
-
-  If neither -k or -u is used then all existing files will be replaced
-  by corresponding file contained within archive.  
-
-  The -z<type> option may be specified to explicitly indicate how
-  tar file is compressed.
-  -z      indicates gzip (.tgz/.tar.gz) compression, uses zlib,
-  -zgz    alias for -z
-  -znone  indicates uncompressed tar file (.tar)
-  -zlzma  indicates lzma (.tlz/.tar.lzma) compression
-  -zbz2   indicates bzip2 (.tbz/.tar.bz2) compression
-  -zZ     indicates compress (.tZ/.tar.Z) compression UNSUPPORTED
-  -zauto  determines type based on content & extension
-          this is the default if -z<type> option is omitted
-          NOTE: prior to version 1.0.15 -z was the default
-  
-
-  NOTES:
-    Without -j there is a security issue as no checking is done to paths,
-    allowing untrusted tarballs to overwrite arbitrary files (e.g. /bin/*).
-    Also no checking is done to directory or file names.  In untar.c there
-    is a hook so custom versions can modify/strip filepaths prior to opening.
-    The -d option is currently implemented by a chdir to indicatd directory
-    prior to extraction; future versions may instead prepend to extracted path.
-*/
-
-
-// plugin specific headers
-#include "nsisUtils.h"
-#include "untar.h"
-
-// standard headers
-#include <stdarg.h>  /* va_list, va_start, va_end */
-
-
-/* The exported API without name mangling */
-extern "C" {
-
-__declspec(dllexport) void extract(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop);
-__declspec(dllexport) void extractV(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop);
-__declspec(dllexport) void extractFile(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop);
-
-
-/* DLL entry function, needs to be __stdcall, but must be extern "C" for proper decoration (name mangling) */
-BOOL WINAPI _DllMainCRTStartup(HANDLE _hModule, DWORD ul_reason_for_call, LPVOID lpReserved);
-
-}
-
-
-// global variables
-HINSTANCE g_hInstance;
-
-HWND g_hwndParent;
-HWND g_hwndList;
-
-
-// DLL entry point
-BOOL WINAPI _DllMainCRTStartup(HANDLE _hModule, DWORD ul_reason_for_call, LPVOID lpReserved)
-{
-  g_hInstance=(HINSTANCE)_hModule;
-  mCRTinit();	/* init out mini clib, mostly just stdin/stdout/stderr */
-  return TRUE;
-}
-
-
-// macro sets R0 to exit status, "success" or error message
-#define setExitStatus(status) setuservariable(INST_R0, status)
-
-// macro to display error status, and sets error value
-#define setErrorStatus(status)	\
-{	\
-    PrintMessage(status);	\
-    setExitStatus(status);	\
-}
-
-// macro to display command line, sets error value, & then returns
-#define exitWithError(status, optSvar)	\
-{	\
-    PrintMessage(cmdline);	\
-    PrintMessage(_T("%s %s"), status, optSvar);	\
-    setExitStatus(status);	\
-    return;	\
-}
-
-
-// macro that attempts to pop argument off stack
-// if one is not available will display (via LogMessage)
-// current command line followed by msg (which should
-// be a description of the error regarding the
-// expected argument that is missing) ...
-// poparg also closes tgzFile, else same as poparg1
-#define poparg1(buf, msg) { if (popstring(buf)) exitWithError(ERR_NO_TARBALL, _T("")); }
-#define poparg(buf, msg) \
-{ \
-  if (popstring(buf)) \
-  { \
-    if (tgzFile) gzclose(tgzFile); \
-    exitWithError(msg, _T("")) \
-  } \
-}
-
-
-// macro that compares argument, if match prints to log and sets variable to value
-#define setOpt(arg, var, value) \
-  else if (_tcscmp(buf, arg) == 0) \
-  { \
-    _tcscat(cmdline, buf); \
-    _tcscat(cmdline, _T(" ")); \
-    *var = value ; \
-  }
-
-
-// error messages
-#define ERR_SUCCESS _T("success")  /* DO NOT CHANGE */
-#define ERR_OPEN_FAILED _T("Error: Could not open tarball.")
-#define ERR_READ _T("Error: Failure reading from tarball.")
-#define ERR_EXTRACT _T("Error: Unable to extract file.")
-#define ERR_HARDLINK _T("Error: Unable to create hard link.")
-#define MESG_DONE _T("extraction complete.")
-
-#define ERR_NO_TARBALL _T("Error: tarball not specified.")
-#define ERR_DOPT_MISSING_DIR _T("Error: -d option given but base directory not specified!")
-#define ERR_BAD_INCLUDE_LIST _T("Error: -i unable to obtain include file list!")
-#define ERR_BAD_EXCLUDE_LIST _T("Error: -x unable to obtain exclude file list!")
-#define ERR_MISSING_INCLUDE_EXCLUDE_TERMINATOR _T("Error: -- include/exclude end marker is missing!")
-#define ERR_MISSING_FILE _T("Error: file to extract not specified!")
-#define ERR_UNSUPPORTED_COMPRESSION _T("Error: Unsupported compression format.")
-#define ERR_UNKNOWN_OPTION _T("Error: unknown option specified!")
-#define WARN_INVALID_OPTION _T("WARNING: invalid option (%s), ignoring!")
-
-
-void argParse(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop, 
-              TCHAR *cmd, TCHAR *cmdline, gzFile *tgzFile, int *compressionMethod,
-              int *junkPaths, enum KeepMode *keep, TCHAR *basePath, int *failOnHardLinks)
-{
-  TCHAR buf[1024];     /* used for argument processor or other temp buffer */
-  TCHAR iPath[1024];   /* initial (base) directory for extraction */
-
-  /* setup stack and other general NSIS plugin stuff */
-  pluginInit(hwndParent, string_size, variables, stacktop);
-
-  /* initialize our logmessage with command called */
-  _tcscpy(cmdline, _T("untgz::"));
-  _tcscat(cmdline, cmd);  /* e.g. "extract", "extractV", or "extractFile" */
-  _tcscat(cmdline, _T(" "));
-
-  /* usage: untgz::extract* [-j] [-d basedir] tarball.tgz ...other arguments... */
-
-  /* sets INST_R0 to "success" if all goes well, else will be set to an error msg */
-  setExitStatus(ERR_SUCCESS);
-
-  /* initialize optional arguments to their general defaults */
-  *tgzFile = 0;
-  *compressionMethod = CM_AUTO;
-  *failOnHardLinks = 0; /* default to warn only                */
-  *keep = OVERWRITE;
-  *junkPaths = 0;       /* keep path information by default    */
-  if (basePath != NULL)
-    *basePath = '\0';   /* default to current directory ""     */
-  *iPath = '\0';        /* default to current directory ""     */
-
-
-  /* get 1st optional argument or the tarball itself */
-  poparg1(buf, ERR_NO_TARBALL);
-
-
-  /* cycle through handling options */
-  while (*buf == static_cast<TCHAR>('-'))
-  {
-    if (_tcscmp(buf, _T("-d")) == 0)       /* see if optional basedir specified */
-    {
-      _tcscat(cmdline, _T("-d "));
-      poparg1(buf, ERR_DOPT_MISSING_DIR);
-
-      /* copy over base directory to our logmesage */
-      _tcscat(cmdline, _T("'"));
-      _tcscat(cmdline, buf);
-      _tcscat(cmdline, _T("' "));
-
-	  /* if basepath is not NULL then copy it over for callee */
-	  if (basePath != NULL) _tcscpy(basePath, buf);
-
-      /* store so we can set as current directory after opening tarball */
-      _tcscpy(iPath, buf);
-    }
-    setOpt(_T("-j"), junkPaths, 1)       /* see if optional junkpaths specified */
-	setOpt(_T("-h"), failOnHardLinks, 1) /* request failure if unable to create hard link */
-    setOpt(_T("-k"), keep, SKIP)         /* see if no overwrite mode given */
-    setOpt(_T("-u"), keep, UPDATE)       /* see if update mode given */
-    setOpt(_T("-z"),     compressionMethod, CM_GZ)    /* compression gzipped */
-    setOpt(_T("-zgz"),   compressionMethod, CM_GZ)    /* compression gzipped */
-    setOpt(_T("-znone"), compressionMethod, CM_NONE)  /* no compression, plain tar */
-    setOpt(_T("-zlzma"), compressionMethod, CM_LZMA)  /* compression lzma */
-    setOpt(_T("-zbz2"),  compressionMethod, CM_BZ2)   /* compression bz2 */
-    setOpt(_T("-zZ"),    compressionMethod, CM_Z)     /* compression compress */
-    setOpt(_T("-zauto"), compressionMethod, CM_AUTO)  /* compression to be determined */
-    else if ((_tcscmp(buf,_T("-x"))==0)||(_tcscmp(buf,_T("-f"))==0))  /* ignored options */
-    {
-      /* update our logmessage */
-      _tcscat(cmdline, buf);
-      _tcscat(cmdline, _T(" "));
-    }
-    else                              /* else invalid optional argument specified */
-    {
-      _tcscat(cmdline, _T("<<"));
-      _tcscat(cmdline, buf);
-      _tcscat(cmdline, _T(">>"));
-	  PrintMessage(WARN_INVALID_OPTION, buf);
-      //exitWithError(ERR_UNKNOWN_OPTION);
-    }
-
-    /* get next optional argument or the tarball itself */
-    poparg1(buf, ERR_NO_TARBALL);
-  }
-
-  /* copy over tarball file name to our logmessage */
-  _tcscat(cmdline, _T("'"));
-  _tcscat(cmdline, buf);  
-  _tcscat(cmdline, _T("' "));
-
-  /* if auto type specified then determine type */
-  if (*compressionMethod == CM_AUTO)
-    *compressionMethod = getFileType(_T2A(buf));
-
-  /* check if compression method requested is supported */
-  if ((*compressionMethod == CM_Z)
-#ifndef ENABLE_BZ2
-      || (*compressionMethod == CM_BZ2)
-#endif
-#ifndef ENABLE_LZMA
-      || (*compressionMethod == CM_LZMA)
-#endif
-     )
-  {
-    exitWithError(ERR_UNSUPPORTED_COMPRESSION, buf);
-  }
-
-  /* PrintMessage("Compression Method is %i", *compressionMethod); */
-
-  /* open tarball so can read/decompress it */
-  if ((*tgzFile = gzopen(_T2A(buf),"rb")) == NULL)
-    exitWithError(ERR_OPEN_FAILED, buf);
-
-  /* set working dir (after opening tarball) to base
-     directory user specified (or leave as current),
-     but 1st try to create if it doesn't exist yet.
-  */
-  if (*iPath) /* != '\0' if not specified, ie current */
-  {
-    makedir(_T2A(iPath));
-    SetCurrentDirectory(iPath);
-  }
-}
-
-
-/* indicates method used to determine files to extract from archive */
-enum ExtractMode {
-  EXTRACT_ALL = 0, /* extract()     */
-  EXTRACT_LISTS,   /* extractV()    */
-  EXTRACT_SINGLE   /* extractFile() */
-};
-TCHAR * funcName[] = { _T("extract"), _T("extractV"), _T("extractFile") };
-
-/* performs extraction, where mode indicates what files to extract
-   as determined by exported function and its arguments
- */
-void doExtraction(enum ExtractMode mode, HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop)
-{
-  register int result;
-  TCHAR cmdline[1024];     /* just used to display to user */
-  int junkPaths;          /* default to extracting with paths -- highly insecure */
-  int compressionMethod;  /* gzip or other compressed tar file */
-  int failOnHardLinks;
-  enum KeepMode keep;     /* overwrite mode */
-  gzFile tgzFile = NULL;  /* the opened tarball (assuming argParse returns successfully) */
-
-  TCHAR buf[1024];         /* used for argument processor or other temp buffer */
-  int iCnt=0, xCnt=0;     /* count for elements in list */
-  char **iList=NULL,      /* (char *) list[Cnt] for list of files to extract */
-       **xList=NULL;      /* (char *) list[Cnt] for list of files to NOT extract */
-
-  /* do common stuff including parsing arguments up to filename to extract */
-  argParse(hwndParent, string_size, variables, stacktop, 
-           funcName[mode], cmdline, &tgzFile, &compressionMethod, &junkPaths, &keep, NULL, &failOnHardLinks);
-
-  /* check if everything up to now processed ok, exit if not */
-  if (_tcscmp(getuservariable(INST_R0), ERR_SUCCESS) != 0) return;
-
-  /* if ExtractV used, ie variable file lists, then pop lists off stack */
-  if (mode == EXTRACT_LISTS)
-  {
-
-  /* get next optional argument or end marker */
-  poparg(buf, ERR_MISSING_INCLUDE_EXCLUDE_TERMINATOR);
-
-  while ((*buf == static_cast<TCHAR>('-')) && (_tcscmp(buf, _T("--")) != 0))
-  {
-    if (_tcscmp(buf, _T("-i")) == 0)
-	{
-      _tcscat(cmdline, _T("-i "));
-
-      /* get include file list */
-      if (getArgList(&iCnt, &iList, cmdline) != 0)
-        exitWithError(ERR_BAD_INCLUDE_LIST, "");
-	}
-	else if (_tcscmp(buf, _T("-x")) == 0)
-    {
-      _tcscat(cmdline, _T("-x "));
-
-      /* get exclude file list */
-      if (getArgList(&xCnt, &xList, cmdline) != 0)
-        exitWithError(ERR_BAD_EXCLUDE_LIST, "");
-    }
-	else                              /* else invalid optional argument specified */
-	{
-      _tcscat(cmdline, _T("<<"));
-      _tcscat(cmdline, buf);
-      _tcscat(cmdline, _T(">>"));
-	  PrintMessage(WARN_INVALID_OPTION, buf);
-      //exitWithError(ERR_UNKNOWN_OPTION);
-	}
-
-    /* get next optional argument or end marker */
-    poparg(buf, ERR_MISSING_INCLUDE_EXCLUDE_TERMINATOR);
-  }
-
-  if (_tcscmp(buf, _T("--")) == 0)
-	  _tcscat(cmdline, _T("--"));
-  else
-	  _tcscat(cmdline, _T("?--?"));
-
-  } /* if (mode == EXTRACT_LISTS) */
-  else if (mode == EXTRACT_SINGLE)
-  {
-    /* actually get the file to extract */
-    poparg(buf /*filename*/, ERR_MISSING_FILE);
-
-    /* copy over file name to extract to our logmessage */
-    _tcscat(cmdline, _T("'"));
-    _tcscat(cmdline, buf);
-    _tcscat(cmdline, _T("'"));
-
-    junkPaths = 1;
-	failOnHardLinks = 1;
-
-    iCnt = 1;
-    iList = (char **)malloc(sizeof(char *));
-    /* if (iList == NULL) return -1; /* error allocating needed memory */
-    iList[0] = (char *)malloc(strlen(_T2A(buf))+1);
-    strcpy(iList[0], _T2A(buf));  /*filename*/
-  }
-  /* else if (mode == EXTRACT_ALL) {} */
-
-
-  /* show user cmdline */
-  PrintMessage(cmdline);
-
-  /* actually perform the extraction */
-  if ((result = tgz_extract(tgzFile, compressionMethod, junkPaths, keep, iCnt, iList, xCnt, xList, failOnHardLinks)) < 0)
-  {
-	switch (result) 
-	{
-	  case -1: setErrorStatus(ERR_READ); break;
-	  case -3: setErrorStatus(ERR_HARDLINK); break;
-	  default: setErrorStatus(ERR_EXTRACT);
-	}
-  }
-  else
-    PrintMessage(MESG_DONE);
-
-  /* clean up */
-  {
-    register int i;
-    for (i = 0; i < iCnt; i++)  if (iList[i] != NULL) free(iList[i]);
-    if (iList != NULL) free(iList);
-    for (i = 0; i < xCnt; i++)  if (xList[i] != NULL) free(xList[i]);
-    if (xList != NULL) free(xList);
-  }
-}
-
-
-
-/* Implemenation of exported API */
-
-void extract(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop)
-{
-  doExtraction(EXTRACT_ALL, hwndParent, string_size, variables, stacktop);
-}
-
-void extractV(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop)
-{
-  doExtraction(EXTRACT_LISTS, hwndParent, string_size, variables, stacktop);
-}
-
-void extractFile(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop)
-{
-  doExtraction(EXTRACT_SINGLE, hwndParent, string_size, variables, stacktop);
-}
-
-
+/*
+  untgz - unzip like replacement plugin, except for tarballs
+  KJD <jeremyd@computer.org> 2002-2005
+
+  Initial plugin and TAR extraction logic derived from untgz.c
+  included with zlib.
+  * written by "Pedro A. Aranda Guti\irrez" <paag@tid.es>
+  * adaptation to Unix by Jean-loup Gailly <jloup@gzip.org>
+
+  Copyright and license:
+  I personally add no additional copyright, so the license is the
+  combination of NSIS exDLL (example plugin) and decompression
+  libraries used.  For basic gzip'd tarballs (which rely on zlib),
+  this is essentially MIT/BSD licensed.  Support for lzma compressed
+  tarballs requires the LZMA files and their LGPL/CPL with exception
+  license.  Please see the included readme and/or libraries for
+  complete copyright and license information.
+  
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors (or copyright holders) be
+  held liable for any damages arising from the use of this software.
+
+*/
+
+
+/*
+  USAGE:
+  untgz::extract [-j] [-d basedir] [-h] [-l] [-S] [-p[n]] [-m MB] [-k|-u|-c] [-z<type>] [-x] [-f] tarball.tgz
+    extracts files from tarball.tgz
+      if [option] is specified then:
+         -j       ignore paths in tarball (junkpaths)
+         -d       will extract relative to basedir
+		 -h       return error if fail to create hard link
+         -l       hard link files with same contents as one already extracted
+         -S       leave blocks of zeros in files as holes (sparse files)
+         -p[n]    write members of an uncompressed tarball with n threads
+                  at once, default one per processor
+         -m MB    memory budget (MiB) for decoder and output buffers, see below
+         -k is    will not overwrite existing files (keep)
+         -u is    will only overwrite older files (update)
+         -c is    will only overwrite files whose contents differ (sync)
+         -z is    determines compression used, see below
+  untgz::extractV [-j] [-d basedir] [-h] [-l] [-S] [-p[n]] [-m MB] [-k|-u|-c] [-z<type>] [-x] [-f] tarball.tgz [-i {iList}] [-x {xList}] --
+    extracts files from tarball.tgz
+      if [option] is specified then:
+         -j       ignore paths in tarball (junkpaths)
+         -d       will extract relative to basedir
+		 -h       return error if fail to create hard link
+         -l       hard link files with same contents as one already extracted
+         -S       leave blocks of zeros in files as holes (sparse files)
+         -p[n]    write members of an uncompressed tarball with n threads
+                  at once, default one per processor
+         -m MB    memory budget (MiB) for decoder and output buffers, see below
+         -k is    will not overwrite existing files (keep)
+         -u is    will only overwrite older files (update)
+         -c is    will only overwrite files whose contents differ (sync)
+         -z is    determines compression used, see below
+      if -i is specified will only extract files whose filename matches
+      if -x is specified will NOT extract files whose filename matches
+      the -- is required and marks the end of the file lists
+  untgz::extractFile [-d basedir] [-z<type>] tarball.tgz file
+    extracts just the file specified
+      path information is ignored, 
+	  implictly -j and -h are specified (may also be explicit)
+  untgz::extractMany [-n threads] [-a] {tarball.tgz options basedir} --
+    extracts several tarballs at the same time, each as
+    untgz::extract options -d basedir tarball.tgz would
+      options is a blank separated list of extract's options (may be ""),
+      basedir may be "" for the current directory
+      if [option] is specified then:
+         -n       number of tarballs extracted at once, default one per processor
+         -a       after a failure, skip tarballs not yet started (abort)
+      the -- is required and marks the end of the list
+    sets $R0 to success or the error of the first tarball that failed, and
+    pushes the result of each tarball, first tarball's on top of the stack
+  untgz::release
+    frees decoder state (buffers, lzma dictionaries, bzip2 tables) kept
+    for reuse by later calls; it is kept only while the plugin stays
+    loaded (/NOUNLOAD) and freed anyway when the plugin is unloaded
+
+  For compatibility with tar command, the following option specifiers may be
+  used (must appear prior to filename argument), however, they are simply ignored.
+      -x indicates action to perform is extraction (extract)
+      -f archive-name indicates name of tarball (filename), note
+         even when used, the filename must be last argument
+
+  If -h is used on any Windows 9x or NT prior to 2000 or if the destination
+    file system is not NTFS or accessing NTFS via a share then the creation of
+	hard links are not supported by Windows so if any hard links exist
+	in the tar file then an error will be returned; 
+	the default action is to simply print a warning if hard links can't be created.
+
+  With -m the decoder and output buffers are kept within the given
+    number of MB (MiB): bzip2 uses its slower small decoder when the fast
+    one won't fit, fewer output buffers are used, fewer xz blocks and
+    zstd frames are decoded at once, and an lzma or xz tarball whose
+    dictionary won't fit (or bzip2 block size, even small, zstd window
+    or lz4 block size) fails with a message saying how much it needs.
+    The peak memory they held is shown once done.
+
+  If none of -k, -u or -c is used then all existing files will be replaced
+  by corresponding file contained within archive.  
+
+  The -z<type> option may be specified to explicitly indicate how
+  tar file is compressed.
+  -z      indicates gzip (.tgz/.tar.gz) compression, uses zlib,
+  -zgz    alias for -z
+  -znone  indicates uncompressed tar file (.tar)
+  -zlzma  indicates lzma (.tlz/.tar.lzma) compression
+  -zxz    indicates xz (.txz/.tar.xz) compression
+  -zzstd  indicates zstd (.tzst/.tar.zst) compression
+  -zlz4   indicates lz4 (.tlz4/.tar.lz4) compression
+  -zbz2   indicates bzip2 (.tbz/.tar.bz2) compression
+  -zZ     indicates compress (.tZ/.tar.Z) compression UNSUPPORTED
+  -zauto  determines type based on content & extension
+          this is the default if -z<type> option is omitted
+          NOTE: prior to version 1.0.15 -z was the default
+  
+
+  NOTES:
+    Without -j there is a security issue as no checking is done to paths,
+    allowing untrusted tarballs to overwrite arbitrary files (e.g. /bin/*).
+    Also no checking is done to directory or file names.  In untar.c there
+    is a hook so custom versions can modify/strip filepaths prior to opening.
+    The -d directory is prepended to each extracted path, the current
+    directory is not changed.
+*/
+
+
+// plugin specific headers
+#include "nsisUtils.h"
+#include "untar.h"
+#include "fsio.h"
+#include "multi.h"
+#include "decpool.h"
+#include "codec.h"
+
+// standard headers
+#include <stdarg.h>  /* va_list, va_start, va_end */
+
+
+/* The exported API without name mangling */
+extern "C" {
+
+__declspec(dllexport) void extract(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop);
+__declspec(dllexport) void extractV(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop);
+__declspec(dllexport) void extractFile(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop);
+__declspec(dllexport) void extractMany(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop);
+__declspec(dllexport) void release(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop);
+
+
+/* DLL entry function, needs to be __stdcall, but must be extern "C" for proper decoration (name mangling) */
+BOOL WINAPI _DllMainCRTStartup(HANDLE _hModule, DWORD ul_reason_for_call, LPVOID lpReserved);
+
+}
+
+
+// global variables
+HINSTANCE g_hInstance;
+
+HWND g_hwndParent;
+HWND g_hwndList;
+
+
+// DLL entry point
+BOOL WINAPI _DllMainCRTStartup(HANDLE _hModule, DWORD ul_reason_for_call, LPVOID lpReserved)
+{
+  g_hInstance=(HINSTANCE)_hModule;
+  if (ul_reason_for_call == DLL_PROCESS_ATTACH)
+  {
+    mCRTinit();	/* init out mini clib, mostly just stdin/stdout/stderr */
+    dpool_init();  /* decoder state kept between calls */
+  }
+  else if ((ul_reason_for_call == DLL_THREAD_DETACH) || (ul_reason_for_call == DLL_PROCESS_DETACH))
+  {
+    mCRTthreadexit();  /* thread's conversion buffer */
+    if (ul_reason_for_call == DLL_PROCESS_DETACH)
+      dpool_exit();
+  }
+  return TRUE;
+}
+
+
+// macro sets R0 to exit status, "success" or error message
+#define setExitStatus(status) setuservariable(INST_R0, status)
+
+// macro to display error status, and sets error value
+#define setErrorStatus(status)	\
+{	\
+    PrintMessage(status);	\
+    setExitStatus(status);	\
+}
+
+// macro to display command line, sets error value, & then returns
+#define exitWithError(status, optSvar)	\
+{	\
+    PrintMessage(cmdline);	\
+    PrintMessage(_T("%s %s"), status, optSvar);	\
+    setExitStatus(status);	\
+    return;	\
+}
+
+
+// macro that attempts to pop argument off stack
+// if one is not available will display (via LogMessage)
+// current command line followed by msg (which should
+// be a description of the error regarding the
+// expected argument that is missing) ...
+// poparg also closes tgzFile and frees out, else same as poparg1
+#define poparg1(buf, msg) { if (popstring(buf)) exitWithError(ERR_NO_TARBALL, _T("")); }
+#define poparg(buf, msg) \
+{ \
+  if (popstring(buf)) \
+  { \
+    if (tgzFile) gzclose(tgzFile); \
+    if (out) fs_free(out); \
+    exitWithError(msg, _T("")) \
+  } \
+}
+
+
+// macro that compares argument, if match prints to log and sets variable to value
+#define setOpt(arg, var, value) \
+  else if (_tcscmp(buf, arg) == 0) \
+  { \
+    _tcscat(cmdline, buf); \
+    _tcscat(cmdline, _T(" ")); \
+    *var = value ; \
+  }
+
+
+// error messages
+#define ERR_SUCCESS _T("success")  /* DO NOT CHANGE */
+#define ERR_OPEN_FAILED _T("Error: Could not open tarball.")
+#define ERR_READ _T("Error: Failure reading from tarball.")
+#define ERR_EXTRACT _T("Error: Unable to extract file.")
+#define ERR_HARDLINK _T("Error: Unable to create hard link.")
+#define ERR_BASEDIR _T("Error: Could not use base directory.")
+#define ERR_SKIPPED _T("Error: Skipped after an earlier tarball failed.")
+#define MESG_DONE _T("extraction complete.")
+#define MESG_PEAKMEM _T("peak memory %lu KB (decoder and output buffers)")
+
+#define ERR_NO_TARBALL _T("Error: tarball not specified.")
+#define ERR_DOPT_MISSING_DIR _T("Error: -d option given but base directory not specified!")
+#define ERR_MOPT_MISSING_SIZE _T("Error: -m option given but memory budget not specified!")
+#define ERR_BAD_INCLUDE_LIST _T("Error: -i unable to obtain include file list!")
+#define ERR_BAD_EXCLUDE_LIST _T("Error: -x unable to obtain exclude file list!")
+#define ERR_MISSING_INCLUDE_EXCLUDE_TERMINATOR _T("Error: -- include/exclude end marker is missing!")
+#define ERR_MISSING_FILE _T("Error: file to extract not specified!")
+#define ERR_MISSING_MANY_TERMINATOR _T("Error: -- end marker is missing or list incomplete!")
+#define ERR_UNSUPPORTED_COMPRESSION _T("Error: Unsupported compression format.")
+#define ERR_UNKNOWN_OPTION _T("Error: unknown option specified!")
+#define WARN_INVALID_OPTION _T("WARNING: invalid option (%s), ignoring!")
+
+
+void argParse(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop, 
+              TCHAR *cmd, TCHAR *cmdline, gzFile *tgzFile, FSCTX **out, int *compressionMethod,
+              int *junkPaths, enum KeepMode *keep, TCHAR *basePath, int *failOnHardLinks, int *dedup, int *holes,
+              int *writers, unsigned long *memlimit, char *tarball)
+{
+  TCHAR buf[1024];     /* used for argument processor or other temp buffer */
+  TCHAR iPath[1024];   /* initial (base) directory for extraction */
+
+  /* setup stack and other general NSIS plugin stuff */
+  pluginInit(hwndParent, string_size, variables, stacktop);
+
+  /* initialize our logmessage with command called */
+  _tcscpy(cmdline, _T("untgz::"));
+  _tcscat(cmdline, cmd);  /* e.g. "extract", "extractV", or "extractFile" */
+  _tcscat(cmdline, _T(" "));
+
+  /* usage: untgz::extract* [-j] [-d basedir] tarball.tgz ...other arguments... */
+
+  /* sets INST_R0 to "success" if all goes well, else will be set to an error msg */
+  setExitStatus(ERR_SUCCESS);
+
+  /* initialize optional arguments to their general defaults */
+  *tgzFile = 0;
+  *out = NULL;
+  *compressionMethod = CM_AUTO;
+  *failOnHardLinks = 0; /* default to warn only                */
+  *dedup = 0;           /* write duplicate files separately    */
+  *holes = 0;           /* write zero blocks like any other    */
+  *writers = -1;        /* extract members in order            */
+  *memlimit = 0;        /* no memory budget                    */
+  *keep = OVERWRITE;
+  *junkPaths = 0;       /* keep path information by default    */
+  if (basePath != NULL)
+    *basePath = '\0';   /* default to current directory ""     */
+  *iPath = '\0';        /* default to current directory ""     */
+
+
+  /* get 1st optional argument or the tarball itself */
+  poparg1(buf, ERR_NO_TARBALL);
+
+
+  /* cycle through handling options */
+  while (*buf == static_cast<TCHAR>('-'))
+  {
+    if (_tcscmp(buf, _T("-d")) == 0)       /* see if optional basedir specified */
+    {
+      _tcscat(cmdline, _T("-d "));
+      poparg1(buf, ERR_DOPT_MISSING_DIR);
+
+      /* copy over base directory to our logmesage */
+      _tcscat(cmdline, _T("'"));
+      _tcscat(cmdline, buf);
+      _tcscat(cmdline, _T("' "));
+
+	  /* if basepath is not NULL then copy it over for callee */
+	  if (basePath != NULL) _tcscpy(basePath, buf);
+
+      /* store so we can set as current directory after opening tarball */
+      _tcscpy(iPath, buf);
+    }
+    setOpt(_T("-j"), junkPaths, 1)       /* see if optional junkpaths specified */
+	setOpt(_T("-h"), failOnHardLinks, 1) /* request failure if unable to create hard link */
+    setOpt(_T("-k"), keep, SKIP)         /* see if no overwrite mode given */
+    setOpt(_T("-u"), keep, UPDATE)       /* see if update mode given */
+    setOpt(_T("-c"), keep, SYNC)         /* see if sync (compare contents) mode given */
+    setOpt(_T("-l"), dedup, 1)           /* link files with same contents */
+    setOpt(_T("-S"), holes, 1)           /* leave runs of zeros as holes */
+    setOpt(_T("-z"),     compressionMethod, CM_GZ)    /* compression gzipped */
+    setOpt(_T("-zgz"),   compressionMethod, CM_GZ)    /* compression gzipped */
+    setOpt(_T("-znone"), compressionMethod, CM_NONE)  /* no compression, plain tar */
+    setOpt(_T("-zlzma"), compressionMethod, CM_LZMA)  /* compression lzma */
+    setOpt(_T("-zxz"),   compressionMethod, CM_XZ)    /* compression xz */
+    setOpt(_T("-zzstd"), compressionMethod, CM_ZSTD)  /* compression zstd */
+    setOpt(_T("-zlz4"),  compressionMethod, CM_LZ4)   /* compression lz4 */
+    setOpt(_T("-zbz2"),  compressionMethod, CM_BZ2)   /* compression bz2 */
+    setOpt(_T("-zZ"),    compressionMethod, CM_Z)     /* compression compress */
+    setOpt(_T("-zauto"), compressionMethod, CM_AUTO)  /* compression to be determined */
+    else if (buf[1] == static_cast<TCHAR>('p'))  /* -p[n], parallel writers */
+    {
+      TCHAR *p;
+      _tcscat(cmdline, buf);
+      _tcscat(cmdline, _T(" "));
+      for (*writers = 0, p = buf + 2; (*p >= '0') && (*p <= '9'); p++)
+        *writers = *writers * 10 + (*p - '0');
+    }
+    else if (_tcscmp(buf, _T("-m")) == 0)  /* -m MB, memory budget */
+    {
+      TCHAR *p;
+      _tcscat(cmdline, _T("-m "));
+      poparg1(buf, ERR_MOPT_MISSING_SIZE);
+      _tcscat(cmdline, buf);
+      _tcscat(cmdline, _T(" "));
+      for (*memlimit = 0, p = buf; (*p >= '0') && (*p <= '9'); p++)
+        *memlimit = *memlimit * 10 + (*p - '0');
+    }
+    else if ((_tcscmp(buf,_T("-x"))==0)||(_tcscmp(buf,_T("-f"))==0))  /* ignored options */
+    {
+      /* update our logmessage */
+      _tcscat(cmdline, buf);
+      _tcscat(cmdline, _T(" "));
+    }
+    else                              /* else invalid optional argument specified */
+    {
+      _tcscat(cmdline, _T("<<"));
+      _tcscat(cmdline, buf);
+      _tcscat(cmdline, _T(">>"));
+	  PrintMessage(WARN_INVALID_OPTION, buf);
+      //exitWithError(ERR_UNKNOWN_OPTION);
+    }
+
+    /* get next optional argument or the tarball itself */
+    poparg1(buf, ERR_NO_TARBALL);
+  }
+
+  /* copy over tarball file name to our logmessage */
+  _tcscat(cmdline, _T("'"));
+  _tcscat(cmdline, buf);  
+  _tcscat(cmdline, _T("' "));
+
+  /* open tarball so can read/decompress it, name kept for -p to map it */
+  strcpy(tarball, _T2A(buf));
+  if ((*tgzFile = gzopen(tarball,"rb")) == NULL)
+    exitWithError(ERR_OPEN_FAILED, buf);
+
+  /* if auto type specified then determine type, from what gzopen read */
+  if (*compressionMethod == CM_AUTO)
+    *compressionMethod = getFileType(*tgzFile, tarball);
+
+  /* check if compression method requested is supported */
+  if (codec_find(*compressionMethod) == NULL)
+  {
+    gzclose(*tgzFile);
+    *tgzFile = 0;
+    exitWithError(ERR_UNSUPPORTED_COMPRESSION, buf);
+  }
+
+  /* PrintMessage("Compression Method is %i", *compressionMethod); */
+
+  /* output to base directory user specified (or current),
+     created if it doesn't exist yet.
+  */
+  if ((*out = fs_new(*iPath ? iPath : NULL)) == NULL)
+  {
+    gzclose(*tgzFile);
+    *tgzFile = 0;
+    exitWithError(ERR_BASEDIR, iPath);
+  }
+}
+
+
+/* indicates method used to determine files to extract from archive */
+enum ExtractMode {
+  EXTRACT_ALL = 0, /* extract()     */
+  EXTRACT_LISTS,   /* extractV()    */
+  EXTRACT_SINGLE   /* extractFile() */
+};
+TCHAR * funcName[] = { _T("extract"), _T("extractV"), _T("extractFile") };
+
+/* performs extraction, where mode indicates what files to extract
+   as determined by exported function and its arguments
+ */
+void doExtraction(enum ExtractMode mode, HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop)
+{
+  register int result;
+  TCHAR cmdline[1024];     /* just used to display to user */
+  int junkPaths;          /* default to extracting with paths -- highly insecure */
+  int compressionMethod;  /* gzip or other compressed tar file */
+  int failOnHardLinks;
+  int dedup;              /* hard link duplicate files */
+  int holes;              /* skip writing zero blocks */
+  int writers;            /* -p threads, -1 to extract in order */
+  unsigned long memlimit; /* -m MB, 0 for none */
+  char tarball[1024];     /* name tarball opened by */
+  enum KeepMode keep;     /* overwrite mode */
+  gzFile tgzFile = NULL;  /* the opened tarball (assuming argParse returns successfully) */
+  FSCTX *out = NULL;      /* output to base directory */
+  TGZCTX *ctx;            /* extraction context, takes over out */
+
+  TCHAR buf[1024];         /* used for argument processor or other temp buffer */
+  int iCnt=0, xCnt=0;     /* count for elements in list */
+  char **iList=NULL,      /* (char *) list[Cnt] for list of files to extract */
+       **xList=NULL;      /* (char *) list[Cnt] for list of files to NOT extract */
+
+  /* do common stuff including parsing arguments up to filename to extract */
+  argParse(hwndParent, string_size, variables, stacktop, 
+           funcName[mode], cmdline, &tgzFile, &out, &compressionMethod, &junkPaths, &keep, NULL, &failOnHardLinks, &dedup, &holes, &writers, &memlimit, tarball);
+
+  /* check if everything up to now processed ok, exit if not */
+  if (_tcscmp(getuservariable(INST_R0), ERR_SUCCESS) != 0) return;
+
+  /* if ExtractV used, ie variable file lists, then pop lists off stack */
+  if (mode == EXTRACT_LISTS)
+  {
+
+  /* get next optional argument or end marker */
+  poparg(buf, ERR_MISSING_INCLUDE_EXCLUDE_TERMINATOR);
+
+  while ((*buf == static_cast<TCHAR>('-')) && (_tcscmp(buf, _T("--")) != 0))
+  {
+    if (_tcscmp(buf, _T("-i")) == 0)
+	{
+      _tcscat(cmdline, _T("-i "));
+
+      /* get include file list */
+      if (getArgList(&iCnt, &iList, cmdline) != 0)
+        exitWithError(ERR_BAD_INCLUDE_LIST, "");
+	}
+	else if (_tcscmp(buf, _T("-x")) == 0)
+    {
+      _tcscat(cmdline, _T("-x "));
+
+      /* get exclude file list */
+      if (getArgList(&xCnt, &xList, cmdline) != 0)
+        exitWithError(ERR_BAD_EXCLUDE_LIST, "");
+    }
+	else                              /* else invalid optional argument specified */
+	{
+      _tcscat(cmdline, _T("<<"));
+      _tcscat(cmdline, buf);
+      _tcscat(cmdline, _T(">>"));
+	  PrintMessage(WARN_INVALID_OPTION, buf);
+      //exitWithError(ERR_UNKNOWN_OPTION);
+	}
+
+    /* get next optional argument or end marker */
+    poparg(buf, ERR_MISSING_INCLUDE_EXCLUDE_TERMINATOR);
+  }
+
+  if (_tcscmp(buf, _T("--")) == 0)
+	  _tcscat(cmdline, _T("--"));
+  else
+	  _tcscat(cmdline, _T("?--?"));
+
+  } /* if (mode == EXTRACT_LISTS) */
+  else if (mode == EXTRACT_SINGLE)
+  {
+    /* actually get the file to extract */
+    poparg(buf /*filename*/, ERR_MISSING_FILE);
+
+    /* copy over file name to extract to our logmessage */
+    _tcscat(cmdline, _T("'"));
+    _tcscat(cmdline, buf);
+    _tcscat(cmdline, _T("'"));
+
+    junkPaths = 1;
+	failOnHardLinks = 1;
+
+    iCnt = 1;
+    iList = (char **)malloc(sizeof(char *));
+    /* if (iList == NULL) return -1; /* error allocating needed memory */
+    iList[0] = (char *)malloc(strlen(_T2A(buf))+1);
+    strcpy(iList[0], _T2A(buf));  /*filename*/
+  }
+  /* else if (mode == EXTRACT_ALL) {} */
+
+
+  /* show user cmdline */
+  PrintMessage(cmdline);
+
+  /* actually perform the extraction */
+  if ((ctx = tgz_new(out)) == NULL)
+  {
+    gzclose(tgzFile);
+    result = -2;
+  }
+  else
+  {
+    if (memlimit) tgz_memlimit(ctx, memlimit);
+    dpool_peak(1);
+    if (writers >= 0)
+      result = tgz_extract_parallel(ctx, tgzFile, tarball, writers, compressionMethod, junkPaths, keep, iCnt, iList, xCnt, xList, failOnHardLinks, dedup, holes);
+    else
+      result = tgz_extract(ctx, tgzFile, compressionMethod, junkPaths, keep, iCnt, iList, xCnt, xList, failOnHardLinks, dedup, holes);
+    tgz_free(ctx);
+  }
+  if (result < 0)
+  {
+	switch (result) 
+	{
+	  case -1: setErrorStatus(ERR_READ); break;
+	  case -3: setErrorStatus(ERR_HARDLINK); break;
+	  default: setErrorStatus(ERR_EXTRACT);
+	}
+  }
+  else
+    PrintMessage(MESG_DONE);
+  if (memlimit)
+    PrintMessage(MESG_PEAKMEM, dpool_peak(0) >> 10);
+
+  /* clean up */
+  {
+    register int i;
+    for (i = 0; i < iCnt; i++)  if (iList[i] != NULL) free(iList[i]);
+    if (iList != NULL) free(iList);
+    for (i = 0; i < xCnt; i++)  if (xList[i] != NULL) free(xList[i]);
+    if (xList != NULL) free(xList);
+  }
+}
+
+
+
+/* R0 status for result of a tarball of extractMany */
+static const TCHAR *manyStatus(int result)
+{
+  switch (result)
+  {
+    case -1:               return ERR_READ;
+    case -3:               return ERR_HARDLINK;
+    case MANY_OPEN:        return ERR_OPEN_FAILED;
+    case MANY_BASEDIR:     return ERR_BASEDIR;
+    case MANY_UNSUPPORTED: return ERR_UNSUPPORTED_COMPRESSION;
+    case MANY_SKIPPED:     return ERR_SKIPPED;
+    default:               return (result < 0) ? ERR_EXTRACT : ERR_SUCCESS;
+  }
+}
+
+/* reports each tarball as it finishes, with how many of them are done */
+static void manyProgress(struct tgz_job *job, int done, int total, void *arg)
+{
+  PrintMessage(_T("[%d/%d] %s %s"), done, total,
+               (job->result < 0) ? manyStatus(job->result) : _T("Extracted"), _A2T((char *)job->tarball));
+}
+
+static void manyFree(struct tgz_job *jobs, int cnt)
+{
+  int i;
+  for (i = 0; i < cnt; i++)
+  {
+    free((void *)jobs[i].tarball);
+    if (jobs[i].dest != NULL) free((void *)jobs[i].dest);
+  }
+  if (jobs != NULL) free(jobs);
+}
+
+/* pops the {tarball options basedir} list of extractMany, up to the --,
+   returns NULL if incomplete (or out of memory) */
+static struct tgz_job *manyArgs(TCHAR *buf, int *cnt)
+{
+  struct tgz_job *jobs = NULL;
+  int size = 0;
+  TCHAR opts[1024];
+
+  *cnt = 0;
+  while (_tcscmp(buf, _T("--")) != 0)
+  {
+    char *tarball;
+    TCHAR *dest = NULL;
+
+    if (*cnt == size)
+    {
+      struct tgz_job *p = (struct tgz_job *)realloc(jobs, (size = size ? size * 2 : 16) * sizeof(struct tgz_job));
+      if (p == NULL) break;
+      jobs = p;
+    }
+    if ((tarball = strdup(_T2A(buf))) == NULL) break;
+    if (popstring(opts) || popstring(buf) ||
+        ((*buf != 0) && ((dest = (TCHAR *)malloc((_tcslen(buf) + 1) * sizeof(TCHAR))) == NULL)))
+    {
+      free(tarball);
+      break;
+    }
+    if (dest != NULL) _tcscpy(dest, buf);
+    tgz_job_init(&jobs[*cnt], tarball, dest);
+    (*cnt)++;
+    if (!tgz_job_options(&jobs[*cnt - 1], _T2A(opts)))
+      PrintMessage(WARN_INVALID_OPTION, opts);
+    if (popstring(buf)) break;
+  }
+  if (_tcscmp(buf, _T("--")) != 0)
+  {
+    manyFree(jobs, *cnt);
+    return NULL;
+  }
+  return jobs;
+}
+
+/* extracts several tarballs at once, see extractMany usage above */
+void doExtractMany(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop)
+{
+  TCHAR cmdline[1024];     /* just used to display to user */
+  TCHAR buf[1024];
+  int nthreads = 0;        /* tarballs at once, 0 for one per processor */
+  int stopOnError = 0;     /* skip tarballs not started once one fails */
+  struct tgz_job *jobs;
+  int cnt, failed, i;
+
+  pluginInit(hwndParent, string_size, variables, stacktop);
+  _tcscpy(cmdline, _T("untgz::extractMany "));
+  setExitStatus(ERR_SUCCESS);
+
+  poparg1(buf, ERR_NO_TARBALL);
+  while ((*buf == static_cast<TCHAR>('-')) && (_tcscmp(buf, _T("--")) != 0))
+  {
+    _tcscat(cmdline, buf);
+    _tcscat(cmdline, _T(" "));
+    if (_tcscmp(buf, _T("-n")) == 0)
+    {
+      TCHAR *p;
+      poparg1(buf, ERR_NO_TARBALL);
+      _tcscat(cmdline, buf);
+      _tcscat(cmdline, _T(" "));
+      for (nthreads = 0, p = buf; (*p >= '0') && (*p <= '9'); p++)
+        nthreads = nthreads * 10 + (*p - '0');
+    }
+    else if (_tcscmp(buf, _T("-a")) == 0)
+      stopOnError = 1;
+    else
+      PrintMessage(WARN_INVALID_OPTION, buf);
+    poparg1(buf, ERR_NO_TARBALL);
+  }
+
+  if (_tcscmp(buf, _T("--")) == 0)
+    exitWithError(ERR_NO_TARBALL, _T(""));
+  if ((jobs = manyArgs(buf, &cnt)) == NULL)
+    exitWithError(ERR_MISSING_MANY_TERMINATOR, _T(""));
+
+  PrintMessage(_T("%s-- (%d tarballs)"), cmdline, cnt);
+  dpool_peak(1);
+  failed = tgz_extract_many(jobs, cnt, nthreads, stopOnError, manyProgress, NULL);
+
+  /* R0 from first failure in list order, each tarball's status on stack */
+  for (i = 0; i < cnt; i++)
+  {
+    if (jobs[i].result < 0)
+    {
+      setErrorStatus((TCHAR *)manyStatus(jobs[i].result));
+      break;
+    }
+  }
+  for (i = cnt - 1; i >= 0; i--)
+    pushstring((TCHAR *)manyStatus(jobs[i].result));
+  if (failed == 0)
+    PrintMessage(MESG_DONE);
+  for (i = 0; i < cnt; i++)
+  {
+    if (jobs[i].memlimit)
+    {
+      PrintMessage(MESG_PEAKMEM, dpool_peak(0) >> 10);
+      break;
+    }
+  }
+  manyFree(jobs, cnt);
+}
+
+
+/* Implemenation of exported API */
+
+void extract(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop)
+{
+  doExtraction(EXTRACT_ALL, hwndParent, string_size, variables, stacktop);
+}
+
+void extractV(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop)
+{
+  doExtraction(EXTRACT_LISTS, hwndParent, string_size, variables, stacktop);
+}
+
+void extractFile(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop)
+{
+  doExtraction(EXTRACT_SINGLE, hwndParent, string_size, variables, stacktop);
+}
+
+void extractMany(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop)
+{
+  doExtractMany(hwndParent, string_size, variables, stacktop);
+}
+
+void release(HWND hwndParent, int string_size, TCHAR *variables, stack_t **stacktop)
+{
+  dpool_trim();
+}
+
+
@@ -0,0 +1,305 @@
+/*
+  untgzcli - command line driver for the untgz extraction engine
+
+  Native (Linux/BSD) program running the same tgz_extract the plugin
+  uses, so extraction can be tested, timed and profiled (perf etc.)
+  without Windows or an installer.  Options are the same as the
+  plugin's extract and extractV functions.
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors (or copyright holders) be
+  held liable for any damages arising from the use of this software.
+*/
+
+/*
+  USAGE:
+  untgzcli [-q] [-s] [-p[n]] [-m MB] [-j] [-d basedir] [-h] [-l] [-S] [-k|-u|-c] [-z<type>] [-x] [-f] tarball.tgz [-i {iList}] [-x {xList}]
+      -q       quiet, only report errors and the time taken
+      -s       synchronous output, do not queue writes (io_uring)
+      -p[n]    write members of an uncompressed tarball with n threads
+               at once, default one per processor
+      -m       memory budget in MB (MiB) for decoder and output buffers,
+               bzip2 uses its small decoder if needed, lzma tarballs
+               with larger dictionaries are refused
+      -j       ignore paths in tarball (junkpaths)
+      -d       will extract relative to basedir
+      -h       return error if fail to create hard link
+      -l       hard link files with same contents as one already extracted
+      -S       leave blocks of zeros in files as holes (sparse files)
+      -k       will not overwrite existing files (keep)
+      -u       will only overwrite older files (update)
+      -c       will only write files whose contents differ (sync)
+      -z<type> compression used, none, gz, bz2, lzma, xz, zstd, lz4 or auto (default)
+      -i       only extract files whose filename matches one in list
+      -x       (after tarball) do NOT extract files matching one in list
+
+  untgzcli -M [-q] [-n threads] [-a] {tarball.tgz options basedir}
+      extracts the tarballs at the same time, as the plugin's extractMany;
+      options (-p[n] -m MB -j -h -l -S -k -u -c -z<type>, blank separated, "" for none)
+      and basedir ("" for current) are given for each tarball
+      -n       number of threads, default one per processor
+      -a       abort, skip tarballs not yet started once one fails
+
+  The time taken is reported with the peak memory held for decoder state
+  and output buffers (decpool.c) and the process's maximum resident size.
+
+  Exits with 0 on success, 1 error reading tarball, 2 error extracting
+  file, 3 error creating hard link, 4 bad arguments or unable to open;
+  with -M 0 if all tarballs were extracted, otherwise 2 (or 4).
+*/
+
+#include "untar.h"
+#include "fsio.h"
+#include "multi.h"
+#include "decpool.h"
+#include "codec.h"
+
+#include <stdarg.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+
+static int quiet = 0;
+
+/* only messages on failure are shown when quiet */
+static int isError(const char *msg)
+{
+  return (strstr(msg, "rror") != NULL) || (strstr(msg, "arning") != NULL) ||
+         (strstr(msg, "nable") != NULL) || (strstr(msg, "failed") != NULL) ||
+         (strstr(msg, "invalid") != NULL) || (strstr(msg, "bad ") != NULL) ||
+         (strstr(msg, "incomplete") != NULL) || (strstr(msg, "Unexpected") != NULL);
+}
+
+/* !!!USER SUPPLIED!!! */
+void PrintMessage(const TCHAR *msg, ...)
+{
+  va_list argptr;
+  int len = (int)strlen(msg);
+
+  if (quiet && !isError(msg)) return;
+  va_start(argptr, msg);
+  vprintf(msg, argptr);
+  va_end(argptr);
+  if ((len == 0) || (msg[len-1] != '\n')) putchar('\n');
+}
+
+
+static double now(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+/* peak decoder and output buffer memory, and maximum resident size, in KB */
+static void memReport(void)
+{
+  struct rusage ru;
+
+  if (getrusage(RUSAGE_SELF, &ru) != 0) ru.ru_maxrss = 0;
+  fprintf(stderr, "peak memory %lu KB (decoder and output buffers), %ld KB resident\n",
+          dpool_peak(0) >> 10, (long)ru.ru_maxrss);
+}
+
+static int usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [-q] [-s] [-p[n]] [-m MB] [-j] [-d basedir] [-h] [-l] [-S] [-k|-u|-c] [-z<type>] tarball [-i files...] [-x files...]\n", prog);
+  fprintf(stderr, "       %s -M [-q] [-n threads] [-a] tarball options basedir [tarball options basedir...]\n", prog);
+  return 4;
+}
+
+
+static void manyProgress(struct tgz_job *job, int done, int total, void *arg)
+{
+  const char *status;
+
+  switch (job->result)
+  {
+    case -1: status = "failed reading tarball"; break;
+    case -2: status = "failed extracting file"; break;
+    case -3: status = "failed creating hard link"; break;
+    case MANY_OPEN: status = "failed, could not open tarball"; break;
+    case MANY_BASEDIR: status = "failed, could not use base directory"; break;
+    case MANY_UNSUPPORTED: status = "failed, unsupported compression format"; break;
+    case MANY_NOMEM: status = "failed, out of memory"; break;
+    case MANY_SKIPPED: status = "skipped"; break;
+    default: status = (job->result < 0) ? "failed" : "extracted"; break;
+  }
+  fprintf(stderr, "[%d/%d] %s %s\n", done, total, job->tarball, status);
+}
+
+/* -M, several tarballs at once */
+static int many(int argc, char *argv[])
+{
+  int nthreads = 0, stopOnError = 0;
+  struct tgz_job *jobs;
+  int cnt, i, argno, failed;
+  double start;
+
+  for (argno = 2; (argno < argc) && (*argv[argno] == '-'); argno++)
+  {
+    if (strcmp(argv[argno], "-q") == 0) quiet = 1;
+    else if (strcmp(argv[argno], "-a") == 0) stopOnError = 1;
+    else if (strcmp(argv[argno], "-n") == 0)
+    {
+      if (++argno >= argc) return usage(argv[0]);
+      nthreads = (int)strtol(argv[argno], NULL, 10);
+    }
+    else return usage(argv[0]);
+  }
+  if ((argno >= argc) || ((argc - argno) % 3 != 0)) return usage(argv[0]);
+  cnt = (argc - argno) / 3;
+
+  if ((jobs = (struct tgz_job *)malloc(cnt * sizeof(struct tgz_job))) == NULL)
+  {
+    fprintf(stderr, "Error: out of memory\n");
+    return 4;
+  }
+  for (i = 0; i < cnt; i++, argno += 3)
+  {
+    tgz_job_init(&jobs[i], argv[argno], *argv[argno+2] ? argv[argno+2] : NULL);
+    if (!tgz_job_options(&jobs[i], argv[argno+1]))
+      fprintf(stderr, "WARNING: invalid option in (%s), ignoring!\n", argv[argno+1]);
+  }
+
+  start = now();
+  failed = tgz_extract_many(jobs, cnt, nthreads, stopOnError, manyProgress, NULL);
+  fprintf(stderr, "%d of %d tarballs extracted in %.3f seconds\n", cnt - failed, cnt, now() - start);
+  memReport();
+  free(jobs);
+  return failed ? 2 : 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+  int junkPaths = 0;
+  int failOnHardLinks = 0;
+  int dedup = 0;
+  int holes = 0;
+  int compressionMethod = CM_AUTO;
+  enum KeepMode keep = OVERWRITE;
+  const char *basePath = NULL;
+  int async = 1;
+  int parallel = 0, writers = 0;
+  unsigned long memlimit = 0;
+  const char *tarball;
+  int iCnt = 0, xCnt = 0;
+  char **iList = NULL, **xList = NULL;
+  gzFile tgzFile;
+  FSCTX *out;
+  TGZCTX *ctx;
+  double start;
+  int argno, result;
+
+  dpool_init();   /* -M reuses decoder state from one tarball to the next */
+  if ((argc > 1) && (strcmp(argv[1], "-M") == 0))
+    return many(argc, argv);
+
+  for (argno = 1; (argno < argc) && (*argv[argno] == '-'); argno++)
+  {
+    const char *arg = argv[argno];
+    if (strcmp(arg, "-d") == 0)
+    {
+      if (++argno >= argc) return usage(argv[0]);
+      basePath = argv[argno];
+    }
+    else if (strcmp(arg, "-q") == 0) quiet = 1;
+    else if (strcmp(arg, "-s") == 0) async = 0;
+    else if (strcmp(arg, "-m") == 0)
+    {
+      if (++argno >= argc) return usage(argv[0]);
+      memlimit = strtoul(argv[argno], NULL, 10);
+    }
+    else if (arg[1] == 'p')
+    {
+      parallel = 1;
+      writers = (int)strtol(arg + 2, NULL, 10);
+    }
+    else if (strcmp(arg, "-j") == 0) junkPaths = 1;
+    else if (strcmp(arg, "-h") == 0) failOnHardLinks = 1;
+    else if (strcmp(arg, "-l") == 0) dedup = 1;
+    else if (strcmp(arg, "-S") == 0) holes = 1;
+    else if (strcmp(arg, "-k") == 0) keep = SKIP;
+    else if (strcmp(arg, "-u") == 0) keep = UPDATE;
+    else if (strcmp(arg, "-c") == 0) keep = SYNC;
+    else if ((strcmp(arg, "-z") == 0) || (strcmp(arg, "-zgz") == 0)) compressionMethod = CM_GZ;
+    else if (strcmp(arg, "-znone") == 0) compressionMethod = CM_NONE;
+    else if (strcmp(arg, "-zlzma") == 0) compressionMethod = CM_LZMA;
+    else if (strcmp(arg, "-zxz") == 0) compressionMethod = CM_XZ;
+    else if (strcmp(arg, "-zzstd") == 0) compressionMethod = CM_ZSTD;
+    else if (strcmp(arg, "-zlz4") == 0) compressionMethod = CM_LZ4;
+    else if (strcmp(arg, "-zbz2") == 0) compressionMethod = CM_BZ2;
+    else if (strcmp(arg, "-zZ") == 0) compressionMethod = CM_Z;
+    else if (strcmp(arg, "-zauto") == 0) compressionMethod = CM_AUTO;
+    else if ((strcmp(arg, "-x") == 0) || (strcmp(arg, "-f") == 0)) ; /* ignored */
+    else
+      fprintf(stderr, "WARNING: invalid option (%s), ignoring!\n", arg);
+  }
+  if (argno >= argc) return usage(argv[0]);
+  tarball = argv[argno++];
+
+  /* include and exclude lists, each runs until the next list or end */
+  while (argno < argc)
+  {
+    int *cnt;
+    char ***list;
+    if (strcmp(argv[argno], "-i") == 0) { cnt = &iCnt; list = &iList; }
+    else if (strcmp(argv[argno], "-x") == 0) { cnt = &xCnt; list = &xList; }
+    else return usage(argv[0]);
+    *list = &argv[++argno];
+    for (*cnt = 0; (argno < argc) && (strcmp(argv[argno], "-i") != 0) && (strcmp(argv[argno], "-x") != 0); argno++)
+      (*cnt)++;
+  }
+
+  if ((tgzFile = gzopen(tarball, "rb")) == NULL)
+  {
+    fprintf(stderr, "Error: Could not open tarball. %s\n", tarball);
+    return 4;
+  }
+
+  /* if auto type specified then determine type, from what gzopen read */
+  if (compressionMethod == CM_AUTO)
+    compressionMethod = getFileType(tgzFile, tarball);
+
+  /* check if compression method requested is supported */
+  if (codec_find(compressionMethod) == NULL)
+  {
+    fprintf(stderr, "Error: Unsupported compression format. %s\n", tarball);
+    gzclose(tgzFile);
+    return 4;
+  }
+
+  if ((out = fs_new(basePath)) == NULL)
+  {
+    fprintf(stderr, "Error: unable to use base directory %s [%d]\n", basePath ? basePath : ".", fs_lasterror(NULL));
+    gzclose(tgzFile);
+    return 4;
+  }
+  fs_async(out, async);
+  if ((ctx = tgz_new(out)) == NULL)
+  {
+    fprintf(stderr, "Error: out of memory\n");
+    gzclose(tgzFile);
+    return 4;
+  }
+
+  if (memlimit) tgz_memlimit(ctx, memlimit);
+
+  start = now();
+  if (parallel)
+    result = tgz_extract_parallel(ctx, tgzFile, tarball, writers, compressionMethod, junkPaths, keep, iCnt, (iCnt ? iList : NULL), xCnt, xList, failOnHardLinks, dedup, holes);
+  else
+    result = tgz_extract(ctx, tgzFile, compressionMethod, junkPaths, keep, iCnt, (iCnt ? iList : NULL), xCnt, xList, failOnHardLinks, dedup, holes);
+  tgz_free(ctx);
+  fprintf(stderr, "%s %s in %.3f seconds\n", tarball, (result < 0) ? "failed" : "extracted", now() - start);
+  memReport();
+
+  switch (result)
+  {
+    case -1: return 1;
+    case -2: return 2;
+    case -3: return 3;
+    default: return (result < 0) ? 2 : 0;
+  }
+}
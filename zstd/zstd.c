@@ -0,0 +1,1262 @@
+/*
+ * zstd - Zstandard (.zst) streams
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * A frame decoded in sequence keeps its window (the most a match reaches
+ * back) and room for a block in one buffer, output handed out from it as
+ * each block is decoded and the window moved back to its start once a
+ * block may not fit.  A frame decoded whole is read into memory first
+ * (as the seek table gives its size, or block header by block header),
+ * then decoded straight into a buffer of its decoded size.  Errors in
+ * frames decoded in parallel are kept until the frame's turn, so they
+ * are reported in order, from the thread reading.
+ */
+
+#include "../zlib/zlib.h"
+#include "zstd.h"
+#include "zstddec.h"
+#include "../miniclib.h"
+#include "../decpool.h"
+#include "../pool.h"
+
+
+/* !!!USER SUPPLIED!!! */
+/* wrap around whatever you want to send error messages to user, c function */
+void PrintMessage(const char *msg, ...);
+
+
+#ifdef _MSC_VER
+typedef unsigned __int64 UInt64;
+#else
+typedef unsigned long long UInt64;
+#endif
+typedef ZU32 UInt32;
+
+#define kInBufferSize (ZSTD_BLOCKMAX + (1 << 15))  /* a whole block and more, 160KB */
+#define ZSTD_MAGIC      0xFD2FB528UL
+#define ZSTD_SKIPMAGIC  0x184D2A50UL    /* skippable frame, low 4 bits any */
+#define ZSTD_SEEKMAGIC  0x8F92EAB1UL    /* ends a seek table */
+#define ZSTD_SEEKFRAME  (ZSTD_SKIPMAGIC | 0xE)
+#define ZSTD_HEADERMAX  18              /* longest frame header */
+#define ZSTD_SEEKFOOTER 9
+#define ZSTD_UNKNOWN    ((UInt64)0 - 1)
+#define ZSTD_WINDOWMAX  ((UInt32)1 << 31)
+#define ZSTD_PARMEM     (256UL << 20)   /* most frames in flight take */
+#define ZSTD_MAXSLOTS   (2 * POOL_MAXWORKERS)
+#define ZSTD_JUMPMAX    (1L << 30)      /* most one seek moves */
+
+/* errors, zstd_read reports them */
+#define ZS_OK          0
+#define ZS_DATA        1
+#define ZS_EOF         2
+#define ZS_CHECK       3
+#define ZS_UNSUPPORTED 4
+#define ZS_NOMEM       5
+#define ZS_REPORTED    6
+static const char *const errors[] = {
+  NULL,
+  "zstd_read: Decoding error",
+  "zstd_read: Unexpected end of input",
+  "zstd_read: Checksum mismatch, data is corrupt",
+  "zstd_read: Unsupported frame (dictionary or window too large)",
+  "zstd_read: Out of memory",
+  NULL
+};
+
+
+/* frame header, as parsed */
+struct framehdr
+{
+  unsigned size;            /* of header, magic number included */
+  UInt32   window;
+  UInt64   content;         /* decoded size, ZSTD_UNKNOWN if not given */
+  int      checksum;        /* nonzero if a checksum follows the blocks */
+};
+
+/* seek table entry, a frame's sizes and checksum */
+struct seekentry
+{
+  UInt32 packed, unpacked, check;
+};
+
+/* XXH64 of decoded data, for checksums */
+typedef struct xxh64
+{
+  UInt64 v[4];
+  UInt64 total;
+  unsigned char mem[32];    /* start of a stripe not yet added */
+  unsigned memSize;
+} xxh64;
+
+/* frame decoded whole */
+struct parframe
+{
+  struct ZSTDFile *f;
+  unsigned char *in;        /* whole frame as in the file, ZSTDDEC_INPAD zeros after */
+  UInt32         inSize;
+  unsigned char *out;       /* ZSTDDEC_SLACK bytes longer than outSize */
+  UInt32         outSize;
+  UInt32         pos;       /* handed out so far */
+  unsigned long  mem;       /* of in and out, counted in inFlight */
+  int            hasCheck;  /* check is the seek table's checksum */
+  UInt32         check;
+  int            done;      /* set (under lock) once decoded */
+  int            result;    /* ZS_* */
+};
+
+/* decoding in sequence */
+#define SEQ_NONE  0       /* between frames */
+#define SEQ_BLOCK 1       /* block header next */
+#define SEQ_CHECK 2       /* checksum (if any) next */
+
+typedef struct ZSTDFile
+{
+  gzFile File;
+  unsigned long maxmem;
+  int threads;                  /* 1 if frames are decoded in sequence only */
+
+  /* input, taken by frames decoded either way */
+  unsigned char Buffer[kInBufferSize + ZSTDDEC_INPAD];
+  unsigned inPos, inEnd;        /* input not yet used */
+  int inEOF;                    /* no more to read */
+
+  /* seek table, NULL if none */
+  struct seekentry *table;
+  UInt32 frames;                /* in table */
+  int tableCheck;               /* nonzero if it has checksums */
+  UInt32 frameNo;               /* frames started (or passed over) so far */
+  int ended;                    /* end of input reached between frames */
+
+  /* frames decoded whole, on the pool once started */
+  struct pool *pool;
+  UInt32 next;                  /* frames read */
+  UInt32 cur;                   /* frames handed out */
+  unsigned slots;               /* most frames in flight */
+  unsigned long budget;         /* memory they may take */
+  unsigned long inFlight;       /* memory they take */
+  struct parframe slot[ZSTD_MAXSLOTS];  /* frame n in slot n % slots */
+  struct parframe *outFrame;    /* being handed out */
+  LOCK lock;
+  SEMA done;                    /* posted as each frame is decoded */
+
+  /* frame decoded in sequence */
+  int seq;
+  struct framehdr hdr;
+  UInt64 unpacked;              /* its decoded size, ZSTD_UNKNOWN if not known */
+  struct seekentry *entry;      /* its seek table entry, NULL if none */
+  zstddec *dec;
+  unsigned char *win;           /* window and room for a block */
+  UInt32 winSize, winPos;       /* output is up to winPos, */
+  UInt32 outPos;                /* handed out up to here */
+  UInt32 blockMax;
+  UInt64 produced, frameIn;     /* of frame so far */
+  xxh64 xxh;
+} ZSTDFile;
+
+
+static UInt32 get32(const unsigned char *p)
+{
+  return (UInt32)p[0] | ((UInt32)p[1] << 8) | ((UInt32)p[2] << 16) | ((UInt32)p[3] << 24);
+}
+
+static UInt64 get64(const unsigned char *p)
+{
+  return (UInt64)get32(p) | ((UInt64)get32(p + 4) << 32);
+}
+
+
+/*
+XXH64
+-----
+Four accumulators take 32 byte stripes, 8 bytes each, then are merged
+and the rest added.  64-bit products are taken from 32-bit ones and
+rotates and shifts are by constants, so no 64-bit helpers are needed
+with MSVC.
+*/
+
+#define PRIME64(hi, lo) (((UInt64)(hi) << 32) | (UInt64)(lo))
+#define P1 PRIME64(0x9E3779B1, 0x85EBCA87)
+#define P2 PRIME64(0xC2B2AE3D, 0x27D4EB4F)
+#define P3 PRIME64(0x165667B1, 0x9E3779F9)
+#define P4 PRIME64(0x85EBCA77, 0xC2B2AE63)
+#define P5 PRIME64(0x27D4EB2F, 0x165667C5)
+#define ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+static UInt64 mul64(UInt64 a, UInt64 b)
+{
+  UInt32 al = (UInt32)a, ah = (UInt32)(a >> 32), bl = (UInt32)b, bh = (UInt32)(b >> 32);
+  return (UInt64)al * (UInt64)bl + ((UInt64)(al * bh + ah * bl) << 32);
+}
+
+static UInt64 xxhRound(UInt64 acc, UInt64 in)
+{
+  acc += mul64(in, P2);
+  acc = ROTL64(acc, 31);
+  return mul64(acc, P1);
+}
+
+static UInt64 xxhMerge(UInt64 h, UInt64 v)
+{
+  h ^= xxhRound(0, v);
+  return mul64(h, P1) + P4;
+}
+
+static void xxhInit(xxh64 *x)
+{
+  x->v[0] = P1 + P2;
+  x->v[1] = P2;
+  x->v[2] = 0;
+  x->v[3] = 0 - P1;
+  x->total = 0;
+  x->memSize = 0;
+}
+
+/* adds n / 32 stripes at p */
+static void xxhStripes(xxh64 *x, const unsigned char *p, UInt32 n)
+{
+  UInt64 v0 = x->v[0], v1 = x->v[1], v2 = x->v[2], v3 = x->v[3];
+
+  for (; n >= 32; n -= 32, p += 32)
+  {
+    v0 = xxhRound(v0, get64(p));
+    v1 = xxhRound(v1, get64(p + 8));
+    v2 = xxhRound(v2, get64(p + 16));
+    v3 = xxhRound(v3, get64(p + 24));
+  }
+  x->v[0] = v0;
+  x->v[1] = v1;
+  x->v[2] = v2;
+  x->v[3] = v3;
+}
+
+static void xxhUpdate(xxh64 *x, const unsigned char *p, UInt32 n)
+{
+  x->total += n;
+  if (x->memSize != 0)
+  {
+    UInt32 k = 32 - x->memSize;
+    if (k > n)
+      k = n;
+    memcpy(x->mem + x->memSize, p, k);
+    x->memSize += k;
+    p += k;
+    n -= k;
+    if (x->memSize < 32)
+      return;
+    xxhStripes(x, x->mem, 32);
+    x->memSize = 0;
+  }
+  xxhStripes(x, p, n & ~(UInt32)31);
+  p += n & ~(UInt32)31;
+  n &= 31;
+  memcpy(x->mem, p, n);
+  x->memSize = n;
+}
+
+/* low 32 bits of the hash, all a checksum keeps */
+static UInt32 xxhDigest(const xxh64 *x)
+{
+  const unsigned char *p = x->mem;
+  unsigned n = x->memSize;
+  UInt64 h;
+
+  if (x->total >= 32)
+  {
+    h = ROTL64(x->v[0], 1) + ROTL64(x->v[1], 7) + ROTL64(x->v[2], 12) + ROTL64(x->v[3], 18);
+    h = xxhMerge(h, x->v[0]);
+    h = xxhMerge(h, x->v[1]);
+    h = xxhMerge(h, x->v[2]);
+    h = xxhMerge(h, x->v[3]);
+  }
+  else
+    h = P5;
+  h += x->total;
+  for (; n >= 8; n -= 8, p += 8)
+  {
+    h ^= xxhRound(0, get64(p));
+    h = mul64(ROTL64(h, 27), P1) + P4;
+  }
+  if (n >= 4)
+  {
+    h ^= mul64(get32(p), P1);
+    h = mul64(ROTL64(h, 23), P2) + P3;
+    n -= 4;
+    p += 4;
+  }
+  for (; n > 0; n--)
+  {
+    h ^= mul64(*p++, P5);
+    h = mul64(ROTL64(h, 11), P1);
+  }
+  h ^= h >> 33;
+  h = mul64(h, P2);
+  h ^= h >> 29;
+  h = mul64(h, P3);
+  h ^= h >> 32;
+  return (UInt32)h;
+}
+
+
+/*
+zstd file format
+----------------
+Frames one after another, each
+  magic    28 B5 2F FD
+  header   descriptor (bits 6-7 content size field size 0/1, 2, 4 or 8
+           bytes, 5 single segment, 2 checksum follows, 0-1 dictionary
+           id size 0, 1, 2 or 4 bytes), window descriptor (unless single
+           segment: exponent in bits 3-7, eighths to add in 0-2),
+           dictionary id, content size (+ 256 if 2 bytes)
+  blocks   3 byte header (bit 0 last, 1-2 type raw, RLE or compressed,
+           3-23 size), then that many bytes, 1 if RLE
+  checksum low 32 bits of XXH64 of the content, if flagged
+or skippable frames, magic 50-5F 2A 4D 18 and 4 bytes of size.  The
+seekable format ends with a skippable frame (5E 2A 4D 18) holding a seek
+table: for each frame its compressed and decompressed size (4 bytes each)
+and, if flagged, checksum (4 bytes), then the number of frames (4), a
+descriptor (bit 7 checksums present) and B1 EA 92 8F.  All little endian.
+*/
+
+/* parses the frame header at p, of which n bytes are available, returns
+   ZS_*, ZS_EOF if more are needed */
+static int frameHeader(const unsigned char *p, unsigned n, struct framehdr *h)
+{
+  static const unsigned char idSizes[4] = { 0, 1, 2, 4 };
+  static const unsigned char fcsSizes[4] = { 0, 2, 4, 8 };
+  unsigned fhd, single, idSize, fcsSize, i;
+
+  if (n < 5)
+    return ZS_EOF;
+  if (get32(p) != ZSTD_MAGIC)
+    return ZS_DATA;
+  fhd = p[4];
+  if (fhd & 8)
+    return ZS_DATA;   /* reserved */
+  single = (fhd >> 5) & 1;
+  idSize = idSizes[fhd & 3];
+  fcsSize = fcsSizes[fhd >> 6];
+  if (single && (fcsSize == 0))
+    fcsSize = 1;
+  h->size = 5 + !single + idSize + fcsSize;
+  h->checksum = (fhd >> 2) & 1;
+  if (n < h->size)
+    return ZS_EOF;
+  p += 5;
+
+  if (!single)
+  {
+    unsigned exponent = p[0] >> 3;
+    if (exponent > 31 - 10)
+      return ZS_UNSUPPORTED;
+    h->window = (UInt32)1 << (10 + exponent);
+    if ((h->window == ZSTD_WINDOWMAX) && (p[0] & 7))
+      return ZS_UNSUPPORTED;
+    h->window += (h->window >> 3) * (p[0] & 7);
+    p++;
+  }
+  for (i = 0; i < idSize; i++)
+    if (*p++ != 0)
+      return ZS_UNSUPPORTED;    /* needs a dictionary */
+
+  switch (fcsSize)
+  {
+    case 1:  h->content = p[0]; break;
+    case 2:  h->content = (UInt64)(p[0] | ((UInt32)p[1] << 8)) + 256; break;
+    case 4:  h->content = get32(p); break;
+    case 8:  h->content = get64(p); break;
+    default: h->content = ZSTD_UNKNOWN; break;
+  }
+  if (single)
+  {
+    if (h->content > ZSTD_WINDOWMAX)
+      return ZS_UNSUPPORTED;
+    h->window = (UInt32)h->content;
+  }
+  return ZS_OK;
+}
+
+/* decodes the block whose header is at in, of which n bytes are
+   available, into out (room bytes, ZSTDDEC_SLACK more writable, history
+   bytes of the frame before it); sets *used, *len to input and output
+   taken and made and *last if it ends the frame; returns ZS_*, ZS_EOF if
+   the block is not all in the n bytes */
+static int block(zstddec *d, const unsigned char *in, UInt32 n, unsigned char *out, UInt32 room,
+                 UInt32 blockMax, UInt32 history, UInt32 *used, UInt32 *len, int *last)
+{
+  UInt32 h, size;
+  long r;
+
+  if (n < 3)
+    return ZS_EOF;
+  h = in[0] | ((UInt32)in[1] << 8) | ((UInt32)in[2] << 16);
+  *last = h & 1;
+  size = h >> 3;
+  if (size > blockMax)
+    return ZS_DATA;
+
+  switch ((h >> 1) & 3)
+  {
+    case 0: /* raw */
+      if (size > room)
+        return ZS_DATA;
+      if (n - 3 < size)
+        return ZS_EOF;
+      memcpy(out, in + 3, size);
+      *used = 3 + size;
+      *len = size;
+      break;
+    case 1: /* RLE */
+      if (size > room)
+        return ZS_DATA;
+      if (n < 4)
+        return ZS_EOF;
+      memset(out, in[3], size);
+      *used = 4;
+      *len = size;
+      break;
+    case 2: /* compressed */
+      if (n - 3 < size)
+        return ZS_EOF;
+      if ((r = zstddec_block(d, in + 3, size, out, (room < blockMax) ? room : blockMax, history)) < 0)
+        return ZS_DATA;
+      *used = 3 + size;
+      *len = (UInt32)r;
+      break;
+    default:
+      return ZS_DATA;
+  }
+  return ZS_OK;
+}
+
+
+/* decodes the whole frame in[0..inSize) to out[0..outSize), checking
+   against the seek table's checksum if hasCheck, returns ZS_* */
+static int decodeFrame(zstddec *d, const unsigned char *in, UInt32 inSize,
+                       unsigned char *out, UInt32 outSize, int hasCheck, UInt32 check)
+{
+  struct framehdr h;
+  UInt32 pos, produced = 0, used, len, blockMax;
+  int last = 0, result;
+
+  if ((result = frameHeader(in, inSize, &h)) != ZS_OK)
+    return (result == ZS_EOF) ? ZS_DATA : result;
+  if ((h.content != ZSTD_UNKNOWN) && (h.content != outSize))
+    return ZS_DATA;
+  blockMax = (h.window < ZSTD_BLOCKMAX) ? h.window : ZSTD_BLOCKMAX;
+  zstddec_reset(d);
+
+  for (pos = h.size; !last; pos += used, produced += len)
+  {
+    result = block(d, in + pos, inSize - pos, out + produced, outSize - produced, blockMax,
+                   (produced < h.window) ? produced : h.window, &used, &len, &last);
+    if (result != ZS_OK)
+      return (result == ZS_EOF) ? ZS_DATA : result;
+  }
+  if (produced != outSize)
+    return ZS_DATA;
+
+  if (h.checksum || hasCheck)
+  {
+    xxh64 x;
+    UInt32 digest;
+
+    xxhInit(&x);
+    xxhUpdate(&x, out, outSize);
+    digest = xxhDigest(&x);
+    if (h.checksum)
+    {
+      if (inSize - pos < 4)
+        return ZS_DATA;
+      if (get32(in + pos) != digest)
+        return ZS_CHECK;
+      pos += 4;
+    }
+    if (hasCheck && (check != digest))
+      return ZS_CHECK;
+  }
+  return (pos == inSize) ? ZS_OK : ZS_DATA;
+}
+
+
+/* moves input not yet used to the start of Buffer and fills the rest */
+static void fillBuffer(ZSTDFile *f)
+{
+  unsigned n = f->inEnd - f->inPos;
+  memmove(f->Buffer, f->Buffer + f->inPos, n);
+  while (!f->inEOF && (n < kInBufferSize))
+  {
+    int len = gzread(f->File, f->Buffer + n, kInBufferSize - n);
+    if (len <= 0)
+      f->inEOF = 1;
+    else
+      n += len;
+  }
+  f->inPos = 0;
+  f->inEnd = n;
+}
+
+/* makes n (at most kInBufferSize) bytes of input available at inPos,
+   returns 0 if input ends first */
+static int avail(ZSTDFile *f, unsigned n)
+{
+  if (f->inEnd - f->inPos < n)
+    fillBuffer(f);
+  return f->inEnd - f->inPos >= n;
+}
+
+/* takes n bytes of input to dst, returns 0 if input ends first */
+static int take(ZSTDFile *f, unsigned char *dst, UInt32 n)
+{
+  UInt32 k = f->inEnd - f->inPos;
+
+  if (k > n)
+    k = n;
+  memcpy(dst, f->Buffer + f->inPos, k);
+  f->inPos += k;
+  for (dst += k, n -= k; n > 0; dst += k, n -= k)
+  {
+    int len = gzread(f->File, dst, n);
+    if (len <= 0)
+    {
+      f->inEOF = 1;
+      return 0;
+    }
+    k = (UInt32)len;
+  }
+  return 1;
+}
+
+/* passes over n bytes of input, seeking past what isn't read yet if the
+   file allows, returns 0 if input ends first */
+static int pass(ZSTDFile *f, UInt64 n)
+{
+  UInt32 k = f->inEnd - f->inPos;
+
+  if ((UInt64)k > n)
+    k = (UInt32)n;
+  f->inPos += k;
+  n -= k;
+  while (n > 0)
+  {
+    long step = (n > (UInt64)ZSTD_JUMPMAX) ? ZSTD_JUMPMAX : (long)n;
+
+    if (!f->inEOF && (gzseek(f->File, step, SEEK_CUR) >= 0))
+      n -= step;
+    else
+    {
+      /* read through */
+      if (!avail(f, 1))
+        return 0;
+      k = f->inEnd - f->inPos;
+      if ((UInt64)k > n)
+        k = (UInt32)n;
+      f->inPos += k;
+      n -= k;
+    }
+  }
+  return 1;
+}
+
+/* passes over the skippable frame at the input, returns ZS_* */
+static int skipFrame(ZSTDFile *f)
+{
+  if (!avail(f, 8))
+    return ZS_EOF;
+  return pass(f, (UInt64)8 + get32(f->Buffer + f->inPos + 4)) ? ZS_OK : ZS_EOF;
+}
+
+/* reads the seek table at the end of the file, if there is one and its
+   frames make up the rest of the file */
+static void tableInit(ZSTDFile *f)
+{
+  unsigned char footer[ZSTD_SEEKFOOTER], *t = NULL;
+  long size;
+  UInt32 n, entrySize, tableSize, i;
+  UInt64 total = 0;
+
+  if (((size = gzseek(f->File, 0L, SEEK_END)) < 8 + ZSTD_SEEKFOOTER) ||
+      (gzseek(f->File, size - ZSTD_SEEKFOOTER, SEEK_SET) < 0) ||
+      (gzread(f->File, footer, ZSTD_SEEKFOOTER) != ZSTD_SEEKFOOTER) ||
+      (get32(footer + 5) != ZSTD_SEEKMAGIC) || (footer[4] & 0x7C))
+    return;
+  n = get32(footer);
+  entrySize = (footer[4] & 0x80) ? 12 : 8;
+  if ((n == 0) || (n > (UInt32)(size - 8 - ZSTD_SEEKFOOTER) / entrySize))
+    return;
+  tableSize = 8 + n * entrySize + ZSTD_SEEKFOOTER;
+
+  if (((t = (unsigned char *)dpool_alloc(tableSize)) == NULL) ||
+      (gzseek(f->File, size - (long)tableSize, SEEK_SET) < 0) ||
+      (gzread(f->File, t, tableSize) != (int)tableSize) ||
+      (get32(t) != ZSTD_SEEKFRAME) || (get32(t + 4) != tableSize - 8) ||
+      ((f->table = (struct seekentry *)dpool_alloc(n * sizeof(struct seekentry))) == NULL))
+  {
+    dpool_free(t);
+    return;
+  }
+  for (i = 0; i < n; i++)
+  {
+    const unsigned char *p = t + 8 + i * entrySize;
+    f->table[i].packed = get32(p);
+    f->table[i].unpacked = get32(p + 4);
+    f->table[i].check = (entrySize == 12) ? get32(p + 8) : 0;
+    total += f->table[i].packed;
+  }
+  dpool_free(t);
+  if (total + tableSize != (UInt64)size)
+  {
+    /* other frames too, so it can't be trusted */
+    dpool_free(f->table);
+    f->table = NULL;
+    return;
+  }
+  f->frames = n;
+  f->tableCheck = (entrySize == 12);
+}
+
+/* the next frame's decoded size, from its header h or the seek table,
+   setting *e to its seek table entry; ZSTD_UNKNOWN if not known, or if
+   they disagree (decoding it reports that) */
+static UInt64 frameSize(ZSTDFile *f, const struct framehdr *h, struct seekentry **e)
+{
+  *e = NULL;
+  if (f->table == NULL)
+    return h->content;
+  if (f->frameNo >= f->frames)
+    return ZSTD_UNKNOWN;
+  *e = &f->table[f->frameNo];
+  if ((h->content != ZSTD_UNKNOWN) && (h->content != (*e)->unpacked))
+    return ZSTD_UNKNOWN;
+  return (*e)->unpacked;
+}
+
+
+/* decodes frame b, on a pool thread (or the reading thread) */
+static void parDecode(struct pool *pool, int worker, void *arg)
+{
+  struct parframe *b = (struct parframe *)arg;
+  ZSTDFile *f = b->f;
+  zstddec *d;
+  int result;
+
+  (void)pool;
+  (void)worker;
+  if ((d = (zstddec *)dpool_alloc(sizeof(zstddec))) == NULL)
+    result = ZS_NOMEM;
+  else
+    result = decodeFrame(d, b->in, b->inSize, b->out, b->outSize, b->hasCheck, b->check);
+
+  dpool_free(d);
+  dpool_free(b->in);
+  lock_acquire(&f->lock);
+  b->in = NULL;
+  b->result = result;
+  b->done = 1;
+  lock_release(&f->lock);
+  sema_post(&f->done, 1);
+}
+
+/* reads the frame with header h at the input into b->in block by block,
+   as no seek table gives its size; returns ZS_* */
+static int readFrame(ZSTDFile *f, struct parframe *b, const struct framehdr *h)
+{
+  unsigned long limit = f->budget - b->outSize;
+  UInt32 cap = b->outSize / 2 + (1 << 16), size = h->size;
+  int last;
+
+  if (cap > limit)
+    cap = limit;
+  if ((b->in = (unsigned char *)dpool_alloc(cap + ZSTDDEC_INPAD)) == NULL)
+    return ZS_NOMEM;
+  memcpy(b->in, f->Buffer + f->inPos, size);
+  f->inPos += size;
+
+  do
+  {
+    UInt32 hdr, n;
+
+    if (!avail(f, 3))
+      return ZS_EOF;
+    hdr = get32(f->Buffer + f->inPos) & 0xFFFFFF;
+    last = hdr & 1;
+    n = 3 + ((((hdr >> 1) & 3) == 1) ? 1 : (hdr >> 3));
+    if ((n > 3 + ZSTD_BLOCKMAX) || (((hdr >> 1) & 3) == 3))
+      return ZS_DATA;
+    if (!avail(f, n))
+      return ZS_EOF;
+    if (cap - size < n + 4)
+    {
+      /* grow, leaving room for the checksum */
+      unsigned char *in;
+      UInt32 want = (cap > limit / 2) ? (UInt32)limit : 2 * cap;
+
+      if (want - size < n + 4)
+        return ZS_DATA;   /* far larger than it decodes to */
+      if ((in = (unsigned char *)dpool_alloc(want + ZSTDDEC_INPAD)) == NULL)
+        return ZS_NOMEM;
+      memcpy(in, b->in, size);
+      dpool_free(b->in);
+      b->in = in;
+      cap = want;
+    }
+    memcpy(b->in + size, f->Buffer + f->inPos, n);
+    f->inPos += n;
+    size += n;
+  } while (!last);
+
+  if (h->checksum)
+  {
+    if (!avail(f, 4))
+      return ZS_EOF;
+    memcpy(b->in + size, f->Buffer + f->inPos, 4);
+    f->inPos += 4;
+    size += 4;
+  }
+  b->inSize = size;
+  return ZS_OK;
+}
+
+/* reads frames whole and has them decoded while slots and memory allow,
+   up to the first to be decoded in sequence (or the end); returns ZS_* */
+static int parFill(ZSTDFile *f)
+{
+  while (f->next - f->cur < f->slots)
+  {
+    struct parframe *b;
+    struct framehdr h;
+    struct seekentry *e;
+    UInt64 unpacked;
+    unsigned long need;
+    UInt32 m;
+    int result;
+
+    if (!avail(f, 4))
+      return ZS_OK;
+    m = get32(f->Buffer + f->inPos);
+    if ((m & 0xFFFFFFF0UL) == ZSTD_SKIPMAGIC)
+    {
+      if ((result = skipFrame(f)) != ZS_OK)
+        return result;
+      continue;
+    }
+    avail(f, ZSTD_HEADERMAX);
+    if (frameHeader(f->Buffer + f->inPos, f->inEnd - f->inPos, &h) != ZS_OK)
+      return ZS_OK;   /* reported decoding it in sequence */
+
+    /* whole if small enough, and once there is room beside those in flight */
+    unpacked = frameSize(f, &h, &e);
+    if ((unpacked == ZSTD_UNKNOWN) || (unpacked > f->budget / 4) ||
+        ((e != NULL) && (e->packed > f->budget / 4)))
+      return ZS_OK;
+    need = (unsigned long)unpacked + ((e != NULL) ? e->packed : (unsigned long)unpacked);
+    if ((f->next != f->cur) && (need > f->budget - f->inFlight))
+      return ZS_OK;
+
+    b = &f->slot[f->next % f->slots];
+    b->f = f;
+    b->outSize = (UInt32)unpacked;
+    b->pos = 0;
+    b->hasCheck = (e != NULL) && f->tableCheck;
+    b->check = (e != NULL) ? e->check : 0;
+    b->done = 0;
+    b->result = ZS_OK;
+    if ((b->out = (unsigned char *)dpool_alloc(b->outSize + ZSTDDEC_SLACK)) == NULL)
+      return ZS_NOMEM;
+    if (e != NULL)
+    {
+      b->inSize = e->packed;
+      if ((b->in = (unsigned char *)dpool_alloc(b->inSize + ZSTDDEC_INPAD)) == NULL)
+        return ZS_NOMEM;
+      if ((b->inSize < h.size) || !take(f, b->in, b->inSize))
+        return ZS_EOF;
+    }
+    else if ((result = readFrame(f, b, &h)) != ZS_OK)
+      return result;
+    memset(b->in + b->inSize, 0, ZSTDDEC_INPAD);
+    b->mem = b->inSize + b->outSize;
+    f->inFlight += b->mem;
+    f->frameNo++;
+    f->next++;
+
+    /* a pool once there is more than this frame to decode */
+    if ((f->pool == NULL) && ((f->next - f->cur > 1) || avail(f, 1)))
+      f->pool = pool_new(f->threads);
+    if ((f->pool == NULL) || !pool_submit(f->pool, -1, parDecode, b))
+      parDecode(NULL, 0, b);
+  }
+  return ZS_OK;
+}
+
+/* waits for the next frame decoded whole and hands it out, returns ZS_* */
+static int parNext(ZSTDFile *f)
+{
+  struct parframe *b = &f->slot[f->cur % f->slots];
+  int result;
+
+  lock_acquire(&f->lock);
+  while (!b->done)
+  {
+    lock_release(&f->lock);
+    sema_wait(&f->done);
+    lock_acquire(&f->lock);
+  }
+  result = b->result;
+  lock_release(&f->lock);
+  if (result != ZS_OK)
+    return result;
+
+  f->cur++;
+  f->outFrame = b;
+  return ZS_OK;
+}
+
+
+/* sets *need to the least window frame h (of unpacked bytes) is decoded
+   in: what is kept of its window, a block and slack; returns 0 after
+   reporting it if that and the decoder's own state are over maxmem */
+static int windowFits(ZSTDFile *f, const struct framehdr *h, UInt64 unpacked, UInt64 *need)
+{
+  UInt32 blockMax = (h->window < ZSTD_BLOCKMAX) ? h->window : ZSTD_BLOCKMAX;
+  UInt32 keep = ((UInt64)h->window < unpacked) ? h->window : (UInt32)unpacked;
+  UInt64 total;
+
+  *need = (UInt64)keep + blockMax + ZSTDDEC_SLACK;
+  total = *need + sizeof(ZSTDFile) + sizeof(zstddec);
+  if ((f->maxmem != 0) && (total > f->maxmem))
+  {
+    PrintMessage("Error: zstd window of %lu KB needs %lu KB, over the %lu KB memory budget for decoding",
+                 (unsigned long)(keep >> 10), (unsigned long)(total >> 10), f->maxmem >> 10);
+    return 0;
+  }
+  return 1;
+}
+
+
+/* starts decoding the frame at the input in sequence, passes over a
+   skippable frame, or sets ended at the end of input; returns ZS_* */
+static int startFrame(ZSTDFile *f)
+{
+  struct framehdr h;
+  struct seekentry *e;
+  UInt64 unpacked, need, want;
+  unsigned long over = sizeof(ZSTDFile) + sizeof(zstddec);
+  UInt32 m;
+  int result;
+
+  if (!avail(f, 4))
+  {
+    if (f->inPos != f->inEnd)
+      return ZS_EOF;
+    if ((f->table != NULL) && (f->frameNo != f->frames))
+      return ZS_DATA;
+    f->ended = 1;
+    return ZS_OK;
+  }
+  m = get32(f->Buffer + f->inPos);
+  if ((m & 0xFFFFFFF0UL) == ZSTD_SKIPMAGIC)
+    return skipFrame(f);
+  avail(f, ZSTD_HEADERMAX);
+  if ((result = frameHeader(f->Buffer + f->inPos, f->inEnd - f->inPos, &h)) != ZS_OK)
+    return result;
+  unpacked = frameSize(f, &h, &e);
+  if ((f->table != NULL) && (unpacked == ZSTD_UNKNOWN))
+    return ZS_DATA;     /* more frames than the table, or not the size it gives */
+
+  /* the window, a block and slack; up to twice the window if allowed, so
+     it is moved back less often */
+  f->blockMax = (h.window < ZSTD_BLOCKMAX) ? h.window : ZSTD_BLOCKMAX;
+  if (!windowFits(f, &h, unpacked, &need))
+    return ZS_REPORTED;
+  want = (UInt64)h.window * 2;
+  if (want > unpacked)
+    want = unpacked;
+  want += f->blockMax + ZSTDDEC_SLACK;
+  if ((f->maxmem != 0) && (want + over > f->maxmem))
+    want = f->maxmem - over;
+  if (want > 0xFFFF0000UL)
+    want = need;
+
+  if (f->winSize < need)
+  {
+    /* all output has been taken */
+    dpool_free(f->win);
+    f->winSize = 0;
+    if ((f->win = (unsigned char *)dpool_alloc((unsigned long)want)) == NULL)
+    {
+      want = need;
+      if ((f->win = (unsigned char *)dpool_alloc((unsigned long)want)) == NULL)
+        return ZS_NOMEM;
+    }
+    f->winSize = (UInt32)want;
+  }
+  if ((f->dec == NULL) && ((f->dec = (zstddec *)dpool_alloc(sizeof(zstddec))) == NULL))
+    return ZS_NOMEM;
+
+  zstddec_reset(f->dec);
+  f->hdr = h;
+  f->unpacked = unpacked;
+  f->entry = e;
+  f->winPos = f->outPos = 0;
+  f->produced = 0;
+  f->frameIn = h.size;
+  f->inPos += h.size;
+  f->frameNo++;
+  xxhInit(&f->xxh);
+  f->seq = SEQ_BLOCK;
+  return ZS_OK;
+}
+
+/* decodes the next block of the frame in sequence into the window, or
+   reads its checksum; returns ZS_* */
+static int seqDecode(ZSTDFile *f)
+{
+  int check = f->hdr.checksum || ((f->entry != NULL) && f->tableCheck);
+
+  if (f->seq == SEQ_BLOCK)
+  {
+    UInt32 used, len, history, room;
+    int last, result;
+
+    /* all output has been taken; move the window back if a block may not fit */
+    if (f->winPos + f->blockMax + ZSTDDEC_SLACK > f->winSize)
+    {
+      UInt32 keep = (f->winPos < f->hdr.window) ? f->winPos : f->hdr.window;
+      memmove(f->win, f->win + f->winPos - keep, keep);
+      f->winPos = f->outPos = keep;
+    }
+    history = (f->produced < (UInt64)f->hdr.window) ? (UInt32)f->produced : f->hdr.window;
+    room = f->winSize - f->winPos - ZSTDDEC_SLACK;
+
+    result = block(f->dec, f->Buffer + f->inPos, f->inEnd - f->inPos, f->win + f->winPos, room,
+                   f->blockMax, history, &used, &len, &last);
+    if ((result == ZS_EOF) && !f->inEOF)
+    {
+      fillBuffer(f);
+      result = block(f->dec, f->Buffer + f->inPos, f->inEnd - f->inPos, f->win + f->winPos, room,
+                     f->blockMax, history, &used, &len, &last);
+    }
+    if (result != ZS_OK)
+      return result;
+    if ((f->unpacked != ZSTD_UNKNOWN) && ((UInt64)len > f->unpacked - f->produced))
+      return ZS_DATA;
+    if (check)
+      xxhUpdate(&f->xxh, f->win + f->winPos, len);
+    f->inPos += used;
+    f->frameIn += used;
+    f->produced += len;
+    f->winPos += len;
+    if (last)
+      f->seq = SEQ_CHECK;
+    return ZS_OK;
+  }
+  else /* SEQ_CHECK */
+  {
+    UInt32 digest = check ? xxhDigest(&f->xxh) : 0;
+
+    if ((f->unpacked != ZSTD_UNKNOWN) && (f->produced != f->unpacked))
+      return ZS_DATA;
+    if (f->hdr.checksum)
+    {
+      if (!avail(f, 4))
+        return ZS_EOF;
+      if (get32(f->Buffer + f->inPos) != digest)
+        return ZS_CHECK;
+      f->inPos += 4;
+      f->frameIn += 4;
+    }
+    if (f->entry != NULL)
+    {
+      if (f->tableCheck && (f->entry->check != digest))
+        return ZS_CHECK;
+      if (f->entry->packed != f->frameIn)
+        return ZS_DATA;
+    }
+    f->seq = SEQ_NONE;
+    return ZS_OK;
+  }
+}
+
+
+/* output decoded and not yet handed out */
+static UInt32 pending(const ZSTDFile *f)
+{
+  if (f->outFrame != NULL)
+    return f->outFrame->outSize - f->outFrame->pos;
+  return f->winPos - f->outPos;
+}
+
+/* frees the frame handed out, all of it having been taken */
+static void release(ZSTDFile *f)
+{
+  if (f->outFrame != NULL)
+  {
+    dpool_free(f->outFrame->out);
+    f->outFrame->out = NULL;
+    f->inFlight -= f->outFrame->mem;
+    f->outFrame = NULL;
+  }
+}
+
+/* makes more output available (or sets ended), all output having been
+   taken; frames are read ahead to decode in parallel unless !fill,
+   returns ZS_* */
+static int advance(ZSTDFile *f, int fill)
+{
+  int result;
+
+  release(f);
+  if (f->seq != SEQ_NONE)
+    return seqDecode(f);
+  if (f->threads > 1)
+  {
+    if (fill && ((result = parFill(f)) != ZS_OK))
+      return result;
+    if (f->cur != f->next)
+      return parNext(f);
+  }
+  return startFrame(f);
+}
+
+/* between frames, with none in flight: passes over the next frame if
+   skippable, or if it decodes to at most most bytes, adding those to
+   *skipped; *jumped is 0 if it has to be decoded; returns ZS_* */
+static int jump(ZSTDFile *f, unsigned long most, unsigned long *skipped, int *jumped)
+{
+  struct framehdr h;
+  struct seekentry *e;
+  UInt64 unpacked;
+  UInt32 m;
+
+  *jumped = 0;
+  if (!avail(f, 4))
+    return ZS_OK;   /* the end, decoding sees to it */
+  m = get32(f->Buffer + f->inPos);
+  if ((m & 0xFFFFFFF0UL) == ZSTD_SKIPMAGIC)
+  {
+    *jumped = 1;
+    return skipFrame(f);
+  }
+  avail(f, ZSTD_HEADERMAX);
+  if (frameHeader(f->Buffer + f->inPos, f->inEnd - f->inPos, &h) != ZS_OK)
+    return ZS_OK;
+  unpacked = frameSize(f, &h, &e);
+  if ((unpacked == ZSTD_UNKNOWN) || (unpacked > most))
+    return ZS_OK;
+
+  if (e != NULL)
+  {
+    /* straight to the next frame */
+    if ((e->packed < h.size) || !pass(f, e->packed))
+      return ZS_EOF;
+  }
+  else
+  {
+    /* over the blocks by their headers */
+    int last;
+
+    f->inPos += h.size;
+    do
+    {
+      UInt32 hdr;
+
+      if (!avail(f, 3))
+        return ZS_EOF;
+      hdr = get32(f->Buffer + f->inPos) & 0xFFFFFF;
+      last = hdr & 1;
+      if (((hdr >> 1) & 3) == 3)
+        return ZS_DATA;
+      if (!pass(f, 3 + ((((hdr >> 1) & 3) == 1) ? 1 : (hdr >> 3))))
+        return ZS_EOF;
+    } while (!last);
+    if (h.checksum && !pass(f, 4))
+      return ZS_EOF;
+  }
+  f->frameNo++;
+  *skipped += (unsigned long)unpacked;
+  *jumped = 1;
+  return ZS_OK;
+}
+
+
+static void report(int result)
+{
+  if (errors[result] != NULL)
+    PrintMessage(errors[result]);
+}
+
+int zstd_init(gzFile infile, struct ZSTDFile **zstdFile, unsigned long maxmem, int threads)
+{
+  ZSTDFile *f;
+  struct framehdr h;
+  struct seekentry *e;
+  UInt64 need;
+  int result;
+
+  *zstdFile = f = (ZSTDFile *)dpool_alloc(sizeof(struct ZSTDFile));
+  if (f == NULL) return -1;
+
+  memset(f, 0, sizeof(ZSTDFile));
+  f->File = infile;
+  f->maxmem = maxmem;
+  f->budget = (maxmem && (maxmem < ZSTD_PARMEM)) ? maxmem : ZSTD_PARMEM;
+  f->threads = 1;
+  if (threads == 0)
+    threads = thread_cpus();
+  if ((threads > 1) && sema_init(&f->done, 0))
+  {
+    lock_init(&f->lock);
+    f->threads = threads;
+    f->slots = (2 * threads < ZSTD_MAXSLOTS) ? 2 * threads : ZSTD_MAXSLOTS;
+  }
+
+  /* seek table, then from the first frame */
+  tableInit(f);
+  if (gzseek(infile, 0L, SEEK_SET) != 0)
+  {
+    PrintMessage("zstd: Can not read input file.");
+    return -1;
+  }
+  if (!avail(f, 4))
+  {
+    PrintMessage("zstd: Can not read input file.");
+    return -1;
+  }
+  if ((get32(f->Buffer) & 0xFFFFFFF0UL) != ZSTD_SKIPMAGIC)
+  {
+    avail(f, ZSTD_HEADERMAX);
+    if ((result = frameHeader(f->Buffer, f->inEnd, &h)) != ZS_OK)
+    {
+      report((result == ZS_EOF) ? ZS_EOF : result);
+      return -1;
+    }
+    /* refused here rather than once reading starts */
+    if (!windowFits(f, &h, frameSize(f, &h, &e), &need))
+      return -1;
+  }
+  return 0;
+}
+
+
+void zstd_cleanup(struct ZSTDFile *zstdFile)
+{
+  unsigned i;
+
+  if (zstdFile != NULL)
+  {
+    if (zstdFile->pool != NULL)
+      pool_free(zstdFile->pool);
+    if (zstdFile->threads > 1)
+    {
+      lock_free(&zstdFile->lock);
+      sema_free(&zstdFile->done);
+    }
+    for (i = 0; i < ZSTD_MAXSLOTS; i++)
+    {
+      dpool_free(zstdFile->slot[i].in);
+      dpool_free(zstdFile->slot[i].out);
+    }
+    dpool_free(zstdFile->table);
+    dpool_free(zstdFile->dec);
+    dpool_free(zstdFile->win);
+    dpool_free(zstdFile);
+  }
+}
+
+
+long zstd_readptr(struct ZSTDFile *zstdFile,
+                  const unsigned char **buffer,
+                  unsigned len)
+{
+  UInt32 n;
+  int result;
+
+  while ((n = pending(zstdFile)) == 0)
+  {
+    if (zstdFile->ended)
+      return 0;
+    if ((result = advance(zstdFile, 1)) != ZS_OK)
+    {
+      report(result);
+      return -1;
+    }
+  }
+  if (n > len)
+    n = len;
+  if (zstdFile->outFrame != NULL)
+  {
+    *buffer = zstdFile->outFrame->out + zstdFile->outFrame->pos;
+    zstdFile->outFrame->pos += n;
+  }
+  else
+  {
+    *buffer = zstdFile->win + zstdFile->outPos;
+    zstdFile->outPos += n;
+  }
+  return (long)n;
+}
+
+
+long zstd_read(struct ZSTDFile *zstdFile,
+               unsigned char *buffer,
+               unsigned len)
+{
+  unsigned done = 0;
+
+  while (done < len)
+  {
+    const unsigned char *p;
+    long n = zstd_readptr(zstdFile, &p, len - done);
+    if (n < 0)
+      return -1;
+    if (n == 0)
+      break;
+    memcpy(buffer + done, p, n);
+    done += n;
+  }
+  return (long)done;
+}
+
+
+long zstd_skip(struct ZSTDFile *zstdFile, unsigned long len)
+{
+  unsigned long done = 0;
+  UInt32 n;
+  int result, jumped;
+
+  while (done < len)
+  {
+    if ((n = pending(zstdFile)) > 0)
+    {
+      if (n > len - done)
+        n = (UInt32)(len - done);
+      if (zstdFile->outFrame != NULL)
+        zstdFile->outFrame->pos += n;
+      else
+        zstdFile->outPos += n;
+      done += n;
+      continue;
+    }
+    if (zstdFile->ended)
+      break;
+
+    if ((zstdFile->seq == SEQ_NONE) && (zstdFile->cur + (zstdFile->outFrame != NULL) == zstdFile->next))
+    {
+      /* between frames with nothing in flight, jump over those inside the rest */
+      release(zstdFile);
+      if ((result = jump(zstdFile, len - done, &done, &jumped)) == ZS_OK)
+        if (!jumped)
+          result = advance(zstdFile, 1);
+    }
+    else
+      result = advance(zstdFile, 0);   /* finish frames already started */
+    if (result != ZS_OK)
+    {
+      report(result);
+      return -1;
+    }
+  }
+  return (long)done;
+}
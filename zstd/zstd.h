@@ -0,0 +1,51 @@
+/*
+ * zstd - Zstandard (.zst) streams
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * Frames hold no references to each other, so when a stream has several
+ * (zstd --seekable, pzstd, or files compressed in pieces and concatenated)
+ * and a frame's decoded size is known, from its header or from a seek
+ * table, it is read whole and decoded on a pool of threads (pool.c) into
+ * a buffer of its own, a few at a time, and handed out in order.  Other
+ * frames are decoded one block at a time through a window buffer, as
+ * lzma.c does.  zstd_skip passes over output without decoding the frames
+ * lying wholly inside it, jumping straight over their input when the
+ * stream ends with a seek table (the seekable format) giving their sizes.
+ * Compressed blocks are decoded by zstddec; dictionaries are not
+ * supported, and skipped frames are not checked.
+ */
+
+#ifndef _ZSTD_H_
+#define _ZSTD_H_
+
+/* prototypes for our read function */
+typedef void * gzFile;
+int gzread(gzFile file, void * buf, unsigned len);
+
+/* holds any information needed about stream */
+struct ZSTDFile;
+typedef struct ZSTDFile ZSTDFile;
+
+/* routines implemented */
+/* maxmem (0 for no limit) refuses frames whose window needs more than
+   maxmem bytes decoded one block at a time, and bounds the frames decoded
+   at the same time; threads (0 for one per processor) decode frames, with
+   fewer than 2 they are decoded one after another */
+int zstd_init(gzFile infile, struct ZSTDFile **zstdFile, unsigned long maxmem, int threads);
+void zstd_cleanup(struct ZSTDFile *zstdFile);
+long zstd_read(struct ZSTDFile *zstdFile,
+               unsigned char *buffer,
+               unsigned len);
+/* as zstd_read, but returns a pointer to up to len bytes decoded (valid
+   until the next read) rather than copying them */
+long zstd_readptr(struct ZSTDFile *zstdFile,
+                  const unsigned char **buffer,
+                  unsigned len);
+/* passes over up to len bytes of output, returns the number passed over
+   (less only at the end) or -1 on error */
+long zstd_skip(struct ZSTDFile *zstdFile, unsigned long len);
+
+#endif /* _ZSTD_H_ */
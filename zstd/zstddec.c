@@ -0,0 +1,800 @@
+/*
+ * zstddec - Zstandard compressed block decoder
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * A compressed block is a literals section, then a sequences section:
+ * each sequence copies some literals and then a match, and the literals
+ * left after the last are copied at the end.  Literals and the tables
+ * for sequences are decoded first, then sequences are decoded and copied
+ * one at a time from a single backward bit stream.
+ */
+
+#include "zstddec.h"
+#include "../miniclib.h"
+
+
+#ifdef __GNUC__
+#define COPY8(d, s) __builtin_memcpy((d), (s), 8)
+#else
+#define COPY8(d, s) (((ZU32 *)(d))[0] = ((const ZU32 *)(s))[0], \
+                     ((ZU32 *)(d))[1] = ((const ZU32 *)(s))[1])
+#endif
+
+#define LL_MAX 35         /* largest codes */
+#define ML_MAX 52
+#define OF_MAX 31
+#define WEIGHT_MAX 11     /* of a literal, ZSTD_HUFBITS */
+
+/* literals block types */
+#define LIT_RAW        0
+#define LIT_RLE        1
+#define LIT_COMPRESSED 2
+#define LIT_TREELESS   3
+
+/* table modes */
+#define MODE_PREDEFINED 0
+#define MODE_RLE        1
+#define MODE_FSE        2
+#define MODE_REPEAT     3
+
+/* lengths and bits added for literal length and match length codes */
+static const ZU32 llBase[LL_MAX + 1] = {
+  0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+  16, 18, 20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512, 1024, 2048, 4096,
+  8192, 16384, 32768, 65536 };
+static const unsigned char llExtra[LL_MAX + 1] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  1, 1, 1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12,
+  13, 14, 15, 16 };
+static const ZU32 mlBase[ML_MAX + 1] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+  19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+  35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515, 1027, 2051,
+  4099, 8195, 16387, 32771, 65539 };
+static const unsigned char mlExtra[ML_MAX + 1] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  1, 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11,
+  12, 13, 14, 15, 16 };
+
+/* predefined distributions */
+static const short llDefault[LL_MAX + 1] = {
+  4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1,
+  2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1,
+  -1, -1, -1, -1 };
+static const short mlDefault[ML_MAX + 1] = {
+  1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1,
+  -1, -1, -1, -1, -1 };
+static const short ofDefault[28 + 1] = {
+  1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1 };
+
+
+static ZU32 get32(const unsigned char *p)
+{
+  return (ZU32)p[0] | ((ZU32)p[1] << 8) | ((ZU32)p[2] << 16) | ((ZU32)p[3] << 24);
+}
+
+/* index of highest bit set, v nonzero */
+static unsigned highbit(ZU32 v)
+{
+  unsigned n = 0;
+  while (v >>= 1)
+    n++;
+  return n;
+}
+
+
+/*
+Backward bit streams
+--------------------
+Huffman and FSE coded data is read from its last byte to its first,
+each byte from its highest bit; the last byte's highest set bit marks
+where the data starts.  bits holds the 4 bytes at ptr, consumed counts
+the bits of them already read; refilling moves ptr back by whole bytes
+read, so at least 25 bits may be read after a refill until ptr reaches
+the start of the stream.
+*/
+
+typedef struct bitin
+{
+  ZU32 bits;
+  unsigned consumed;
+  const unsigned char *ptr, *start;
+} bitin;
+
+/* next n (at most 25, or 0) bits */
+#define PEEK(b, n) ((((b)->bits << ((b)->consumed & 31)) >> 1) >> ((31 - (n)) & 31))
+
+static ZU32 bitsRead(bitin *b, unsigned n)
+{
+  ZU32 v = PEEK(b, n);
+  b->consumed += n;
+  return v;
+}
+
+/* starts reading in[0..size), returns 0 if empty or not marked */
+static int bitsInit(bitin *b, const unsigned char *in, ZU32 size)
+{
+  if ((size == 0) || (in[size - 1] == 0))
+    return 0;
+  b->start = in;
+  if (size >= 4)
+  {
+    b->ptr = in + size - 4;
+    b->bits = get32(b->ptr);
+    b->consumed = 0;
+  }
+  else
+  {
+    /* short stream, its bytes at the top */
+    b->ptr = in;
+    b->bits = in[0];
+    if (size > 1) b->bits |= (ZU32)in[1] << 8;
+    if (size > 2) b->bits |= (ZU32)in[2] << 16;
+    b->bits <<= (4 - size) * 8;
+    b->consumed = (4 - size) * 8;
+  }
+  b->consumed += 8 - highbit(in[size - 1]);
+  return 1;
+}
+
+/* refills, returns 0 once more bits were read than the stream has */
+static int bitsReload(bitin *b)
+{
+  unsigned n;
+
+  if (b->consumed > 32)
+    return 0;
+  n = b->consumed >> 3;
+  if ((unsigned)(b->ptr - b->start) < n)
+    n = (unsigned)(b->ptr - b->start);
+  if (n != 0)
+  {
+    b->ptr -= n;
+    b->consumed -= n * 8;
+    b->bits = get32(b->ptr);
+  }
+  return 1;
+}
+
+/* nonzero if exactly all bits were read */
+static int bitsDone(const bitin *b)
+{
+  return (b->ptr == b->start) && (b->consumed == 32);
+}
+
+
+/*
+FSE tables
+----------
+A table description is read forward, lowest bits first: 4 bits of
+accuracy log - 5, then each symbol's probability in as few bits as the
+probability left allows (-1 meaning less than 1), with runs of symbols
+of probability 0 given as 2 bit repeat counts after one.  Symbols are
+spread over the table of 1 << log states, those of probability -1 at
+its end, and each state gets the bits to read for the next state.
+*/
+
+/* reads a description from in[0..size) (ZSTDDEC_INPAD bytes readable
+   after), symbols up to *maxSym and log up to maxLog, setting *maxSym to
+   the last symbol given; returns the bytes used, or 0 if invalid */
+static ZU32 readCounts(short *norm, unsigned *maxSym, unsigned *log, unsigned maxLog,
+                       const unsigned char *in, ZU32 size)
+{
+  ZU32 pos = 4;       /* in bits */
+  int remaining, threshold, nbBits;
+  unsigned sym = 0;
+  int prev0 = 0;
+
+  if (size == 0)
+    return 0;
+  *log = (in[0] & 15) + 5;
+  if (*log > maxLog)
+    return 0;
+  remaining = (1 << *log) + 1;
+  threshold = 1 << *log;
+  nbBits = *log + 1;
+
+  while ((remaining > 1) && (sym <= *maxSym))
+  {
+    ZU32 v;
+    int max, count;
+
+    if (prev0)
+    {
+      unsigned n0 = sym, r;
+      do
+      {
+        r = (get32(in + (pos >> 3)) >> (pos & 7)) & 3;
+        pos += 2;
+        n0 += r;
+        if (pos > size * 8)
+          return 0;
+      } while (r == 3);
+      if (n0 > *maxSym)
+        return 0;
+      while (sym < n0)
+        norm[sym++] = 0;
+    }
+
+    v = get32(in + (pos >> 3)) >> (pos & 7);
+    max = (2 * threshold - 1) - remaining;
+    if ((int)(v & (threshold - 1)) < max)
+    {
+      count = (int)(v & (threshold - 1));
+      pos += nbBits - 1;
+    }
+    else
+    {
+      count = (int)(v & (2 * threshold - 1));
+      if (count >= threshold)
+        count -= max;
+      pos += nbBits;
+    }
+    count--;
+    remaining -= (count < 0) ? -count : count;
+    norm[sym++] = (short)count;
+    prev0 = (count == 0);
+    while (remaining < threshold)
+    {
+      nbBits--;
+      threshold >>= 1;
+    }
+    if (pos > size * 8)
+      return 0;
+  }
+
+  if (remaining != 1)
+    return 0;
+  *maxSym = sym - 1;
+  return (pos + 7) >> 3;
+}
+
+/* spreads symbols over the table, setting each state's symbol, next
+   state base and bits; returns 0 if the counts don't fill it */
+static int buildStates(unsigned char *symbol, unsigned short *state, unsigned char *nbBits,
+                       const short *norm, unsigned maxSym, unsigned log)
+{
+  unsigned size = 1 << log, high = size - 1, pos = 0;
+  unsigned step = (size >> 1) + (size >> 3) + 3, s, i;
+  unsigned short next[ML_MAX + 1];
+
+  for (s = 0; s <= maxSym; s++)
+  {
+    if (norm[s] == -1)
+    {
+      symbol[high--] = (unsigned char)s;
+      next[s] = 1;
+    }
+    else
+      next[s] = (unsigned short)norm[s];
+  }
+  for (s = 0; s <= maxSym; s++)
+    for (i = 0; (int)i < norm[s]; i++)
+    {
+      symbol[pos] = (unsigned char)s;
+      do
+        pos = (pos + step) & (size - 1);
+      while (pos > high);
+    }
+  if (pos != 0)
+    return 0;
+
+  for (i = 0; i < size; i++)
+  {
+    unsigned n = next[symbol[i]]++;
+    unsigned bits = log - highbit(n);
+    nbBits[i] = (unsigned char)bits;
+    state[i] = (unsigned short)((n << bits) - size);
+  }
+  return 1;
+}
+
+/* builds a sequence table from counts, base and extra bits of its codes */
+static int buildSeq(zseq *t, const short *norm, unsigned maxSym, unsigned log,
+                    const ZU32 *base, const unsigned char *extra)
+{
+  unsigned char symbol[1 << ZSTD_LLLOG], nbBits[1 << ZSTD_LLLOG];
+  unsigned short state[1 << ZSTD_LLLOG];
+  unsigned i;
+
+  if (!buildStates(symbol, state, nbBits, norm, maxSym, log))
+    return 0;
+  for (i = 0; i < (1U << log); i++)
+  {
+    unsigned s = symbol[i];
+    t[i].state = state[i];
+    t[i].nbBits = nbBits[i];
+    t[i].base = (base != NULL) ? base[s] : (ZU32)1 << s;
+    t[i].extra = (extra != NULL) ? extra[s] : (unsigned char)s;
+  }
+  return 1;
+}
+
+/* reads the table for one of the sequence codes given mode, from
+   in[0..size), returns bytes used or -1 if invalid */
+static long seqTable(zseq *t, unsigned *log, int mode, int have, unsigned maxSym, unsigned maxLog,
+                     const short *def, unsigned defMax, unsigned defLog,
+                     const ZU32 *base, const unsigned char *extra,
+                     const unsigned char *in, ZU32 size)
+{
+  short norm[ML_MAX + 1];
+  unsigned n = maxSym;
+  ZU32 used;
+
+  switch (mode)
+  {
+    case MODE_PREDEFINED:
+      *log = defLog;
+      return buildSeq(t, def, defMax, defLog, base, extra) ? 0 : -1;
+    case MODE_RLE:
+      if ((size == 0) || (in[0] > maxSym))
+        return -1;
+      *log = 0;
+      t[0].state = 0;
+      t[0].nbBits = 0;
+      t[0].base = (base != NULL) ? base[in[0]] : (ZU32)1 << in[0];
+      t[0].extra = (extra != NULL) ? extra[in[0]] : in[0];
+      return 1;
+    case MODE_FSE:
+      if ((used = readCounts(norm, &n, log, maxLog, in, size)) == 0)
+        return -1;
+      return buildSeq(t, norm, n, *log, base, extra) ? (long)used : -1;
+    default: /* MODE_REPEAT */
+      return have ? 0 : -1;
+  }
+}
+
+
+/*
+Huffman literals
+----------------
+The tree is given as the weight of each literal but the last, either 4
+bits each or FSE coded (two states taking turns on one stream, until
+it runs out); a literal of weight w has a code of maxBits + 1 - w bits,
+the last literal's weight making the codes complete.  Codes are
+assigned in order of weight, then of literal, from the shortest codes
+down, so a table indexed by the next maxBits bits has each literal's
+entries together.  Literals are in one stream, or four of a quarter
+each (the last taking the rest) after a table of the first three's
+sizes.
+*/
+
+/* reads the tree description at in[0..size), returns bytes used or 0 */
+static ZU32 readTree(zstddec *d, const unsigned char *in, ZU32 size)
+{
+  unsigned char weights[256];
+  unsigned n, i, w, maxBits;
+  unsigned count[WEIGHT_MAX + 2], start[WEIGHT_MAX + 2];
+  ZU32 sum, rest, used;
+
+  if (size == 0)
+    return 0;
+  if (in[0] >= 128)
+  {
+    n = in[0] - 127;
+    used = 1 + (n + 1) / 2;
+    if (used > size)
+      return 0;
+    for (i = 0; i < n; i++)
+      weights[i] = (i & 1) ? (in[1 + i / 2] & 15) : (in[1 + i / 2] >> 4);
+  }
+  else
+  {
+    short norm[WEIGHT_MAX + 2];
+    unsigned char symbol[1 << 6], nbBits[1 << 6];
+    unsigned short state[1 << 6];
+    unsigned maxSym = WEIGHT_MAX + 1, log, s[2];
+    ZU32 hdr;
+    bitin b;
+
+    used = 1 + in[0];
+    if ((in[0] == 0) || (used > size))
+      return 0;
+    if (((hdr = readCounts(norm, &maxSym, &log, 6, in + 1, in[0])) == 0) ||
+        !buildStates(symbol, state, nbBits, norm, maxSym, log) ||
+        !bitsInit(&b, in + 1 + hdr, in[0] - hdr))
+      return 0;
+    s[0] = bitsRead(&b, log);
+    s[1] = bitsRead(&b, log);
+    for (n = 0; ; n++)
+    {
+      unsigned *cur = &s[n & 1];
+      if (n >= 254)
+        return 0;
+      weights[n] = symbol[*cur];
+      *cur = state[*cur] + bitsRead(&b, nbBits[*cur]);
+      if (!bitsReload(&b))
+      {
+        /* out of bits, the other state's symbol is the last */
+        weights[n + 1] = symbol[s[(n + 1) & 1]];
+        n += 2;
+        break;
+      }
+    }
+  }
+
+  /* last weight from the rest */
+  memset(count, 0, sizeof(count));
+  for (i = 0, sum = 0; i < n; i++)
+  {
+    if (weights[i] > WEIGHT_MAX)
+      return 0;
+    count[weights[i]]++;
+    if (weights[i])
+      sum += (ZU32)1 << (weights[i] - 1);
+  }
+  if (sum == 0)
+    return 0;
+  maxBits = highbit(sum) + 1;
+  rest = ((ZU32)1 << maxBits) - sum;
+  if ((maxBits > ZSTD_HUFBITS) || (rest & (rest - 1)))
+    return 0;
+  weights[n] = (unsigned char)(highbit(rest) + 1);
+  count[weights[n]]++;
+  n++;
+
+  start[1] = 0;
+  for (w = 1; w <= maxBits; w++)
+    start[w + 1] = start[w] + (count[w] << (w - 1));
+  for (i = 0; i < n; i++)
+  {
+    ZU32 j, len;
+    zhuf e;
+
+    if ((w = weights[i]) == 0)
+      continue;
+    e.symbol = (unsigned char)i;
+    e.nbBits = (unsigned char)(maxBits + 1 - w);
+    len = (ZU32)1 << (w - 1);
+    for (j = 0; j < len; j++)
+      d->huf[start[w] + j] = e;
+    start[w] += len;
+  }
+  d->hufBits = maxBits;
+  return used;
+}
+
+/* decodes n literals from the stream in[0..size) to out */
+static int hufStream(const zstddec *d, unsigned char *out, ZU32 n, const unsigned char *in, ZU32 size)
+{
+  const zhuf *t = d->huf;
+  unsigned bits = d->hufBits;
+  bitin b;
+
+  if (!bitsInit(&b, in, size))
+    return 0;
+  /* two codes a refill */
+  for (; n >= 2; n -= 2)
+  {
+    zhuf e;
+    if (!bitsReload(&b))
+      return 0;
+    e = t[PEEK(&b, bits)];
+    b.consumed += e.nbBits;
+    out[0] = e.symbol;
+    e = t[PEEK(&b, bits)];
+    b.consumed += e.nbBits;
+    out[1] = e.symbol;
+    out += 2;
+  }
+  if (n)
+  {
+    zhuf e;
+    if (!bitsReload(&b))
+      return 0;
+    e = t[PEEK(&b, bits)];
+    b.consumed += e.nbBits;
+    *out = e.symbol;
+  }
+  bitsReload(&b);
+  return bitsDone(&b);
+}
+
+/* reads the literals section at in[0..size), setting *lit and *litSize,
+   returns bytes used or -1 if invalid */
+static long literals(zstddec *d, const unsigned char *in, ZU32 size, const unsigned char **lit, ZU32 *litSize)
+{
+  unsigned type, format, hsize;
+  ZU32 regen, csize, h, used, total;
+
+  if (size == 0)
+    return -1;
+  type = in[0] & 3;
+  format = (in[0] >> 2) & 3;
+
+  if ((type == LIT_RAW) || (type == LIT_RLE))
+  {
+    hsize = (format == 1) ? 2 : (format == 3) ? 3 : 1;
+    if (size < hsize)
+      return -1;
+    if (hsize == 1)
+      regen = in[0] >> 3;
+    else if (hsize == 2)
+      regen = (in[0] >> 4) + ((ZU32)in[1] << 4);
+    else
+      regen = (in[0] >> 4) + ((ZU32)in[1] << 4) + ((ZU32)in[2] << 12);
+    if (regen > ZSTD_BLOCKMAX)
+      return -1;
+    *litSize = regen;
+    if (type == LIT_RAW)
+    {
+      if (size - hsize < regen)
+        return -1;
+      *lit = in + hsize;
+      return (long)(hsize + regen);
+    }
+    if (size - hsize < 1)
+      return -1;
+    memset(d->lit, in[hsize], regen);
+    *lit = d->lit;
+    return (long)(hsize + 1);
+  }
+
+  /* Huffman coded */
+  hsize = (format < 2) ? 3 : format + 2;
+  if (size < hsize + 1)
+    return -1;
+  h = get32(in);
+  if (hsize == 3)
+  {
+    h &= 0xFFFFFF;
+    regen = (h >> 4) & 0x3FF;
+    csize = (h >> 14) & 0x3FF;
+  }
+  else if (hsize == 4)
+  {
+    regen = (h >> 4) & 0x3FFF;
+    csize = h >> 18;
+  }
+  else
+  {
+    regen = (h >> 4) & 0x3FFFF;
+    csize = (h >> 22) + ((ZU32)in[4] << 10);
+  }
+  if ((regen > ZSTD_BLOCKMAX) || (csize > size - hsize))
+    return -1;
+  total = hsize + csize;
+  in += hsize;
+
+  if (type == LIT_COMPRESSED)
+  {
+    if ((used = readTree(d, in, csize)) == 0)
+      return -1;
+    in += used;
+    csize -= used;
+  }
+  else if (d->hufBits == 0)
+    return -1;    /* treeless without an earlier tree */
+
+  if (format == 0)
+  {
+    if (!hufStream(d, d->lit, regen, in, csize))
+      return -1;
+  }
+  else
+  {
+    ZU32 s1, s2, s3, s4, seg = (regen + 3) / 4;
+
+    if ((csize < 6) || (regen < 3 * seg))
+      return -1;
+    s1 = in[0] | ((ZU32)in[1] << 8);
+    s2 = in[2] | ((ZU32)in[3] << 8);
+    s3 = in[4] | ((ZU32)in[5] << 8);
+    if (s1 + s2 + s3 > csize - 6)
+      return -1;
+    s4 = csize - 6 - s1 - s2 - s3;
+    in += 6;
+    if (!hufStream(d, d->lit, seg, in, s1) ||
+        !hufStream(d, d->lit + seg, seg, in + s1, s2) ||
+        !hufStream(d, d->lit + 2 * seg, seg, in + s1 + s2, s3) ||
+        !hufStream(d, d->lit + 3 * seg, regen - 3 * seg, in + s1 + s2 + s3, s4))
+      return -1;
+  }
+  *lit = d->lit;
+  *litSize = regen;
+  return (long)total;
+}
+
+
+/* copies n bytes 8 at a time, writing up to 7 more */
+static void wildcopy(unsigned char *dst, const unsigned char *src, ZU32 n)
+{
+  unsigned char *end = dst + n;
+  do
+  {
+    COPY8(dst, src);
+    dst += 8;
+    src += 8;
+  } while (dst < end);
+}
+
+
+void zstddec_reset(zstddec *d)
+{
+  d->hufBits = 0;
+  d->haveSeq = 0;
+  d->rep[0] = 1;
+  d->rep[1] = 4;
+  d->rep[2] = 8;
+}
+
+
+/*
+Sequences
+---------
+The section starts with the number of sequences (1 to 3 bytes) and,
+if any, a byte of modes for the literal length, offset and match length
+tables, whose descriptions follow in that order.  The bit stream then
+gives the three initial states and, for each sequence, the offset's,
+match length's and literal length's extra bits, then the next states.
+Offset values of 1 to 3 pick one of the repeat offsets (shifted by one
+when there are no literals), larger ones are the offset + 3.
+*/
+
+long zstddec_block(zstddec *d, const unsigned char *in, ZU32 size,
+                   unsigned char *out, ZU32 outMax, ZU32 history)
+{
+  const unsigned char *end = in + size, *lit, *litEnd;
+  unsigned char *op = out, *oend = out + outMax;
+  ZU32 litSize, nbSeq, i;
+  long n;
+  unsigned modes;
+  bitin b;
+  unsigned llState, ofState, mlState;
+
+  if ((n = literals(d, in, size, &lit, &litSize)) < 0)
+    return -1;
+  in += n;
+  litEnd = lit + litSize;
+
+  if (in >= end)
+    return -1;
+  nbSeq = *in++;
+  if (nbSeq == 0)
+  {
+    if ((in != end) || (litSize > outMax))
+      return -1;
+    memcpy(out, lit, litSize);
+    return (long)litSize;
+  }
+  if (nbSeq >= 128)
+  {
+    if (nbSeq == 255)
+    {
+      if (end - in < 2)
+        return -1;
+      nbSeq = in[0] + ((ZU32)in[1] << 8) + 0x7F00;
+      in += 2;
+    }
+    else
+    {
+      if (end - in < 1)
+        return -1;
+      nbSeq = ((nbSeq - 128) << 8) + *in++;
+    }
+  }
+
+  if ((in >= end) || ((modes = *in++) & 3))
+    return -1;
+  n = seqTable(d->ll, &d->llLog, modes >> 6, d->haveSeq, LL_MAX, ZSTD_LLLOG,
+               llDefault, LL_MAX, 6, llBase, llExtra, in, (ZU32)(end - in));
+  if (n < 0)
+    return -1;
+  in += n;
+  n = seqTable(d->of, &d->ofLog, (modes >> 4) & 3, d->haveSeq, OF_MAX, ZSTD_OFLOG,
+               ofDefault, 28, 5, NULL, NULL, in, (ZU32)(end - in));
+  if (n < 0)
+    return -1;
+  in += n;
+  n = seqTable(d->ml, &d->mlLog, (modes >> 2) & 3, d->haveSeq, ML_MAX, ZSTD_MLLOG,
+               mlDefault, ML_MAX, 6, mlBase, mlExtra, in, (ZU32)(end - in));
+  if (n < 0)
+    return -1;
+  in += n;
+  d->haveSeq = 1;
+
+  if (!bitsInit(&b, in, (ZU32)(end - in)))
+    return -1;
+  llState = bitsRead(&b, d->llLog);
+  bitsReload(&b);
+  ofState = bitsRead(&b, d->ofLog);
+  bitsReload(&b);
+  mlState = bitsRead(&b, d->mlLog);
+
+  for (i = 0; i < nbSeq; i++)
+  {
+    const zseq *ll = &d->ll[llState], *of = &d->of[ofState], *ml = &d->ml[mlState];
+    ZU32 ofValue, offset, llen, mlen;
+    const unsigned char *match;
+
+    if (!bitsReload(&b))
+      return -1;
+    if (of->extra > 24)
+    {
+      ofValue = of->base + (bitsRead(&b, of->extra - 24) << 24);
+      bitsReload(&b);
+      ofValue += bitsRead(&b, 24);
+    }
+    else
+      ofValue = of->base + bitsRead(&b, of->extra);
+    bitsReload(&b);
+    mlen = ml->base + bitsRead(&b, ml->extra);
+    if (ml->extra + ll->extra > 25 - 7)
+      bitsReload(&b);
+    llen = ll->base + bitsRead(&b, ll->extra);
+
+    if (ofValue > 3)
+    {
+      offset = ofValue - 3;
+      d->rep[2] = d->rep[1];
+      d->rep[1] = d->rep[0];
+      d->rep[0] = offset;
+    }
+    else
+    {
+      unsigned idx = ofValue - 1 + (llen == 0);
+      if (idx != 0)
+      {
+        offset = (idx == 3) ? d->rep[0] - 1 : d->rep[idx];
+        if (idx != 1)
+          d->rep[2] = d->rep[1];
+        d->rep[1] = d->rep[0];
+        d->rep[0] = offset;
+      }
+      else
+        offset = d->rep[0];
+    }
+
+    if (i + 1 < nbSeq)
+    {
+      bitsReload(&b);
+      llState = ll->state + bitsRead(&b, ll->nbBits);
+      mlState = ml->state + bitsRead(&b, ml->nbBits);
+      bitsReload(&b);
+      ofState = of->state + bitsRead(&b, of->nbBits);
+    }
+
+    /* literals, then the match */
+    if ((llen > (ZU32)(litEnd - lit)) || (llen > (ZU32)(oend - op)) ||
+        (mlen > (ZU32)(oend - op) - llen))
+      return -1;
+    if (llen)
+    {
+      wildcopy(op, lit, llen);
+      op += llen;
+      lit += llen;
+    }
+    if ((offset == 0) || (offset > (ZU32)(op - out) + history))
+      return -1;
+    match = op - offset;
+    if (offset >= 8)
+      wildcopy(op, match, mlen);
+    else if (offset == 1)
+      memset(op, *match, mlen);
+    else
+    {
+      ZU32 k;
+      for (k = 0; k < mlen; k++)
+        op[k] = match[k];
+    }
+    op += mlen;
+  }
+  bitsReload(&b);
+  if (!bitsDone(&b))
+    return -1;
+
+  /* the rest of the literals */
+  litSize = (ZU32)(litEnd - lit);
+  if (litSize > (ZU32)(oend - op))
+    return -1;
+  memcpy(op, lit, litSize);
+  op += litSize;
+  return (long)(op - out);
+}
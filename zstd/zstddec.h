@@ -0,0 +1,70 @@
+/*
+ * zstddec - Zstandard compressed block decoder
+ *
+ *   This software is provided 'as-is', without any express or implied
+ *   warranty.  In no event will the authors be held liable for any damages
+ *   arising from the use of this software.
+ *
+ * Decodes the compressed blocks of a Zstandard frame (RFC 8878): Huffman
+ * coded literals and FSE coded sequences, whose tables and repeat offsets
+ * carry from block to block.  Raw and RLE blocks, frame headers and
+ * checksums are left to the caller (zstd.c).  A block's output goes
+ * straight after the frame's earlier output, which matches copy from;
+ * literals and matches are copied 8 bytes at a time, so up to
+ * ZSTDDEC_SLACK bytes past the output may be written and ZSTDDEC_INPAD
+ * past the input read.  Bits are read 32 at a time, so nothing needs
+ * 64-bit helpers on 32-bit x86.
+ */
+
+#ifndef _ZSTDDEC_H_
+#define _ZSTDDEC_H_
+
+typedef unsigned int ZU32;
+
+#define ZSTD_BLOCKMAX  (1 << 17)  /* most a block decodes to, 128KB */
+#define ZSTDDEC_SLACK  32         /* writable bytes needed past the output */
+#define ZSTDDEC_INPAD  8          /* readable bytes needed past the input */
+
+#define ZSTD_HUFBITS   11         /* longest literal code */
+#define ZSTD_LLLOG     9          /* largest table logs */
+#define ZSTD_OFLOG     8
+#define ZSTD_MLLOG     9
+
+/* Huffman decoding table entry, indexed by the next hufBits bits */
+typedef struct zhuf
+{
+  unsigned char symbol;
+  unsigned char nbBits;
+} zhuf;
+
+/* sequence decoding table entry, state is the next state less its bits */
+typedef struct zseq
+{
+  ZU32           base;      /* of length or offset value */
+  unsigned short state;
+  unsigned char  nbBits;    /* of next state */
+  unsigned char  extra;     /* bits added to base */
+} zseq;
+
+typedef struct zstddec
+{
+  zhuf     huf[1 << ZSTD_HUFBITS];
+  unsigned hufBits;         /* 0 if no table yet */
+  zseq     ll[1 << ZSTD_LLLOG], of[1 << ZSTD_OFLOG], ml[1 << ZSTD_MLLOG];
+  unsigned llLog, ofLog, mlLog;
+  int      haveSeq;         /* set once tables for sequences were given */
+  ZU32     rep[3];          /* repeat offsets */
+  unsigned char lit[ZSTD_BLOCKMAX + ZSTDDEC_SLACK];
+} zstddec;
+
+/* starts a frame: no tables, initial repeat offsets */
+void zstddec_reset(zstddec *d);
+
+/* decodes the compressed block (without its header) in[0..size) to out,
+   making at most outMax bytes; history bytes before out are earlier
+   output of the frame that matches may copy from; returns the number of
+   bytes made, or -1 if the block is corrupt */
+long zstddec_block(zstddec *d, const unsigned char *in, ZU32 size,
+                   unsigned char *out, ZU32 outMax, ZU32 history);
+
+#endif /* _ZSTDDEC_H_ */